@@ -36,6 +36,7 @@ const uint16_t F16MAX       = 0x7bff;   // MAXFLT bit pattern for XMHALF
 
 // Because these are used in SAL annotations, they need to remain macros rather than const values
 #define NUM_PIXELS_PER_BLOCK 16
+#define NUM_BLOCKS_PER_BATCH 8
 #define BC6H_MAX_REGIONS 2
 #define BC6H_MAX_INDICES 16
 #define BC7_MAX_REGIONS 3
@@ -46,6 +47,7 @@ const size_t BC6H_MAX_SHAPES = 32;
 
 const size_t BC7_NUM_CHANNELS = 4;
 const size_t BC7_MAX_SHAPES = 64;
+const size_t BC7_QUICK_ITEMS = 2; // Rough cases refined per mode with BC_FLAGS_BC7_QUICK
 
 const int32_t BC67_WEIGHT_MAX = 64;
 const uint32_t BC67_WEIGHT_SHIFT = 6;
@@ -61,6 +63,8 @@ enum BC_FLAGS
     BC_FLAGS_DITHER_RGB = 0x10000,  // Enables dithering for RGB colors for BC1-3
     BC_FLAGS_DITHER_A   = 0x20000,  // Enables dithering for Alpha channel for BC1-3
     BC_FLAGS_UNIFORM    = 0x40000,  // By default, uses perceptual weighting for BC1-3; this flag makes it a uniform weighting
+    BC_FLAGS_FORCE_SCALAR = 0x80000, // Reference mode for the batch encoders; encodes one block at a time without SIMD lanes
+    BC_FLAGS_BC7_QUICK  = 0x100000, // Fast BC7 compression; refines the best BC7_QUICK_ITEMS rough candidates per mode, skips rotations and prunes modes for opaque and solid blocks
 };
 
 //-------------------------------------------------------------------------------------
@@ -625,7 +629,7 @@ class D3DX_BC7 : private CBits< 16 >
 {
 public:
     void Decode(_Out_writes_(NUM_PIXELS_PER_BLOCK) HDRColorA* pOut) const;
-    void Encode(_In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA* const pIn);
+    void Encode(_In_ DWORD flags, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA* const pIn);
 
 private:
     struct ModeInfo
@@ -876,6 +880,16 @@ void D3DXDecodeBC6HU(_Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor, _In_re
 void D3DXDecodeBC6HS(_Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor, _In_reads_(16) const uint8_t *pBC);
 void D3DXDecodeBC7(_Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor, _In_reads_(16) const uint8_t *pBC);
 
+void D3DXDecodeBC1Palette(_Out_writes_(4) XMVECTOR *pPalette, _Out_writes_(NUM_PIXELS_PER_BLOCK) uint8_t *pIndices, _In_reads_(8) const uint8_t *pBC);
+void D3DXDecodeBC2Palette(_Out_writes_(4) XMVECTOR *pPalette, _Out_writes_(NUM_PIXELS_PER_BLOCK) uint8_t *pIndices,
+                          _Out_writes_(16) float *pAlpha, _Out_writes_(NUM_PIXELS_PER_BLOCK) uint8_t *pAlphaIndices, _In_reads_(16) const uint8_t *pBC);
+void D3DXDecodeBC3Palette(_Out_writes_(4) XMVECTOR *pPalette, _Out_writes_(NUM_PIXELS_PER_BLOCK) uint8_t *pIndices,
+                          _Out_writes_(8) float *pAlpha, _Out_writes_(NUM_PIXELS_PER_BLOCK) uint8_t *pAlphaIndices, _In_reads_(16) const uint8_t *pBC);
+void D3DXDecodeBC4UPalette(_Out_writes_(8) float *pRed, _Out_writes_(NUM_PIXELS_PER_BLOCK) uint8_t *pIndices, _In_reads_(8) const uint8_t *pBC);
+void D3DXDecodeBC4SPalette(_Out_writes_(8) float *pRed, _Out_writes_(NUM_PIXELS_PER_BLOCK) uint8_t *pIndices, _In_reads_(8) const uint8_t *pBC);
+    // Palette form of the BC1-BC4 decoders: the block's endpoint and interpolated values in index order plus each
+    // texel's index. Looking up the indices gives the same values as D3DXDecodeBCn (BC5 is two BC4 blocks)
+
 void D3DXEncodeBC1(_Out_writes_(8) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ float alphaRef, _In_ DWORD flags);
     // BC1 requires one additional parameter, so it doesn't match signature of BC_ENCODE above
 
@@ -889,4 +903,10 @@ void D3DXEncodeBC6HU(_Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BL
 void D3DXEncodeBC6HS(_Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ DWORD flags);
 void D3DXEncodeBC7(_Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ DWORD flags);
 
+void D3DXEncodeBC1Batch(_Out_writes_(8*nBlocks) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK*nBlocks) const XMVECTOR *pColor, _In_ size_t nBlocks, _In_ float alphaRef, _In_ DWORD flags);
+void D3DXEncodeBC3Batch(_Out_writes_(16*nBlocks) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK*nBlocks) const XMVECTOR *pColor, _In_ size_t nBlocks, _In_ DWORD flags);
+    // Encodes nBlocks consecutive blocks, running the endpoint search for several blocks at once in SIMD lanes.
+    // Output is bit-identical to calling D3DXEncodeBC1/D3DXEncodeBC3 on each block, provided BC.cpp is built
+    // with /fp:precise (the project files set this) so float expressions are not contracted or reassociated
+
 }; // namespace
@@ -194,6 +194,14 @@ namespace DirectX
             // Filtering mode to use for any required image resizing (only needed when loading arrays of differently sized images; defaults to Fant)
     };
 
+    enum TGA_FLAGS
+    {
+        TGA_FLAGS_NONE                  = 0x0,
+
+        TGA_FLAGS_RLE                   = 0x1,
+            // Write run-length encoded pixel data (smaller files for images with flat areas such as masks)
+    };
+
     HRESULT GetMetadataFromDDSMemory( _In_reads_bytes_(size) LPCVOID pSource, _In_ size_t size, _In_ DWORD flags,
                                       _Out_ TexMetadata& metadata );
     HRESULT GetMetadataFromDDSFile( _In_z_ LPCWSTR szFile, _In_ DWORD flags,
@@ -209,6 +217,57 @@ namespace DirectX
     HRESULT GetMetadataFromWICFile( _In_z_ LPCWSTR szFile, _In_ DWORD flags,
                                     _Out_ TexMetadata& metadata );
 
+    //---------------------------------------------------------------------------------
+    // Persistent metadata index for batch scans of DDS and TGA files
+    enum TEX_INDEX_FLAGS
+    {
+        TEX_INDEX_DEFAULT           = 0,
+
+        TEX_INDEX_RECURSIVE         = 0x1,
+            // Scan subdirectories as well
+
+        TEX_INDEX_PRUNE             = 0x2,
+            // Remove entries under the scanned directory whose files no longer exist
+    };
+
+    struct TexIndexStatistics
+    {
+        size_t  files;      // DDS and TGA files found by the scan
+        size_t  parsed;     // New or changed files whose header had to be read
+        size_t  failed;     // Files whose header could not be read or decoded
+        size_t  removed;    // Entries pruned because their file no longer exists
+    };
+
+    class TexMetadataIndex
+    {
+    public:
+        TexMetadataIndex();
+        ~TexMetadataIndex();
+
+        HRESULT Load( _In_z_ LPCWSTR szFile );
+            // Replaces the contents with a previously saved index
+        HRESULT Save( _In_z_ LPCWSTR szFile ) const;
+
+        HRESULT Scan( _In_z_ LPCWSTR szDirectory, _In_ DWORD flags, _In_ DWORD ddsFlags,
+                      _Out_opt_ TexIndexStatistics* stats = nullptr );
+            // Reads the headers of new and changed .dds/.tga files in parallel; files whose size and
+            // write time match the index are not opened
+
+        bool Find( _In_z_ LPCWSTR szFile, _Out_ TexMetadata& metadata ) const;
+            // Constant-time lookup without file system access (paths are compared as full, case-insensitive paths)
+
+        size_t GetCount() const;
+        void Clear();
+
+    private:
+        struct Impl;
+        Impl*   _impl;
+
+        // Hide copy constructor and assignment operator
+        TexMetadataIndex( const TexMetadataIndex& );
+        TexMetadataIndex& operator=( const TexMetadataIndex& );
+    };
+
     //---------------------------------------------------------------------------------
     // Bitmap image container
     struct Image
@@ -221,18 +280,78 @@ namespace DirectX
         uint8_t*    pixels;
     };
 
+    //---------------------------------------------------------------------------------
+    // Pixel memory allocator for ScratchImage (blocks must be 16-byte aligned; Free is
+    // given the same size that was passed to Allocate)
+    class ImageAllocator
+    {
+    public:
+        virtual void* Allocate( _In_ size_t size ) = 0;
+        virtual void Free( _In_opt_ void* ptr, _In_ size_t size ) = 0;
+
+    protected:
+        virtual ~ImageAllocator() {}
+    };
+
+    //---------------------------------------------------------------------------------
+    // Size-classed pool which keeps released blocks for reuse instead of returning them
+    // to the heap (thread-safe)
+    struct ImagePoolStatistics
+    {
+        size_t  allocations;        // Calls to Allocate
+        size_t  heapAllocations;    // Allocations that had to go to the heap
+        size_t  heapBytes;          // Bytes currently held from the heap (in use and cached)
+        size_t  peakHeapBytes;      // Largest value of heapBytes
+        size_t  cachedBytes;        // Bytes of released blocks waiting for reuse
+    };
+
+    class ImagePool : public ImageAllocator
+    {
+    public:
+        explicit ImagePool( _In_ size_t maxCachedBytes = 0 );
+            // maxCachedBytes of 0 caches every released block
+        virtual ~ImagePool();
+
+        virtual void* Allocate( _In_ size_t size );
+        virtual void Free( _In_opt_ void* ptr, _In_ size_t size );
+
+        void Trim();
+            // Returns all cached blocks to the heap
+
+        void GetStatistics( _Out_ ImagePoolStatistics& stats ) const;
+
+    private:
+        static const size_t MAX_CLASSES = 256;
+
+        mutable CRITICAL_SECTION    _cs;
+        void*                       _free[ MAX_CLASSES ];
+        size_t                      _maxCachedBytes;
+        ImagePoolStatistics         _stats;
+
+        // Hide copy constructor and assignment operator
+        ImagePool( const ImagePool& );
+        ImagePool& operator=( const ImagePool& );
+    };
+
     class ScratchImage
     {
     public:
         ScratchImage()
-            : _nimages(0), _size(0), _image(nullptr), _memory(nullptr) {}
+            : _nimages(0), _size(0), _capacity(0), _image(nullptr), _memory(nullptr), _allocator(nullptr) {}
+        explicit ScratchImage( _In_opt_ ImageAllocator* allocator )
+            : _nimages(0), _size(0), _capacity(0), _image(nullptr), _memory(nullptr), _allocator(allocator) {}
         ScratchImage(ScratchImage&& moveFrom)
-            : _nimages(0), _size(0), _image(nullptr), _memory(nullptr) { *this = std::move(moveFrom); }
+            : _nimages(0), _size(0), _capacity(0), _image(nullptr), _memory(nullptr), _allocator(nullptr) { *this = std::move(moveFrom); }
         ~ScratchImage() { Release(); }
 
         ScratchImage& operator= (ScratchImage&& moveFrom);
 
+        void SetAllocator( _In_opt_ ImageAllocator* allocator );
+            // Releases any current contents; nullptr uses the heap
+
         HRESULT Initialize( _In_ const TexMetadata& mdata );
+        HRESULT InitializeReuse( _In_ const TexMetadata& mdata );
+            // Like Initialize, but keeps the current pixel buffer if it is large enough (contents are undefined)
 
         HRESULT Initialize1D( _In_ DXGI_FORMAT fmt, _In_ size_t length, _In_ size_t arraySize, _In_ size_t mipLevels );
         HRESULT Initialize2D( _In_ DXGI_FORMAT fmt, _In_ size_t width, _In_ size_t height, _In_ size_t arraySize, _In_ size_t mipLevels );
@@ -260,17 +379,60 @@ namespace DirectX
         bool IsAlphaAllOpaque() const;
 
     private:
-        size_t      _nimages;
-        size_t      _size;
-        TexMetadata _metadata;
-        Image*      _image;
-        uint8_t*    _memory;
+        size_t          _nimages;
+        size_t          _size;
+        size_t          _capacity;
+        TexMetadata     _metadata;
+        Image*          _image;
+        uint8_t*        _memory;
+        ImageAllocator* _allocator;
 
         // Hide copy constructor and assignment operator
         ScratchImage( const ScratchImage& );
         ScratchImage& operator=( const ScratchImage& );
     };
 
+    //---------------------------------------------------------------------------------
+    // Read-only image container backed by a memory-mapped file
+    //  (the Image pixels point into the mapping and must not be written to)
+    class MappedImage
+    {
+    public:
+        MappedImage()
+            : _nimages(0), _size(0), _image(nullptr), _pixels(nullptr), _view(nullptr) {}
+        ~MappedImage() { Release(); }
+
+        void Release();
+
+        const TexMetadata& GetMetadata() const { return _metadata; }
+        const Image* GetImage(_In_ size_t mip, _In_ size_t item, _In_ size_t slice) const;
+
+        const Image* GetImages() const { return _image; }
+        size_t GetImageCount() const { return _nimages; }
+
+        const uint8_t* GetPixels() const { return _pixels; }
+        size_t GetPixelsSize() const { return _size; }
+
+        bool IsMapped() const { return _view != nullptr; }
+            // false if the file needed conversion and was copied into memory instead
+
+    private:
+        size_t          _nimages;
+        size_t          _size;
+        TexMetadata     _metadata;
+        Image*          _image;
+        const uint8_t*  _pixels;
+        const void*     _view;
+        ScratchImage    _copy;
+
+        friend HRESULT LoadFromDDSFile( _In_z_ LPCWSTR szFile, _In_ DWORD flags,
+                                        _Out_opt_ TexMetadata* metadata, _Out_ MappedImage& image );
+
+        // Hide copy constructor and assignment operator
+        MappedImage( const MappedImage& );
+        MappedImage& operator=( const MappedImage& );
+    };
+
     //---------------------------------------------------------------------------------
     // Memory blob (allocated buffer pointer is always 16-byte aligned)
     class Blob
@@ -284,6 +446,9 @@ namespace DirectX
 
         HRESULT Initialize( _In_ size_t size );
 
+        HRESULT Trim( _In_ size_t size );
+            // Shrinks the reported size of the buffer (e.g. after writing less than the worst case)
+
         void Release();
 
         void *GetBufferPointer() const { return _buffer; }
@@ -298,6 +463,110 @@ namespace DirectX
         Blob& operator=( const Blob& );
     };
 
+    //---------------------------------------------------------------------------------
+    // Streaming DDS file writer (subresources can be written in any order as they are
+    // produced, so the whole texture never has to be held in memory)
+    class DDSFileWriter
+    {
+    public:
+        DDSFileWriter()
+            : _hFile(nullptr), _nimages(0), _nwritten(0), _offsets(nullptr), _written(nullptr) {}
+        ~DDSFileWriter() { Close(); }
+
+        HRESULT Create( _In_z_ LPCWSTR szFile, _In_ const TexMetadata& metadata, _In_ DWORD flags );
+            // Creates the file and writes the DDS header
+
+        HRESULT WriteImage( _In_ const Image& image, _In_ size_t mip, _In_ size_t item, _In_ size_t slice );
+            // Image must match the size and format of the subresource; rows may be padded
+
+        HRESULT Close();
+            // Returns E_FAIL if any subresource was never written
+
+        const TexMetadata& GetMetadata() const { return _metadata; }
+        size_t GetImageCount() const { return _nimages; }
+        size_t GetWrittenCount() const { return _nwritten; }
+
+    private:
+        void*       _hFile;
+        TexMetadata _metadata;
+        size_t      _nimages;
+        size_t      _nwritten;
+        uint64_t*   _offsets;
+        bool*       _written;
+
+        // Hide copy constructor and assignment operator
+        DDSFileWriter( const DDSFileWriter& );
+        DDSFileWriter& operator=( const DDSFileWriter& );
+    };
+
+    //---------------------------------------------------------------------------------
+    // Streaming DDS file reader (only the header is read on open; mip levels are then read
+    // on demand, coarsest first, so a usable texture is available before the whole file is)
+    class DDSFileReader
+    {
+    public:
+        DDSFileReader()
+            : _hFile(nullptr), _flags(0), _nimages(0), _offsets(nullptr), _hThread(nullptr), _levelEvents(nullptr),
+              _images(nullptr), _firstMip(0), _readyMip(0), _cancel(0), _result(S_OK) {}
+        ~DDSFileReader() { Close(); }
+
+        HRESULT Open( _In_z_ LPCWSTR szFile, _In_ DWORD flags );
+            // Reads and decodes the header only; legacy formats that need conversion on load are not supported
+
+        HRESULT GetSubresourceRange( _In_ size_t mip, _In_ size_t item, _In_ size_t slice,
+                                     _Out_ uint64_t& offset, _Out_ size_t& size ) const;
+            // Location of the subresource in the file
+
+        HRESULT ReadImage( _In_ const Image& image, _In_ size_t mip, _In_ size_t item, _In_ size_t slice );
+            // Synchronous read; image must match the size and format of the subresource and rows may be padded
+
+        HRESULT BeginRead( _In_reads_(nimages) const Image* images, _In_ size_t nimages, _In_ size_t firstMip,
+                           _In_opt_ std::function<void(size_t mip)> levelReady = nullptr );
+            // Reads mip levels mipLevels-1 down to firstMip on a background thread. images is laid out like
+            // ScratchImage::GetImages(); levels finer than firstMip are not touched and may have null pixels.
+            // levelReady is called on the background thread once every subresource of a level is in place
+
+        HRESULT WaitForLevel( _In_ size_t mip );
+            // Blocks until the level (and so every coarser one) has been read
+
+        size_t GetReadyLevel() const { return static_cast<size_t>( _readyMip ); }
+            // Finest level read so far by BeginRead, or mipLevels if none
+
+        HRESULT EndRead();
+            // Waits for the background read to finish and returns its result
+
+        void CancelRead();
+            // Stops the background read at the next subresource; EndRead then returns E_ABORT
+
+        HRESULT Close();
+
+        const TexMetadata& GetMetadata() const { return _metadata; }
+
+    private:
+        void*           _hFile;
+        TexMetadata     _metadata;
+        DWORD           _flags;
+        size_t          _nimages;
+        uint64_t*       _offsets;
+
+        // Background read state
+        void*           _hThread;
+        void**          _levelEvents;
+        const Image*    _images;
+        size_t          _firstMip;
+        volatile LONG   _readyMip;
+        volatile LONG   _cancel;
+        HRESULT         _result;
+        std::function<void(size_t mip)> _levelReady;
+
+        static unsigned __stdcall _ReadThreadProc( void* pParam );
+        HRESULT _ReadLevels();
+
+        // Hide copy constructor and assignment operator
+        DDSFileReader( const DDSFileReader& );
+        DDSFileReader& operator=( const DDSFileReader& );
+    };
+
     //---------------------------------------------------------------------------------
     // Image I/O
 
@@ -306,6 +575,9 @@ namespace DirectX
                                _Out_opt_ TexMetadata* metadata, _Out_ ScratchImage& image );
     HRESULT LoadFromDDSFile( _In_z_ LPCWSTR szFile, _In_ DWORD flags,
                              _Out_opt_ TexMetadata* metadata, _Out_ ScratchImage& image );
+    HRESULT LoadFromDDSFile( _In_z_ LPCWSTR szFile, _In_ DWORD flags,
+                             _Out_opt_ TexMetadata* metadata, _Out_ MappedImage& image );
+        // Maps the file instead of reading it; images that need no conversion are used in place
 
     HRESULT SaveToDDSMemory( _In_ const Image& image, _In_ DWORD flags,
                              _Out_ Blob& blob );
@@ -314,6 +586,9 @@ namespace DirectX
 
     HRESULT SaveToDDSFile( _In_ const Image& image, _In_ DWORD flags, _In_z_ LPCWSTR szFile );
     HRESULT SaveToDDSFile( _In_reads_(nimages) const Image* images, _In_ size_t nimages, _In_ const TexMetadata& metadata, _In_ DWORD flags, _In_z_ LPCWSTR szFile );
+    HRESULT SaveToDDSFile( _In_ const TexMetadata& metadata, _In_ DWORD flags, _In_z_ LPCWSTR szFile,
+                           _In_ std::function<HRESULT(size_t mip, size_t item, size_t slice, const Image& image)> produceImage );
+        // Streams the file one subresource at a time; produceImage fills in each image in file order before it is written
 
     // TGA operations
     HRESULT LoadFromTGAMemory( _In_reads_bytes_(size) LPCVOID pSource, _In_ size_t size,
@@ -322,7 +597,9 @@ namespace DirectX
                              _Out_opt_ TexMetadata* metadata, _Out_ ScratchImage& image );
 
     HRESULT SaveToTGAMemory( _In_ const Image& image, _Out_ Blob& blob );
+    HRESULT SaveToTGAMemory( _In_ const Image& image, _In_ DWORD flags, _Out_ Blob& blob );
     HRESULT SaveToTGAFile( _In_ const Image& image, _In_z_ LPCWSTR szFile );
+    HRESULT SaveToTGAFile( _In_ const Image& image, _In_ DWORD flags, _In_z_ LPCWSTR szFile );
 
     // WIC operations
     HRESULT LoadFromWICMemory( _In_reads_bytes_(size) LPCVOID pSource, _In_ size_t size, _In_ DWORD flags,
@@ -371,6 +648,9 @@ namespace DirectX
                         _In_ DWORD flags, _Out_ ScratchImage& result );
         // Flip and/or rotate image
 
+    HRESULT FlipRotate( _Inout_ ScratchImage& image, _In_ DWORD flags );
+        // Flip and/or rotate every image in place (BC6H/BC7, packed, video, and sub-byte formats are not supported)
+
     enum TEX_FILTER_FLAGS
     {
         TEX_FILTER_DEFAULT          = 0,
@@ -405,7 +685,10 @@ namespace DirectX
         TEX_FILTER_BOX              = 0x400000,
         TEX_FILTER_FANT             = 0x400000, // Equiv to Box filtering for mipmap generation
         TEX_FILTER_TRIANGLE         = 0x500000,
+        TEX_FILTER_LANCZOS          = 0x600000, // Lanczos-3 windowed sinc
+        TEX_FILTER_KAISER           = 0x700000, // Kaiser windowed sinc
             // Filtering mode to use for any required image resizing
+            // LANCZOS and KAISER always use the non-WIC path
 
         TEX_FILTER_SRGB_IN          = 0x1000000,
         TEX_FILTER_SRGB_OUT         = 0x2000000,
@@ -482,6 +765,10 @@ namespace DirectX
         TEX_COMPRESS_UNIFORM        = 0x40000,
             // Uniform color weighting for BC1-3 compression; by default uses perceptual weighting
 
+        TEX_COMPRESS_BC7_QUICK      = 0x100000,
+            // Fast but lower quality BC7 compression; refines only the best few partitions per mode, skips rotations,
+            // skips alpha modes for opaque blocks and limits solid blocks to modes 5 and 6
+
         TEX_COMPRESS_SRGB_IN        = 0x1000000,
         TEX_COMPRESS_SRGB_OUT       = 0x2000000,
         TEX_COMPRESS_SRGB           = ( TEX_COMPRESS_SRGB_IN | TEX_COMPRESS_SRGB_OUT ),
@@ -492,21 +779,58 @@ namespace DirectX
             // Compress is free to use multithreading to improve performance (by default it does not use multithreading)
     };
 
+    enum TEX_DECOMPRESS_FLAGS
+    {
+        TEX_DECOMPRESS_DEFAULT      = 0,
+
+        TEX_DECOMPRESS_PARALLEL     = 0x10000000,
+            // Decompress is free to use multithreading to improve performance (by default it does not use multithreading)
+    };
+
+    void SetMaxThreadCount( _In_ size_t threads );
+    size_t GetMaxThreadCount();
+        // Number of worker threads used by TEX_COMPRESS_PARALLEL and TEX_DECOMPRESS_PARALLEL; 0 (the default) uses one per logical processor
+
     HRESULT Compress( _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ DWORD compress, _In_ float alphaRef,
                       _Out_ ScratchImage& cImage );
     HRESULT Compress( _In_reads_(nimages) const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
                       _In_ DXGI_FORMAT format, _In_ DWORD compress, _In_ float alphaRef, _Out_ ScratchImage& cImages );
+    HRESULT Compress( _In_reads_(nimages) const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
+                      _In_ DXGI_FORMAT format, _In_ DWORD compress, _In_ float alphaRef, _Out_ ScratchImage& cImages,
+                      _In_ std::function<bool(size_t blocksDone, size_t blocksTotal)> progress );
         // Note that alphaRef is only used by BC1. 0.5f is a typical value to use
+        // progress is called as blocks complete (from worker threads with TEX_COMPRESS_PARALLEL, but never concurrently);
+        // returning false cancels the compression with E_ABORT
 
-    HRESULT Compress( _In_ ID3D11Device* pDevice, _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ DWORD compress,
+    HRESULT Compress( _In_opt_ ID3D11Device* pDevice, _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ DWORD compress,
                       _Out_ ScratchImage& image );
-    HRESULT Compress( _In_ ID3D11Device* pDevice, _In_ const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
+    HRESULT Compress( _In_opt_ ID3D11Device* pDevice, _In_ const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
                       _In_ DXGI_FORMAT format, _In_ DWORD compress, _Out_ ScratchImage& cImages );
-        // DirectCompute-based compression
+    HRESULT Compress( _In_opt_ ID3D11Device* pDevice, _In_ const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
+                      _In_ DXGI_FORMAT format, _In_ DWORD compress, _In_ float alphaRef, _Out_ ScratchImage& cImages,
+                      _In_ std::function<bool(size_t blocksDone, size_t blocksTotal)> progress );
+        // DirectCompute-based compression for BC6H and BC7. Without a device, on hardware without DirectCompute, or for
+        // other BC formats, this uses the CPU encoders on all cores (TEX_COMPRESS_PARALLEL is implied). The overloads
+        // without alphaRef use 0.5f. progress is called as for the CPU overload (per image on the GPU)
 
     HRESULT Decompress( _In_ const Image& cImage, _In_ DXGI_FORMAT format, _Out_ ScratchImage& image );
     HRESULT Decompress( _In_reads_(nimages) const Image* cImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
                         _In_ DXGI_FORMAT format, _Out_ ScratchImage& images );
+    HRESULT Decompress( _In_ const Image& cImage, _In_ DXGI_FORMAT format, _In_ DWORD flags, _Out_ ScratchImage& image );
+    HRESULT Decompress( _In_reads_(nimages) const Image* cImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
+                        _In_ DXGI_FORMAT format, _In_ DWORD flags, _Out_ ScratchImage& images );
+        // BC1-BC5 decompressed to their default formats (R8G8B8A8, R8, or R8G8) skip the float conversion per texel
+
+    //---------------------------------------------------------------------------------
+    // Texture processing pipeline
+    HRESULT ProcessTexture( _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ DWORD filter, _In_ size_t levels,
+                            _In_ DWORD compress, _In_ float alphaRef, _Out_ ScratchImage& result );
+    HRESULT ProcessTexture( _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ DWORD filter, _In_ size_t levels,
+                            _In_ DWORD compress, _In_ float alphaRef, _In_ DWORD ddsFlags, _In_z_ LPCWSTR szFile );
+        // Equivalent to Convert (for a non-BC format), GenerateMipMaps, then Compress (for a BC format) with
+        // TEX_FILTER_FORCE_NON_WIC, but streams the image through all the stages in bands of rows so no full size
+        // intermediate image is created. Point filtering and error diffusion dithering run the stages one at a time.
+        // compress and alphaRef are only used for BC formats; TEX_COMPRESS_PARALLEL also converts bands in parallel
 
     //---------------------------------------------------------------------------------
     // Normal map operations
@@ -533,12 +857,17 @@ namespace DirectX
 
         CNMAP_COMPUTE_OCCLUSION = 0x8000,
             // Computes a crude occlusion term stored in the alpha channel
+
+        CNMAP_SOBEL             = 0x10000,
+            // Uses a Sobel kernel for the height gradient (defaults to central differences averaged over three rows/columns)
     };
 
     HRESULT ComputeNormalMap( _In_ const Image& srcImage, _In_ DWORD flags, _In_ float amplitude,
                               _In_ DXGI_FORMAT format, _Out_ ScratchImage& normalMap );
     HRESULT ComputeNormalMap( _In_reads_(nimages) const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
                               _In_ DWORD flags, _In_ float amplitude, _In_ DXGI_FORMAT format, _Out_ ScratchImage& normalMaps );
+        // Two-channel formats receive the normal's X and Y for reconstruction in the shader; BC5_UNORM and BC5_SNORM
+        // are generated as R8G8 and compressed directly
 
     //---------------------------------------------------------------------------------
     // Misc image operations
@@ -577,6 +906,20 @@ namespace DirectX
 
     HRESULT ComputeMSE( _In_ const Image& image1, _In_ const Image& image2, _Out_ float& mse, _Out_writes_opt_(4) float* mseV, _In_ DWORD flags = 0 );
 
+    struct ImageQuality
+    {
+        float mse;          // Sum of the per-channel MSE (as returned by ComputeMSE)
+        float mseV[4];      // Per-channel MSE
+        float psnr;         // Peak signal-to-noise ratio in dB over the channels compared, assuming a peak of 1.0 (infinite for identical images)
+        float ssim;         // Mean structural similarity index over the channels compared
+        float ssimV[4];     // Per-channel SSIM (1.0 for ignored channels)
+    };
+
+    HRESULT ComputeQuality( _In_reads_(nimages) const Image* images1, _In_reads_(nimages) const Image* images2, _In_ size_t nimages,
+                            _Out_writes_(nimages) ImageQuality* results, _In_ DWORD flags = 0 );
+        // Compares each pair of images (i.e. every subresource of two mip chains or arrays) in a single multithreaded pass.
+        // SSIM is averaged over 8x8 windows. Takes the same CMSE_FLAGS as ComputeMSE
+
     //---------------------------------------------------------------------------------
     // Direct3D 11 functions
     bool IsSupportedTexture( _In_ ID3D11Device* pDevice, _In_ const TexMetadata& metadata );
@@ -200,6 +200,37 @@ namespace DirectX
     void _ConvertScanline( _Inout_updates_all_(count) XMVECTOR* pBuffer, _In_ size_t count,
                            _In_ DXGI_FORMAT outFormat, _In_ DXGI_FORMAT inFormat, _In_ DWORD flags );
 
+    HRESULT _ConvertRows( _In_ const Image& srcImage, _In_ DWORD filter, _In_ const Image& destImage, _In_ float threshold );
+        // Non-WIC conversion of a band of rows (error diffusion dithering is not supported)
+
+    //---------------------------------------------------------------------------------
+    // Compression helper functions
+    typedef std::function<bool(size_t blocksDone, size_t blocksTotal)> COMPRESS_PROGRESS;
+
+    HRESULT _CompressImages( _In_reads_(nimages) const Image* srcImages, _In_reads_(nimages) const Image* destImages, _In_ size_t nimages,
+                             _In_ DWORD compress, _In_ float alphaRef, _In_opt_ const COMPRESS_PROGRESS* progress = nullptr );
+        // Returns E_ABORT if progress returns false
+
+    //---------------------------------------------------------------------------------
+    // Parallel helper functions
+    typedef bool (*PARALLEL_TASK)( _In_ size_t item, _In_opt_ void* pContext );
+
+    size_t _GetThreadCount( _In_ size_t nItems );
+
+    HRESULT _ParallelFor( _In_ size_t nItems, _In_ PARALLEL_TASK pfTask, _In_opt_ void* pContext );
+        // Runs the task for every item in [0, nItems) using a work-stealing pool of threads
+
+    bool _IsAVXSupported();
+
+    //---------------------------------------------------------------------------------
+    // Separable filter helper functions
+    struct SeparableFilter;
+
+    HRESULT _ResizeSeparable( _In_reads_(nitems*srcDepth) const Image* srcImages, _In_ size_t srcDepth,
+                              _In_reads_(nitems*destDepth) const Image* destImages, _In_ size_t destDepth, _In_ size_t nitems,
+                              _In_ const SeparableFilter& fx, _In_ const SeparableFilter& fy, _In_ const SeparableFilter& fz, _In_ DWORD filter );
+        // Filters each item's source slices into its destination slices, one axis at a time (see filters.h)
+
     //---------------------------------------------------------------------------------
     // DDS helper functions
     HRESULT _EncodeDDSHeader( _In_ const TexMetadata& metadata, DWORD flags,
@@ -421,4 +421,359 @@ namespace TriangleFilter
 
 }; // namespace
 
+
+//-------------------------------------------------------------------------------------
+// Separable filtering helpers
+//
+// Every filter above is separable, so it can be expressed as a fixed number of weighted
+// source texels (taps) for each destination texel along each axis. Unused taps have zero
+// weight
+//-------------------------------------------------------------------------------------
+
+struct FilterTap
+{
+    size_t  u;
+    float   weight;
+};
+
+struct SeparableFilter
+{
+    size_t                          source;
+    size_t                          dest;
+    size_t                          taps;
+    std::unique_ptr<FilterTap[]>    tap;    // dest * taps entries
+
+    SeparableFilter() : source(0), dest(0), taps(0) {}
+};
+
+inline HRESULT _AllocateSeparableFilter( _In_ size_t source, _In_ size_t dest, _In_ size_t taps, _Inout_ SeparableFilter& sf )
+{
+    assert( source > 0 );
+    assert( dest > 0 );
+    assert( taps > 0 );
+
+    sf.tap.reset( new (std::nothrow) FilterTap[ dest * taps ] );
+    if ( !sf.tap )
+        return E_OUTOFMEMORY;
+
+    memset( sf.tap.get(), 0, sizeof(FilterTap) * dest * taps );
+
+    sf.source = source;
+    sf.dest = dest;
+    sf.taps = taps;
+
+    return S_OK;
+}
+
+inline HRESULT _CreateSeparableIdentity( _In_ size_t size, _Inout_ SeparableFilter& sf )
+{
+    HRESULT hr = _AllocateSeparableFilter( size, size, 1, sf );
+    if ( FAILED(hr) )
+        return hr;
+
+    for( size_t u = 0; u < size; ++u )
+    {
+        sf.tap[ u ].u = u;
+        sf.tap[ u ].weight = 1.f;
+    }
+
+    return S_OK;
+}
+
+inline HRESULT _CreateSeparableBox( _In_ size_t source, _In_ size_t dest, _Inout_ SeparableFilter& sf )
+{
+    // Box filtering is only used for exact halving (or a single texel that can't be halved)
+    assert( dest == ( (source > 1) ? (source >> 1) : 1 ) );
+
+    HRESULT hr = _AllocateSeparableFilter( source, dest, 2, sf );
+    if ( FAILED(hr) )
+        return hr;
+
+    for( size_t u = 0; u < dest; ++u )
+    {
+        FilterTap* tap = &sf.tap[ u * 2 ];
+        tap[0].u = std::min<size_t>( u * 2, source - 1 );
+        tap[0].weight = 0.5f;
+        tap[1].u = std::min<size_t>( u * 2 + 1, source - 1 );
+        tap[1].weight = 0.5f;
+    }
+
+    return S_OK;
+}
+
+inline HRESULT _CreateSeparableLinear( _In_ size_t source, _In_ size_t dest, _In_ bool wrap, _Inout_ SeparableFilter& sf )
+{
+    std::unique_ptr<LinearFilter[]> lf( new (std::nothrow) LinearFilter[ dest ] );
+    if ( !lf )
+        return E_OUTOFMEMORY;
+
+    _CreateLinearFilter( source, dest, wrap, lf.get() );
+
+    HRESULT hr = _AllocateSeparableFilter( source, dest, 2, sf );
+    if ( FAILED(hr) )
+        return hr;
+
+    for( size_t u = 0; u < dest; ++u )
+    {
+        FilterTap* tap = &sf.tap[ u * 2 ];
+        tap[0].u = lf[ u ].u0;
+        tap[0].weight = lf[ u ].weight0;
+        tap[1].u = lf[ u ].u1;
+        tap[1].weight = lf[ u ].weight1;
+    }
+
+    return S_OK;
+}
+
+inline HRESULT _CreateSeparableCubic( _In_ size_t source, _In_ size_t dest, _In_ bool wrap, _In_ bool mirror, _Inout_ SeparableFilter& sf )
+{
+    std::unique_ptr<CubicFilter[]> cf( new (std::nothrow) CubicFilter[ dest ] );
+    if ( !cf )
+        return E_OUTOFMEMORY;
+
+    _CreateCubicFilter( source, dest, wrap, mirror, cf.get() );
+
+    HRESULT hr = _AllocateSeparableFilter( source, dest, 4, sf );
+    if ( FAILED(hr) )
+        return hr;
+
+    for( size_t u = 0; u < dest; ++u )
+    {
+        // Weights of p0..p3 in CUBIC_INTERPOLATE
+        float x = cf[ u ].x;
+        float x2 = x * x;
+        float x3 = x2 * x;
+
+        float w0 = -x/3.f + x2/2.f - x3/6.f;
+        float w2 = x + x2/2.f - x3/2.f;
+        float w3 = -x/6.f + x3/6.f;
+
+        FilterTap* tap = &sf.tap[ u * 4 ];
+        tap[0].u = cf[ u ].u0;
+        tap[0].weight = w0;
+        tap[1].u = cf[ u ].u1;
+        tap[1].weight = 1.f - w0 - w2 - w3;
+        tap[2].u = cf[ u ].u2;
+        tap[2].weight = w2;
+        tap[3].u = cf[ u ].u3;
+        tap[3].weight = w3;
+    }
+
+    return S_OK;
+}
+
+inline HRESULT _CreateSeparableTriangle( _In_ size_t source, _In_ size_t dest, _In_ bool wrap, _Inout_ SeparableFilter& sf )
+{
+    using namespace TriangleFilter;
+
+    std::unique_ptr<Filter> tf;
+    HRESULT hr = _Create( source, dest, wrap, tf );
+    if ( FAILED(hr) )
+        return hr;
+
+    auto fromEnd = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( tf.get() ) + tf->sizeInBytes );
+
+    // The triangle filter is built source-to-destination, so transpose it
+    std::unique_ptr<size_t[]> count( new (std::nothrow) size_t[ dest ] );
+    if ( !count )
+        return E_OUTOFMEMORY;
+
+    memset( count.get(), 0, sizeof(size_t) * dest );
+
+    size_t taps = 1;
+    for( const FilterFrom* from = tf->from; from < fromEnd; )
+    {
+        for( size_t j = 0; j < from->count; ++j )
+        {
+            size_t u = from->to[ j ].u;
+            if ( u >= dest )
+                return E_FAIL;
+
+            taps = std::max<size_t>( taps, ++count[ u ] );
+        }
+
+        from = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( from ) + from->sizeInBytes );
+    }
+
+    hr = _AllocateSeparableFilter( source, dest, taps, sf );
+    if ( FAILED(hr) )
+        return hr;
+
+    memset( count.get(), 0, sizeof(size_t) * dest );
+
+    size_t x = 0;
+    for( const FilterFrom* from = tf->from; from < fromEnd; ++x )
+    {
+        for( size_t j = 0; j < from->count; ++j )
+        {
+            size_t u = from->to[ j ].u;
+
+            FilterTap& tap = sf.tap[ u * taps + count[ u ]++ ];
+            tap.u = x;
+            tap.weight = from->to[ j ].weight;
+        }
+
+        from = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( from ) + from->sizeInBytes );
+    }
+
+    return S_OK;
+}
+
+//-------------------------------------------------------------------------------------
+// Windowed sinc filters (Lanczos, Kaiser)
+//
+// The kernel is stretched by the reduction factor when minifying, so the number of taps
+// grows with it. Weights are computed once per destination texel and normalized
+//-------------------------------------------------------------------------------------
+
+namespace WindowedSinc
+{
+    const double LANCZOS_RADIUS = 3.0;
+
+    const double KAISER_RADIUS = 3.0;
+    const double KAISER_ALPHA = 4.0;
+
+    inline double _Sinc( double x )
+    {
+        if ( fabs( x ) < 1e-8 )
+            return 1.0;
+
+        x *= 3.14159265358979323846;
+        return sin( x ) / x;
+    }
+
+    // Zeroth order modified Bessel function of the first kind
+    inline double _BesselI0( double x )
+    {
+        const double y = x * x * 0.25;
+
+        double sum = 1.0;
+        double term = 1.0;
+        for( size_t k = 1; k < 64; ++k )
+        {
+            term *= y / double( k * k );
+            sum += term;
+
+            if ( term < ( sum * 1e-12 ) )
+                break;
+        }
+
+        return sum;
+    }
+
+    inline double _Lanczos( double x )
+    {
+        if ( fabs( x ) >= LANCZOS_RADIUS )
+            return 0.0;
+
+        return _Sinc( x ) * _Sinc( x / LANCZOS_RADIUS );
+    }
+
+    inline double _Kaiser( double x )
+    {
+        const double t = x / KAISER_RADIUS;
+        if ( fabs( t ) >= 1.0 )
+            return 0.0;
+
+        return _Sinc( x ) * _BesselI0( KAISER_ALPHA * sqrt( 1.0 - t * t ) ) / _BesselI0( KAISER_ALPHA );
+    }
+
+    // The support can span several periods of a small source, so unlike bounduvw this wraps
+    // and mirrors any offset rather than folding only one period
+    inline size_t _AddressTap( ptrdiff_t j, ptrdiff_t n, bool wrap, bool mirror )
+    {
+        if ( wrap )
+            return size_t( ( ( j % n ) + n ) % n );
+
+        if ( mirror )
+        {
+            // Mirroring repeats the edge texel, so the pattern has a period of 2n
+            const ptrdiff_t period = n * 2;
+            const ptrdiff_t m = ( ( j % period ) + period ) % period;
+            return size_t( ( m < n ) ? m : ( period - 1 - m ) );
+        }
+
+        return size_t( std::min<ptrdiff_t>( std::max<ptrdiff_t>( j, 0 ), n - 1 ) );
+    }
+}; // namespace
+
+inline HRESULT _CreateSeparableWindowedSinc( _In_ size_t source, _In_ size_t dest, _In_ bool wrap, _In_ bool mirror, _In_ bool kaiser,
+                                             _Inout_ SeparableFilter& sf )
+{
+    using namespace WindowedSinc;
+
+    assert( source > 0 );
+    assert( dest > 0 );
+
+    const double scale = double(source) / double(dest);
+    const double stretch = std::max<double>( scale, 1.0 );
+    const double support = ( kaiser ? KAISER_RADIUS : LANCZOS_RADIUS ) * stretch;
+
+    const size_t taps = size_t( ceil( support * 2.0 ) ) + 1;
+
+    HRESULT hr = _AllocateSeparableFilter( source, dest, taps, sf );
+    if ( FAILED(hr) )
+        return hr;
+
+    for( size_t u = 0; u < dest; ++u )
+    {
+        const double center = ( double(u) + 0.5 ) * scale - 0.5;
+
+        // First source texel strictly inside the support; taps past the far edge get zero weight
+        ptrdiff_t j = ptrdiff_t( floor( center - support ) ) + 1;
+
+        FilterTap* tap = &sf.tap[ u * taps ];
+
+        double total = 0.0;
+        for( size_t k = 0; k < taps; ++k, ++j )
+        {
+            const double x = ( double(j) - center ) / stretch;
+            const double weight = ( kaiser ) ? _Kaiser( x ) : _Lanczos( x );
+
+            tap[ k ].u = _AddressTap( j, ptrdiff_t(source), wrap, mirror );
+            tap[ k ].weight = float( weight );
+            total += weight;
+        }
+
+        if ( total != 0.0 )
+        {
+            const float norm = float( 1.0 / total );
+            for( size_t k = 0; k < taps; ++k )
+            {
+                tap[ k ].weight *= norm;
+            }
+        }
+    }
+
+    return S_OK;
+}
+
+inline HRESULT _CreateSeparableFilter( _In_ DWORD filter, _In_ size_t source, _In_ size_t dest, _In_ bool wrap, _In_ bool mirror,
+                                       _Inout_ SeparableFilter& sf )
+{
+    switch( filter & TEX_FILTER_MASK )
+    {
+    case TEX_FILTER_BOX:
+        return _CreateSeparableBox( source, dest, sf );
+
+    case TEX_FILTER_LINEAR:
+        return _CreateSeparableLinear( source, dest, wrap, sf );
+
+    case TEX_FILTER_CUBIC:
+        return _CreateSeparableCubic( source, dest, wrap, mirror, sf );
+
+    case TEX_FILTER_TRIANGLE:
+        return _CreateSeparableTriangle( source, dest, wrap, sf );
+
+    case TEX_FILTER_LANCZOS:
+        return _CreateSeparableWindowedSinc( source, dest, wrap, mirror, false, sf );
+
+    case TEX_FILTER_KAISER:
+        return _CreateSeparableWindowedSinc( source, dest, wrap, mirror, true, sf );
+
+    default:
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+    }
+}
+
 }; // namespace
\ No newline at end of file
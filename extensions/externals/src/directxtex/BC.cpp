@@ -21,6 +21,12 @@
 
 #include "BC.h"
 
+#if defined(_XM_SSE_INTRINSICS_) && !defined(COLOR_WEIGHTS)
+// Batch encoders run the BC1 endpoint search in SIMD lanes (SSE2, or AVX when available)
+#define BC_USE_LANES
+#include <immintrin.h>
+#endif
+
 using namespace DirectX::PackedVector;
 
 namespace DirectX
@@ -319,9 +325,324 @@ static void OptimizeRGB(_Out_ HDRColorA *pX, _Out_ HDRColorA *pY,
 
 
 //-------------------------------------------------------------------------------------
-inline static void DecodeBC1( _Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor, _In_ const D3DX_BC1 *pBC, _In_ bool isbc1 )
+// SIMD lanes version of OptimizeRGB
+//
+// Runs the endpoint search for several blocks at once, with one block per SIMD lane.
+// Each lane performs the same floating-point operations in the same order as the
+// scalar OptimizeRGB, and the early-outs become per-lane masks, so the endpoints are
+// bit-identical to the single-block path. That relies on the compiler keeping the
+// operation order, so this file is built with /fp:precise rather than /fp:fast.
+//-------------------------------------------------------------------------------------
+#ifdef BC_USE_LANES
+
+struct BC1Lanes
 {
-    assert( pColor && pBC );
+    // Structure-of-arrays copy of the quantized (and weighted) block colors
+    float r[NUM_PIXELS_PER_BLOCK][NUM_BLOCKS_PER_BATCH];
+    float g[NUM_PIXELS_PER_BLOCK][NUM_BLOCKS_PER_BATCH];
+    float b[NUM_PIXELS_PER_BLOCK][NUM_BLOCKS_PER_BATCH];
+    float steps[NUM_BLOCKS_PER_BATCH];  // cSteps - 1
+
+    // Resulting endpoints
+    float xr[NUM_BLOCKS_PER_BATCH], xg[NUM_BLOCKS_PER_BATCH], xb[NUM_BLOCKS_PER_BATCH];
+    float yr[NUM_BLOCKS_PER_BATCH], yg[NUM_BLOCKS_PER_BATCH], yb[NUM_BLOCKS_PER_BATCH];
+};
+
+struct LanesSSE
+{
+    static const size_t Count = 4;
+    typedef __m128 Vec;
+
+    static Vec Load( const float* p ) { return _mm_loadu_ps( p ); }
+    static void Store( float* p, Vec v ) { _mm_storeu_ps( p, v ); }
+    static Vec Splat( float f ) { return _mm_set1_ps( f ); }
+    static Vec Add( Vec a, Vec b ) { return _mm_add_ps( a, b ); }
+    static Vec Sub( Vec a, Vec b ) { return _mm_sub_ps( a, b ); }
+    static Vec Mul( Vec a, Vec b ) { return _mm_mul_ps( a, b ); }
+    static Vec Div( Vec a, Vec b ) { return _mm_div_ps( a, b ); }
+    static Vec Min( Vec a, Vec b ) { return _mm_min_ps( a, b ); }   // (a < b) ? a : b
+    static Vec Max( Vec a, Vec b ) { return _mm_max_ps( a, b ); }   // (a > b) ? a : b
+    static Vec Less( Vec a, Vec b ) { return _mm_cmplt_ps( a, b ); }
+    static Vec NotLess( Vec a, Vec b ) { return _mm_cmpnlt_ps( a, b ); }
+    static Vec LessEqual( Vec a, Vec b ) { return _mm_cmple_ps( a, b ); }
+    static Vec Greater( Vec a, Vec b ) { return _mm_cmpgt_ps( a, b ); }
+    static Vec GreaterEqual( Vec a, Vec b ) { return _mm_cmpge_ps( a, b ); }
+    static Vec Equal( Vec a, Vec b ) { return _mm_cmpeq_ps( a, b ); }
+    static Vec And( Vec a, Vec b ) { return _mm_and_ps( a, b ); }
+    static Vec AndNot( Vec a, Vec b ) { return _mm_andnot_ps( b, a ); }  // a & ~b
+    static Vec Or( Vec a, Vec b ) { return _mm_or_ps( a, b ); }
+    static Vec Select( Vec mask, Vec a, Vec b ) { return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) ); }
+    static Vec Truncate( Vec a ) { return _mm_cvtepi32_ps( _mm_cvttps_epi32( a ) ); }
+    static bool Any( Vec mask ) { return _mm_movemask_ps( mask ) != 0; }
+    static void End() {}
+};
+
+struct LanesAVX
+{
+    static const size_t Count = 8;
+    typedef __m256 Vec;
+
+    static Vec Load( const float* p ) { return _mm256_loadu_ps( p ); }
+    static void Store( float* p, Vec v ) { _mm256_storeu_ps( p, v ); }
+    static Vec Splat( float f ) { return _mm256_set1_ps( f ); }
+    static Vec Add( Vec a, Vec b ) { return _mm256_add_ps( a, b ); }
+    static Vec Sub( Vec a, Vec b ) { return _mm256_sub_ps( a, b ); }
+    static Vec Mul( Vec a, Vec b ) { return _mm256_mul_ps( a, b ); }
+    static Vec Div( Vec a, Vec b ) { return _mm256_div_ps( a, b ); }
+    static Vec Min( Vec a, Vec b ) { return _mm256_min_ps( a, b ); }
+    static Vec Max( Vec a, Vec b ) { return _mm256_max_ps( a, b ); }
+    static Vec Less( Vec a, Vec b ) { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+    static Vec NotLess( Vec a, Vec b ) { return _mm256_cmp_ps( a, b, _CMP_NLT_UQ ); }
+    static Vec LessEqual( Vec a, Vec b ) { return _mm256_cmp_ps( a, b, _CMP_LE_OQ ); }
+    static Vec Greater( Vec a, Vec b ) { return _mm256_cmp_ps( a, b, _CMP_GT_OQ ); }
+    static Vec GreaterEqual( Vec a, Vec b ) { return _mm256_cmp_ps( a, b, _CMP_GE_OQ ); }
+    static Vec Equal( Vec a, Vec b ) { return _mm256_cmp_ps( a, b, _CMP_EQ_OQ ); }
+    static Vec And( Vec a, Vec b ) { return _mm256_and_ps( a, b ); }
+    static Vec AndNot( Vec a, Vec b ) { return _mm256_andnot_ps( b, a ); }
+    static Vec Or( Vec a, Vec b ) { return _mm256_or_ps( a, b ); }
+    static Vec Select( Vec mask, Vec a, Vec b ) { return _mm256_or_ps( _mm256_and_ps( mask, a ), _mm256_andnot_ps( mask, b ) ); }
+    static Vec Truncate( Vec a ) { return _mm256_cvtepi32_ps( _mm256_cvttps_epi32( a ) ); }
+    static bool Any( Vec mask ) { return _mm256_movemask_ps( mask ) != 0; }
+    static void End() { _mm256_zeroupper(); }
+};
+
+static const bool g_SupportsAVX = _IsAVXSupported();
+
+template <class L>
+static void OptimizeRGBLanes(_Inout_ BC1Lanes& lanes, _In_ size_t offset, _In_ DWORD flags)
+{
+    typedef typename L::Vec Vec;
+
+    assert( offset + L::Count <= NUM_BLOCKS_PER_BATCH );
+
+    const Vec vZero = L::Splat( 0.0f );
+    const Vec vEpsilon = L::Splat( (0.25f / 64.0f) * (0.25f / 64.0f) );
+    const Vec vLenMin = L::Splat( 1.0f / 4096.0f );
+    const Vec vEighth = L::Splat( 1.0f / 8.0f );
+
+    // Per-lane step weights, as each block may use either 3 or 4 steps
+    const Vec fSteps = L::Load( &lanes.steps[offset] );
+    const Vec is3 = L::Equal( fSteps, L::Splat( 2.0f ) );
+
+    Vec pC[4], pD[4];
+    pC[0] = L::Select( is3, L::Splat( 2.0f/2.0f ), L::Splat( 3.0f/3.0f ) );
+    pC[1] = L::Select( is3, L::Splat( 1.0f/2.0f ), L::Splat( 2.0f/3.0f ) );
+    pC[2] = L::Select( is3, L::Splat( 0.0f/2.0f ), L::Splat( 1.0f/3.0f ) );
+    pC[3] = L::Select( is3, vZero,                 L::Splat( 0.0f/3.0f ) );
+    pD[0] = L::Select( is3, L::Splat( 0.0f/2.0f ), L::Splat( 0.0f/3.0f ) );
+    pD[1] = L::Select( is3, L::Splat( 1.0f/2.0f ), L::Splat( 1.0f/3.0f ) );
+    pD[2] = L::Select( is3, L::Splat( 2.0f/2.0f ), L::Splat( 2.0f/3.0f ) );
+    pD[3] = L::Select( is3, vZero,                 L::Splat( 3.0f/3.0f ) );
+
+    // Find Min and Max points, as starting point
+    Vec Xr, Xg, Xb;
+    if ( flags & BC_FLAGS_UNIFORM )
+    {
+        Xr = Xg = Xb = L::Splat( 1.0f );
+    }
+    else
+    {
+        Xr = L::Splat( g_Luminance.r );
+        Xg = L::Splat( g_Luminance.g );
+        Xb = L::Splat( g_Luminance.b );
+    }
+
+    Vec Yr = vZero;
+    Vec Yg = vZero;
+    Vec Yb = vZero;
+
+    for(size_t iPoint = 0; iPoint < NUM_PIXELS_PER_BLOCK; iPoint++)
+    {
+        Vec Pr = L::Load( &lanes.r[iPoint][offset] );
+        Vec Pg = L::Load( &lanes.g[iPoint][offset] );
+        Vec Pb = L::Load( &lanes.b[iPoint][offset] );
+
+        Xr = L::Min( Pr, Xr );
+        Xg = L::Min( Pg, Xg );
+        Xb = L::Min( Pb, Xb );
+
+        Yr = L::Max( Pr, Yr );
+        Yg = L::Max( Pg, Yg );
+        Yb = L::Max( Pb, Yb );
+    }
+
+    // Diagonal axis
+    Vec ABr = L::Sub( Yr, Xr );
+    Vec ABg = L::Sub( Yg, Xg );
+    Vec ABb = L::Sub( Yb, Xb );
+
+    Vec fAB = L::Add( L::Add( L::Mul( ABr, ABr ), L::Mul( ABg, ABg ) ), L::Mul( ABb, ABb ) );
+
+    // Single color blocks keep the min/max points
+    const Vec solid = L::Less( fAB, L::Splat( FLT_MIN ) );
+    const Vec Xr0 = Xr, Xg0 = Xg, Xb0 = Xb;
+    const Vec Yr0 = Yr, Yg0 = Yg, Yb0 = Yb;
+
+    // Try all four axis directions, to determine which diagonal best fits data
+    Vec fABInv = L::Div( L::Splat( 1.0f ), fAB );
+
+    Vec Dirr = L::Mul( ABr, fABInv );
+    Vec Dirg = L::Mul( ABg, fABInv );
+    Vec Dirb = L::Mul( ABb, fABInv );
+
+    Vec Midr = L::Mul( L::Add( Xr, Yr ), L::Splat( 0.5f ) );
+    Vec Midg = L::Mul( L::Add( Xg, Yg ), L::Splat( 0.5f ) );
+    Vec Midb = L::Mul( L::Add( Xb, Yb ), L::Splat( 0.5f ) );
+
+    Vec fDir[4];
+    fDir[0] = fDir[1] = fDir[2] = fDir[3] = vZero;
+
+    for(size_t iPoint = 0; iPoint < NUM_PIXELS_PER_BLOCK; iPoint++)
+    {
+        Vec Ptr = L::Mul( L::Sub( L::Load( &lanes.r[iPoint][offset] ), Midr ), Dirr );
+        Vec Ptg = L::Mul( L::Sub( L::Load( &lanes.g[iPoint][offset] ), Midg ), Dirg );
+        Vec Ptb = L::Mul( L::Sub( L::Load( &lanes.b[iPoint][offset] ), Midb ), Dirb );
+
+        Vec f;
+
+        f = L::Add( L::Add( Ptr, Ptg ), Ptb );
+        fDir[0] = L::Add( fDir[0], L::Mul( f, f ) );
+
+        f = L::Sub( L::Add( Ptr, Ptg ), Ptb );
+        fDir[1] = L::Add( fDir[1], L::Mul( f, f ) );
+
+        f = L::Add( L::Sub( Ptr, Ptg ), Ptb );
+        fDir[2] = L::Add( fDir[2], L::Mul( f, f ) );
+
+        f = L::Sub( L::Sub( Ptr, Ptg ), Ptb );
+        fDir[3] = L::Add( fDir[3], L::Mul( f, f ) );
+    }
+
+    Vec fDirMax = fDir[0];
+    Vec iDirMax = vZero;
+
+    for(size_t iDir = 1; iDir < 4; iDir++)
+    {
+        Vec m = L::Greater( fDir[iDir], fDirMax );
+        fDirMax = L::Select( m, fDir[iDir], fDirMax );
+        iDirMax = L::Select( m, L::Splat( float(iDir) ), iDirMax );
+    }
+
+    const Vec dir3 = L::Equal( iDirMax, L::Splat( 3.0f ) );
+
+    Vec swap = L::Or( L::Equal( iDirMax, L::Splat( 2.0f ) ), dir3 );
+    Vec f = Xg;
+    Xg = L::Select( swap, Yg, Xg );
+    Yg = L::Select( swap, f, Yg );
+
+    swap = L::Or( L::Equal( iDirMax, L::Splat( 1.0f ) ), dir3 );
+    f = Xb;
+    Xb = L::Select( swap, Yb, Xb );
+    Yb = L::Select( swap, f, Yb );
+
+    // Two color blocks (and single color blocks) don't need to root-find
+    Vec active = L::NotLess( fAB, vLenMin );
+
+    // Use Newton's Method to find local minima of sum-of-squares error.
+    for(size_t iIteration = 0; iIteration < 8 && L::Any( active ); iIteration++)
+    {
+        // Calculate color direction
+        Dirr = L::Sub( Yr, Xr );
+        Dirg = L::Sub( Yg, Xg );
+        Dirb = L::Sub( Yb, Xb );
+
+        Vec fLen = L::Add( L::Add( L::Mul( Dirr, Dirr ), L::Mul( Dirg, Dirg ) ), L::Mul( Dirb, Dirb ) );
+
+        active = L::And( active, L::NotLess( fLen, vLenMin ) );
+        if ( !L::Any( active ) )
+            break;
+
+        Vec fScale = L::Div( fSteps, fLen );
+
+        Dirr = L::Mul( Dirr, fScale );
+        Dirg = L::Mul( Dirg, fScale );
+        Dirb = L::Mul( Dirb, fScale );
+
+        // Evaluate function, and derivatives
+        Vec d2X = vZero, dXr = vZero, dXg = vZero, dXb = vZero;
+        Vec d2Y = vZero, dYr = vZero, dYg = vZero, dYb = vZero;
+
+        for(size_t iPoint = 0; iPoint < NUM_PIXELS_PER_BLOCK; iPoint++)
+        {
+            Vec Pr = L::Load( &lanes.r[iPoint][offset] );
+            Vec Pg = L::Load( &lanes.g[iPoint][offset] );
+            Vec Pb = L::Load( &lanes.b[iPoint][offset] );
+
+            Vec fDot = L::Add( L::Add( L::Mul( L::Sub( Pr, Xr ), Dirr ),
+                                       L::Mul( L::Sub( Pg, Xg ), Dirg ) ),
+                                       L::Mul( L::Sub( Pb, Xb ), Dirb ) );
+
+            Vec iStep = L::Truncate( L::Add( fDot, L::Splat( 0.5f ) ) );
+            iStep = L::Select( L::GreaterEqual( fDot, fSteps ), fSteps, iStep );
+            iStep = L::Select( L::LessEqual( fDot, vZero ), vZero, iStep );
+
+            Vec C = pC[0], D = pD[0];
+
+            for(size_t k = 1; k < 4; k++)
+            {
+                Vec m = L::Equal( iStep, L::Splat( float(k) ) );
+                C = L::Select( m, pC[k], C );
+                D = L::Select( m, pD[k], D );
+            }
+
+            // Same expression as the step colors in the scalar path, just evaluated per point
+            Vec Diffr = L::Sub( L::Add( L::Mul( Xr, C ), L::Mul( Yr, D ) ), Pr );
+            Vec Diffg = L::Sub( L::Add( L::Mul( Xg, C ), L::Mul( Yg, D ) ), Pg );
+            Vec Diffb = L::Sub( L::Add( L::Mul( Xb, C ), L::Mul( Yb, D ) ), Pb );
+
+            Vec fC = L::Mul( C, vEighth );
+            Vec fD = L::Mul( D, vEighth );
+
+            d2X = L::Add( d2X, L::Mul( fC, C ) );
+            dXr = L::Add( dXr, L::Mul( fC, Diffr ) );
+            dXg = L::Add( dXg, L::Mul( fC, Diffg ) );
+            dXb = L::Add( dXb, L::Mul( fC, Diffb ) );
+
+            d2Y = L::Add( d2Y, L::Mul( fD, D ) );
+            dYr = L::Add( dYr, L::Mul( fD, Diffr ) );
+            dYg = L::Add( dYg, L::Mul( fD, Diffg ) );
+            dYb = L::Add( dYb, L::Mul( fD, Diffb ) );
+        }
+
+        // Move endpoints
+        Vec m = L::And( active, L::Greater( d2X, vZero ) );
+        f = L::Div( L::Splat( -1.0f ), d2X );
+
+        Xr = L::Select( m, L::Add( Xr, L::Mul( dXr, f ) ), Xr );
+        Xg = L::Select( m, L::Add( Xg, L::Mul( dXg, f ) ), Xg );
+        Xb = L::Select( m, L::Add( Xb, L::Mul( dXb, f ) ), Xb );
+
+        m = L::And( active, L::Greater( d2Y, vZero ) );
+        f = L::Div( L::Splat( -1.0f ), d2Y );
+
+        Yr = L::Select( m, L::Add( Yr, L::Mul( dYr, f ) ), Yr );
+        Yg = L::Select( m, L::Add( Yg, L::Mul( dYg, f ) ), Yg );
+        Yb = L::Select( m, L::Add( Yb, L::Mul( dYb, f ) ), Yb );
+
+        Vec done = L::And( L::And( L::Less( L::Mul( dXr, dXr ), vEpsilon ), L::Less( L::Mul( dXg, dXg ), vEpsilon ) ),
+                           L::And( L::Less( L::Mul( dXb, dXb ), vEpsilon ), L::Less( L::Mul( dYr, dYr ), vEpsilon ) ) );
+        done = L::And( done, L::And( L::Less( L::Mul( dYg, dYg ), vEpsilon ), L::Less( L::Mul( dYb, dYb ), vEpsilon ) ) );
+
+        active = L::AndNot( active, done );
+    }
+
+    L::Store( &lanes.xr[offset], L::Select( solid, Xr0, Xr ) );
+    L::Store( &lanes.xg[offset], L::Select( solid, Xg0, Xg ) );
+    L::Store( &lanes.xb[offset], L::Select( solid, Xb0, Xb ) );
+    L::Store( &lanes.yr[offset], L::Select( solid, Yr0, Yr ) );
+    L::Store( &lanes.yg[offset], L::Select( solid, Yg0, Yg ) );
+    L::Store( &lanes.yb[offset], L::Select( solid, Yb0, Yb ) );
+
+    L::End();
+}
+
+#endif // BC_USE_LANES
+
+
+//-------------------------------------------------------------------------------------
+inline static void DecodeBC1Palette( _Out_writes_(4) XMVECTOR *pPalette, _In_ const D3DX_BC1 *pBC, _In_ bool isbc1 )
+{
+    assert( pPalette && pBC );
     static_assert( sizeof(D3DX_BC1) == 8, "D3DX_BC1 should be 8 bytes" );
 
     static XMVECTORF32 s_Scale = { 1.f/31.f, 1.f/63.f, 1.f/31.f, 1.f };
@@ -338,46 +659,78 @@ inline static void DecodeBC1( _Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColo
     clr0 = XMVectorSelect( g_XMIdentityR3, clr0, g_XMSelect1110 );
     clr1 = XMVectorSelect( g_XMIdentityR3, clr1, g_XMSelect1110 );
 
-    XMVECTOR clr2, clr3;
+    pPalette[0] = clr0;
+    pPalette[1] = clr1;
+
     if ( isbc1 && (pBC->rgb[0] <= pBC->rgb[1]) )
     {
-        clr2 = XMVectorLerp( clr0, clr1, 0.5f );
-        clr3 = XMVectorZero();  // Alpha of 0
+        pPalette[2] = XMVectorLerp( clr0, clr1, 0.5f );
+        pPalette[3] = XMVectorZero();  // Alpha of 0
     }
     else
     {
-        clr2 = XMVectorLerp( clr0, clr1, 1.f/3.f );
-        clr3 = XMVectorLerp( clr0, clr1, 2.f/3.f );
+        pPalette[2] = XMVectorLerp( clr0, clr1, 1.f/3.f );
+        pPalette[3] = XMVectorLerp( clr0, clr1, 2.f/3.f );
     }
+}
+
+inline static void DecodeBC1( _Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor, _In_ const D3DX_BC1 *pBC, _In_ bool isbc1 )
+{
+    XMVECTOR palette[4];
+    DecodeBC1Palette( palette, pBC, isbc1 );
 
     uint32_t dw = pBC->bitmap;
 
     for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 2)
     {
-        switch(dw & 3)
-        {
-        case 0: pColor[i] = clr0; break;
-        case 1: pColor[i] = clr1; break;
-        case 2: pColor[i] = clr2; break;
+        pColor[i] = palette[dw & 3];
+    }
+}
 
-        case 3:
-        default: pColor[i] = clr3; break;
-        }
+inline static void DecodeBC1Indices( _Out_writes_(NUM_PIXELS_PER_BLOCK) uint8_t *pIndices, _In_ const D3DX_BC1 *pBC )
+{
+    uint32_t dw = pBC->bitmap;
+
+    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 2)
+    {
+        pIndices[i] = static_cast<uint8_t>( dw & 3 );
     }
 }
 
 
 //-------------------------------------------------------------------------------------
+inline static void DecodeBC3AlphaPalette( _Out_writes_(8) float *fAlpha, _In_ const D3DX_BC3 *pBC3 )
+{
+    fAlpha[0] = ((float) pBC3->alpha[0]) * (1.0f / 255.0f);
+    fAlpha[1] = ((float) pBC3->alpha[1]) * (1.0f / 255.0f);
 
-static void EncodeBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA *pColor,
-                      _In_ bool bColorKey, _In_ float alphaRef, _In_ DWORD flags)
+    if(pBC3->alpha[0] > pBC3->alpha[1]) 
+    {
+        for(size_t i = 1; i < 7; ++i)
+            fAlpha[i + 1] = (fAlpha[0] * (7 - i) + fAlpha[1] * i) * (1.0f / 7.0f);
+    }
+    else 
+    {
+        for(size_t i = 1; i < 5; ++i)
+            fAlpha[i + 1] = (fAlpha[0] * (5 - i) + fAlpha[1] * i) * (1.0f / 5.0f);
+
+        fAlpha[6] = 0.0f;
+        fAlpha[7] = 1.0f;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// Determines the step count and quantizes the block prior to the endpoint search. Returns false if
+// the block was fully color-keyed and has already been written out.
+static bool PrepareBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA *pColor,
+                       _In_ bool bColorKey, _In_ float alphaRef, _In_ DWORD flags,
+                       _Out_writes_(NUM_PIXELS_PER_BLOCK) HDRColorA *Color, _Out_ size_t& uSteps)
 {
-    assert( pBC && pColor );
+    assert( pBC && pColor && Color );
     static_assert( sizeof(D3DX_BC1) == 8, "D3DX_BC1 should be 8 bytes" );
 
     // Determine if we need to colorkey this block
-    size_t uSteps;
-    
     if (bColorKey)
     {
         size_t uColorKey = 0;
@@ -393,7 +746,8 @@ static void EncodeBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) cons
             pBC->rgb[0] = 0x0000;
             pBC->rgb[1] = 0xffff;
             pBC->bitmap = 0xffffffff;
-            return;
+            uSteps = 0;
+            return false;
         }
 
         uSteps = (uColorKey > 0) ? 3 : 4;
@@ -406,14 +760,12 @@ static void EncodeBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) cons
     // Quantize block to R56B5, using Floyd Stienberg error diffusion.  This 
     // increases the chance that colors will map directly to the quantized 
     // axis endpoints.
-    HDRColorA Color[NUM_PIXELS_PER_BLOCK];
     HDRColorA Error[NUM_PIXELS_PER_BLOCK];
 
     if (flags & BC_FLAGS_DITHER_RGB)
         memset(Error, 0x00, NUM_PIXELS_PER_BLOCK * sizeof(HDRColorA));
 
-    size_t i;
-    for(i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
     {
         HDRColorA Clr;
         Clr.r = pColor[i].r;
@@ -485,11 +837,19 @@ static void EncodeBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) cons
         }
     }
 
-    // Perform 6D root finding function to find two endpoints of color axis.
-    // Then quantize and sort the endpoints depending on mode.
-    HDRColorA ColorA, ColorB, ColorC, ColorD;
+    return true;
+}
 
-    OptimizeRGB(&ColorA, &ColorB, Color, uSteps, flags);
+
+//-------------------------------------------------------------------------------------
+// Quantizes and sorts the endpoints found by OptimizeRGB, then encodes the color indices
+static void FinishBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA *pColor,
+                      _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA *Color, _In_ size_t uSteps,
+                      _In_ HDRColorA ColorA, _In_ HDRColorA ColorB, _In_ float alphaRef, _In_ DWORD flags)
+{
+    assert( pBC && pColor && Color );
+
+    HDRColorA ColorC, ColorD;
 
     if ( flags & BC_FLAGS_UNIFORM )
     {
@@ -591,10 +951,11 @@ static void EncodeBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) cons
 
     // Encode colors
     uint32_t dw = 0;
+    HDRColorA Error[NUM_PIXELS_PER_BLOCK];
     if (flags & BC_FLAGS_DITHER_RGB)
         memset(Error, 0x00, NUM_PIXELS_PER_BLOCK * sizeof(HDRColorA));
 
-    for(i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
     {
         if((3 == uSteps) && (pColor[i].a < alphaRef))
         {
@@ -676,6 +1037,26 @@ static void EncodeBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) cons
     pBC->bitmap = dw;
 }
 
+
+//-------------------------------------------------------------------------------------
+static void EncodeBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA *pColor,
+                      _In_ bool bColorKey, _In_ float alphaRef, _In_ DWORD flags)
+{
+    HDRColorA Color[NUM_PIXELS_PER_BLOCK];
+    size_t uSteps;
+
+    if ( !PrepareBC1(pBC, pColor, bColorKey, alphaRef, flags, Color, uSteps) )
+        return;
+
+    // Perform 6D root finding function to find two endpoints of color axis.
+    // Then quantize and sort the endpoints depending on mode.
+    HDRColorA ColorA, ColorB;
+
+    OptimizeRGB(&ColorA, &ColorB, Color, uSteps, flags);
+
+    FinishBC1(pBC, pColor, Color, uSteps, ColorA, ColorB, alphaRef, flags);
+}
+
 //-------------------------------------------------------------------------------------
 #ifdef COLOR_WEIGHTS
 static void EncodeSolidBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA *pColor)
@@ -711,26 +1092,11 @@ static void EncodeSolidBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK)
 #endif // COLOR_WEIGHTS
 
 
-//=====================================================================================
-// Entry points
-//=====================================================================================
-
-//-------------------------------------------------------------------------------------
-// BC1 Compression
 //-------------------------------------------------------------------------------------
-_Use_decl_annotations_
-void D3DXDecodeBC1(XMVECTOR *pColor, const uint8_t *pBC)
-{
-    auto pBC1 = reinterpret_cast<const D3DX_BC1 *>(pBC);
-    DecodeBC1( pColor, pBC1, true );
-}
-
-_Use_decl_annotations_
-void D3DXEncodeBC1(uint8_t *pBC, const XMVECTOR *pColor, float alphaRef, DWORD flags)
+// Loads a block for BC1 encoding, quantizing alpha to 1 bit if dithering is enabled
+static void LoadBC1(_Out_writes_(NUM_PIXELS_PER_BLOCK) HDRColorA *Color, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ DWORD flags)
 {
-    assert( pBC && pColor );
-
-    HDRColorA Color[NUM_PIXELS_PER_BLOCK];
+    assert( Color && pColor );
 
     if (flags & BC_FLAGS_DITHER_A)
     {
@@ -781,60 +1147,24 @@ void D3DXEncodeBC1(uint8_t *pBC, const XMVECTOR *pColor, float alphaRef, DWORD f
             XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( &Color[i] ), pColor[i] );
         }
     }
-
-    auto pBC1 = reinterpret_cast<D3DX_BC1 *>(pBC);
-    EncodeBC1(pBC1, Color, true, alphaRef, flags);
 }
 
 
 //-------------------------------------------------------------------------------------
-// BC2 Compression
-//-------------------------------------------------------------------------------------
-_Use_decl_annotations_
-void D3DXDecodeBC2(XMVECTOR *pColor, const uint8_t *pBC)
-{
-    assert( pColor && pBC );
-    static_assert( sizeof(D3DX_BC2) == 16, "D3DX_BC2 should be 16 bytes" );
-
-    auto pBC2 = reinterpret_cast<const D3DX_BC2 *>(pBC);
-
-    // RGB part
-    DecodeBC1(pColor, &pBC2->bc1, false);
-
-    // 4-bit alpha part
-    DWORD dw = pBC2->bitmap[0];
-
-    for(size_t i = 0; i < 8; ++i, dw >>= 4)
-    {
-        #pragma prefast(suppress:22103, "writing blocks in two halves confuses tool")
-        pColor[i] = XMVectorSetW( pColor[i], (float) (dw & 0xf) * (1.0f / 15.0f) );
-    }
-
-    dw = pBC2->bitmap[1];
-
-    for(size_t i = 8; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 4)
-        pColor[i] = XMVectorSetW( pColor[i], (float) (dw & 0xf) * (1.0f / 15.0f) );
-}
-
-_Use_decl_annotations_
-void D3DXEncodeBC2(uint8_t *pBC, const XMVECTOR *pColor, DWORD flags)
+// Encodes the adaptive 3-bit alpha part of a BC3 block
+static void EncodeBC3Alpha(_Inout_ D3DX_BC3 *pBC3, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA *Color, _In_ DWORD flags)
 {
-    assert( pBC && pColor );
-    static_assert( sizeof(D3DX_BC2) == 16, "D3DX_BC2 should be 16 bytes" );
-
-    HDRColorA Color[NUM_PIXELS_PER_BLOCK];
-    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
-    {
-        XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( &Color[i] ), pColor[i] );
-    }
+    assert( pBC3 && Color );
 
-    auto pBC2 = reinterpret_cast<D3DX_BC2 *>(pBC);
+    // Quantize block to A8, using Floyd Stienberg error diffusion.  This 
+    // increases the chance that colors will map directly to the quantized 
+    // axis endpoints.
+    float fAlpha[NUM_PIXELS_PER_BLOCK];
+    float fError[NUM_PIXELS_PER_BLOCK];
 
-    // 4-bit alpha part.  Dithered using Floyd Stienberg error diffusion.
-    pBC2->bitmap[0] = 0;
-    pBC2->bitmap[1] = 0;
+    float fMinAlpha = Color[0].a;
+    float fMaxAlpha = Color[0].a;
 
-    float fError[NUM_PIXELS_PER_BLOCK];
     if (flags & BC_FLAGS_DITHER_A)
         memset(fError, 0x00, NUM_PIXELS_PER_BLOCK * sizeof(float));
 
@@ -844,14 +1174,16 @@ void D3DXEncodeBC2(uint8_t *pBC, const XMVECTOR *pColor, DWORD flags)
         if (flags & BC_FLAGS_DITHER_A)
             fAlph += fError[i];
 
-        uint32_t u = (uint32_t) static_cast<int32_t>(fAlph * 15.0f + 0.5f);
-
-        pBC2->bitmap[i >> 3] >>= 4;
-        pBC2->bitmap[i >> 3] |= (u << 28);
+        fAlpha[i] = static_cast<int32_t>(fAlph * 255.0f + 0.5f) * (1.0f / 255.0f);
 
+        if(fAlpha[i] < fMinAlpha)
+            fMinAlpha = fAlpha[i];
+        else if(fAlpha[i] > fMaxAlpha)
+            fMaxAlpha = fAlpha[i];
+    
         if (flags & BC_FLAGS_DITHER_A)
-        {     
-            float fDiff = fAlph - (float) u * (1.0f / 15.0f);
+        {
+            float fDiff = fAlph - fAlpha[i];
 
             if(3 != (i & 3))
             {
@@ -877,133 +1209,8 @@ void D3DXEncodeBC2(uint8_t *pBC, const XMVECTOR *pColor, DWORD flags)
         }
     }
 
-    // RGB part
 #ifdef COLOR_WEIGHTS
-    if(!pBC2->bitmap[0] && !pBC2->bitmap[1])
-    {
-        EncodeSolidBC1(pBC2->dxt1, Color);
-        return;
-    }
-#endif // COLOR_WEIGHTS
-
-    EncodeBC1(&pBC2->bc1, Color, false, 0.f, flags);
-}
-
-
-//-------------------------------------------------------------------------------------
-// BC3 Compression
-//-------------------------------------------------------------------------------------
-_Use_decl_annotations_
-void D3DXDecodeBC3(XMVECTOR *pColor, const uint8_t *pBC)
-{
-    assert( pColor && pBC );
-    static_assert( sizeof(D3DX_BC3) == 16, "D3DX_BC3 should be 16 bytes" );
-
-    auto pBC3 = reinterpret_cast<const D3DX_BC3 *>(pBC);
-
-    // RGB part
-    DecodeBC1(pColor, &pBC3->bc1, false);
-
-    // Adaptive 3-bit alpha part
-    float fAlpha[8];
-
-    fAlpha[0] = ((float) pBC3->alpha[0]) * (1.0f / 255.0f);
-    fAlpha[1] = ((float) pBC3->alpha[1]) * (1.0f / 255.0f);
-
-    if(pBC3->alpha[0] > pBC3->alpha[1]) 
-    {
-        for(size_t i = 1; i < 7; ++i)
-            fAlpha[i + 1] = (fAlpha[0] * (7 - i) + fAlpha[1] * i) * (1.0f / 7.0f);
-    }
-    else 
-    {
-        for(size_t i = 1; i < 5; ++i)
-            fAlpha[i + 1] = (fAlpha[0] * (5 - i) + fAlpha[1] * i) * (1.0f / 5.0f);
-
-        fAlpha[6] = 0.0f;
-        fAlpha[7] = 1.0f;
-    }
-
-    DWORD dw = pBC3->bitmap[0] | (pBC3->bitmap[1] << 8) | (pBC3->bitmap[2] << 16);
-
-    for(size_t i = 0; i < 8; ++i, dw >>= 3)
-        pColor[i] = XMVectorSetW( pColor[i], fAlpha[dw & 0x7] );
-
-    dw = pBC3->bitmap[3] | (pBC3->bitmap[4] << 8) | (pBC3->bitmap[5] << 16);
-
-    for(size_t i = 8; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 3)
-        pColor[i] = XMVectorSetW( pColor[i], fAlpha[dw & 0x7] );
-}
-
-_Use_decl_annotations_
-void D3DXEncodeBC3(uint8_t *pBC, const XMVECTOR *pColor, DWORD flags)
-{
-    assert( pBC && pColor );
-    static_assert( sizeof(D3DX_BC3) == 16, "D3DX_BC3 should be 16 bytes" );
-
-    HDRColorA Color[NUM_PIXELS_PER_BLOCK];
-    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
-    {
-        XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( &Color[i] ), pColor[i] );
-    }
-
-    auto pBC3 = reinterpret_cast<D3DX_BC3 *>(pBC);
-
-    // Quantize block to A8, using Floyd Stienberg error diffusion.  This 
-    // increases the chance that colors will map directly to the quantized 
-    // axis endpoints.
-    float fAlpha[NUM_PIXELS_PER_BLOCK];
-    float fError[NUM_PIXELS_PER_BLOCK];
-
-    float fMinAlpha = Color[0].a;
-    float fMaxAlpha = Color[0].a;
-
-    if (flags & BC_FLAGS_DITHER_A)
-        memset(fError, 0x00, NUM_PIXELS_PER_BLOCK * sizeof(float));
-
-    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
-    {
-        float fAlph = Color[i].a;
-        if (flags & BC_FLAGS_DITHER_A)
-            fAlph += fError[i];
-
-        fAlpha[i] = static_cast<int32_t>(fAlph * 255.0f + 0.5f) * (1.0f / 255.0f);
-
-        if(fAlpha[i] < fMinAlpha)
-            fMinAlpha = fAlpha[i];
-        else if(fAlpha[i] > fMaxAlpha)
-            fMaxAlpha = fAlpha[i];
-    
-        if (flags & BC_FLAGS_DITHER_A)
-        {
-            float fDiff = fAlph - fAlpha[i];
-
-            if(3 != (i & 3))
-            {
-                assert( i < 15 );
-                _Analysis_assume_( i < 15 );
-                fError[i + 1] += fDiff * (7.0f / 16.0f);
-            }
-
-            if(i < 12)
-            {
-                if(i & 3)
-                    fError[i + 3] += fDiff * (3.0f / 16.0f);
-
-                fError[i + 4] += fDiff * (5.0f / 16.0f);
-
-                if(3 != (i & 3))
-                {
-                    assert( i < 11 );
-                    _Analysis_assume_( i < 11 );
-                    fError[i + 5] += fDiff * (1.0f / 16.0f);
-                }
-            }
-        }
-    }
-
-#ifdef COLOR_WEIGHTS
-    if(0.0f == fMaxAlpha)
+    if(0.0f == fMaxAlpha)
     {
         EncodeSolidBC1(&pBC3->dxt1, Color);
         pBC3->alpha[0] = 0x00;
@@ -1012,9 +1219,6 @@ void D3DXEncodeBC3(uint8_t *pBC, const XMVECTOR *pColor, DWORD flags)
     }
 #endif
 
-    // RGB part
-    EncodeBC1(&pBC3->bc1, Color, false, 0.f, flags);
-
     // Alpha part
     if(1.0f == fMinAlpha)
     {
@@ -1138,4 +1342,396 @@ void D3DXEncodeBC3(uint8_t *pBC, const XMVECTOR *pColor, DWORD flags)
     }
 }
 
+
+//-------------------------------------------------------------------------------------
+// Encodes up to NUM_BLOCKS_PER_BATCH BC1 blocks, with the endpoint search for all of
+// them running together in SIMD lanes
+#ifdef BC_USE_LANES
+static void EncodeBC1Lanes(_Out_writes_bytes_(stride*count) uint8_t *pBC, _In_ size_t stride,
+                           _In_reads_(NUM_PIXELS_PER_BLOCK*count) const HDRColorA *pColor, _In_ size_t count,
+                           _In_ bool bColorKey, _In_ float alphaRef, _In_ DWORD flags)
+{
+    assert( pBC && pColor );
+    assert( count > 0 && count <= NUM_BLOCKS_PER_BATCH );
+
+    HDRColorA Color[NUM_BLOCKS_PER_BATCH][NUM_PIXELS_PER_BLOCK];
+    size_t uSteps[NUM_BLOCKS_PER_BATCH];
+    bool bPending[NUM_BLOCKS_PER_BATCH];
+
+    BC1Lanes lanes;
+
+    for(size_t j = 0; j < NUM_BLOCKS_PER_BATCH; ++j)
+    {
+        bPending[j] = (j < count)
+                      && PrepareBC1(reinterpret_cast<D3DX_BC1 *>(pBC + j * stride), &pColor[j * NUM_PIXELS_PER_BLOCK],
+                                    bColorKey, alphaRef, flags, Color[j], uSteps[j]);
+
+        if ( bPending[j] )
+        {
+            for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+            {
+                lanes.r[i][j] = Color[j][i].r;
+                lanes.g[i][j] = Color[j][i].g;
+                lanes.b[i][j] = Color[j][i].b;
+            }
+
+            lanes.steps[j] = (float) (uSteps[j] - 1);
+        }
+        else
+        {
+            // Unused lanes just see a single color block
+            for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+            {
+                lanes.r[i][j] = lanes.g[i][j] = lanes.b[i][j] = 0.0f;
+            }
+
+            lanes.steps[j] = 3.0f;
+        }
+    }
+
+    if ( g_SupportsAVX && count > LanesSSE::Count )
+    {
+        OptimizeRGBLanes<LanesAVX>(lanes, 0, flags);
+    }
+    else
+    {
+        OptimizeRGBLanes<LanesSSE>(lanes, 0, flags);
+
+        if ( count > LanesSSE::Count )
+            OptimizeRGBLanes<LanesSSE>(lanes, LanesSSE::Count, flags);
+    }
+
+    for(size_t j = 0; j < count; ++j)
+    {
+        if ( !bPending[j] )
+            continue;
+
+        HDRColorA ColorA( lanes.xr[j], lanes.xg[j], lanes.xb[j], 1.0f );
+        HDRColorA ColorB( lanes.yr[j], lanes.yg[j], lanes.yb[j], 1.0f );
+
+        FinishBC1(reinterpret_cast<D3DX_BC1 *>(pBC + j * stride), &pColor[j * NUM_PIXELS_PER_BLOCK],
+                  Color[j], uSteps[j], ColorA, ColorB, alphaRef, flags);
+    }
+}
+#endif // BC_USE_LANES
+
+
+//=====================================================================================
+// Entry points
+//=====================================================================================
+
+//-------------------------------------------------------------------------------------
+// BC1 Compression
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void D3DXDecodeBC1(XMVECTOR *pColor, const uint8_t *pBC)
+{
+    auto pBC1 = reinterpret_cast<const D3DX_BC1 *>(pBC);
+    DecodeBC1( pColor, pBC1, true );
+}
+
+_Use_decl_annotations_
+void D3DXDecodeBC1Palette(XMVECTOR *pPalette, uint8_t *pIndices, const uint8_t *pBC)
+{
+    assert( pPalette && pIndices && pBC );
+
+    auto pBC1 = reinterpret_cast<const D3DX_BC1 *>(pBC);
+    DecodeBC1Palette( pPalette, pBC1, true );
+    DecodeBC1Indices( pIndices, pBC1 );
+}
+
+_Use_decl_annotations_
+void D3DXEncodeBC1(uint8_t *pBC, const XMVECTOR *pColor, float alphaRef, DWORD flags)
+{
+    assert( pBC && pColor );
+
+    HDRColorA Color[NUM_PIXELS_PER_BLOCK];
+
+    LoadBC1(Color, pColor, flags);
+
+    auto pBC1 = reinterpret_cast<D3DX_BC1 *>(pBC);
+    EncodeBC1(pBC1, Color, true, alphaRef, flags);
+}
+
+_Use_decl_annotations_
+void D3DXEncodeBC1Batch(uint8_t *pBC, const XMVECTOR *pColor, size_t nBlocks, float alphaRef, DWORD flags)
+{
+    assert( pBC && pColor );
+
+#ifdef BC_USE_LANES
+    if ( !(flags & BC_FLAGS_FORCE_SCALAR) )
+    {
+        HDRColorA Color[NUM_BLOCKS_PER_BATCH * NUM_PIXELS_PER_BLOCK];
+
+        while( nBlocks > 0 )
+        {
+            size_t count = std::min<size_t>( nBlocks, NUM_BLOCKS_PER_BATCH );
+
+            for(size_t j = 0; j < count; ++j)
+            {
+                LoadBC1(&Color[j * NUM_PIXELS_PER_BLOCK], &pColor[j * NUM_PIXELS_PER_BLOCK], flags);
+            }
+
+            EncodeBC1Lanes(pBC, sizeof(D3DX_BC1), Color, count, true, alphaRef, flags);
+
+            pBC += count * sizeof(D3DX_BC1);
+            pColor += count * NUM_PIXELS_PER_BLOCK;
+            nBlocks -= count;
+        }
+        return;
+    }
+#endif // BC_USE_LANES
+
+    for(size_t j = 0; j < nBlocks; ++j)
+    {
+        D3DXEncodeBC1(pBC + j * sizeof(D3DX_BC1), &pColor[j * NUM_PIXELS_PER_BLOCK], alphaRef, flags);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// BC2 Compression
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void D3DXDecodeBC2(XMVECTOR *pColor, const uint8_t *pBC)
+{
+    assert( pColor && pBC );
+    static_assert( sizeof(D3DX_BC2) == 16, "D3DX_BC2 should be 16 bytes" );
+
+    auto pBC2 = reinterpret_cast<const D3DX_BC2 *>(pBC);
+
+    // RGB part
+    DecodeBC1(pColor, &pBC2->bc1, false);
+
+    // 4-bit alpha part
+    DWORD dw = pBC2->bitmap[0];
+
+    for(size_t i = 0; i < 8; ++i, dw >>= 4)
+    {
+        #pragma prefast(suppress:22103, "writing blocks in two halves confuses tool")
+        pColor[i] = XMVectorSetW( pColor[i], (float) (dw & 0xf) * (1.0f / 15.0f) );
+    }
+
+    dw = pBC2->bitmap[1];
+
+    for(size_t i = 8; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 4)
+        pColor[i] = XMVectorSetW( pColor[i], (float) (dw & 0xf) * (1.0f / 15.0f) );
+}
+
+_Use_decl_annotations_
+void D3DXDecodeBC2Palette(XMVECTOR *pPalette, uint8_t *pIndices, float *pAlpha, uint8_t *pAlphaIndices, const uint8_t *pBC)
+{
+    assert( pPalette && pIndices && pAlpha && pAlphaIndices && pBC );
+
+    auto pBC2 = reinterpret_cast<const D3DX_BC2 *>(pBC);
+
+    // RGB part
+    DecodeBC1Palette(pPalette, &pBC2->bc1, false);
+    DecodeBC1Indices(pIndices, &pBC2->bc1);
+
+    // 4-bit alpha part
+    for(size_t i = 0; i < 16; ++i)
+        pAlpha[i] = (float) i * (1.0f / 15.0f);
+
+    DWORD dw = pBC2->bitmap[0];
+
+    for(size_t i = 0; i < 8; ++i, dw >>= 4)
+        pAlphaIndices[i] = static_cast<uint8_t>( dw & 0xf );
+
+    dw = pBC2->bitmap[1];
+
+    for(size_t i = 8; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 4)
+        pAlphaIndices[i] = static_cast<uint8_t>( dw & 0xf );
+}
+
+_Use_decl_annotations_
+void D3DXEncodeBC2(uint8_t *pBC, const XMVECTOR *pColor, DWORD flags)
+{
+    assert( pBC && pColor );
+    static_assert( sizeof(D3DX_BC2) == 16, "D3DX_BC2 should be 16 bytes" );
+
+    HDRColorA Color[NUM_PIXELS_PER_BLOCK];
+    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( &Color[i] ), pColor[i] );
+    }
+
+    auto pBC2 = reinterpret_cast<D3DX_BC2 *>(pBC);
+
+    // 4-bit alpha part.  Dithered using Floyd Stienberg error diffusion.
+    pBC2->bitmap[0] = 0;
+    pBC2->bitmap[1] = 0;
+
+    float fError[NUM_PIXELS_PER_BLOCK];
+    if (flags & BC_FLAGS_DITHER_A)
+        memset(fError, 0x00, NUM_PIXELS_PER_BLOCK * sizeof(float));
+
+    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        float fAlph = Color[i].a;
+        if (flags & BC_FLAGS_DITHER_A)
+            fAlph += fError[i];
+
+        uint32_t u = (uint32_t) static_cast<int32_t>(fAlph * 15.0f + 0.5f);
+
+        pBC2->bitmap[i >> 3] >>= 4;
+        pBC2->bitmap[i >> 3] |= (u << 28);
+
+        if (flags & BC_FLAGS_DITHER_A)
+        {     
+            float fDiff = fAlph - (float) u * (1.0f / 15.0f);
+
+            if(3 != (i & 3))
+            {
+                assert( i < 15 );
+                _Analysis_assume_( i < 15 );
+                fError[i + 1] += fDiff * (7.0f / 16.0f);
+            }
+
+            if(i < 12)
+            {
+                if(i & 3)
+                    fError[i + 3] += fDiff * (3.0f / 16.0f);
+
+                fError[i + 4] += fDiff * (5.0f / 16.0f);
+
+                if(3 != (i & 3))
+                {
+                    assert( i < 11 );
+                    _Analysis_assume_( i < 11 );
+                    fError[i + 5] += fDiff * (1.0f / 16.0f);
+                }
+            }
+        }
+    }
+
+    // RGB part
+#ifdef COLOR_WEIGHTS
+    if(!pBC2->bitmap[0] && !pBC2->bitmap[1])
+    {
+        EncodeSolidBC1(pBC2->dxt1, Color);
+        return;
+    }
+#endif // COLOR_WEIGHTS
+
+    EncodeBC1(&pBC2->bc1, Color, false, 0.f, flags);
+}
+
+
+//-------------------------------------------------------------------------------------
+// BC3 Compression
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void D3DXDecodeBC3(XMVECTOR *pColor, const uint8_t *pBC)
+{
+    assert( pColor && pBC );
+    static_assert( sizeof(D3DX_BC3) == 16, "D3DX_BC3 should be 16 bytes" );
+
+    auto pBC3 = reinterpret_cast<const D3DX_BC3 *>(pBC);
+
+    // RGB part
+    DecodeBC1(pColor, &pBC3->bc1, false);
+
+    // Adaptive 3-bit alpha part
+    float fAlpha[8];
+    DecodeBC3AlphaPalette(fAlpha, pBC3);
+
+    DWORD dw = pBC3->bitmap[0] | (pBC3->bitmap[1] << 8) | (pBC3->bitmap[2] << 16);
+
+    for(size_t i = 0; i < 8; ++i, dw >>= 3)
+        pColor[i] = XMVectorSetW( pColor[i], fAlpha[dw & 0x7] );
+
+    dw = pBC3->bitmap[3] | (pBC3->bitmap[4] << 8) | (pBC3->bitmap[5] << 16);
+
+    for(size_t i = 8; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 3)
+        pColor[i] = XMVectorSetW( pColor[i], fAlpha[dw & 0x7] );
+}
+
+_Use_decl_annotations_
+void D3DXDecodeBC3Palette(XMVECTOR *pPalette, uint8_t *pIndices, float *pAlpha, uint8_t *pAlphaIndices, const uint8_t *pBC)
+{
+    assert( pPalette && pIndices && pAlpha && pAlphaIndices && pBC );
+
+    auto pBC3 = reinterpret_cast<const D3DX_BC3 *>(pBC);
+
+    // RGB part
+    DecodeBC1Palette(pPalette, &pBC3->bc1, false);
+    DecodeBC1Indices(pIndices, &pBC3->bc1);
+
+    // Adaptive 3-bit alpha part
+    DecodeBC3AlphaPalette(pAlpha, pBC3);
+
+    DWORD dw = pBC3->bitmap[0] | (pBC3->bitmap[1] << 8) | (pBC3->bitmap[2] << 16);
+
+    for(size_t i = 0; i < 8; ++i, dw >>= 3)
+        pAlphaIndices[i] = static_cast<uint8_t>( dw & 0x7 );
+
+    dw = pBC3->bitmap[3] | (pBC3->bitmap[4] << 8) | (pBC3->bitmap[5] << 16);
+
+    for(size_t i = 8; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 3)
+        pAlphaIndices[i] = static_cast<uint8_t>( dw & 0x7 );
+}
+
+_Use_decl_annotations_
+void D3DXEncodeBC3(uint8_t *pBC, const XMVECTOR *pColor, DWORD flags)
+{
+    assert( pBC && pColor );
+    static_assert( sizeof(D3DX_BC3) == 16, "D3DX_BC3 should be 16 bytes" );
+
+    HDRColorA Color[NUM_PIXELS_PER_BLOCK];
+    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( &Color[i] ), pColor[i] );
+    }
+
+    auto pBC3 = reinterpret_cast<D3DX_BC3 *>(pBC);
+
+    EncodeBC3Alpha(pBC3, Color, flags);
+
+    // RGB part
+    EncodeBC1(&pBC3->bc1, Color, false, 0.f, flags);
+}
+
+_Use_decl_annotations_
+void D3DXEncodeBC3Batch(uint8_t *pBC, const XMVECTOR *pColor, size_t nBlocks, DWORD flags)
+{
+    assert( pBC && pColor );
+    static_assert( sizeof(D3DX_BC3) == 16, "D3DX_BC3 should be 16 bytes" );
+
+#ifdef BC_USE_LANES
+    if ( !(flags & BC_FLAGS_FORCE_SCALAR) )
+    {
+        HDRColorA Color[NUM_BLOCKS_PER_BATCH * NUM_PIXELS_PER_BLOCK];
+
+        while( nBlocks > 0 )
+        {
+            size_t count = std::min<size_t>( nBlocks, NUM_BLOCKS_PER_BATCH );
+
+            for(size_t j = 0; j < count; ++j)
+            {
+                for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+                {
+                    XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( &Color[j * NUM_PIXELS_PER_BLOCK + i] ), pColor[j * NUM_PIXELS_PER_BLOCK + i] );
+                }
+
+                EncodeBC3Alpha(reinterpret_cast<D3DX_BC3 *>(pBC + j * sizeof(D3DX_BC3)), &Color[j * NUM_PIXELS_PER_BLOCK], flags);
+            }
+
+            // RGB part
+            EncodeBC1Lanes(pBC + offsetof(D3DX_BC3, bc1), sizeof(D3DX_BC3), Color, count, false, 0.f, flags);
+
+            pBC += count * sizeof(D3DX_BC3);
+            pColor += count * NUM_PIXELS_PER_BLOCK;
+            nBlocks -= count;
+        }
+        return;
+    }
+#endif // BC_USE_LANES
+
+    for(size_t j = 0; j < nBlocks; ++j)
+    {
+        D3DXEncodeBC3(pBC + j * sizeof(D3DX_BC3), &pColor[j * NUM_PIXELS_PER_BLOCK], flags);
+    }
+}
+
 } // namespace
@@ -292,24 +292,6 @@ static void FindEndPointsBC4S(_In_reads_(BLOCK_SIZE) const float theTexelsU[], _
 }
 
 
-//------------------------------------------------------------------------------
-static inline void FindEndPointsBC5U( _In_reads_(BLOCK_SIZE) const float theTexelsU[], _In_reads_(BLOCK_SIZE) const float theTexelsV[],
-                                      _Out_ uint8_t &endpointU_0, _Out_ uint8_t &endpointU_1, _Out_ uint8_t &endpointV_0, _Out_ uint8_t &endpointV_1)
-{
-    //Encoding the U and V channel by BC4 codec separately.
-    FindEndPointsBC4U( theTexelsU, endpointU_0, endpointU_1);
-    FindEndPointsBC4U( theTexelsV, endpointV_0, endpointV_1);
-}
-
-static inline void FindEndPointsBC5S( _In_reads_(BLOCK_SIZE) const float theTexelsU[], _In_reads_(BLOCK_SIZE) const float theTexelsV[],
-                                      _Out_ int8_t &endpointU_0, _Out_ int8_t &endpointU_1, _Out_ int8_t &endpointV_0, _Out_ int8_t &endpointV_1)
-{
-    //Encoding the U and V channel by BC4 codec separately.
-    FindEndPointsBC4S( theTexelsU, endpointU_0, endpointU_1);
-    FindEndPointsBC4S( theTexelsV, endpointV_0, endpointV_1);
-}
-
-
 //------------------------------------------------------------------------------
 static void FindClosestUNORM(_Inout_ BC4_UNORM* pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const float theTexelsU[])
 {
@@ -361,6 +343,118 @@ static void FindClosestSNORM(_Inout_ BC4_SNORM* pBC, _In_reads_(NUM_PIXELS_PER_B
     }
 }
 
+//------------------------------------------------------------------------------
+// Constant, two-value, and ramp blocks (common in masks and normal maps) whose
+// texels all sit exactly on the palette spanned by their min and max can be
+// encoded losslessly without the endpoint search
+//------------------------------------------------------------------------------
+#define EXACT_EPSILON 1e-6f
+
+static inline bool QuantizeExact( _In_ float fVal, _Out_ uint8_t &iVal )
+{
+    iVal = 0;
+    if ( !( fVal >= 0.0f && fVal <= 1.0f ) )
+        return false;
+
+    iVal = (uint8_t) (fVal * 255.0f + 0.5f);
+    return ( fabsf( iVal / 255.0f - fVal ) <= EXACT_EPSILON );
+}
+
+static inline bool QuantizeExact( _In_ float fVal, _Out_ int8_t &iVal )
+{
+    iVal = 0;
+    if ( !( fVal >= -1.0f && fVal <= 1.0f ) )
+        return false;
+
+    FloatToSNorm( fVal, &iVal );
+    return ( fabsf( iVal / 127.0f - fVal ) <= EXACT_EPSILON );
+}
+
+template <class BC4, typename ENDPOINT>
+static bool EncodeExactBC4( _Inout_ BC4* pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const float theTexels[] )
+{
+    float fBlockMin = theTexels[0];
+    float fBlockMax = theTexels[0];
+    for (size_t i = 1; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        if (theTexels[i] < fBlockMin)
+        {
+            fBlockMin = theTexels[i];
+        }
+        else if (theTexels[i] > fBlockMax)
+        {
+            fBlockMax = theTexels[i];
+        }
+    }
+
+    ENDPOINT iMin, iMax;
+    if ( !QuantizeExact( fBlockMin, iMin ) || !QuantizeExact( fBlockMax, iMax ) )
+        return false;
+
+    // Try the 8-value palette (red_0 > red_1) first, then the 6-value palette which also handles constant blocks
+    for (size_t uPass = 0; uPass < 2; ++uPass)
+    {
+        if ( !uPass )
+        {
+            if ( iMin == iMax )
+                continue;
+
+            pBC->red_0 = iMax;
+            pBC->red_1 = iMin;
+        }
+        else
+        {
+            pBC->red_0 = iMin;
+            pBC->red_1 = iMax;
+        }
+
+        float rGradient[8];
+        for (size_t uIndex = 0; uIndex < 8; ++uIndex)
+        {
+            rGradient[uIndex] = pBC->DecodeFromIndex(uIndex);
+        }
+
+        size_t i;
+        for (i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            size_t uIndex;
+            for (uIndex = 0; uIndex < 8; ++uIndex)
+            {
+                if ( fabsf( rGradient[uIndex] - theTexels[i] ) <= EXACT_EPSILON )
+                    break;
+            }
+
+            if ( uIndex >= 8 )
+                break;
+
+            pBC->SetIndex(i, uIndex);
+        }
+
+        if ( i >= NUM_PIXELS_PER_BLOCK )
+            return true;
+    }
+
+    return false;
+}
+
+static void EncodeBC4U( _Inout_ BC4_UNORM* pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const float theTexelsU[] )
+{
+    if ( EncodeExactBC4<BC4_UNORM, uint8_t>( pBC, theTexelsU ) )
+        return;
+
+    FindEndPointsBC4U( theTexelsU, pBC->red_0, pBC->red_1 );
+    FindClosestUNORM( pBC, theTexelsU );
+}
+
+static void EncodeBC4S( _Inout_ BC4_SNORM* pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const float theTexelsU[] )
+{
+    if ( EncodeExactBC4<BC4_SNORM, int8_t>( pBC, theTexelsU ) )
+        return;
+
+    FindEndPointsBC4S( theTexelsU, pBC->red_0, pBC->red_1 );
+    FindClosestSNORM( pBC, theTexelsU );
+}
+
 
 //=====================================================================================
 // Entry points
@@ -399,6 +493,36 @@ void D3DXDecodeBC4S(XMVECTOR *pColor, const uint8_t *pBC)
     }       
 }
 
+_Use_decl_annotations_
+void D3DXDecodeBC4UPalette( float *pRed, uint8_t *pIndices, const uint8_t *pBC )
+{
+    assert( pRed && pIndices && pBC );
+    static_assert( sizeof(BC4_UNORM) == 8, "BC4_UNORM should be 8 bytes" );
+
+    auto pBC4 = reinterpret_cast<const BC4_UNORM*>(pBC);
+
+    for (size_t i = 0; i < 8; ++i)
+        pRed[i] = pBC4->DecodeFromIndex(i);
+
+    for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        pIndices[i] = static_cast<uint8_t>( pBC4->GetIndex(i) );
+}
+
+_Use_decl_annotations_
+void D3DXDecodeBC4SPalette( float *pRed, uint8_t *pIndices, const uint8_t *pBC )
+{
+    assert( pRed && pIndices && pBC );
+    static_assert( sizeof(BC4_SNORM) == 8, "BC4_SNORM should be 8 bytes" );
+
+    auto pBC4 = reinterpret_cast<const BC4_SNORM*>(pBC);
+
+    for (size_t i = 0; i < 8; ++i)
+        pRed[i] = pBC4->DecodeFromIndex(i);
+
+    for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        pIndices[i] = static_cast<uint8_t>( pBC4->GetIndex(i) );
+}
+
 _Use_decl_annotations_
 void D3DXEncodeBC4U( uint8_t *pBC, const XMVECTOR *pColor, DWORD flags )
 {
@@ -416,8 +540,7 @@ void D3DXEncodeBC4U( uint8_t *pBC, const XMVECTOR *pColor, DWORD flags )
         theTexelsU[i] = XMVectorGetX( pColor[i] );
     }
 
-    FindEndPointsBC4U(theTexelsU, pBC4->red_0, pBC4->red_1);
-    FindClosestUNORM(pBC4, theTexelsU);
+    EncodeBC4U(pBC4, theTexelsU);
 }
 
 _Use_decl_annotations_
@@ -437,8 +560,7 @@ void D3DXEncodeBC4S( uint8_t *pBC, const XMVECTOR *pColor, DWORD flags )
         theTexelsU[i] = XMVectorGetX( pColor[i] );
     }
 
-    FindEndPointsBC4S(theTexelsU, pBC4->red_0, pBC4->red_1);
-    FindClosestSNORM(pBC4, theTexelsU);
+    EncodeBC4S(pBC4, theTexelsU);
 }
 
 
@@ -499,16 +621,9 @@ void D3DXEncodeBC5U( uint8_t *pBC, const XMVECTOR *pColor, DWORD flags )
         theTexelsV[i] = clr.y;
     }
 
-    FindEndPointsBC5U(
-        theTexelsU,
-        theTexelsV,
-        pBCR->red_0,
-        pBCR->red_1,
-        pBCG->red_0,
-        pBCG->red_1);
-
-    FindClosestUNORM(pBCR, theTexelsU);
-    FindClosestUNORM(pBCG, theTexelsV);
+    //Encoding the U and V channel by BC4 codec separately.
+    EncodeBC4U(pBCR, theTexelsU);
+    EncodeBC4U(pBCG, theTexelsV);
 }
 
 _Use_decl_annotations_
@@ -533,16 +648,9 @@ void D3DXEncodeBC5S( uint8_t *pBC, const XMVECTOR *pColor, DWORD flags )
         theTexelsV[i] = clr.y;
     }
 
-    FindEndPointsBC5S(
-        theTexelsU,
-        theTexelsV,
-        pBCR->red_0,
-        pBCR->red_1,
-        pBCG->red_0,
-        pBCG->red_1);
-
-    FindClosestSNORM(pBCR, theTexelsU);
-    FindClosestSNORM(pBCG, theTexelsV);
+    //Encoding the U and V channel by BC4 codec separately.
+    EncodeBC4S(pBCR, theTexelsU);
+    EncodeBC4S(pBCG, theTexelsV);
 }
 
 } // namespace
@@ -2144,7 +2144,7 @@ void D3DX_BC7::Decode(HDRColorA* pOut) const
 }
 
 _Use_decl_annotations_
-void D3DX_BC7::Encode(const HDRColorA* const pIn)
+void D3DX_BC7::Encode(DWORD flags, const HDRColorA* const pIn)
 {
     assert( pIn );
 
@@ -2160,17 +2160,44 @@ void D3DX_BC7::Encode(const HDRColorA* const pIn)
         EP.aLDRPixels[i].a = uint8_t( std::max<float>( 0.0f, std::min<float>( 255.0f, pIn[i].a * 255.0f + 0.01f ) ) );
     }
 
+    // In quick mode, opaque blocks skip the modes that spend bits on alpha and solid blocks
+    // only try the single subset modes, which can represent them without partitioning
+    const bool bQuick = (flags & BC_FLAGS_BC7_QUICK) != 0;
+    bool bOpaque = true;
+    bool bSolid = true;
+    if ( bQuick )
+    {
+        for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            if ( EP.aLDRPixels[i].a != 255 )
+                bOpaque = false;
+
+            if ( EP.aLDRPixels[i].r != EP.aLDRPixels[0].r || EP.aLDRPixels[i].g != EP.aLDRPixels[0].g
+                 || EP.aLDRPixels[i].b != EP.aLDRPixels[0].b || EP.aLDRPixels[i].a != EP.aLDRPixels[0].a )
+                bSolid = false;
+        }
+    }
+
     for(EP.uMode = 0; EP.uMode < 8 && fMSEBest > 0; ++EP.uMode)
     {
+        if ( bQuick )
+        {
+            if ( bSolid && EP.uMode != 5 && EP.uMode != 6 )
+                continue;
+
+            if ( bOpaque && (EP.uMode == 4 || EP.uMode == 5 || EP.uMode == 7) )
+                continue;
+        }
+
         const size_t uShapes = size_t(1) << ms_aInfo[EP.uMode].uPartitionBits;
         assert( uShapes <= BC7_MAX_SHAPES );
         _Analysis_assume_( uShapes <= BC7_MAX_SHAPES );
 
-        const size_t uNumRots = size_t(1) << ms_aInfo[EP.uMode].uRotationBits;
+        const size_t uNumRots = bQuick ? 1 : size_t(1) << ms_aInfo[EP.uMode].uRotationBits;
         const size_t uNumIdxMode = size_t(1) << ms_aInfo[EP.uMode].uIndexModeBits;
         // Number of rough cases to look at. reasonable values of this are 1, uShapes/4, and uShapes
         // uShapes/4 gets nearly all the cases; you can increase that a bit (say by 3 or 4) if you really want to squeeze the last bit out
-        const size_t uItems = std::max<size_t>(1, uShapes >> 2);
+        const size_t uItems = bQuick ? std::min<size_t>(BC7_QUICK_ITEMS, uShapes) : std::max<size_t>(1, uShapes >> 2);
         float afRoughMSE[BC7_MAX_SHAPES];
         size_t auShape[BC7_MAX_SHAPES];
 
@@ -2207,6 +2234,11 @@ void D3DX_BC7::Encode(const HDRColorA* const pIn)
 
                 for(size_t i = 0; i < uItems && fMSEBest > 0; i++)
                 {
+                    // The rough estimate ignores endpoint quantization, so it rarely beats the refined
+                    // error; once it is already worse than the best block found, skip the refinement
+                    if ( bQuick && afRoughMSE[i] >= fMSEBest )
+                        break;
+
                     float fMSE = Refine(&EP, auShape[i], r, im);
                     if(fMSE < fMSEBest)
                     {
@@ -2862,10 +2894,9 @@ void D3DXDecodeBC7(XMVECTOR *pColor, const uint8_t *pBC)
 _Use_decl_annotations_
 void D3DXEncodeBC7(uint8_t *pBC, const XMVECTOR *pColor, DWORD flags)
 {
-    UNREFERENCED_PARAMETER(flags);
     assert( pBC && pColor );
     static_assert( sizeof(D3DX_BC7) == 16, "D3DX_BC7 should be 16 bytes" );
-    reinterpret_cast< D3DX_BC7* >( pBC )->Encode(reinterpret_cast<const HDRColorA*>(pColor));
+    reinterpret_cast< D3DX_BC7* >( pBC )->Encode(flags, reinterpret_cast<const HDRColorA*>(pColor));
 }
 
 } // namespace
@@ -15,11 +15,6 @@
 
 #include "directxtexp.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#pragma warning(disable : 4616 6993)
-#endif
-
 #include "bc.h"
 
 
@@ -32,7 +27,8 @@ inline static DWORD _GetBCFlags( _In_ DWORD compress )
     static_assert( TEX_COMPRESS_A_DITHER == BC_FLAGS_DITHER_A, "TEX_COMPRESS_* flags should match BC_FLAGS_*"  );
     static_assert( TEX_COMPRESS_DITHER == (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A), "TEX_COMPRESS_* flags should match BC_FLAGS_*"  );
     static_assert( TEX_COMPRESS_UNIFORM == BC_FLAGS_UNIFORM, "TEX_COMPRESS_* flags should match BC_FLAGS_*"  );
-    return ( compress & (BC_FLAGS_DITHER_RGB|BC_FLAGS_DITHER_A|BC_FLAGS_UNIFORM) );
+    static_assert( TEX_COMPRESS_BC7_QUICK == BC_FLAGS_BC7_QUICK, "TEX_COMPRESS_* flags should match BC_FLAGS_*"  );
+    return ( compress & (BC_FLAGS_DITHER_RGB|BC_FLAGS_DITHER_A|BC_FLAGS_UNIFORM|BC_FLAGS_BC7_QUICK) );
 }
 
 inline static DWORD _GetSRGBFlags( _In_ DWORD compress )
@@ -67,6 +63,95 @@ inline static bool _DetermineEncoderSettings( _In_ DXGI_FORMAT format, _Out_ BC_
     return true;
 }
 
+//-------------------------------------------------------------------------------------
+// Loads a 4x4 block, replicating pixels for partial blocks on the right or bottom edge
+static bool _LoadBlock( _Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR* temp, _In_ const uint8_t* pSrc, _In_ size_t rowPitch,
+                        _In_ DXGI_FORMAT format, _In_ size_t pw, _In_ size_t ph )
+{
+    assert( pw > 0 && ph > 0 );
+
+    if ( !_LoadScanline( &temp[0], pw, pSrc, rowPitch, format ) )
+        return false;
+
+    if ( ph > 1 )
+    {
+        if ( !_LoadScanline( &temp[4], pw, pSrc + rowPitch, rowPitch, format ) )
+            return false;
+
+        if ( ph > 2 )
+        {
+            if ( !_LoadScanline( &temp[8], pw, pSrc + rowPitch*2, rowPitch, format ) )
+                return false;
+
+            if ( ph > 3 )
+            {
+                if ( !_LoadScanline( &temp[12], pw, pSrc + rowPitch*3, rowPitch, format ) )
+                    return false;
+            }
+        }
+    }
+
+    if ( pw != 4 || ph != 4 )
+    {
+        // Replicate pixels for partial block
+        static const size_t uSrc[] = { 0, 0, 0, 1 };
+
+        if ( pw < 4 )
+        {
+            for( size_t t = 0; t < ph && t < 4; ++t )
+            {
+                for( size_t s = pw; s < 4; ++s )
+                {
+                    temp[ (t << 2) | s ] = temp[ (t << 2) | uSrc[s] ]; 
+                }
+            }
+        }
+
+        if ( ph < 4 )
+        {
+            for( size_t t = ph; t < 4; ++t )
+            {
+                for( size_t s = 0; s < 4; ++s )
+                {
+                    temp[ (t << 2) | s ] = temp[ (uSrc[t] << 2) | s ]; 
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Encodes a run of consecutive blocks; BC1 and BC3 use the batched SIMD encoders
+static void _EncodeBlocks( _In_ DXGI_FORMAT format, _In_opt_ BC_ENCODE pfEncode, _In_ size_t blocksize,
+                           _Out_writes_bytes_(blocksize*nBlocks) uint8_t* pDest,
+                           _In_reads_(NUM_PIXELS_PER_BLOCK*nBlocks) const XMVECTOR* pColor, _In_ size_t nBlocks,
+                           _In_ DWORD bcflags, _In_ float alphaRef )
+{
+    switch( format )
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+        D3DXEncodeBC1Batch( pDest, pColor, nBlocks, alphaRef, bcflags );
+        break;
+
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+        D3DXEncodeBC3Batch( pDest, pColor, nBlocks, bcflags );
+        break;
+
+    default:
+        assert( pfEncode != 0 );
+        for( size_t i = 0; i < nBlocks; ++i )
+        {
+            pfEncode( pDest + i*blocksize, pColor + i*NUM_PIXELS_PER_BLOCK, bcflags );
+        }
+        break;
+    }
+}
+
 
 //-------------------------------------------------------------------------------------
 static HRESULT _CompressBC( _In_ const Image& image, _In_ const Image& result, _In_ DWORD bcflags,
@@ -101,7 +186,7 @@ static HRESULT _CompressBC( _In_ const Image& image, _In_ const Image& result, _
     if ( !_DetermineEncoderSettings( result.format, pfEncode, blocksize, cflags ) )
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
 
-    XMVECTOR temp[16];
+    XMVECTOR temp[NUM_PIXELS_PER_BLOCK * NUM_BLOCKS_PER_BATCH];
     const uint8_t *pSrc = image.pixels;
     const size_t rowPitch = image.rowPitch;
     for( size_t h=0; h < image.height; h += 4 )
@@ -110,69 +195,31 @@ static HRESULT _CompressBC( _In_ const Image& image, _In_ const Image& result, _
         uint8_t* dptr = pDest;
         size_t ph = std::min<size_t>( 4, image.height - h );
         size_t w = 0;
+        size_t nb = 0;
         for( size_t count = 0; count < rowPitch; count += sbpp*4, w += 4 )
         {
             size_t pw = std::min<size_t>( 4, image.width - w );
             assert( pw > 0 && ph > 0 );
 
-            if ( !_LoadScanline( &temp[0], pw, sptr, rowPitch, format ) )
+            XMVECTOR* block = &temp[ nb * NUM_PIXELS_PER_BLOCK ];
+            if ( !_LoadBlock( block, sptr, rowPitch, format, pw, ph ) )
                 return E_FAIL;
 
-            if ( ph > 1 )
-            {
-                if ( !_LoadScanline( &temp[4], pw, sptr + rowPitch, rowPitch, format ) )
-                    return E_FAIL;
+            _ConvertScanline( block, NUM_PIXELS_PER_BLOCK, result.format, format, cflags | srgb );
 
-                if ( ph > 2 )
-                {
-                    if ( !_LoadScanline( &temp[8], pw, sptr + rowPitch*2, rowPitch, format ) )
-                        return E_FAIL;
-
-                    if ( ph > 3 )
-                    {
-                        if ( !_LoadScanline( &temp[12], pw, sptr + rowPitch*3, rowPitch, format ) )
-                            return E_FAIL;
-                    }
-                }
-            }
+            sptr += sbpp*4;
 
-            if ( pw != 4 || ph != 4 )
+            if ( ++nb == NUM_BLOCKS_PER_BATCH )
             {
-                // Replicate pixels for partial block
-                static const size_t uSrc[] = { 0, 0, 0, 1 };
-
-                if ( pw < 4 )
-                {
-                    for( size_t t = 0; t < ph && t < 4; ++t )
-                    {
-                        for( size_t s = pw; s < 4; ++s )
-                        {
-                            temp[ (t << 2) | s ] = temp[ (t << 2) | uSrc[s] ]; 
-                        }
-                    }
-                }
-
-                if ( ph < 4 )
-                {
-                    for( size_t t = ph; t < 4; ++t )
-                    {
-                        for( size_t s = 0; s < 4; ++s )
-                        {
-                            temp[ (t << 2) | s ] = temp[ (uSrc[t] << 2) | s ]; 
-                        }
-                    }
-                }
+                _EncodeBlocks( result.format, pfEncode, blocksize, dptr, temp, nb, bcflags, alphaRef );
+                dptr += blocksize * nb;
+                nb = 0;
             }
+        }
 
-            _ConvertScanline( temp, 16, result.format, format, cflags | srgb );
-            
-            if ( pfEncode )
-                pfEncode( dptr, temp, bcflags );
-            else
-                D3DXEncodeBC1( dptr, temp, alphaRef, bcflags );
-
-            sptr += sbpp*4;
-            dptr += blocksize;
+        if ( nb > 0 )
+        {
+            _EncodeBlocks( result.format, pfEncode, blocksize, dptr, temp, nb, bcflags, alphaRef );
         }
 
         pSrc += rowPitch*4;
@@ -184,123 +231,189 @@ static HRESULT _CompressBC( _In_ const Image& image, _In_ const Image& result, _
 
 
 //-------------------------------------------------------------------------------------
-#ifdef _OPENMP
-static HRESULT _CompressBC_Parallel( _In_ const Image& image, _In_ const Image& result, _In_ DWORD bcflags,
-                                     _In_ DWORD srgb, _In_ float alphaRef )
+// Parallel compression splits every image into tiles of up to COMPRESS_TILE_BLOCKS blocks
+// from one row of blocks, and schedules the tiles of all the images together so that small
+// mips and array slices don't leave threads idle
+//-------------------------------------------------------------------------------------
+
+// Each tile encodes several batches so cheap formats aren't dominated by scheduling
+static const size_t COMPRESS_TILE_BLOCKS = NUM_BLOCKS_PER_BATCH * 8;
+
+// Progress is reported about this many times over the whole set of images
+static const size_t COMPRESS_PROGRESS_STEPS = 256;
+
+struct _CompressImage
 {
-    if ( !image.pixels || !result.pixels )
-        return E_POINTER;
+    const Image*    image;
+    const Image*    result;
+    size_t          sbpp;
+    size_t          nbWidth;
+    size_t          nTileWidth;
+};
+
+struct _CompressContext
+{
+    std::vector<_CompressImage> images;
+    std::vector<size_t>         firstTile;
+    BC_ENCODE                   pfEncode;
+    size_t                      blocksize;
+    DWORD                       cflags;
+    DWORD                       bcflags;
+    DWORD                       srgb;
+    float                       alphaRef;
+
+    // Progress callback state; the callback is only invoked while holding cs
+    const COMPRESS_PROGRESS*    progress;
+    CRITICAL_SECTION            cs;
+    size_t                      blocksDone;
+    size_t                      blocksTotal;
+    size_t                      nextReport;
+    volatile LONG               cancelled;
+};
+
+static bool _CompressTile( _In_ size_t tile, _In_opt_ void* pContext )
+{
+    _CompressContext* context = reinterpret_cast<_CompressContext*>( pContext );
+    assert( context );
 
-    assert( image.width == result.width );
-    assert( image.height == result.height );
+    if ( context->cancelled )
+        return false;
 
-    const DXGI_FORMAT format = image.format;
-    size_t sbpp = BitsPerPixel( format );
-    if ( !sbpp )
-        return E_FAIL;
+    // Find the image that contains the tile
+    const size_t index = ( std::upper_bound( context->firstTile.begin(), context->firstTile.end(), tile ) - context->firstTile.begin() ) - 1;
+    assert( index < context->images.size() );
 
-    if ( sbpp < 8 )
-    {
-        // We don't support compressing from monochrome (DXGI_FORMAT_R1_UNORM)
-        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
-    }
+    const _CompressImage& ci = context->images[ index ];
+    const Image& image = *ci.image;
+    const Image& result = *ci.result;
 
-    // Round to bytes
-    sbpp = ( sbpp + 7 ) / 8;
+    const size_t ntile = tile - context->firstTile[ index ];
+    const size_t y = ntile / ci.nTileWidth;
+    const size_t x = ( ntile - (y*ci.nTileWidth) ) * COMPRESS_TILE_BLOCKS;
+    const size_t nBlocks = std::min<size_t>( COMPRESS_TILE_BLOCKS, ci.nbWidth - x );
 
-    // Determine BC format encoder
-    BC_ENCODE pfEncode;
-    size_t blocksize;
-    DWORD cflags;
-    if ( !_DetermineEncoderSettings( result.format, pfEncode, blocksize, cflags ) )
-        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+    assert( (x*4) < image.width && (y*4) < image.height );
 
-    // Refactored version of loop to support parallel independance
-    const size_t nBlocks = std::max<size_t>(1, (image.width + 3) / 4 ) * std::max<size_t>(1, (image.height + 3) / 4 );
+    size_t rowPitch = image.rowPitch;
+    const uint8_t *pSrc = image.pixels + (y*4*rowPitch) + (x*4*ci.sbpp);
 
-    bool fail = false;
+    uint8_t *pDest = result.pixels + (y*result.rowPitch) + (x*context->blocksize);
 
-#pragma omp parallel for
-    for( int nb=0; nb < static_cast<int>( nBlocks ); ++nb )
-    {
-        const size_t nbWidth = std::max<size_t>(1, (image.width + 3) / 4 );
+    size_t ph = std::min<size_t>( 4, image.height - y*4 );
 
-        const size_t y = nb / nbWidth;
-        const size_t x = nb - (y*nbWidth);
+    XMVECTOR temp[NUM_PIXELS_PER_BLOCK * NUM_BLOCKS_PER_BATCH];
+    for( size_t batch = 0; batch < nBlocks; batch += NUM_BLOCKS_PER_BATCH )
+    {
+        const size_t nb = std::min<size_t>( NUM_BLOCKS_PER_BATCH, nBlocks - batch );
 
-        assert( x < image.width && y < image.height );
+        for( size_t j = 0; j < nb; ++j )
+        {
+            size_t pw = std::min<size_t>( 4, image.width - (x + batch + j)*4 );
 
-        size_t rowPitch = image.rowPitch;
-        const uint8_t *pSrc = image.pixels + (y*4*rowPitch) + (x*4*sbpp);
+            XMVECTOR* block = &temp[ j * NUM_PIXELS_PER_BLOCK ];
+            if ( !_LoadBlock( block, pSrc + (batch + j)*4*ci.sbpp, rowPitch, image.format, pw, ph ) )
+                return false;
 
-        uint8_t *pDest = result.pixels + (nb*blocksize);
+            _ConvertScanline( block, NUM_PIXELS_PER_BLOCK, result.format, image.format, context->cflags | context->srgb );
+        }
 
-        size_t ph = std::min<size_t>( 4, image.height - y );
-        size_t pw = std::min<size_t>( 4, image.width - x );
-        assert( pw > 0 && ph > 0 );
+        _EncodeBlocks( result.format, context->pfEncode, context->blocksize, pDest + batch*context->blocksize, temp, nb,
+                       context->bcflags, context->alphaRef );
+    }
 
-        XMVECTOR temp[16];
-        if ( !_LoadScanline( &temp[0], pw, pSrc, rowPitch, format ) )
-            fail = true;
+    if ( context->progress )
+    {
+        EnterCriticalSection( &context->cs );
 
-        if ( ph > 1 )
+        context->blocksDone += nBlocks;
+        if ( context->blocksDone >= context->nextReport && !context->cancelled )
         {
-            if ( !_LoadScanline( &temp[4], pw, pSrc + rowPitch, rowPitch, format ) )
-                fail = true;
+            const size_t step = std::max<size_t>( 1, context->blocksTotal / COMPRESS_PROGRESS_STEPS );
+            context->nextReport = std::min<size_t>( context->blocksDone + step, context->blocksTotal );
 
-            if ( ph > 2 )
+            if ( !(*context->progress)( context->blocksDone, context->blocksTotal ) )
             {
-                if ( !_LoadScanline( &temp[8], pw, pSrc + rowPitch*2, rowPitch, format ) )
-                    fail = true;
-
-                if ( ph > 3 )
-                {
-                    if ( !_LoadScanline( &temp[12], pw, pSrc + rowPitch*3, rowPitch, format ) )
-                        fail = true;
-                }
+                context->cancelled = 1;
             }
         }
 
-        if ( pw != 4 || ph != 4 )
-        {
-            // Replicate pixels for partial block
-            static const size_t uSrc[] = { 0, 0, 0, 1 };
+        LeaveCriticalSection( &context->cs );
+    }
 
-            if ( pw < 4 )
-            {
-                for( size_t t = 0; t < ph && t < 4; ++t )
-                {
-                    for( size_t s = pw; s < 4; ++s )
-                    {
-                        temp[ (t << 2) | s ] = temp[ (t << 2) | uSrc[s] ]; 
-                    }
-                }
-            }
+    return !context->cancelled;
+}
 
-            if ( ph < 4 )
-            {
-                for( size_t t = ph; t < 4; ++t )
-                {
-                    for( size_t s = 0; s < 4; ++s )
-                    {
-                        temp[ (t << 2) | s ] = temp[ (uSrc[t] << 2) | s ]; 
-                    }
-                }
-            }
+static HRESULT _CompressBC_Parallel( _In_reads_(nimages) const Image* images, _In_reads_(nimages) const Image* results, _In_ size_t nimages,
+                                     _In_ DWORD bcflags, _In_ DWORD srgb, _In_ float alphaRef, _In_opt_ const COMPRESS_PROGRESS* progress )
+{
+    assert( images && results && nimages > 0 );
+
+    _CompressContext context;
+
+    // Determine BC format encoder
+    if ( !_DetermineEncoderSettings( results[0].format, context.pfEncode, context.blocksize, context.cflags ) )
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+
+    context.bcflags = bcflags;
+    context.srgb = srgb;
+    context.alphaRef = alphaRef;
+
+    context.images.reserve( nimages );
+    context.firstTile.reserve( nimages );
+
+    size_t nTiles = 0;
+    size_t nBlocks = 0;
+    for( size_t index = 0; index < nimages; ++index )
+    {
+        const Image& image = images[ index ];
+        const Image& result = results[ index ];
+
+        if ( !image.pixels || !result.pixels )
+            return E_POINTER;
+
+        assert( image.width == result.width );
+        assert( image.height == result.height );
+        assert( result.format == results[0].format );
+
+        size_t sbpp = BitsPerPixel( image.format );
+        if ( !sbpp )
+            return E_FAIL;
+
+        if ( sbpp < 8 )
+        {
+            // We don't support compressing from monochrome (DXGI_FORMAT_R1_UNORM)
+            return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
         }
 
-        _ConvertScanline( temp, 16, result.format, format, cflags | srgb );
-            
-        if ( pfEncode )
-            pfEncode( pDest, temp, bcflags );
-        else
-            D3DXEncodeBC1( pDest, temp, alphaRef, bcflags );
+        _CompressImage ci;
+        ci.image = &image;
+        ci.result = &result;
+        ci.sbpp = ( sbpp + 7 ) / 8;
+        ci.nbWidth = std::max<size_t>(1, (image.width + 3) / 4 );
+        ci.nTileWidth = ( ci.nbWidth + COMPRESS_TILE_BLOCKS - 1 ) / COMPRESS_TILE_BLOCKS;
+
+        context.images.push_back( ci );
+        context.firstTile.push_back( nTiles );
+
+        const size_t nbHeight = std::max<size_t>(1, (image.height + 3) / 4 );
+        nTiles += ci.nTileWidth * nbHeight;
+        nBlocks += ci.nbWidth * nbHeight;
     }
 
-    return (fail) ? E_FAIL : S_OK;
-}
+    context.progress = ( progress && *progress ) ? progress : nullptr;
+    context.blocksDone = 0;
+    context.blocksTotal = nBlocks;
+    context.nextReport = 0;
+    context.cancelled = 0;
+
+    InitializeCriticalSection( &context.cs );
 
-#endif // _OPENMP
+    HRESULT hr = _ParallelFor( nTiles, _CompressTile, &context );
+
+    DeleteCriticalSection( &context.cs );
+
+    return ( context.cancelled ) ? E_ABORT : hr;
+}
 
 
 //-------------------------------------------------------------------------------------
@@ -352,113 +465,375 @@ static DXGI_FORMAT _DefaultDecompress( _In_ DXGI_FORMAT format )
 
 
 //-------------------------------------------------------------------------------------
-static HRESULT _DecompressBC( _In_ const Image& cImage, _In_ const Image& result )
+// Direct decoders write a block straight to 8-bit texels. Only the block's palette goes
+// through _StoreScanline and the texels are then looked up by index, so the output is
+// the same as decoding to XMVECTOR and storing every texel.
+//-------------------------------------------------------------------------------------
+typedef bool (*BC_DECODE_DIRECT)( _Out_writes_bytes_(NUM_PIXELS_PER_BLOCK*4) uint8_t* pTexels, _In_ const uint8_t* pBC, _In_ DXGI_FORMAT format );
+
+// BC1 -> R8G8B8A8
+static bool _DecodeBC1Direct( uint8_t* pTexels, const uint8_t* pBC, DXGI_FORMAT format )
 {
-    if ( !cImage.pixels || !result.pixels )
-        return E_POINTER;
+    XMVECTOR palette[4];
+    uint8_t indices[NUM_PIXELS_PER_BLOCK];
+    D3DXDecodeBC1Palette( palette, indices, pBC );
 
-    assert( cImage.width == result.width );
-    assert( cImage.height == result.height );
+    uint32_t colors[4];
+    if ( !_StoreScanline( colors, sizeof(colors), format, palette, 4 ) )
+        return false;
 
-    const DXGI_FORMAT format = result.format;
-    size_t dbpp = BitsPerPixel( format );
-    if ( !dbpp )
-        return E_FAIL;
+    uint32_t* dPtr = reinterpret_cast<uint32_t*>( pTexels );
+    for( size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i )
+    {
+        dPtr[ i ] = colors[ indices[ i ] ];
+    }
 
-    if ( dbpp < 8 )
+    return true;
+}
+
+// BC2/BC3 -> R8G8B8A8
+static bool _DecodeBCAlphaDirect( _Out_writes_bytes_(NUM_PIXELS_PER_BLOCK*4) uint8_t* pTexels, _In_ DXGI_FORMAT format,
+                                  _In_reads_(4) const XMVECTOR* palette, _In_reads_(NUM_PIXELS_PER_BLOCK) const uint8_t* indices,
+                                  _In_reads_(nalpha) const float* alpha, _In_ size_t nalpha, _In_reads_(NUM_PIXELS_PER_BLOCK) const uint8_t* alphaIndices )
+{
+    assert( nalpha <= 16 );
+
+    uint32_t colors[4];
+    if ( !_StoreScanline( colors, sizeof(colors), format, palette, 4 ) )
+        return false;
+
+    XMVECTOR alphaPalette[16];
+    for( size_t i = 0; i < nalpha; ++i )
     {
-        // We don't support decompressing to monochrome (DXGI_FORMAT_R1_UNORM)
-        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+        alphaPalette[ i ] = XMVectorSet( 0.f, 0.f, 0.f, alpha[ i ] );
     }
 
-    // Round to bytes
-    dbpp = ( dbpp + 7 ) / 8;
+    uint32_t alphas[16];
+    if ( !_StoreScanline( alphas, sizeof(uint32_t) * nalpha, format, alphaPalette, nalpha ) )
+        return false;
 
-    uint8_t *pDest = result.pixels;
-    if ( !pDest )
-        return E_POINTER;
+    uint32_t* dPtr = reinterpret_cast<uint32_t*>( pTexels );
+    for( size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i )
+    {
+        dPtr[ i ] = ( colors[ indices[ i ] ] & 0x00FFFFFF ) | ( alphas[ alphaIndices[ i ] ] & 0xFF000000 );
+    }
 
-    // Promote "typeless" BC formats
-    DXGI_FORMAT cformat;
-    switch( cImage.format )
+    return true;
+}
+
+static bool _DecodeBC2Direct( uint8_t* pTexels, const uint8_t* pBC, DXGI_FORMAT format )
+{
+    XMVECTOR palette[4];
+    uint8_t indices[NUM_PIXELS_PER_BLOCK];
+    float alpha[16];
+    uint8_t alphaIndices[NUM_PIXELS_PER_BLOCK];
+    D3DXDecodeBC2Palette( palette, indices, alpha, alphaIndices, pBC );
+
+    return _DecodeBCAlphaDirect( pTexels, format, palette, indices, alpha, 16, alphaIndices );
+}
+
+static bool _DecodeBC3Direct( uint8_t* pTexels, const uint8_t* pBC, DXGI_FORMAT format )
+{
+    XMVECTOR palette[4];
+    uint8_t indices[NUM_PIXELS_PER_BLOCK];
+    float alpha[8];
+    uint8_t alphaIndices[NUM_PIXELS_PER_BLOCK];
+    D3DXDecodeBC3Palette( palette, indices, alpha, alphaIndices, pBC );
+
+    return _DecodeBCAlphaDirect( pTexels, format, palette, indices, alpha, 8, alphaIndices );
+}
+
+// Quantizes an 8-entry BC4 palette into one channel of an 8-bit R or RG format
+static bool _StoreBC4Palette( _Out_writes_(8) uint8_t* pValues, _In_ DXGI_FORMAT format, _In_reads_(8) const float* pPalette, _In_ size_t channel )
+{
+    assert( channel < 2 );
+
+    XMVECTOR palette[8];
+    for( size_t i = 0; i < 8; ++i )
     {
-    case DXGI_FORMAT_BC1_TYPELESS:  cformat = DXGI_FORMAT_BC1_UNORM; break;
-    case DXGI_FORMAT_BC2_TYPELESS:  cformat = DXGI_FORMAT_BC2_UNORM; break;
-    case DXGI_FORMAT_BC3_TYPELESS:  cformat = DXGI_FORMAT_BC3_UNORM; break;
-    case DXGI_FORMAT_BC4_TYPELESS:  cformat = DXGI_FORMAT_BC4_UNORM; break;
-    case DXGI_FORMAT_BC5_TYPELESS:  cformat = DXGI_FORMAT_BC5_UNORM; break;
-    case DXGI_FORMAT_BC6H_TYPELESS: cformat = DXGI_FORMAT_BC6H_UF16; break;
-    case DXGI_FORMAT_BC7_TYPELESS:  cformat = DXGI_FORMAT_BC7_UNORM; break;
-    default:                        cformat = cImage.format;         break;
+        palette[ i ] = ( channel ) ? XMVectorSet( 0.f, pPalette[ i ], 0.f, 1.f ) : XMVectorSet( pPalette[ i ], 0.f, 0.f, 1.f );
     }
 
-    // Determine BC format decoder
-    BC_DECODE pfDecode;
-    size_t sbpp;
-    switch(cformat)
+    const size_t bpp = ( format == DXGI_FORMAT_R8G8_UNORM || format == DXGI_FORMAT_R8G8_SNORM ) ? 2 : 1;
+
+    uint8_t values[16];
+    if ( !_StoreScanline( values, bpp * 8, format, palette, 8 ) )
+        return false;
+
+    for( size_t i = 0; i < 8; ++i )
     {
-    case DXGI_FORMAT_BC1_UNORM:
-    case DXGI_FORMAT_BC1_UNORM_SRGB:    pfDecode = D3DXDecodeBC1;   sbpp = 8;   break;
-    case DXGI_FORMAT_BC2_UNORM:
-    case DXGI_FORMAT_BC2_UNORM_SRGB:    pfDecode = D3DXDecodeBC2;   sbpp = 16;  break;
-    case DXGI_FORMAT_BC3_UNORM:
-    case DXGI_FORMAT_BC3_UNORM_SRGB:    pfDecode = D3DXDecodeBC3;   sbpp = 16;  break;
-    case DXGI_FORMAT_BC4_UNORM:         pfDecode = D3DXDecodeBC4U;  sbpp = 8;   break;
-    case DXGI_FORMAT_BC4_SNORM:         pfDecode = D3DXDecodeBC4S;  sbpp = 8;   break;
-    case DXGI_FORMAT_BC5_UNORM:         pfDecode = D3DXDecodeBC5U;  sbpp = 16;  break;
-    case DXGI_FORMAT_BC5_SNORM:         pfDecode = D3DXDecodeBC5S;  sbpp = 16;  break;
-    case DXGI_FORMAT_BC6H_UF16:         pfDecode = D3DXDecodeBC6HU; sbpp = 16;  break;
-    case DXGI_FORMAT_BC6H_SF16:         pfDecode = D3DXDecodeBC6HS; sbpp = 16;  break;
-    case DXGI_FORMAT_BC7_UNORM:
-    case DXGI_FORMAT_BC7_UNORM_SRGB:    pfDecode = D3DXDecodeBC7;   sbpp = 16;  break;
-    default:
-        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+        pValues[ i ] = values[ i * bpp + channel ];
     }
 
-    XMVECTOR temp[16];
-    const uint8_t *pSrc = cImage.pixels;
+    return true;
+}
+
+// BC4 -> R8
+static bool _DecodeBC4Direct( uint8_t* pTexels, const uint8_t* pBC, DXGI_FORMAT format )
+{
+    float red[8];
+    uint8_t indices[NUM_PIXELS_PER_BLOCK];
+    if ( format == DXGI_FORMAT_R8_SNORM )
+        D3DXDecodeBC4SPalette( red, indices, pBC );
+    else
+        D3DXDecodeBC4UPalette( red, indices, pBC );
+
+    uint8_t values[8];
+    if ( !_StoreBC4Palette( values, format, red, 0 ) )
+        return false;
+
+    for( size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i )
+    {
+        pTexels[ i ] = values[ indices[ i ] ];
+    }
+
+    return true;
+}
+
+// BC5 -> R8G8
+static bool _DecodeBC5Direct( uint8_t* pTexels, const uint8_t* pBC, DXGI_FORMAT format )
+{
+    float red[8], green[8];
+    uint8_t redIndices[NUM_PIXELS_PER_BLOCK], greenIndices[NUM_PIXELS_PER_BLOCK];
+    if ( format == DXGI_FORMAT_R8G8_SNORM )
+    {
+        D3DXDecodeBC4SPalette( red, redIndices, pBC );
+        D3DXDecodeBC4SPalette( green, greenIndices, pBC + 8 );
+    }
+    else
+    {
+        D3DXDecodeBC4UPalette( red, redIndices, pBC );
+        D3DXDecodeBC4UPalette( green, greenIndices, pBC + 8 );
+    }
+
+    uint8_t reds[8], greens[8];
+    if ( !_StoreBC4Palette( reds, format, red, 0 ) || !_StoreBC4Palette( greens, format, green, 1 ) )
+        return false;
+
+    for( size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i )
+    {
+        pTexels[ i*2 ] = reds[ redIndices[ i ] ];
+        pTexels[ i*2 + 1 ] = greens[ greenIndices[ i ] ];
+    }
+
+    return true;
+}
+
+static BC_DECODE_DIRECT _GetDirectDecoder( _In_ DXGI_FORMAT cformat, _In_ DXGI_FORMAT format )
+{
+    // Only pairs where _ConvertScanline has nothing to do (sRGB flags cancel for sRGB -> sRGB)
+    switch( cformat )
+    {
+    case DXGI_FORMAT_BC1_UNORM:         return ( format == DXGI_FORMAT_R8G8B8A8_UNORM ) ? _DecodeBC1Direct : nullptr;
+    case DXGI_FORMAT_BC1_UNORM_SRGB:    return ( format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ) ? _DecodeBC1Direct : nullptr;
+    case DXGI_FORMAT_BC2_UNORM:         return ( format == DXGI_FORMAT_R8G8B8A8_UNORM ) ? _DecodeBC2Direct : nullptr;
+    case DXGI_FORMAT_BC2_UNORM_SRGB:    return ( format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ) ? _DecodeBC2Direct : nullptr;
+    case DXGI_FORMAT_BC3_UNORM:         return ( format == DXGI_FORMAT_R8G8B8A8_UNORM ) ? _DecodeBC3Direct : nullptr;
+    case DXGI_FORMAT_BC3_UNORM_SRGB:    return ( format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ) ? _DecodeBC3Direct : nullptr;
+    case DXGI_FORMAT_BC4_UNORM:         return ( format == DXGI_FORMAT_R8_UNORM ) ? _DecodeBC4Direct : nullptr;
+    case DXGI_FORMAT_BC4_SNORM:         return ( format == DXGI_FORMAT_R8_SNORM ) ? _DecodeBC4Direct : nullptr;
+    case DXGI_FORMAT_BC5_UNORM:         return ( format == DXGI_FORMAT_R8G8_UNORM ) ? _DecodeBC5Direct : nullptr;
+    case DXGI_FORMAT_BC5_SNORM:         return ( format == DXGI_FORMAT_R8G8_SNORM ) ? _DecodeBC5Direct : nullptr;
+    default:                            return nullptr;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// Decompression works one row of blocks at a time; with TEX_DECOMPRESS_PARALLEL the rows
+// of all the images are scheduled together
+//-------------------------------------------------------------------------------------
+struct _DecompressImage
+{
+    const Image*        image;
+    const Image*        result;
+    DXGI_FORMAT         cformat;
+    BC_DECODE           pfDecode;
+    BC_DECODE_DIRECT    pfDirect;
+    size_t              sbpp;
+    size_t              dbpp;
+};
+
+struct _DecompressContext
+{
+    std::vector<_DecompressImage>   images;
+    std::vector<size_t>             firstRow;
+};
+
+static bool _DecompressRow( _In_ size_t row, _In_opt_ void* pContext )
+{
+    const _DecompressContext* context = reinterpret_cast<const _DecompressContext*>( pContext );
+    assert( context );
+
+    // Find the image that contains the row
+    const size_t index = ( std::upper_bound( context->firstRow.begin(), context->firstRow.end(), row ) - context->firstRow.begin() ) - 1;
+    assert( index < context->images.size() );
+
+    const _DecompressImage& di = context->images[ index ];
+    const Image& cImage = *di.image;
+    const Image& result = *di.result;
+    const DXGI_FORMAT format = result.format;
+    const size_t dbpp = di.dbpp;
+
+    const size_t h = ( row - context->firstRow[ index ] ) * 4;
+    assert( h < cImage.height );
+
+    const uint8_t *sptr = cImage.pixels + ( h / 4 ) * cImage.rowPitch;
     const size_t rowPitch = result.rowPitch;
-    for( size_t h=0; h < cImage.height; h += 4 )
+    uint8_t* dptr = result.pixels + h * rowPitch;
+
+    size_t ph = std::min<size_t>( 4, cImage.height - h );
+
+    if ( di.pfDirect )
     {
-        const uint8_t *sptr = pSrc;
-        uint8_t* dptr = pDest;
-        size_t ph = std::min<size_t>( 4, cImage.height - h );
-        size_t w = 0;
-        for( size_t count = 0; count < cImage.rowPitch; count += sbpp, w += 4 )
+        uint8_t texels[NUM_PIXELS_PER_BLOCK*4];
+        for( size_t w = 0; w < cImage.width; w += 4 )
         {
-            pfDecode( temp, sptr );
-            _ConvertScanline( temp, 16, format, cformat, 0 );
+            if ( !di.pfDirect( texels, sptr, format ) )
+                return false;
 
             size_t pw = std::min<size_t>( 4, cImage.width - w );
             assert( pw > 0 && ph > 0 );
 
-            if ( !_StoreScanline( dptr, rowPitch, format, &temp[0], pw ) )
-                return E_FAIL;
+            for( size_t y = 0; y < ph; ++y )
+            {
+                memcpy( dptr + rowPitch*y, texels + y*4*dbpp, pw*dbpp );
+            }
 
-            if ( ph > 1 )
+            sptr += di.sbpp;
+            dptr += dbpp*4;
+        }
+
+        return true;
+    }
+
+    XMVECTOR temp[16];
+    size_t w = 0;
+    for( size_t count = 0; count < cImage.rowPitch; count += di.sbpp, w += 4 )
+    {
+        di.pfDecode( temp, sptr );
+        _ConvertScanline( temp, 16, format, di.cformat, 0 );
+
+        size_t pw = std::min<size_t>( 4, cImage.width - w );
+        assert( pw > 0 && ph > 0 );
+
+        if ( !_StoreScanline( dptr, rowPitch, format, &temp[0], pw ) )
+            return false;
+
+        if ( ph > 1 )
+        {
+            if ( !_StoreScanline( dptr + rowPitch, rowPitch, format, &temp[4], pw ) )
+                return false;
+
+            if ( ph > 2 )
             {
-                if ( !_StoreScanline( dptr + rowPitch, rowPitch, format, &temp[4], pw ) )
-                    return E_FAIL;
+                if ( !_StoreScanline( dptr + rowPitch*2, rowPitch, format, &temp[8], pw ) )
+                    return false;
 
-                if ( ph > 2 )
+                if ( ph > 3 )
                 {
-                    if ( !_StoreScanline( dptr + rowPitch*2, rowPitch, format, &temp[8], pw ) )
-                        return E_FAIL;
-
-                    if ( ph > 3 )
-                    {
-                        if ( !_StoreScanline( dptr + rowPitch*3, rowPitch, format, &temp[12], pw ) )
-                            return E_FAIL;
-                    }
+                    if ( !_StoreScanline( dptr + rowPitch*3, rowPitch, format, &temp[12], pw ) )
+                        return false;
                 }
             }
+        }
 
-            sptr += sbpp;
-            dptr += dbpp*4;
+        sptr += di.sbpp;
+        dptr += dbpp*4;
+    }
+
+    return true;
+}
+
+static HRESULT _DecompressBC( _In_reads_(nimages) const Image* cImages, _In_reads_(nimages) const Image* results, _In_ size_t nimages, _In_ DWORD flags )
+{
+    assert( cImages && results && nimages > 0 );
+
+    _DecompressContext context;
+    context.images.reserve( nimages );
+    context.firstRow.reserve( nimages );
+
+    size_t nRows = 0;
+    for( size_t index = 0; index < nimages; ++index )
+    {
+        const Image& cImage = cImages[ index ];
+        const Image& result = results[ index ];
+
+        if ( !cImage.pixels || !result.pixels )
+            return E_POINTER;
+
+        assert( cImage.width == result.width );
+        assert( cImage.height == result.height );
+
+        const DXGI_FORMAT format = result.format;
+        size_t dbpp = BitsPerPixel( format );
+        if ( !dbpp )
+            return E_FAIL;
+
+        if ( dbpp < 8 )
+        {
+            // We don't support decompressing to monochrome (DXGI_FORMAT_R1_UNORM)
+            return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
         }
 
-        pSrc += cImage.rowPitch;
-        pDest += rowPitch*4;
+        _DecompressImage di;
+        di.image = &cImage;
+        di.result = &result;
+
+        // Round to bytes
+        di.dbpp = ( dbpp + 7 ) / 8;
+
+        // Promote "typeless" BC formats
+        switch( cImage.format )
+        {
+        case DXGI_FORMAT_BC1_TYPELESS:  di.cformat = DXGI_FORMAT_BC1_UNORM; break;
+        case DXGI_FORMAT_BC2_TYPELESS:  di.cformat = DXGI_FORMAT_BC2_UNORM; break;
+        case DXGI_FORMAT_BC3_TYPELESS:  di.cformat = DXGI_FORMAT_BC3_UNORM; break;
+        case DXGI_FORMAT_BC4_TYPELESS:  di.cformat = DXGI_FORMAT_BC4_UNORM; break;
+        case DXGI_FORMAT_BC5_TYPELESS:  di.cformat = DXGI_FORMAT_BC5_UNORM; break;
+        case DXGI_FORMAT_BC6H_TYPELESS: di.cformat = DXGI_FORMAT_BC6H_UF16; break;
+        case DXGI_FORMAT_BC7_TYPELESS:  di.cformat = DXGI_FORMAT_BC7_UNORM; break;
+        default:                        di.cformat = cImage.format;         break;
+        }
+
+        // Determine BC format decoder
+        switch( di.cformat )
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:    di.pfDecode = D3DXDecodeBC1;   di.sbpp = 8;   break;
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:    di.pfDecode = D3DXDecodeBC2;   di.sbpp = 16;  break;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:    di.pfDecode = D3DXDecodeBC3;   di.sbpp = 16;  break;
+        case DXGI_FORMAT_BC4_UNORM:         di.pfDecode = D3DXDecodeBC4U;  di.sbpp = 8;   break;
+        case DXGI_FORMAT_BC4_SNORM:         di.pfDecode = D3DXDecodeBC4S;  di.sbpp = 8;   break;
+        case DXGI_FORMAT_BC5_UNORM:         di.pfDecode = D3DXDecodeBC5U;  di.sbpp = 16;  break;
+        case DXGI_FORMAT_BC5_SNORM:         di.pfDecode = D3DXDecodeBC5S;  di.sbpp = 16;  break;
+        case DXGI_FORMAT_BC6H_UF16:         di.pfDecode = D3DXDecodeBC6HU; di.sbpp = 16;  break;
+        case DXGI_FORMAT_BC6H_SF16:         di.pfDecode = D3DXDecodeBC6HS; di.sbpp = 16;  break;
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:    di.pfDecode = D3DXDecodeBC7;   di.sbpp = 16;  break;
+        default:
+            return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+        }
+
+        di.pfDirect = _GetDirectDecoder( di.cformat, format );
+
+        context.images.push_back( di );
+        context.firstRow.push_back( nRows );
+
+        nRows += ( cImage.height + 3 ) / 4;
+    }
+
+    if ( flags & TEX_DECOMPRESS_PARALLEL )
+    {
+        return _ParallelFor( nRows, _DecompressRow, &context );
+    }
+
+    for( size_t row = 0; row < nRows; ++row )
+    {
+        if ( !_DecompressRow( row, &context ) )
+            return E_FAIL;
     }
 
     return S_OK;
@@ -551,6 +926,48 @@ bool _IsAlphaAllOpaqueBC( _In_ const Image& cImage )
 }
 
 
+//-------------------------------------------------------------------------------------
+// Compresses each source image into the matching result image, which can also be bands
+// of whole block rows cut out of larger images
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT _CompressImages( const Image* srcImages, const Image* destImages, size_t nimages, DWORD compress, float alphaRef,
+                         const COMPRESS_PROGRESS* progress )
+{
+    if ( !srcImages || !destImages || !nimages )
+        return E_INVALIDARG;
+
+    if ( (compress & TEX_COMPRESS_PARALLEL) )
+    {
+        // All subresources share one pool of tiles
+        return _CompressBC_Parallel( srcImages, destImages, nimages, _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef, progress );
+    }
+
+    size_t nBlocks = 0;
+    for( size_t index=0; index < nimages; ++index )
+    {
+        nBlocks += std::max<size_t>( 1, ( srcImages[ index ].width + 3 ) / 4 ) * std::max<size_t>( 1, ( srcImages[ index ].height + 3 ) / 4 );
+    }
+
+    size_t blocksDone = 0;
+    for( size_t index=0; index < nimages; ++index )
+    {
+        HRESULT hr = _CompressBC( srcImages[ index ], destImages[ index ], _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
+        if ( FAILED(hr) )
+            return hr;
+
+        if ( progress && *progress )
+        {
+            blocksDone += std::max<size_t>( 1, ( srcImages[ index ].width + 3 ) / 4 ) * std::max<size_t>( 1, ( srcImages[ index ].height + 3 ) / 4 );
+            if ( !(*progress)( blocksDone, nBlocks ) )
+                return E_ABORT;
+        }
+    }
+
+    return S_OK;
+}
+
+
 //=====================================================================================
 // Entry-points
 //=====================================================================================
@@ -577,18 +994,7 @@ HRESULT Compress( const Image& srcImage, DXGI_FORMAT format, DWORD compress, flo
     }
 
     // Compress single image
-    if (compress & TEX_COMPRESS_PARALLEL)
-    {
-#ifndef _OPENMP
-        return E_NOTIMPL;
-#else
-        hr = _CompressBC_Parallel( srcImage, *img, _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
-#endif // _OPENMP
-    }
-    else
-    {
-        hr = _CompressBC( srcImage, *img, _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
-    }
+    hr = _CompressImages( &srcImage, img, 1, compress, alphaRef );
 
     if ( FAILED(hr) )
         image.Release();
@@ -599,6 +1005,14 @@ HRESULT Compress( const Image& srcImage, DXGI_FORMAT format, DWORD compress, flo
 _Use_decl_annotations_
 HRESULT Compress( const Image* srcImages, size_t nimages, const TexMetadata& metadata,
                   DXGI_FORMAT format, DWORD compress, float alphaRef, ScratchImage& cImages )
+{
+    return Compress( srcImages, nimages, metadata, format, compress, alphaRef, cImages, nullptr );
+}
+
+_Use_decl_annotations_
+HRESULT Compress( const Image* srcImages, size_t nimages, const TexMetadata& metadata,
+                  DXGI_FORMAT format, DWORD compress, float alphaRef, ScratchImage& cImages,
+                  std::function<bool(size_t blocksDone, size_t blocksTotal)> progress )
 {
     if ( !srcImages || !nimages )
         return E_INVALIDARG;
@@ -638,32 +1052,13 @@ HRESULT Compress( const Image* srcImages, size_t nimages, const TexMetadata& met
             cImages.Release();
             return E_FAIL;
         }
+    }
 
-        if ( (compress & TEX_COMPRESS_PARALLEL) )
-        {
-#ifndef _OPENMP
-            return E_NOTIMPL;
-#else
-            if ( compress & TEX_COMPRESS_PARALLEL )
-            {
-                hr = _CompressBC_Parallel( src, dest[ index ], _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
-                if ( FAILED(hr) )
-                {
-                    cImages.Release();
-                    return  hr;
-                }
-            }
-#endif // _OPENMP
-        }
-        else
-        {
-            hr = _CompressBC( src, dest[ index ], _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
-            if ( FAILED(hr) )
-            {
-                cImages.Release();
-                return hr;
-            }
-        }
+    hr = _CompressImages( srcImages, dest, nimages, compress, alphaRef, &progress );
+    if ( FAILED(hr) )
+    {
+        cImages.Release();
+        return hr;
     }
 
     return S_OK;
@@ -675,6 +1070,12 @@ HRESULT Compress( const Image* srcImages, size_t nimages, const TexMetadata& met
 //-------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT Decompress( const Image& cImage, DXGI_FORMAT format, ScratchImage& image )
+{
+    return Decompress( cImage, format, TEX_DECOMPRESS_DEFAULT, image );
+}
+
+_Use_decl_annotations_
+HRESULT Decompress( const Image& cImage, DXGI_FORMAT format, DWORD flags, ScratchImage& image )
 {
     if ( IsCompressed(format) || IsTypeless(format) )
         return E_INVALIDARG;
@@ -705,7 +1106,7 @@ HRESULT Decompress( const Image& cImage, DXGI_FORMAT format, ScratchImage& image
     }
 
     // Decompress single image
-    hr = _DecompressBC( cImage, *img );
+    hr = _DecompressBC( &cImage, img, 1, flags );
     if ( FAILED(hr) )
         image.Release();
 
@@ -715,6 +1116,13 @@ HRESULT Decompress( const Image& cImage, DXGI_FORMAT format, ScratchImage& image
 _Use_decl_annotations_
 HRESULT Decompress( const Image* cImages, size_t nimages, const TexMetadata& metadata,
                     DXGI_FORMAT format, ScratchImage& images )
+{
+    return Decompress( cImages, nimages, metadata, format, TEX_DECOMPRESS_DEFAULT, images );
+}
+
+_Use_decl_annotations_
+HRESULT Decompress( const Image* cImages, size_t nimages, const TexMetadata& metadata,
+                    DXGI_FORMAT format, DWORD flags, ScratchImage& images )
 {
     if ( !cImages || !nimages )
         return E_INVALIDARG;
@@ -772,13 +1180,13 @@ HRESULT Decompress( const Image* cImages, size_t nimages, const TexMetadata& met
             images.Release();
             return E_FAIL;
         }
+    }
 
-        hr = _DecompressBC( src, dest[ index ] );
-        if ( FAILED(hr) )
-        {
-            images.Release();
-            return hr;
-        }
+    hr = _DecompressBC( cImages, dest, nimages, flags );
+    if ( FAILED(hr) )
+    {
+        images.Release();
+        return hr;
     }
 
     return S_OK;
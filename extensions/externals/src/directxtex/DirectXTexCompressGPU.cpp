@@ -190,6 +190,45 @@ inline static HRESULT _GPUCompress( _In_ GPUCompressBC* gpubc, _In_ const Image&
 }
 
 
+//-------------------------------------------------------------------------------------
+// DirectCompute only has BC6H and BC7 encoders and needs compute shader support; gpubc is
+// left empty (and S_FALSE returned) when the CPU encoders should be used instead
+//-------------------------------------------------------------------------------------
+static HRESULT _CreateGPUCompressor( _In_opt_ ID3D11Device* pDevice, _In_ DXGI_FORMAT format, _Inout_ std::unique_ptr<GPUCompressBC>& gpubc )
+{
+    gpubc.reset();
+
+    if ( !pDevice )
+        return S_FALSE;
+
+    switch( format )
+    {
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        break;
+
+    default:
+        return S_FALSE;
+    }
+
+    gpubc.reset( new (std::nothrow) GPUCompressBC );
+    if ( !gpubc )
+        return E_OUTOFMEMORY;
+
+    HRESULT hr = gpubc->Initialize( pDevice );
+    if ( hr == HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED ) )
+    {
+        // Feature level 9.x, or 10.x without compute shaders
+        gpubc.reset();
+        return S_FALSE;
+    }
+
+    return hr;
+}
+
+
 //=====================================================================================
 // Entry-points
 //=====================================================================================
@@ -200,18 +239,18 @@ inline static HRESULT _GPUCompress( _In_ GPUCompressBC* gpubc, _In_ const Image&
 _Use_decl_annotations_
 HRESULT Compress( ID3D11Device* pDevice, const Image& srcImage, DXGI_FORMAT format, DWORD compress, ScratchImage& image )
 {
-    if ( !pDevice || IsCompressed(srcImage.format) || !IsCompressed(format) || IsTypeless(format) )
+    if ( IsCompressed(srcImage.format) || !IsCompressed(format) || IsTypeless(format) )
         return E_INVALIDARG;
 
     // Setup GPU compressor
-    std::unique_ptr<GPUCompressBC> gpubc( new (std::nothrow) GPUCompressBC );
-    if ( !gpubc )
-        return E_OUTOFMEMORY;
-
-    HRESULT hr = gpubc->Initialize( pDevice );
+    std::unique_ptr<GPUCompressBC> gpubc;
+    HRESULT hr = _CreateGPUCompressor( pDevice, format, gpubc );
     if ( FAILED(hr) )
         return hr;
 
+    if ( !gpubc )
+        return Compress( srcImage, format, compress | TEX_COMPRESS_PARALLEL, 0.5f, image );
+
     hr = gpubc->Prepare( srcImage.width, srcImage.height, format );
     if ( FAILED(hr) )
         return hr;
@@ -239,7 +278,15 @@ _Use_decl_annotations_
 HRESULT Compress( ID3D11Device* pDevice, const Image* srcImages, size_t nimages, const TexMetadata& metadata,
                   DXGI_FORMAT format, DWORD compress, ScratchImage& cImages )
 {
-    if ( !pDevice || !srcImages || !nimages )
+    return Compress( pDevice, srcImages, nimages, metadata, format, compress, 0.5f, cImages, nullptr );
+}
+
+_Use_decl_annotations_
+HRESULT Compress( ID3D11Device* pDevice, const Image* srcImages, size_t nimages, const TexMetadata& metadata,
+                  DXGI_FORMAT format, DWORD compress, float alphaRef, ScratchImage& cImages,
+                  std::function<bool(size_t blocksDone, size_t blocksTotal)> progress )
+{
+    if ( !srcImages || !nimages )
         return E_INVALIDARG;
 
     if ( !IsCompressed(format) || IsTypeless(format) )
@@ -248,14 +295,16 @@ HRESULT Compress( ID3D11Device* pDevice, const Image* srcImages, size_t nimages,
     cImages.Release();
 
     // Setup GPU compressor
-    std::unique_ptr<GPUCompressBC> gpubc( new (std::nothrow) GPUCompressBC );
-    if ( !gpubc )
-        return E_OUTOFMEMORY;
-
-    HRESULT hr = gpubc->Initialize( pDevice );
+    std::unique_ptr<GPUCompressBC> gpubc;
+    HRESULT hr = _CreateGPUCompressor( pDevice, format, gpubc );
     if ( FAILED(hr) )
         return hr;
 
+    if ( !gpubc )
+    {
+        return Compress( srcImages, nimages, metadata, format, compress | TEX_COMPRESS_PARALLEL, alphaRef, cImages, progress );
+    }
+
     // Create workspace for result
     TexMetadata mdata2 = metadata;
     mdata2.format = format;
@@ -276,6 +325,15 @@ HRESULT Compress( ID3D11Device* pDevice, const Image* srcImages, size_t nimages,
         return E_POINTER;
     }
 
+    // Progress is reported per image since each one is a single dispatch
+    size_t blocksTotal = 0;
+    for( size_t index = 0; index < nimages; ++index )
+    {
+        blocksTotal += std::max<size_t>( 1, ( srcImages[ index ].width + 3 ) / 4 ) * std::max<size_t>( 1, ( srcImages[ index ].height + 3 ) / 4 );
+    }
+
+    size_t blocksDone = 0;
+
     // Process images (ordered by size)
     switch( metadata.dimension )
     {
@@ -319,6 +377,16 @@ HRESULT Compress( ID3D11Device* pDevice, const Image* srcImages, size_t nimages,
                         cImages.Release();
                         return hr;
                     }
+
+                    if ( progress )
+                    {
+                        blocksDone += std::max<size_t>( 1, ( src.width + 3 ) / 4 ) * std::max<size_t>( 1, ( src.height + 3 ) / 4 );
+                        if ( !progress( blocksDone, blocksTotal ) )
+                        {
+                            cImages.Release();
+                            return E_ABORT;
+                        }
+                    }
                 }
 
                 if ( h > 1 )
@@ -370,6 +438,16 @@ HRESULT Compress( ID3D11Device* pDevice, const Image* srcImages, size_t nimages,
                         cImages.Release();
                         return hr;
                     }
+
+                    if ( progress )
+                    {
+                        blocksDone += std::max<size_t>( 1, ( src.width + 3 ) / 4 ) * std::max<size_t>( 1, ( src.height + 3 ) / 4 );
+                        if ( !progress( blocksDone, blocksTotal ) )
+                        {
+                            cImages.Release();
+                            return E_ABORT;
+                        }
+                    }
                 }
 
                 if ( h > 1 )
@@ -385,6 +463,7 @@ HRESULT Compress( ID3D11Device* pDevice, const Image* srcImages, size_t nimages,
         break;
 
     default:
+        cImages.Release();
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
     }
 
@@ -1872,29 +1872,121 @@ HRESULT _ConvertFromR32G32B32A32( const Image* srcImages, size_t nimages, const
 
 
 //-------------------------------------------------------------------------------------
-// Convert from Linear RGB to sRGB
+// Convert between Linear RGB and sRGB
 //
 // if C_linear <= 0.0031308 -> C_srgb = 12.92 * C_linear
 // if C_linear >  0.0031308 -> C_srgb = ( 1 + a ) * pow( C_Linear, 1 / 2.4 ) - a
-//                             where a = 0.055
+//
+// if C_srgb <= 0.04045 -> C_linear = C_srgb / 12.92
+// if C_srgb >  0.04045 -> C_linear = pow( ( C_srgb + a ) / ( 1 + a ), 2.4 )
+//
+//                         where a = 0.055
+//
+// Rather than calling pow for every channel, both directions interpolate tables built
+// once from the formulas above. Decoding uses a 256-entry table so UNORM8 values land on
+// table entries; encoding uses a piecewise-linear table with 64 segments per octave of
+// input above 2^-9. Either direction stays within 1e-5 of the exact curve, which is well
+// under 1% of an 8-bit step. Alpha is passed through unchanged, and RGB is saturated to [0,1].
 //-------------------------------------------------------------------------------------
-#if DIRECTX_MATH_VERSION < 306
-static inline XMVECTOR XMColorRGBToSRGB( FXMVECTOR rgb )
+static const size_t SRGB_DECODE_ENTRIES = 256;
+
+static const uint32_t SRGB_ENCODE_BASE = 0x3B000000;     // 2^-9 as float bits, below the linear cutoff
+static const uint32_t SRGB_ENCODE_SHIFT = 23 - 6;        // 64 segments per octave
+static const size_t SRGB_ENCODE_ENTRIES = ( 9 << 6 ) + 2;
+
+struct SRGBTables
+{
+    float decode[ SRGB_DECODE_ENTRIES ];
+    float encode[ SRGB_ENCODE_ENTRIES ];
+
+    SRGBTables()
+    {
+        for( size_t i = 0; i < SRGB_DECODE_ENTRIES; ++i )
+        {
+            double c = double(i) / 255.0;
+            decode[ i ] = static_cast<float>( ( c <= 0.04045 ) ? ( c / 12.92 ) : pow( ( c + 0.055 ) / 1.055, 2.4 ) );
+        }
+
+        for( size_t i = 0; i < SRGB_ENCODE_ENTRIES; ++i )
+        {
+            // Segment start is 2^-9 plus i segment widths in float bit space (always above the linear cutoff)
+            double c = ldexp( 1.0 + double( i & 63 ) / 64.0, int( i >> 6 ) - 9 );
+            encode[ i ] = static_cast<float>( 1.055 * pow( c, 1.0 / 2.4 ) - 0.055 );
+        }
+    }
+};
+
+static const SRGBTables g_SRGBTables;
+
+static void _LinearToSRGB( _Inout_updates_all_(count) XMVECTOR* pBuffer, _In_ size_t count )
 {
     static const XMVECTORF32 Cutoff = { 0.0031308f, 0.0031308f, 0.0031308f, 1.f };
     static const XMVECTORF32 Linear = { 12.92f, 12.92f, 12.92f, 1.f };
-    static const XMVECTORF32 Scale = { 1.055f, 1.055f, 1.055f, 1.f };
-    static const XMVECTORF32 Bias = { 0.055f, 0.055f, 0.055f, 0.f };
-    static const XMVECTORF32 InvGamma = { 1.0f/2.4f, 1.0f/2.4f, 1.0f/2.4f, 1.f };
-
-    XMVECTOR V = XMVectorSaturate(rgb);
-    XMVECTOR V0 = XMVectorMultiply( V, Linear );
-    XMVECTOR V1 = Scale * XMVectorPow( V, InvGamma ) - Bias;
-    XMVECTOR select = XMVectorLess( V, Cutoff );
-    V = XMVectorSelect( V1, V0, select );
-    return XMVectorSelect( rgb, V, g_XMSelect1110 );
+    static const XMVECTORU32 Base = { SRGB_ENCODE_BASE, SRGB_ENCODE_BASE, SRGB_ENCODE_BASE, SRGB_ENCODE_BASE };
+    static const float FracScale = 1.f / float( 1 << SRGB_ENCODE_SHIFT );
+
+    const float* table = g_SRGBTables.encode;
+
+    XMVECTOR* ptr = pBuffer;
+    for( size_t i = 0; i < count; ++i, ++ptr )
+    {
+        XMVECTOR rgb = *ptr;
+        XMVECTOR V = XMVectorSaturate( rgb );
+        XMVECTOR V0 = XMVectorMultiply( V, Linear );
+
+        // Lanes below 2^-9 take the linear branch, so clamp them to keep the table index in range
+        uint32_t bits[4];
+        XMStoreInt4( bits, XMVectorMax( V, Base ) );
+
+        uint32_t o0 = bits[0] - SRGB_ENCODE_BASE;
+        uint32_t o1 = bits[1] - SRGB_ENCODE_BASE;
+        uint32_t o2 = bits[2] - SRGB_ENCODE_BASE;
+        const float* s0 = table + ( o0 >> SRGB_ENCODE_SHIFT );
+        const float* s1 = table + ( o1 >> SRGB_ENCODE_SHIFT );
+        const float* s2 = table + ( o2 >> SRGB_ENCODE_SHIFT );
+
+        const uint32_t fracMask = ( 1 << SRGB_ENCODE_SHIFT ) - 1;
+        XMVECTOR frac = XMVectorSet( float( o0 & fracMask ), float( o1 & fracMask ), float( o2 & fracMask ), 0.f );
+        XMVECTOR lo = XMVectorSet( s0[0], s1[0], s2[0], 0.f );
+        XMVECTOR hi = XMVectorSet( s0[1], s1[1], s2[1], 0.f );
+        XMVECTOR V1 = XMVectorMultiplyAdd( XMVectorSubtract( hi, lo ), XMVectorScale( frac, FracScale ), lo );
+
+        V = XMVectorSelect( V1, V0, XMVectorLess( V, Cutoff ) );
+        *ptr = XMVectorSelect( rgb, V, g_XMSelect1110 );
+    }
 }
-#endif
+
+static void _SRGBToLinear( _Inout_updates_all_(count) XMVECTOR* pBuffer, _In_ size_t count )
+{
+    static const XMVECTORF32 Scale = { 255.f, 255.f, 255.f, 0.f };
+    static const XMVECTORF32 MaxIndex = { 254.f, 254.f, 254.f, 0.f };
+
+    const float* table = g_SRGBTables.decode;
+
+    XMVECTOR* ptr = pBuffer;
+    for( size_t i = 0; i < count; ++i, ++ptr )
+    {
+        XMVECTOR srgb = *ptr;
+        XMVECTOR T = XMVectorMultiply( XMVectorSaturate( srgb ), Scale );
+
+        // Interpolate between the two entries around T; 1.0 uses the top of the last segment
+        XMVECTOR index = XMVectorTruncate( XMVectorMin( T, MaxIndex ) );
+        XMVECTOR frac = XMVectorSubtract( T, index );
+
+        XMFLOAT4A idx;
+        XMStoreFloat4A( &idx, index );
+        const float* s0 = table + static_cast<size_t>( idx.x );
+        const float* s1 = table + static_cast<size_t>( idx.y );
+        const float* s2 = table + static_cast<size_t>( idx.z );
+
+        XMVECTOR lo = XMVectorSet( s0[0], s1[0], s2[0], 0.f );
+        XMVECTOR hi = XMVectorSet( s0[1], s1[1], s2[1], 0.f );
+        XMVECTOR V = XMVectorMultiplyAdd( XMVectorSubtract( hi, lo ), frac, lo );
+
+        *ptr = XMVectorSelect( srgb, V, g_XMSelect1110 );
+    }
+}
+
 
 _Use_decl_annotations_
 bool _StoreScanlineLinear( LPVOID pDestination, size_t size, DXGI_FORMAT format,
@@ -1948,42 +2040,13 @@ bool _StoreScanlineLinear( LPVOID pDestination, size_t size, DXGI_FORMAT format,
     {
         // To avoid the need for another temporary scanline buffer, we allow this function to overwrite the source buffer in-place
         // Given the intended usage in the filtering routines, this is not a problem.
-        XMVECTOR* ptr = pSource;
-        for( size_t i=0; i < count; ++i, ++ptr )
-        {
-            *ptr = XMColorRGBToSRGB( *ptr );
-        }
+        _LinearToSRGB( pSource, count );
     }
 
     return _StoreScanline( pDestination, size, format, pSource, count );
 }
 
 
-//-------------------------------------------------------------------------------------
-// Convert from sRGB to Linear RGB
-//
-// if C_srgb <= 0.04045 -> C_linear = C_srgb / 12.92
-// if C_srgb >  0.04045 -> C_linear = pow( ( C_srgb + a ) / ( 1 + a ), 2.4 )
-//                         where a = 0.055
-//-------------------------------------------------------------------------------------
-#if DIRECTX_MATH_VERSION < 306
-static inline XMVECTOR XMColorSRGBToRGB( FXMVECTOR srgb )
-{
-    static const XMVECTORF32 Cutoff = { 0.04045f, 0.04045f, 0.04045f, 1.f };
-    static const XMVECTORF32 ILinear = { 1.f/12.92f, 1.f/12.92f, 1.f/12.92f, 1.f };
-    static const XMVECTORF32 Scale = { 1.f/1.055f, 1.f/1.055f, 1.f/1.055f, 1.f };
-    static const XMVECTORF32 Bias = { 0.055f, 0.055f, 0.055f, 0.f };
-    static const XMVECTORF32 Gamma = { 2.4f, 2.4f, 2.4f, 1.f };
-
-    XMVECTOR V = XMVectorSaturate(srgb);
-    XMVECTOR V0 = XMVectorMultiply( V, ILinear );
-    XMVECTOR V1 = XMVectorPow( (V + Bias) * Scale, Gamma );
-    XMVECTOR select = XMVectorGreater( V, Cutoff );
-    V = XMVectorSelect( V0, V1, select );
-    return XMVectorSelect( srgb, V, g_XMSelect1110 );
-}
-#endif
-
 _Use_decl_annotations_
 bool _LoadScanlineLinear( XMVECTOR* pDestination, size_t count,
                           LPCVOID pSource, size_t size, DXGI_FORMAT format, DWORD flags )
@@ -2036,11 +2099,7 @@ bool _LoadScanlineLinear( XMVECTOR* pDestination, size_t count,
         // sRGB input processing (sRGB -> Linear RGB)
         if ( flags & TEX_FILTER_SRGB_IN )
         {
-            XMVECTOR* ptr = pDestination;
-            for( size_t i=0; i < count; ++i, ++ptr )
-            {
-                *ptr = XMColorSRGBToRGB( *ptr );
-            }
+            _SRGBToLinear( pDestination, count );
         }
 
         return true;
@@ -2251,11 +2310,7 @@ void _ConvertScanline( XMVECTOR* pBuffer, size_t count, DXGI_FORMAT outFormat, D
     {
         if ( !(in->flags & CONVF_DEPTH) && ( (in->flags & CONVF_FLOAT) || (in->flags & CONVF_UNORM) ) )
         {
-            XMVECTOR* ptr = pBuffer;
-            for( size_t i=0; i < count; ++i, ++ptr )
-            {
-                *ptr = XMColorSRGBToRGB( *ptr );
-            }
+            _SRGBToLinear( pBuffer, count );
         }
     }
 
@@ -2451,11 +2506,7 @@ void _ConvertScanline( XMVECTOR* pBuffer, size_t count, DXGI_FORMAT outFormat, D
     {
         if ( !(out->flags & CONVF_DEPTH) && ( (out->flags & CONVF_FLOAT) || (out->flags & CONVF_UNORM) ) )
         {
-            XMVECTOR* ptr = pBuffer;
-            for( size_t i=0; i < count; ++i, ++ptr )
-            {
-                *ptr = XMColorRGBToSRGB( *ptr );
-            }
+            _LinearToSRGB( pBuffer, count );
         }
     }
 }
@@ -3194,6 +3245,289 @@ static HRESULT _ConvertUsingWIC( _In_ const Image& srcImage, _In_ const WICPixel
 }
 
 
+//-------------------------------------------------------------------------------------
+// Direct scanline conversions for common format pairs that don't need the XMVECTOR
+// round-trip. Each produces the same bits as the non-WIC path for that pair when no
+// colorspace conversion or dithering is requested.
+//-------------------------------------------------------------------------------------
+struct DirectTables
+{
+    uint8_t     unorm8[256];    // UNORM8 -> float -> UNORM8
+    uint32_t    udec10[256];    // UNORM8 -> float -> 10-bit UNORM
+    uint32_t    udec2[256];     // UNORM8 -> float -> 2-bit UNORM
+    uint32_t    udec2one;       // 1.0 -> 2-bit UNORM
+    bool        identity8;
+};
+
+typedef void (*DIRECT_CONVERT)( _Out_ void* pDestination, _In_ const void* pSource, _In_ size_t count, _In_ const DirectTables& tables );
+
+enum DIRECT_CONVERT_FLAGS
+{
+    DCONVF_EXACT    = 0x1,  // Moves bits without requantizing so it can stand in for WIC too
+    DCONVF_UNORM8   = 0x2,  // Only exact when UNORM8 values survive the float round-trip
+};
+
+static void _BuildDirectTables( _Out_ DirectTables& tables )
+{
+    // Quantize through the same load/store routines the scanline path uses so the results match
+    tables.identity8 = true;
+    for( uint32_t i = 0; i < 256; ++i )
+    {
+        XMUBYTEN4 b;
+        b.v = i | ( i << 8 ) | ( i << 16 ) | ( i << 24 );
+        XMVECTOR v = XMLoadUByteN4( &b );
+
+        XMStoreUByteN4( &b, v );
+        tables.unorm8[ i ] = static_cast<uint8_t>( b.v & 0xFF );
+        if ( tables.unorm8[ i ] != i )
+            tables.identity8 = false;
+
+        XMUDECN4 d;
+        XMStoreUDecN4( &d, v );
+        tables.udec10[ i ] = d.v & 0x3FF;
+        tables.udec2[ i ] = d.v >> 30;
+    }
+
+    XMUDECN4 d;
+    XMStoreUDecN4( &d, g_XMOne );
+    tables.udec2one = d.v >> 30;
+}
+
+#pragma warning(push)
+#pragma warning( disable : 4127 )
+
+// RGBA8/BGRA8/BGRX8 <-> RGBA8/BGRA8/BGRX8, optionally exchanging red and blue and forcing alpha to 1
+template<bool swap, bool setalpha>
+static void _Direct8888( void* pDestination, const void* pSource, size_t count, const DirectTables& tables )
+{
+    const uint32_t * __restrict sPtr = reinterpret_cast<const uint32_t*>( pSource );
+    uint32_t * __restrict dPtr = reinterpret_cast<uint32_t*>( pDestination );
+
+    if ( !tables.identity8 )
+    {
+        const uint8_t* remap = tables.unorm8;
+        for( size_t i = 0; i < count; ++i )
+        {
+            uint32_t t = sPtr[ i ];
+            uint32_t r = remap[ t & 0xFF ];
+            uint32_t g = remap[ ( t >> 8 ) & 0xFF ];
+            uint32_t b = remap[ ( t >> 16 ) & 0xFF ];
+            uint32_t a = ( setalpha ) ? 0xFF : remap[ t >> 24 ];
+            if ( swap )
+                std::swap( r, b );
+            dPtr[ i ] = r | ( g << 8 ) | ( b << 16 ) | ( a << 24 );
+        }
+        return;
+    }
+
+    if ( !swap && !setalpha )
+    {
+        memcpy( dPtr, sPtr, count * sizeof(uint32_t) );
+        return;
+    }
+
+    size_t i = 0;
+
+#if defined(_XM_SSE_INTRINSICS_)
+    const __m128i alpha = _mm_set1_epi32( ( setalpha ) ? static_cast<int>( 0xFF000000 ) : 0 );
+    const __m128i maskGA = _mm_set1_epi32( static_cast<int>( 0xFF00FF00 ) );
+    for( ; ( i + 4 ) <= count; i += 4 )
+    {
+        __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( sPtr + i ) );
+        if ( swap )
+        {
+            // Red and blue are the two 16-bit halves of each 0x00BB00RR lane
+            __m128i rb = _mm_andnot_si128( maskGA, v );
+            rb = _mm_shufflehi_epi16( _mm_shufflelo_epi16( rb, _MM_SHUFFLE(2,3,0,1) ), _MM_SHUFFLE(2,3,0,1) );
+            v = _mm_or_si128( _mm_and_si128( v, maskGA ), rb );
+        }
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dPtr + i ), _mm_or_si128( v, alpha ) );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        uint32_t t = sPtr[ i ];
+        if ( swap )
+            t = ( t & 0xFF00FF00 ) | ( ( t >> 16 ) & 0xFF ) | ( ( t & 0xFF ) << 16 );
+        dPtr[ i ] = ( setalpha ) ? ( t | 0xFF000000 ) : t;
+    }
+}
+
+// RGBA8/BGRA8/BGRX8 -> R10G10B10A2_UNORM
+template<bool bgr, bool setalpha>
+static void _Direct8888To1010102( void* pDestination, const void* pSource, size_t count, const DirectTables& tables )
+{
+    const uint32_t * __restrict sPtr = reinterpret_cast<const uint32_t*>( pSource );
+    uint32_t * __restrict dPtr = reinterpret_cast<uint32_t*>( pDestination );
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        uint32_t t = sPtr[ i ];
+        uint32_t r = tables.udec10[ t & 0xFF ];
+        uint32_t g = tables.udec10[ ( t >> 8 ) & 0xFF ];
+        uint32_t b = tables.udec10[ ( t >> 16 ) & 0xFF ];
+        uint32_t a = ( setalpha ) ? tables.udec2one : tables.udec2[ t >> 24 ];
+        if ( bgr )
+            std::swap( r, b );
+        dPtr[ i ] = r | ( g << 10 ) | ( b << 20 ) | ( a << 30 );
+    }
+}
+
+#pragma warning(pop)
+
+// 16-bit float -> 32-bit float with the same number of channels
+template<size_t channels>
+static void _DirectHalfToFloat( void* pDestination, const void* pSource, size_t count, const DirectTables& )
+{
+    XMConvertHalfToFloatStream( reinterpret_cast<float*>( pDestination ), sizeof(float),
+                                reinterpret_cast<const HALF*>( pSource ), sizeof(HALF), count * channels );
+}
+
+// 32-bit float -> 16-bit float with the same number of channels
+template<size_t channels>
+static void _DirectFloatToHalf( void* pDestination, const void* pSource, size_t count, const DirectTables& )
+{
+    XMConvertFloatToHalfStream( reinterpret_cast<HALF*>( pDestination ), sizeof(HALF),
+                                reinterpret_cast<const float*>( pSource ), sizeof(float), count * channels );
+}
+
+struct DirectConvertData
+{
+    DXGI_FORMAT     in;
+    DXGI_FORMAT     out;
+    DIRECT_CONVERT  pfConvert;
+    DWORD           flags;
+};
+
+static const DirectConvertData g_DirectConvertTable[] = {
+    // Relabels
+    { DXGI_FORMAT_R8G8B8A8_UNORM,       DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,    _Direct8888<false, false>,  DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  DXGI_FORMAT_R8G8B8A8_UNORM,         _Direct8888<false, false>,  DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM,       DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,    _Direct8888<false, false>,  DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8A8_UNORM,         _Direct8888<false, false>,  DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM,       DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,    _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8X8_UNORM,         _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+
+    // BGRA <-> BGRX
+    { DXGI_FORMAT_B8G8R8A8_UNORM,       DXGI_FORMAT_B8G8R8X8_UNORM,         _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM,       DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,    _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8X8_UNORM,         _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,    _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM,       DXGI_FORMAT_B8G8R8A8_UNORM,         _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM,       DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,    _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8A8_UNORM,         _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,    _Direct8888<false, true>,   DCONVF_EXACT | DCONVF_UNORM8 },
+
+    // RGBA <-> BGRA
+    { DXGI_FORMAT_R8G8B8A8_UNORM,       DXGI_FORMAT_B8G8R8A8_UNORM,         _Direct8888<true, false>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_R8G8B8A8_UNORM,       DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,    _Direct8888<true, false>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8A8_UNORM,         _Direct8888<true, false>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,    _Direct8888<true, false>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM,       DXGI_FORMAT_R8G8B8A8_UNORM,         _Direct8888<true, false>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM,       DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,    _Direct8888<true, false>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,  DXGI_FORMAT_R8G8B8A8_UNORM,         _Direct8888<true, false>,   DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,  DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,    _Direct8888<true, false>,   DCONVF_EXACT | DCONVF_UNORM8 },
+
+    // RGBA <-> BGRX
+    { DXGI_FORMAT_R8G8B8A8_UNORM,       DXGI_FORMAT_B8G8R8X8_UNORM,         _Direct8888<true, true>,    DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_R8G8B8A8_UNORM,       DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,    _Direct8888<true, true>,    DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8X8_UNORM,         _Direct8888<true, true>,    DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,    _Direct8888<true, true>,    DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM,       DXGI_FORMAT_R8G8B8A8_UNORM,         _Direct8888<true, true>,    DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM,       DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,    _Direct8888<true, true>,    DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,  DXGI_FORMAT_R8G8B8A8_UNORM,         _Direct8888<true, true>,    DCONVF_EXACT | DCONVF_UNORM8 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,  DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,    _Direct8888<true, true>,    DCONVF_EXACT | DCONVF_UNORM8 },
+
+    // 8:8:8:8 -> 10:10:10:2
+    { DXGI_FORMAT_R8G8B8A8_UNORM,       DXGI_FORMAT_R10G10B10A2_UNORM,      _Direct8888To1010102<false, false>, 0 },
+    { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  DXGI_FORMAT_R10G10B10A2_UNORM,      _Direct8888To1010102<false, false>, 0 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM,       DXGI_FORMAT_R10G10B10A2_UNORM,      _Direct8888To1010102<true, false>,  0 },
+    { DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,  DXGI_FORMAT_R10G10B10A2_UNORM,      _Direct8888To1010102<true, false>,  0 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM,       DXGI_FORMAT_R10G10B10A2_UNORM,      _Direct8888To1010102<true, true>,   0 },
+    { DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,  DXGI_FORMAT_R10G10B10A2_UNORM,      _Direct8888To1010102<true, true>,   0 },
+
+    // Half <-> float
+    { DXGI_FORMAT_R16_FLOAT,            DXGI_FORMAT_R32_FLOAT,              _DirectHalfToFloat<1>,      DCONVF_EXACT },
+    { DXGI_FORMAT_R16G16_FLOAT,         DXGI_FORMAT_R32G32_FLOAT,           _DirectHalfToFloat<2>,      DCONVF_EXACT },
+    { DXGI_FORMAT_R16G16B16A16_FLOAT,   DXGI_FORMAT_R32G32B32A32_FLOAT,     _DirectHalfToFloat<4>,      DCONVF_EXACT },
+    { DXGI_FORMAT_R32_FLOAT,            DXGI_FORMAT_R16_FLOAT,              _DirectFloatToHalf<1>,      0 },
+    { DXGI_FORMAT_R32G32_FLOAT,         DXGI_FORMAT_R16G16_FLOAT,           _DirectFloatToHalf<2>,      0 },
+    { DXGI_FORMAT_R32G32B32A32_FLOAT,   DXGI_FORMAT_R16G16B16A16_FLOAT,     _DirectFloatToHalf<4>,      0 },
+};
+
+static DIRECT_CONVERT _UseDirectConversion( _In_ DWORD filter, _In_ DXGI_FORMAT sformat, _In_ DXGI_FORMAT tformat,
+                                            _In_ bool usewic, _Inout_ DirectTables& tables )
+{
+    if ( filter & (TEX_FILTER_FORCE_WIC | TEX_FILTER_DITHER | TEX_FILTER_DITHER_DIFFUSION) )
+        return nullptr;
+
+    // Direct conversions never change color space
+    if ( IsSRGB( sformat ) )
+        filter |= TEX_FILTER_SRGB_IN;
+
+    if ( IsSRGB( tformat ) )
+        filter |= TEX_FILTER_SRGB_OUT;
+
+    if ( (filter & (TEX_FILTER_SRGB_IN|TEX_FILTER_SRGB_OUT)) == (TEX_FILTER_SRGB_IN|TEX_FILTER_SRGB_OUT) )
+    {
+        filter &= ~(TEX_FILTER_SRGB_IN|TEX_FILTER_SRGB_OUT);
+    }
+
+    if ( filter & (TEX_FILTER_SRGB_IN|TEX_FILTER_SRGB_OUT) )
+        return nullptr;
+
+    for( size_t index = 0; index < _countof(g_DirectConvertTable); ++index )
+    {
+        const DirectConvertData& entry = g_DirectConvertTable[ index ];
+        if ( entry.in != sformat || entry.out != tformat )
+            continue;
+
+        _BuildDirectTables( tables );
+
+        if ( usewic )
+        {
+            // Only take over from WIC when the result is identical to a straight copy of the bits
+            if ( !(entry.flags & DCONVF_EXACT) )
+                return nullptr;
+
+            if ( (entry.flags & DCONVF_UNORM8) && !tables.identity8 )
+                return nullptr;
+        }
+
+        return entry.pfConvert;
+    }
+
+    return nullptr;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Convert the source image using a direct scanline conversion
+//-------------------------------------------------------------------------------------
+static HRESULT _ConvertDirect( _In_ const Image& srcImage, _In_ DIRECT_CONVERT pfConvert, _In_ const DirectTables& tables, _In_ const Image& destImage )
+{
+    assert( srcImage.width == destImage.width );
+    assert( srcImage.height == destImage.height );
+    assert( pfConvert != 0 );
+
+    const uint8_t *pSrc = srcImage.pixels;
+    uint8_t *pDest = destImage.pixels;
+    if ( !pSrc || !pDest )
+        return E_POINTER;
+
+    for( size_t h = 0; h < srcImage.height; ++h )
+    {
+        pfConvert( pDest, pSrc, srcImage.width, tables );
+
+        pSrc += srcImage.rowPitch;
+        pDest += destImage.rowPitch;
+    }
+
+    return S_OK;
+}
+
+
 //-------------------------------------------------------------------------------------
 // Convert the source image (not using WIC)
 //-------------------------------------------------------------------------------------
@@ -3279,6 +3613,28 @@ static HRESULT _Convert( _In_ const Image& srcImage, _In_ DWORD filter, _In_ con
 }
 
 
+//-------------------------------------------------------------------------------------
+// Converts a band of rows without WIC; for ordered dithering the band should start on
+// a multiple of 4 rows so the pattern lines up with its neighbors
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT _ConvertRows( const Image& srcImage, DWORD filter, const Image& destImage, float threshold )
+{
+    if ( filter & TEX_FILTER_DITHER_DIFFUSION )
+    {
+        // Error diffusion carries from row to row, so it can't be split into bands
+        return E_INVALIDARG;
+    }
+
+    DirectTables tables;
+    DIRECT_CONVERT pfDirect = _UseDirectConversion( filter, srcImage.format, destImage.format, false, tables );
+    if ( pfDirect )
+        return _ConvertDirect( srcImage, pfDirect, tables, destImage );
+
+    return _Convert( srcImage, filter, destImage, threshold, 0 );
+}
+
+
 //=====================================================================================
 // Entry-points
 //=====================================================================================
@@ -3317,7 +3673,16 @@ HRESULT Convert( const Image& srcImage, DXGI_FORMAT format, DWORD filter, float
     }
 
     WICPixelFormatGUID pfGUID, targetGUID;
-    if ( _UseWICConversion( filter, srcImage.format, format, pfGUID, targetGUID ) )
+    bool usewic = _UseWICConversion( filter, srcImage.format, format, pfGUID, targetGUID );
+
+    DirectTables tables;
+    DIRECT_CONVERT pfDirect = _UseDirectConversion( filter, srcImage.format, format, usewic, tables );
+
+    if ( pfDirect )
+    {
+        hr = _ConvertDirect( srcImage, pfDirect, tables, *rimage );
+    }
+    else if ( usewic )
     {
         hr = _ConvertUsingWIC( srcImage, pfGUID, targetGUID, filter, threshold, *rimage );
     }
@@ -3378,6 +3743,9 @@ HRESULT Convert( const Image* srcImages, size_t nimages, const TexMetadata& meta
     WICPixelFormatGUID pfGUID, targetGUID;
     bool usewic = _UseWICConversion( filter, metadata.format, format, pfGUID, targetGUID );
 
+    DirectTables tables;
+    DIRECT_CONVERT pfDirect = _UseDirectConversion( filter, metadata.format, format, usewic, tables );
+
     switch (metadata.dimension)
     {
     case TEX_DIMENSION_TEXTURE1D:
@@ -3405,7 +3773,11 @@ HRESULT Convert( const Image* srcImages, size_t nimages, const TexMetadata& meta
                 return E_FAIL;
             }
 
-            if ( usewic )
+            if ( pfDirect )
+            {
+                hr = _ConvertDirect( src, pfDirect, tables, dst );
+            }
+            else if ( usewic )
             {
                 hr = _ConvertUsingWIC( src, pfGUID, targetGUID, filter, threshold, dst );
             }
@@ -3454,7 +3826,11 @@ HRESULT Convert( const Image* srcImages, size_t nimages, const TexMetadata& meta
                         return E_FAIL;
                     }
 
-                    if ( usewic )
+                    if ( pfDirect )
+                    {
+                        hr = _ConvertDirect( src, pfDirect, tables, dst );
+                    }
+                    else if ( usewic )
                     {
                         hr = _ConvertUsingWIC( src, pfGUID, targetGUID, filter, threshold, dst );
                     }
@@ -17,6 +17,8 @@
 
 #include "dds.h"
 
+#include <process.h>
+
 namespace DirectX
 {
 
@@ -1576,6 +1578,155 @@ HRESULT LoadFromDDSFile( LPCWSTR szFile, DWORD flags, TexMetadata* metadata, Scr
 }
 
 
+//-------------------------------------------------------------------------------------
+// Load a DDS file from disk by mapping it into memory
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT LoadFromDDSFile( LPCWSTR szFile, DWORD flags, TexMetadata* metadata, MappedImage& image )
+{
+    if ( !szFile )
+        return E_INVALIDARG;
+
+    image.Release();
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile( safe_handle ( CreateFile2( szFile, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, 0 ) ) );
+#else
+    ScopedHandle hFile( safe_handle ( CreateFileW( szFile, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                                   FILE_ATTRIBUTE_NORMAL, 0 ) ) );
+#endif
+
+    if ( !hFile )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    // Get the file size
+    LARGE_INTEGER fileSize = {0};
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_VISTA)
+    FILE_STANDARD_INFO fileInfo;
+    if ( !GetFileInformationByHandleEx( hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo) ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+    fileSize = fileInfo.EndOfFile;
+#else
+    if ( !GetFileSizeEx( hFile.get(), &fileSize ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+#endif
+
+    // Files over 4 GB can only be mapped in a 64-bit address space
+    if ( fileSize.QuadPart < 0 || static_cast<uint64_t>( fileSize.QuadPart ) > static_cast<uint64_t>( SIZE_MAX ) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_FILE_TOO_LARGE );
+    }
+
+    const size_t size = static_cast<size_t>( fileSize.QuadPart );
+
+    // Need at least enough data to fill the standard header and magic number to be a valid DDS
+    if ( size < ( sizeof(DDS_HEADER) + sizeof(uint32_t) ) )
+    {
+        return E_FAIL;
+    }
+
+    // The view keeps the mapping alive after the handles are closed
+    ScopedHandle hMapping( CreateFileMappingW( hFile.get(), 0, PAGE_READONLY, 0, 0, 0 ) );
+    if ( !hMapping )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    const uint8_t* pView = reinterpret_cast<const uint8_t*>( MapViewOfFile( hMapping.get(), FILE_MAP_READ, 0, 0, 0 ) );
+    if ( !pView )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    image._view = pView;
+
+    DWORD convFlags = 0;
+    TexMetadata mdata;
+    HRESULT hr = _DecodeDDSHeader( pView, size, flags, mdata, convFlags );
+    if ( FAILED(hr) )
+    {
+        image.Release();
+        return hr;
+    }
+
+    if ( (convFlags & (CONV_FLAGS_EXPAND | CONV_FLAGS_NOALPHA | CONV_FLAGS_SWIZZLE | CONV_FLAGS_PAL8))
+         || (flags & DDS_FLAGS_LEGACY_DWORD) )
+    {
+        // Pixels need converting, so copy them out of the mapping and release it
+        hr = LoadFromDDSMemory( pView, size, flags, nullptr, image._copy );
+        if ( FAILED(hr) )
+        {
+            image.Release();
+            return hr;
+        }
+
+        UnmapViewOfFile( image._view );
+        image._view = nullptr;
+
+        image._nimages = image._copy.GetImageCount();
+        image._image = new (std::nothrow) Image[ image._nimages ];
+        if ( !image._image )
+        {
+            image.Release();
+            return E_OUTOFMEMORY;
+        }
+
+        memcpy( image._image, image._copy.GetImages(), sizeof(Image) * image._nimages );
+        image._pixels = image._copy.GetPixels();
+        image._size = image._copy.GetPixelsSize();
+    }
+    else
+    {
+        size_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER);
+        if ( convFlags & CONV_FLAGS_DX10 )
+            offset += sizeof(DDS_HEADER_DXT10);
+
+        assert( offset <= size );
+
+        size_t pixelSize, nimages;
+        _DetermineImageArray( mdata, CP_FLAGS_NONE, nimages, pixelSize );
+        if ( !nimages || pixelSize > ( size - offset ) )
+        {
+            image.Release();
+            return E_FAIL;
+        }
+
+        image._image = new (std::nothrow) Image[ nimages ];
+        if ( !image._image )
+        {
+            image.Release();
+            return E_OUTOFMEMORY;
+        }
+
+        // Image views point straight into the read-only mapping
+        uint8_t* pPixels = const_cast<uint8_t*>( pView + offset );
+        if ( !_SetupImageArray( pPixels, pixelSize, mdata, CP_FLAGS_NONE, image._image, nimages ) )
+        {
+            image.Release();
+            return E_FAIL;
+        }
+
+        image._nimages = nimages;
+        image._pixels = pPixels;
+        image._size = pixelSize;
+    }
+
+    image._metadata = mdata;
+
+    if ( metadata )
+        memcpy( metadata, &mdata, sizeof(TexMetadata) );
+
+    return S_OK;
+}
+
+
 //-------------------------------------------------------------------------------------
 // Save a DDS file to memory
 //-------------------------------------------------------------------------------------
@@ -1820,4 +1971,801 @@ HRESULT SaveToDDSFile( const Image* images, size_t nimages, const TexMetadata& m
     return S_OK;
 }
 
+
+//=====================================================================================
+// DDSFileWriter - Streaming DDS file writer
+//=====================================================================================
+
+//-------------------------------------------------------------------------------------
+// Writes a buffer that may be larger than a single WriteFile call allows
+//-------------------------------------------------------------------------------------
+static HRESULT _WriteBytes( _In_ HANDLE hFile, _In_reads_bytes_(size) const uint8_t* pData, _In_ size_t size )
+{
+    while( size > 0 )
+    {
+        DWORD chunk = static_cast<DWORD>( std::min<size_t>( size, 0x40000000 ) );
+
+        DWORD bytesWritten;
+        if ( !WriteFile( hFile, pData, chunk, &bytesWritten, 0 ) )
+        {
+            return HRESULT_FROM_WIN32( GetLastError() );
+        }
+
+        if ( bytesWritten != chunk )
+        {
+            return E_FAIL;
+        }
+
+        pData += chunk;
+        size -= chunk;
+    }
+
+    return S_OK;
+}
+
+//-------------------------------------------------------------------------------------
+// Computes the file offset of each subresource, indexed as by TexMetadata::ComputeIndex
+//-------------------------------------------------------------------------------------
+static HRESULT _ComputeSubresourceOffsets( _In_ const TexMetadata& metadata, _In_ DWORD cpFlags, _In_ uint64_t baseOffset,
+                                           _Out_writes_(nimages) uint64_t* offsets, _In_ size_t nimages, _Out_ uint64_t& end )
+{
+    // Subresources follow the header in the same order as ScratchImage stores them
+    uint64_t offset = baseOffset;
+    size_t index = 0;
+
+    switch( metadata.dimension )
+    {
+    case TEX_DIMENSION_TEXTURE1D:
+    case TEX_DIMENSION_TEXTURE2D:
+        for( size_t item = 0; item < metadata.arraySize; ++item )
+        {
+            size_t w = metadata.width;
+            size_t h = metadata.height;
+
+            for( size_t level = 0; level < metadata.mipLevels; ++level, ++index )
+            {
+                if ( index >= nimages )
+                    return E_FAIL;
+
+                size_t rowPitch, slicePitch;
+                ComputePitch( metadata.format, w, h, rowPitch, slicePitch, cpFlags );
+
+                offsets[ index ] = offset;
+                offset += slicePitch;
+
+                if ( h > 1 )
+                    h >>= 1;
+
+                if ( w > 1 )
+                    w >>= 1;
+            }
+        }
+        break;
+
+    case TEX_DIMENSION_TEXTURE3D:
+        {
+            size_t w = metadata.width;
+            size_t h = metadata.height;
+            size_t d = metadata.depth;
+
+            for( size_t level = 0; level < metadata.mipLevels; ++level )
+            {
+                size_t rowPitch, slicePitch;
+                ComputePitch( metadata.format, w, h, rowPitch, slicePitch, cpFlags );
+
+                for( size_t slice = 0; slice < d; ++slice, ++index )
+                {
+                    if ( index >= nimages )
+                        return E_FAIL;
+
+                    offsets[ index ] = offset;
+                    offset += slicePitch;
+                }
+
+                if ( h > 1 )
+                    h >>= 1;
+
+                if ( w > 1 )
+                    w >>= 1;
+
+                if ( d > 1 )
+                    d >>= 1;
+            }
+        }
+        break;
+
+    default:
+        return E_FAIL;
+    }
+
+    end = offset;
+
+    return ( index == nimages ) ? S_OK : E_FAIL;
+}
+
+_Use_decl_annotations_
+HRESULT DDSFileWriter::Create( LPCWSTR szFile, const TexMetadata& metadata, DWORD flags )
+{
+    if ( !szFile )
+        return E_INVALIDARG;
+
+    Close();
+
+    if ( metadata.dimension == TEX_DIMENSION_TEXTURE3D && metadata.arraySize != 1 )
+        return E_INVALIDARG;
+
+    // Create DDS Header
+    const size_t MAX_HEADER_SIZE = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+    uint8_t header[MAX_HEADER_SIZE];
+    size_t required;
+    HRESULT hr = _EncodeDDSHeader( metadata, flags, header, MAX_HEADER_SIZE, required );
+    if ( FAILED(hr) )
+        return hr;
+
+    size_t nimages, pixelSize;
+    _DetermineImageArray( metadata, CP_FLAGS_NONE, nimages, pixelSize );
+    if ( !nimages )
+        return E_INVALIDARG;
+
+    std::unique_ptr<uint64_t[]> offsets( new (std::nothrow) uint64_t[ nimages ] );
+    std::unique_ptr<bool[]> written( new (std::nothrow) bool[ nimages ] );
+    if ( !offsets || !written )
+        return E_OUTOFMEMORY;
+
+    uint64_t end;
+    hr = _ComputeSubresourceOffsets( metadata, CP_FLAGS_NONE, required, offsets.get(), nimages, end );
+    if ( FAILED(hr) )
+        return hr;
+
+    // Create file and write header
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile( safe_handle( CreateFile2( szFile, GENERIC_WRITE, 0, CREATE_ALWAYS, 0 ) ) );
+#else
+    ScopedHandle hFile( safe_handle( CreateFileW( szFile, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0 ) ) );
+#endif
+    if ( !hFile )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    hr = _WriteBytes( hFile.get(), header, required );
+    if ( FAILED(hr) )
+        return hr;
+
+    memset( written.get(), 0, sizeof(bool) * nimages );
+
+    _hFile = hFile.release();
+    _metadata = metadata;
+    _nimages = nimages;
+    _nwritten = 0;
+    _offsets = offsets.release();
+    _written = written.release();
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DDSFileWriter::WriteImage( const Image& image, size_t mip, size_t item, size_t slice )
+{
+    if ( !_hFile )
+        return E_FAIL;
+
+    size_t index = _metadata.ComputeIndex( mip, item, slice );
+    if ( index >= _nimages )
+        return E_INVALIDARG;
+
+    if ( !image.pixels )
+        return E_POINTER;
+
+    const size_t width = std::max<size_t>( 1, _metadata.width >> mip );
+    const size_t height = std::max<size_t>( 1, _metadata.height >> mip );
+    if ( image.width != width || image.height != height || image.format != _metadata.format )
+        return E_INVALIDARG;
+
+    size_t rowPitch, slicePitch;
+    ComputePitch( _metadata.format, width, height, rowPitch, slicePitch, CP_FLAGS_NONE );
+
+    if ( image.rowPitch < rowPitch )
+        return E_INVALIDARG;
+
+    LARGE_INTEGER filePos;
+    filePos.QuadPart = static_cast<LONGLONG>( _offsets[ index ] );
+    if ( !SetFilePointerEx( _hFile, filePos, 0, FILE_BEGIN ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    HRESULT hr = S_OK;
+    if ( image.rowPitch == rowPitch )
+    {
+        hr = _WriteBytes( _hFile, image.pixels, slicePitch );
+    }
+    else
+    {
+        // Drop the padding at the end of each row
+        const size_t rows = slicePitch / rowPitch;
+        const uint8_t* pSrc = image.pixels;
+        for( size_t y = 0; y < rows && SUCCEEDED(hr); ++y )
+        {
+            hr = _WriteBytes( _hFile, pSrc, rowPitch );
+            pSrc += image.rowPitch;
+        }
+    }
+
+    if ( FAILED(hr) )
+        return hr;
+
+    if ( !_written[ index ] )
+    {
+        _written[ index ] = true;
+        ++_nwritten;
+    }
+
+    return S_OK;
+}
+
+HRESULT DDSFileWriter::Close()
+{
+    HRESULT hr = S_OK;
+
+    if ( _hFile )
+    {
+        if ( _nwritten != _nimages )
+            hr = E_FAIL;
+
+        CloseHandle( _hFile );
+        _hFile = nullptr;
+    }
+
+    if ( _offsets )
+    {
+        delete [] _offsets;
+        _offsets = nullptr;
+    }
+
+    if ( _written )
+    {
+        delete [] _written;
+        _written = nullptr;
+    }
+
+    _nimages = 0;
+    _nwritten = 0;
+
+    memset(&_metadata, 0, sizeof(_metadata));
+
+    return hr;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Save a DDS file to disk, producing one subresource at a time
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT SaveToDDSFile( const TexMetadata& metadata, DWORD flags, LPCWSTR szFile,
+                       std::function<HRESULT(size_t mip, size_t item, size_t slice, const Image& image)> produceImage )
+{
+    if ( !szFile || !produceImage )
+        return E_INVALIDARG;
+
+    DDSFileWriter writer;
+    HRESULT hr = writer.Create( szFile, metadata, flags );
+    if ( FAILED(hr) )
+        return hr;
+
+    // The top mip is the largest subresource, so one buffer of that size is reused for all of them
+    size_t rowPitch, slicePitch;
+    ComputePitch( metadata.format, metadata.width, metadata.height, rowPitch, slicePitch, CP_FLAGS_NONE );
+
+    std::unique_ptr<uint8_t, aligned_deleter> buffer( reinterpret_cast<uint8_t*>( _aligned_malloc( slicePitch, 16 ) ) );
+    if ( !buffer )
+        return E_OUTOFMEMORY;
+
+    const size_t nitems = ( metadata.dimension == TEX_DIMENSION_TEXTURE3D ) ? 1 : metadata.arraySize;
+
+    for( size_t item = 0; item < nitems; ++item )
+    {
+        size_t d = ( metadata.dimension == TEX_DIMENSION_TEXTURE3D ) ? metadata.depth : 1;
+
+        for( size_t level = 0; level < metadata.mipLevels; ++level )
+        {
+            Image img;
+            img.width = std::max<size_t>( 1, metadata.width >> level );
+            img.height = std::max<size_t>( 1, metadata.height >> level );
+            img.format = metadata.format;
+            img.pixels = buffer.get();
+            ComputePitch( img.format, img.width, img.height, img.rowPitch, img.slicePitch, CP_FLAGS_NONE );
+
+            for( size_t slice = 0; slice < d; ++slice )
+            {
+                hr = produceImage( level, item, slice, img );
+                if ( FAILED(hr) )
+                    return hr;
+
+                hr = writer.WriteImage( img, level, item, slice );
+                if ( FAILED(hr) )
+                    return hr;
+            }
+
+            if ( d > 1 )
+                d >>= 1;
+        }
+    }
+
+    return writer.Close();
+}
+
+
+//=====================================================================================
+// DDSFileReader - Streaming DDS file reader
+//=====================================================================================
+
+//-------------------------------------------------------------------------------------
+// Reads a buffer that may be larger than a single ReadFile call allows
+//-------------------------------------------------------------------------------------
+static HRESULT _ReadBytes( _In_ HANDLE hFile, _Out_writes_bytes_(size) uint8_t* pData, _In_ size_t size )
+{
+    while( size > 0 )
+    {
+        DWORD chunk = static_cast<DWORD>( std::min<size_t>( size, 0x40000000 ) );
+
+        DWORD bytesRead;
+        if ( !ReadFile( hFile, pData, chunk, &bytesRead, 0 ) )
+        {
+            return HRESULT_FROM_WIN32( GetLastError() );
+        }
+
+        if ( bytesRead != chunk )
+        {
+            return E_FAIL;
+        }
+
+        pData += chunk;
+        size -= chunk;
+    }
+
+    return S_OK;
+}
+
+//-------------------------------------------------------------------------------------
+// Checks a caller-supplied image against the subresource it is to receive
+//-------------------------------------------------------------------------------------
+static HRESULT _ValidateReadImage( _In_ const TexMetadata& metadata, _In_ const Image& image, _In_ size_t mip )
+{
+    if ( !image.pixels )
+        return E_POINTER;
+
+    const size_t width = std::max<size_t>( 1, metadata.width >> mip );
+    const size_t height = std::max<size_t>( 1, metadata.height >> mip );
+    if ( image.width != width || image.height != height || image.format != metadata.format )
+        return E_INVALIDARG;
+
+    size_t rowPitch, slicePitch;
+    ComputePitch( metadata.format, width, height, rowPitch, slicePitch, CP_FLAGS_NONE );
+
+    if ( image.rowPitch < rowPitch )
+        return E_INVALIDARG;
+
+    return S_OK;
+}
+
+//-------------------------------------------------------------------------------------
+// Reads one subresource from the file into a validated image
+//-------------------------------------------------------------------------------------
+static HRESULT _ReadSubresource( _In_ HANDLE hFile, _In_ const TexMetadata& metadata, _In_ DWORD cpFlags,
+                                 _In_ uint64_t offset, _In_ const Image& image, _In_ size_t mip )
+{
+    const size_t width = std::max<size_t>( 1, metadata.width >> mip );
+    const size_t height = std::max<size_t>( 1, metadata.height >> mip );
+
+    size_t rowPitch, slicePitch;
+    ComputePitch( metadata.format, width, height, rowPitch, slicePitch, CP_FLAGS_NONE );
+
+    size_t fileRowPitch, fileSlicePitch;
+    ComputePitch( metadata.format, width, height, fileRowPitch, fileSlicePitch, cpFlags );
+
+    LARGE_INTEGER filePos;
+    filePos.QuadPart = static_cast<LONGLONG>( offset );
+    if ( !SetFilePointerEx( hFile, filePos, 0, FILE_BEGIN ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    if ( image.rowPitch == fileRowPitch )
+    {
+        return _ReadBytes( hFile, image.pixels, fileSlicePitch );
+    }
+
+    // Row padding differs between the file and the image, so read the whole subresource then copy it row by row
+    std::unique_ptr<uint8_t[]> temp( new (std::nothrow) uint8_t[ fileSlicePitch ] );
+    if ( !temp )
+        return E_OUTOFMEMORY;
+
+    HRESULT hr = _ReadBytes( hFile, temp.get(), fileSlicePitch );
+    if ( FAILED(hr) )
+        return hr;
+
+    const size_t rows = fileSlicePitch / fileRowPitch;
+    const uint8_t* pSrc = temp.get();
+    uint8_t* pDest = image.pixels;
+    for( size_t y = 0; y < rows; ++y )
+    {
+        memcpy_s( pDest, image.rowPitch, pSrc, rowPitch );
+        pSrc += fileRowPitch;
+        pDest += image.rowPitch;
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DDSFileReader::Open( LPCWSTR szFile, DWORD flags )
+{
+    if ( !szFile )
+        return E_INVALIDARG;
+
+    Close();
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile( safe_handle( CreateFile2( szFile, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, 0 ) ) );
+#else
+    ScopedHandle hFile( safe_handle( CreateFileW( szFile, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0 ) ) );
+#endif
+    if ( !hFile )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    // Get the file size
+    LARGE_INTEGER fileSize = {0};
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_VISTA)
+    FILE_STANDARD_INFO fileInfo;
+    if ( !GetFileInformationByHandleEx( hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo) ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+    fileSize = fileInfo.EndOfFile;
+#else
+    if ( !GetFileSizeEx( hFile.get(), &fileSize ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+#endif
+
+    // Need at least enough data to fill the standard header and magic number to be a valid DDS
+    if ( fileSize.QuadPart < static_cast<LONGLONG>( sizeof(DDS_HEADER) + sizeof(uint32_t) ) )
+    {
+        return E_FAIL;
+    }
+
+    // Read the header in (including extended header if present)
+    const size_t MAX_HEADER_SIZE = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+    uint8_t header[MAX_HEADER_SIZE];
+
+    DWORD bytesRead = 0;
+    if ( !ReadFile( hFile.get(), header, MAX_HEADER_SIZE, &bytesRead, 0 ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    DWORD convFlags = 0;
+    TexMetadata mdata;
+    HRESULT hr = _DecodeDDSHeader( header, bytesRead, flags, mdata, convFlags );
+    if ( FAILED(hr) )
+        return hr;
+
+    // Pixel data is read straight into the caller's images, so formats that LoadFromDDSFile converts are not supported.
+    // Legacy formats that map directly to a DXGI format (565, 5551, 4444, L8, ...) are copied as-is and are fine.
+    if ( convFlags & (CONV_FLAGS_EXPAND | CONV_FLAGS_NOALPHA | CONV_FLAGS_SWIZZLE | CONV_FLAGS_PAL8) )
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+
+    size_t nimages, pixelSize;
+    _DetermineImageArray( mdata, CP_FLAGS_NONE, nimages, pixelSize );
+    if ( !nimages )
+        return E_FAIL;
+
+    std::unique_ptr<uint64_t[]> offsets( new (std::nothrow) uint64_t[ nimages ] );
+    if ( !offsets )
+        return E_OUTOFMEMORY;
+
+    const DWORD cpFlags = (flags & DDS_FLAGS_LEGACY_DWORD) ? CP_FLAGS_LEGACY_DWORD : CP_FLAGS_NONE;
+
+    size_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER);
+    if ( convFlags & CONV_FLAGS_DX10 )
+        offset += sizeof(DDS_HEADER_DXT10);
+
+    uint64_t end;
+    hr = _ComputeSubresourceOffsets( mdata, cpFlags, offset, offsets.get(), nimages, end );
+    if ( FAILED(hr) )
+        return hr;
+
+    // Reject truncated files up front rather than failing part way through a streamed read
+    if ( end > static_cast<uint64_t>( fileSize.QuadPart ) )
+        return E_FAIL;
+
+    _hFile = hFile.release();
+    _metadata = mdata;
+    _flags = flags;
+    _nimages = nimages;
+    _offsets = offsets.release();
+    _readyMip = static_cast<LONG>( mdata.mipLevels );
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DDSFileReader::GetSubresourceRange( size_t mip, size_t item, size_t slice, uint64_t& offset, size_t& size ) const
+{
+    offset = 0;
+    size = 0;
+
+    if ( !_hFile )
+        return E_FAIL;
+
+    size_t index = _metadata.ComputeIndex( mip, item, slice );
+    if ( index >= _nimages )
+        return E_INVALIDARG;
+
+    size_t rowPitch, slicePitch;
+    ComputePitch( _metadata.format,
+                  std::max<size_t>( 1, _metadata.width >> mip ), std::max<size_t>( 1, _metadata.height >> mip ),
+                  rowPitch, slicePitch,
+                  (_flags & DDS_FLAGS_LEGACY_DWORD) ? CP_FLAGS_LEGACY_DWORD : CP_FLAGS_NONE );
+
+    offset = _offsets[ index ];
+    size = slicePitch;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DDSFileReader::ReadImage( const Image& image, size_t mip, size_t item, size_t slice )
+{
+    if ( !_hFile )
+        return E_FAIL;
+
+    // The file position belongs to the background thread while it is running
+    if ( _hThread )
+        return HRESULT_FROM_WIN32( ERROR_BUSY );
+
+    size_t index = _metadata.ComputeIndex( mip, item, slice );
+    if ( index >= _nimages )
+        return E_INVALIDARG;
+
+    HRESULT hr = _ValidateReadImage( _metadata, image, mip );
+    if ( FAILED(hr) )
+        return hr;
+
+    return _ReadSubresource( _hFile, _metadata, (_flags & DDS_FLAGS_LEGACY_DWORD) ? CP_FLAGS_LEGACY_DWORD : CP_FLAGS_NONE,
+                             _offsets[ index ], image, mip );
+}
+
+_Use_decl_annotations_
+HRESULT DDSFileReader::BeginRead( const Image* images, size_t nimages, size_t firstMip, std::function<void(size_t mip)> levelReady )
+{
+    if ( !_hFile )
+        return E_FAIL;
+
+    if ( _hThread || _levelEvents )
+        return HRESULT_FROM_WIN32( ERROR_BUSY );
+
+    if ( !images || nimages != _nimages || firstMip >= _metadata.mipLevels )
+        return E_INVALIDARG;
+
+    // Validate every image that will be written before starting, so the read can only fail on I/O
+    const size_t nitems = ( _metadata.dimension == TEX_DIMENSION_TEXTURE3D ) ? 1 : _metadata.arraySize;
+
+    for( size_t level = firstMip; level < _metadata.mipLevels; ++level )
+    {
+        const size_t d = ( _metadata.dimension == TEX_DIMENSION_TEXTURE3D ) ? std::max<size_t>( 1, _metadata.depth >> level ) : 1;
+
+        for( size_t item = 0; item < nitems; ++item )
+        {
+            for( size_t slice = 0; slice < d; ++slice )
+            {
+                size_t index = _metadata.ComputeIndex( level, item, slice );
+                if ( index >= _nimages )
+                    return E_FAIL;
+
+                HRESULT hr = _ValidateReadImage( _metadata, images[ index ], level );
+                if ( FAILED(hr) )
+                    return hr;
+            }
+        }
+    }
+
+    std::unique_ptr<void*[]> events( new (std::nothrow) void*[ _metadata.mipLevels ] );
+    if ( !events )
+        return E_OUTOFMEMORY;
+
+    memset( events.get(), 0, sizeof(void*) * _metadata.mipLevels );
+
+    HRESULT hr = S_OK;
+    for( size_t level = 0; level < _metadata.mipLevels; ++level )
+    {
+#if (_WIN32_WINNT >= _WIN32_WINNT_VISTA)
+        events[ level ] = CreateEventEx( nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_ALL_ACCESS );
+#else
+        events[ level ] = CreateEvent( nullptr, TRUE, FALSE, nullptr );
+#endif
+        if ( !events[ level ] )
+        {
+            hr = HRESULT_FROM_WIN32( GetLastError() );
+            break;
+        }
+    }
+
+    if ( SUCCEEDED(hr) )
+    {
+        _levelEvents = events.get();
+        _images = images;
+        _firstMip = firstMip;
+        _readyMip = static_cast<LONG>( _metadata.mipLevels );
+        _cancel = 0;
+        _result = S_OK;
+        _levelReady = levelReady;
+
+        _hThread = reinterpret_cast<HANDLE>( _beginthreadex( nullptr, 0, _ReadThreadProc, this, 0, nullptr ) );
+        if ( _hThread )
+        {
+            events.release();
+            return S_OK;
+        }
+
+        hr = E_FAIL;
+
+        _levelEvents = nullptr;
+        _images = nullptr;
+        _levelReady = nullptr;
+    }
+
+    for( size_t level = 0; level < _metadata.mipLevels; ++level )
+    {
+        if ( events[ level ] )
+            CloseHandle( events[ level ] );
+    }
+
+    return hr;
+}
+
+unsigned __stdcall DDSFileReader::_ReadThreadProc( void* pParam )
+{
+    auto reader = reinterpret_cast<DDSFileReader*>( pParam );
+
+    HRESULT hr = reader->_ReadLevels();
+
+    // Wake anything still waiting on a level that will now never be read
+    reader->_result = hr;
+    for( size_t level = 0; level < reader->_metadata.mipLevels; ++level )
+    {
+        SetEvent( reader->_levelEvents[ level ] );
+    }
+
+    return 0;
+}
+
+HRESULT DDSFileReader::_ReadLevels()
+{
+    const DWORD cpFlags = (_flags & DDS_FLAGS_LEGACY_DWORD) ? CP_FLAGS_LEGACY_DWORD : CP_FLAGS_NONE;
+    const size_t nitems = ( _metadata.dimension == TEX_DIMENSION_TEXTURE3D ) ? 1 : _metadata.arraySize;
+
+    // The smallest levels come first so the texture is usable as soon as possible
+    for( size_t level = _metadata.mipLevels; level-- > _firstMip; )
+    {
+        const size_t d = ( _metadata.dimension == TEX_DIMENSION_TEXTURE3D ) ? std::max<size_t>( 1, _metadata.depth >> level ) : 1;
+
+        for( size_t item = 0; item < nitems; ++item )
+        {
+            for( size_t slice = 0; slice < d; ++slice )
+            {
+                if ( _cancel )
+                    return E_ABORT;
+
+                size_t index = _metadata.ComputeIndex( level, item, slice );
+
+                HRESULT hr = _ReadSubresource( _hFile, _metadata, cpFlags, _offsets[ index ], _images[ index ], level );
+                if ( FAILED(hr) )
+                    return hr;
+            }
+        }
+
+        InterlockedExchange( &_readyMip, static_cast<LONG>( level ) );
+        SetEvent( _levelEvents[ level ] );
+
+        if ( _levelReady )
+            _levelReady( level );
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DDSFileReader::WaitForLevel( size_t mip )
+{
+    if ( !_levelEvents )
+        return E_FAIL;
+
+    if ( mip < _firstMip || mip >= _metadata.mipLevels )
+        return E_INVALIDARG;
+
+    if ( WaitForSingleObjectEx( _levelEvents[ mip ], INFINITE, FALSE ) != WAIT_OBJECT_0 )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    // The event is also set when the read stops early
+    if ( static_cast<size_t>( _readyMip ) > mip )
+    {
+        return FAILED(_result) ? _result : E_FAIL;
+    }
+
+    return S_OK;
+}
+
+HRESULT DDSFileReader::EndRead()
+{
+    if ( !_levelEvents )
+        return E_FAIL;
+
+    if ( _hThread )
+    {
+        WaitForSingleObjectEx( _hThread, INFINITE, FALSE );
+        CloseHandle( _hThread );
+        _hThread = nullptr;
+    }
+
+    for( size_t level = 0; level < _metadata.mipLevels; ++level )
+    {
+        CloseHandle( _levelEvents[ level ] );
+    }
+
+    delete [] _levelEvents;
+    _levelEvents = nullptr;
+
+    _images = nullptr;
+    _levelReady = nullptr;
+
+    return _result;
+}
+
+void DDSFileReader::CancelRead()
+{
+    InterlockedExchange( &_cancel, 1 );
+}
+
+HRESULT DDSFileReader::Close()
+{
+    HRESULT hr = S_OK;
+
+    if ( _levelEvents )
+    {
+        CancelRead();
+        hr = EndRead();
+    }
+
+    if ( _hFile )
+    {
+        CloseHandle( _hFile );
+        _hFile = nullptr;
+    }
+
+    if ( _offsets )
+    {
+        delete [] _offsets;
+        _offsets = nullptr;
+    }
+
+    _flags = 0;
+    _nimages = 0;
+    _firstMip = 0;
+    _readyMip = 0;
+    _cancel = 0;
+    _result = S_OK;
+
+    memset(&_metadata, 0, sizeof(_metadata));
+
+    return ( hr == E_ABORT ) ? S_OK : hr;
+}
+
 }; // namespace
@@ -0,0 +1,488 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexFilter.cpp
+//
+// DirectX Texture Library - Separable image filtering
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#include "directxtexp.h"
+
+#include "filters.h"
+
+#if defined(_XM_SSE_INTRINSICS_)
+#include <immintrin.h>
+#endif
+
+namespace DirectX
+{
+
+#if defined(_XM_SSE_INTRINSICS_)
+static const bool g_SupportsAVX = _IsAVXSupported();
+#endif
+
+// Each task filters a band of destination rows at least this many texels in size
+static const size_t SEPARABLE_BAND_TEXELS = 16384;
+
+// Largest row cache per task before rows are filtered horizontally as they are loaded
+static const size_t SEPARABLE_CACHE_BYTES = 2 * 1024 * 1024;
+
+//-------------------------------------------------------------------------------------
+// Vertical pass: weighted sum of cached rows
+//-------------------------------------------------------------------------------------
+static void _AccumulateRows( _Out_writes_(count) XMVECTOR* pDest, _In_reads_(nrows) const XMVECTOR* const* rows,
+                             _In_reads_(nrows) const float* weights, _In_ size_t nrows, _In_ size_t count )
+{
+    assert( pDest && rows && weights && nrows > 0 );
+
+    size_t x = 0;
+
+#if defined(_XM_SSE_INTRINSICS_)
+    if ( g_SupportsAVX )
+    {
+        // Two texels per 256-bit register
+        float* pOut = reinterpret_cast<float*>( pDest );
+        for( ; ( x + 2 ) <= count; x += 2 )
+        {
+            const size_t offset = x * 4;
+
+            __m256 v = _mm256_mul_ps( _mm256_loadu_ps( reinterpret_cast<const float*>( rows[0] ) + offset ), _mm256_set1_ps( weights[0] ) );
+            for( size_t k = 1; k < nrows; ++k )
+            {
+                __m256 r = _mm256_loadu_ps( reinterpret_cast<const float*>( rows[k] ) + offset );
+                v = _mm256_add_ps( v, _mm256_mul_ps( r, _mm256_set1_ps( weights[k] ) ) );
+            }
+
+            _mm256_storeu_ps( pOut + offset, v );
+        }
+
+        _mm256_zeroupper();
+    }
+#endif
+
+    for( ; x < count; ++x )
+    {
+        XMVECTOR v = XMVectorScale( rows[0][ x ], weights[0] );
+        for( size_t k = 1; k < nrows; ++k )
+        {
+            v = XMVectorMultiplyAdd( rows[k][ x ], XMVectorReplicate( weights[k] ), v );
+        }
+
+        pDest[ x ] = v;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// Horizontal pass: gathers the taps of each destination texel from one row
+//-------------------------------------------------------------------------------------
+static void _FilterRow( _Out_writes_(fx.dest) XMVECTOR* pDest, _In_reads_(fx.source) const XMVECTOR* pSource, _In_ const SeparableFilter& fx )
+{
+    const size_t taps = fx.taps;
+    const FilterTap* tap = fx.tap.get();
+
+    switch( taps )
+    {
+    case 1:
+        for( size_t x = 0; x < fx.dest; ++x, ++tap )
+        {
+            pDest[ x ] = XMVectorScale( pSource[ tap->u ], tap->weight );
+        }
+        break;
+
+    case 2:
+        for( size_t x = 0; x < fx.dest; ++x, tap += 2 )
+        {
+            XMVECTOR v = XMVectorScale( pSource[ tap[0].u ], tap[0].weight );
+            pDest[ x ] = XMVectorMultiplyAdd( pSource[ tap[1].u ], XMVectorReplicate( tap[1].weight ), v );
+        }
+        break;
+
+    default:
+        {
+            size_t x = 0;
+
+#if defined(_XM_SSE_INTRINSICS_)
+            if ( g_SupportsAVX )
+            {
+                // Two destination texels per 256-bit register, which pays off for the wide kernels
+                float* pOut = reinterpret_cast<float*>( pDest );
+                for( ; ( x + 2 ) <= fx.dest; x += 2, tap += taps * 2 )
+                {
+                    const FilterTap* tap1 = tap + taps;
+
+                    __m256 s = _mm256_insertf128_ps( _mm256_castps128_ps256( pSource[ tap[0].u ] ), pSource[ tap1[0].u ], 1 );
+                    __m256 v = _mm256_mul_ps( s, _mm256_setr_ps( tap[0].weight, tap[0].weight, tap[0].weight, tap[0].weight,
+                                                                 tap1[0].weight, tap1[0].weight, tap1[0].weight, tap1[0].weight ) );
+                    for( size_t k = 1; k < taps; ++k )
+                    {
+                        s = _mm256_insertf128_ps( _mm256_castps128_ps256( pSource[ tap[k].u ] ), pSource[ tap1[k].u ], 1 );
+                        v = _mm256_add_ps( v, _mm256_mul_ps( s, _mm256_setr_ps( tap[k].weight, tap[k].weight, tap[k].weight, tap[k].weight,
+                                                                                 tap1[k].weight, tap1[k].weight, tap1[k].weight, tap1[k].weight ) ) );
+                    }
+
+                    _mm256_storeu_ps( pOut + ( x * 4 ), v );
+                }
+
+                _mm256_zeroupper();
+            }
+#endif
+
+            for( ; x < fx.dest; ++x, tap += taps )
+            {
+                XMVECTOR v = XMVectorScale( pSource[ tap[0].u ], tap[0].weight );
+                for( size_t k = 1; k < taps; ++k )
+                {
+                    v = XMVectorMultiplyAdd( pSource[ tap[k].u ], XMVectorReplicate( tap[k].weight ), v );
+                }
+
+                pDest[ x ] = v;
+            }
+        }
+        break;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// Both passes at once for two rows and two taps (box and linear), which avoids writing
+// out the intermediate row
+//-------------------------------------------------------------------------------------
+static void _FilterRows2x2( _Out_writes_(fx.dest) XMVECTOR* pDest, _In_reads_(fx.source) const XMVECTOR* pRow0, _In_reads_(fx.source) const XMVECTOR* pRow1,
+                            _In_ float weight0, _In_ float weight1, _In_ const SeparableFilter& fx )
+{
+    assert( fx.taps == 2 );
+
+    const FilterTap* tap = fx.tap.get();
+    size_t x = 0;
+
+#if defined(_XM_SSE_INTRINSICS_)
+    if ( g_SupportsAVX )
+    {
+        // Adjacent taps are loaded as one 256-bit pair of texels
+        const __m256 w0 = _mm256_set1_ps( weight0 );
+        const __m256 w1 = _mm256_set1_ps( weight1 );
+
+        for( ; x < fx.dest; ++x, tap += 2 )
+        {
+            const size_t u0 = tap[0].u;
+            if ( tap[1].u != u0 + 1 )
+                break;
+
+            __m256 v = _mm256_mul_ps( _mm256_loadu_ps( reinterpret_cast<const float*>( pRow0 + u0 ) ), w0 );
+            v = _mm256_add_ps( v, _mm256_mul_ps( _mm256_loadu_ps( reinterpret_cast<const float*>( pRow1 + u0 ) ), w1 ) );
+
+            __m256 wx = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_set1_ps( tap[0].weight ) ), _mm_set1_ps( tap[1].weight ), 1 );
+            v = _mm256_mul_ps( v, wx );
+
+            pDest[ x ] = _mm_add_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+        }
+
+        _mm256_zeroupper();
+    }
+#endif
+
+    const XMVECTOR w0 = XMVectorReplicate( weight0 );
+    const XMVECTOR w1 = XMVectorReplicate( weight1 );
+
+    for( ; x < fx.dest; ++x, tap += 2 )
+    {
+        const size_t u0 = tap[0].u;
+        const size_t u1 = tap[1].u;
+
+        XMVECTOR v0 = XMVectorMultiply( pRow0[ u0 ], w0 );
+        v0 = XMVectorMultiplyAdd( pRow1[ u0 ], w1, v0 );
+
+        XMVECTOR v1 = XMVectorMultiply( pRow0[ u1 ], w0 );
+        v1 = XMVectorMultiplyAdd( pRow1[ u1 ], w1, v1 );
+
+        v0 = XMVectorScale( v0, tap[0].weight );
+        pDest[ x ] = XMVectorMultiplyAdd( v1, XMVectorReplicate( tap[1].weight ), v0 );
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// Filters one band of rows of one destination slice
+//-------------------------------------------------------------------------------------
+struct _SeparableContext
+{
+    const Image*            srcImages;
+    size_t                  srcDepth;
+    const Image*            destImages;
+    size_t                  destDepth;
+    const SeparableFilter*  fx;
+    const SeparableFilter*  fy;
+    const SeparableFilter*  fz;
+    DWORD                   filter;
+    size_t                  bandHeight;
+    size_t                  nBands;
+    bool                    prefilter;
+};
+
+static bool _FilterBand( _In_ size_t task, _In_opt_ void* pContext )
+{
+    const _SeparableContext* context = reinterpret_cast<const _SeparableContext*>( pContext );
+    assert( context );
+
+    const SeparableFilter& fx = *context->fx;
+    const SeparableFilter& fy = *context->fy;
+    const SeparableFilter& fz = *context->fz;
+
+    const size_t slice = task / context->nBands;
+    const size_t band = task - ( slice * context->nBands );
+    const size_t item = slice / context->destDepth;
+    const size_t z = slice - ( item * context->destDepth );
+
+    const Image* srcSlices = context->srcImages + ( item * context->srcDepth );
+    const Image& dest = context->destImages[ slice ];
+
+    const size_t width = fx.source;
+    const size_t height = fy.source;
+
+    // Every destination row reads at most fy.taps * fz.taps source rows. Rows shared with the
+    // previous destination row stay cached; the extra slots keep a volume filter from evicting
+    // a row it still needs for a later slice. Prefiltered rows are cached at destination width
+    const size_t nrows = fy.taps * fz.taps;
+    const size_t ncache = nrows + fy.taps;
+    const size_t rowWidth = context->prefilter ? fx.dest : width;
+
+    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( sizeof(XMVECTOR) * ( rowWidth * ncache + width + fx.dest ), 16 ) ) );
+    std::unique_ptr<size_t[]> cacheInfo( new (std::nothrow) size_t[ ncache * 2 ] );
+    std::unique_ptr<const XMVECTOR*[]> rows( new (std::nothrow) const XMVECTOR*[ nrows ] );
+    std::unique_ptr<float[]> weights( new (std::nothrow) float[ nrows ] );
+    if ( !scanline || !cacheInfo || !rows || !weights )
+        return false;
+
+    // vrow holds the vertical sum, or the source row being loaded when prefiltering
+    XMVECTOR* cache = scanline.get();
+    XMVECTOR* vrow = cache + ( rowWidth * ncache );
+    XMVECTOR* target = vrow + width;
+
+    size_t* keys = cacheInfo.get();
+    size_t* stamps = keys + ncache;
+    for( size_t j = 0; j < ncache; ++j )
+    {
+        keys[ j ] = size_t(-1);
+        stamps[ j ] = 0;
+    }
+
+    const FilterTap* zTaps = &fz.tap[ z * fz.taps ];
+
+    const size_t y0 = band * context->bandHeight;
+    const size_t y1 = std::min<size_t>( y0 + context->bandHeight, fy.dest );
+
+    const bool bias = ( ( context->filter & TEX_FILTER_MASK ) == TEX_FILTER_TRIANGLE )
+                      && ( dest.format == DXGI_FORMAT_R10G10B10A2_UNORM || dest.format == DXGI_FORMAT_R10G10B10A2_UINT );
+
+    for( size_t y = y0; y < y1; ++y )
+    {
+        const FilterTap* yTaps = &fy.tap[ y * fy.taps ];
+
+        // Gather the source rows for this destination row, loading any that aren't cached
+        size_t n = 0;
+        for( size_t tz = 0; tz < fz.taps; ++tz )
+        {
+            if ( zTaps[ tz ].weight == 0.f )
+                continue;
+
+            for( size_t ty = 0; ty < fy.taps; ++ty )
+            {
+                float weight = zTaps[ tz ].weight * yTaps[ ty ].weight;
+                if ( weight == 0.f )
+                    continue;
+
+                const size_t su = zTaps[ tz ].u;
+                const size_t sv = yTaps[ ty ].u;
+                assert( su < context->srcDepth && sv < height );
+
+                const size_t key = su * height + sv;
+
+                size_t slot = ncache;
+                size_t oldest = 0;
+                for( size_t j = 0; j < ncache; ++j )
+                {
+                    if ( keys[ j ] == key )
+                    {
+                        slot = j;
+                        break;
+                    }
+
+                    if ( stamps[ j ] < stamps[ oldest ] )
+                        oldest = j;
+                }
+
+                if ( slot == ncache )
+                {
+                    // Rows used by the current destination row are never the oldest
+                    slot = oldest;
+                    assert( stamps[ slot ] <= y );
+
+                    const Image& src = srcSlices[ su ];
+                    XMVECTOR* row = cache + ( slot * rowWidth );
+                    if ( !_LoadScanlineLinear( context->prefilter ? vrow : row, width, src.pixels + ( src.rowPitch * sv ), src.rowPitch, src.format, context->filter ) )
+                        return false;
+
+                    if ( context->prefilter )
+                        _FilterRow( row, vrow, fx );
+
+                    keys[ slot ] = key;
+                }
+
+                stamps[ slot ] = y + 1;
+
+                const XMVECTOR* row = cache + ( slot * rowWidth );
+
+                // Clamped edges can reference the same row more than once
+                size_t j = 0;
+                for( ; j < n; ++j )
+                {
+                    if ( rows[ j ] == row )
+                    {
+                        weights[ j ] += weight;
+                        break;
+                    }
+                }
+
+                if ( j == n )
+                {
+                    rows[ n ] = row;
+                    weights[ n ] = weight;
+                    ++n;
+                }
+            }
+        }
+
+        if ( context->prefilter )
+        {
+            // The store converts in place, so a cached row is copied out rather than stored directly
+            if ( !n )
+            {
+                memset( target, 0, sizeof(XMVECTOR) * fx.dest );
+            }
+            else if ( n == 1 && weights[0] == 1.f )
+            {
+                memcpy( target, rows[0], sizeof(XMVECTOR) * fx.dest );
+            }
+            else
+            {
+                _AccumulateRows( target, rows.get(), weights.get(), n, fx.dest );
+            }
+        }
+        else if ( n == 2 && fx.taps == 2 )
+        {
+            _FilterRows2x2( target, rows[0], rows[1], weights[0], weights[1], fx );
+        }
+        else
+        {
+            const XMVECTOR* pSrc = vrow;
+            if ( !n )
+            {
+                memset( vrow, 0, sizeof(XMVECTOR) * width );
+            }
+            else if ( n == 1 && weights[0] == 1.f )
+            {
+                pSrc = rows[0];
+            }
+            else
+            {
+                _AccumulateRows( vrow, rows.get(), weights.get(), n, width );
+            }
+
+            _FilterRow( target, pSrc, fx );
+        }
+
+        if ( bias )
+        {
+            // Need to slightly bias results for floating-point error accumulation which can
+            // be visible with harshly quantized values
+            static const XMVECTORF32 Bias = { 0.f, 0.f, 0.f, 0.1f };
+
+            for( size_t x = 0; x < fx.dest; ++x )
+            {
+                target[ x ] = XMVectorAdd( target[ x ], Bias );
+            }
+        }
+
+        if ( !_StoreScanlineLinear( dest.pixels + ( dest.rowPitch * y ), dest.rowPitch, dest.format, target, fx.dest, context->filter ) )
+            return false;
+    }
+
+    return true;
+}
+
+
+//=====================================================================================
+// Internal functions
+//=====================================================================================
+
+//-------------------------------------------------------------------------------------
+// Filters srcDepth slices of each item into destDepth slices. Work is split into bands
+// of destination rows which run on the thread pool
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT _ResizeSeparable( const Image* srcImages, size_t srcDepth, const Image* destImages, size_t destDepth, size_t nitems,
+                          const SeparableFilter& fx, const SeparableFilter& fy, const SeparableFilter& fz, DWORD filter )
+{
+    if ( !srcImages || !srcDepth || !destImages || !destDepth || !nitems )
+        return E_INVALIDARG;
+
+    if ( !fx.tap || !fy.tap || !fz.tap )
+        return E_INVALIDARG;
+
+    if ( fz.source != srcDepth || fz.dest != destDepth )
+        return E_INVALIDARG;
+
+    for( size_t index = 0; index < nitems * srcDepth; ++index )
+    {
+        const Image& src = srcImages[ index ];
+        if ( !src.pixels )
+            return E_POINTER;
+
+        if ( src.width != fx.source || src.height != fy.source )
+            return E_FAIL;
+    }
+
+    for( size_t index = 0; index < nitems * destDepth; ++index )
+    {
+        const Image& dest = destImages[ index ];
+        if ( !dest.pixels )
+            return E_POINTER;
+
+        if ( dest.width != fx.dest || dest.height != fy.dest )
+            return E_FAIL;
+    }
+
+    _SeparableContext context;
+    context.srcImages = srcImages;
+    context.srcDepth = srcDepth;
+    context.destImages = destImages;
+    context.destDepth = destDepth;
+    context.fx = &fx;
+    context.fy = &fy;
+    context.fz = &fz;
+    context.filter = filter;
+    context.bandHeight = std::max<size_t>( 1, SEPARABLE_BAND_TEXELS / fx.dest );
+    context.nBands = ( fy.dest + context.bandHeight - 1 ) / context.bandHeight;
+
+    // Filtering rows horizontally as they load trades one horizontal pass per source row for a
+    // vertical pass over destination-width rows. It is required when minifying heavily, where
+    // fy.taps grows with the scale factor and full source rows would not fit the cache budget
+    const size_t nrows = fy.taps * fz.taps;
+    const size_t loads = std::min<size_t>( nrows, fz.taps * ( ( fy.source + fy.dest - 1 ) / fy.dest ) );
+    const size_t verticalFirst = ( nrows * fx.source ) + ( fx.dest * fx.taps );
+    const size_t horizontalFirst = ( loads * fx.dest * fx.taps ) + ( nrows * fx.dest );
+    context.prefilter = ( horizontalFirst < verticalFirst )
+                        || ( ( nrows + fy.taps ) * fx.source * sizeof(XMVECTOR) > SEPARABLE_CACHE_BYTES );
+
+    return _ParallelFor( nitems * destDepth * context.nBands, _FilterBand, &context );
+}
+
+}; // namespace
@@ -121,6 +121,338 @@ static HRESULT _PerformFlipRotateViaF32( _In_ const Image& srcImage, _In_ DWORD
 }
 
 
+//-------------------------------------------------------------------------------------
+// Native flip/rotate
+//-------------------------------------------------------------------------------------
+
+// Rotations copy in square tiles of this many texels so source and destination rows both stay in cache
+static const size_t FR_TILE = 32;
+
+//-------------------------------------------------------------------------------------
+// Maps a destination coordinate to its source coordinate. Rotation is clockwise and
+// applied first, with the flips applied in destination space (as WIC does)
+//-------------------------------------------------------------------------------------
+static void _MapFlipRotate( _In_ DWORD flags, _In_ ptrdiff_t width, _In_ ptrdiff_t height, _In_ ptrdiff_t x, _In_ ptrdiff_t y,
+                            _Out_ ptrdiff_t& sx, _Out_ ptrdiff_t& sy )
+{
+    const bool swap = ( flags & TEX_FR_ROTATE90 ) != 0;
+    const ptrdiff_t nwidth = swap ? height : width;
+    const ptrdiff_t nheight = swap ? width : height;
+
+    if ( flags & TEX_FR_FLIP_HORIZONTAL )
+        x = nwidth - 1 - x;
+
+    if ( flags & TEX_FR_FLIP_VERTICAL )
+        y = nheight - 1 - y;
+
+    switch( flags & (TEX_FR_ROTATE90|TEX_FR_ROTATE180|TEX_FR_ROTATE270) )
+    {
+    case TEX_FR_ROTATE90:   sx = y;                 sy = height - 1 - x;    break;
+    case TEX_FR_ROTATE180:  sx = width - 1 - x;     sy = height - 1 - y;    break;
+    case TEX_FR_ROTATE270:  sx = width - 1 - y;     sy = x;                 break;
+    default:                sx = x;                 sy = y;                 break;
+    }
+}
+
+static bool _IsNativeFlipRotate( _In_ DXGI_FORMAT format )
+{
+    if ( IsCompressed( format ) )
+    {
+        switch( format )
+        {
+        case DXGI_FORMAT_BC1_TYPELESS:
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC2_TYPELESS:
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+        case DXGI_FORMAT_BC3_TYPELESS:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_TYPELESS:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+        case DXGI_FORMAT_BC5_TYPELESS:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC5_SNORM:
+            // Endpoints are position independent, so only the per-texel indices move
+            return true;
+
+        default:
+            // BC6H/BC7 partitions and anchor indices are tied to texel positions
+            return false;
+        }
+    }
+
+    if ( IsPacked( format ) || IsVideo( format ) )
+        return false;
+
+    const size_t bpp = BitsPerPixel( format );
+    return ( bpp >= 8 ) && !( bpp & 7 );
+}
+
+//-------------------------------------------------------------------------------------
+// Uncompressed images: each destination row walks the source with a fixed stride
+//-------------------------------------------------------------------------------------
+struct _Texel96 { uint32_t v[3]; };
+struct _Texel128 { uint64_t v[2]; };
+
+template<typename T>
+static void _FlipRotateTexels( _In_ const uint8_t* pOrigin, _In_ ptrdiff_t xStep, _In_ ptrdiff_t yStep, _In_ const Image& destImage )
+{
+    if ( xStep == sizeof(T) )
+    {
+        // No rotation and no horizontal flip, so rows are contiguous
+        for( size_t y = 0; y < destImage.height; ++y )
+        {
+            memcpy( destImage.pixels + y * destImage.rowPitch, pOrigin + ptrdiff_t(y) * yStep, destImage.width * sizeof(T) );
+        }
+        return;
+    }
+
+    for( size_t ty = 0; ty < destImage.height; ty += FR_TILE )
+    {
+        const size_t th = std::min<size_t>( FR_TILE, destImage.height - ty );
+
+        for( size_t tx = 0; tx < destImage.width; tx += FR_TILE )
+        {
+            const size_t tw = std::min<size_t>( FR_TILE, destImage.width - tx );
+
+            for( size_t y = ty; y < ty + th; ++y )
+            {
+                const uint8_t* pSrc = pOrigin + ptrdiff_t(y) * yStep + ptrdiff_t(tx) * xStep;
+                T* pDest = reinterpret_cast<T*>( destImage.pixels + y * destImage.rowPitch ) + tx;
+
+                for( size_t x = 0; x < tw; ++x, pSrc += xStep )
+                {
+                    *pDest++ = *reinterpret_cast<const T*>( pSrc );
+                }
+            }
+        }
+    }
+}
+
+static HRESULT _PerformFlipRotateNative( _In_ const Image& srcImage, _In_ DWORD flags, _In_ const Image& destImage )
+{
+    if ( !srcImage.pixels || !destImage.pixels )
+        return E_POINTER;
+
+    assert( srcImage.format == destImage.format );
+    assert( !IsCompressed( srcImage.format ) );
+
+    const size_t bpp = BitsPerPixel( srcImage.format ) / 8;
+
+    const ptrdiff_t width = ptrdiff_t( srcImage.width );
+    const ptrdiff_t height = ptrdiff_t( srcImage.height );
+    const ptrdiff_t rowPitch = ptrdiff_t( srcImage.rowPitch );
+
+    // The mapping is affine, so three points give the origin and both strides
+    ptrdiff_t x0, y0, x1, y1, x2, y2;
+    _MapFlipRotate( flags, width, height, 0, 0, x0, y0 );
+    _MapFlipRotate( flags, width, height, 1, 0, x1, y1 );
+    _MapFlipRotate( flags, width, height, 0, 1, x2, y2 );
+
+    const uint8_t* pOrigin = srcImage.pixels + y0 * rowPitch + x0 * ptrdiff_t(bpp);
+    const ptrdiff_t xStep = ( y1 - y0 ) * rowPitch + ( x1 - x0 ) * ptrdiff_t(bpp);
+    const ptrdiff_t yStep = ( y2 - y0 ) * rowPitch + ( x2 - x0 ) * ptrdiff_t(bpp);
+
+    switch( bpp )
+    {
+    case 1:     _FlipRotateTexels<uint8_t>( pOrigin, xStep, yStep, destImage );     break;
+    case 2:     _FlipRotateTexels<uint16_t>( pOrigin, xStep, yStep, destImage );    break;
+    case 4:     _FlipRotateTexels<uint32_t>( pOrigin, xStep, yStep, destImage );    break;
+    case 8:     _FlipRotateTexels<uint64_t>( pOrigin, xStep, yStep, destImage );    break;
+    case 12:    _FlipRotateTexels<_Texel96>( pOrigin, xStep, yStep, destImage );    break;
+    case 16:    _FlipRotateTexels<_Texel128>( pOrigin, xStep, yStep, destImage );   break;
+    default:
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+    }
+
+    return S_OK;
+}
+
+//-------------------------------------------------------------------------------------
+// BC1-BC5: blocks are moved and the texel indices inside each block are permuted
+//-------------------------------------------------------------------------------------
+static inline uint64_t _PermuteIndices( _In_ uint64_t indices, _In_ size_t bits, _In_reads_(16) const uint8_t* perm )
+{
+    const uint64_t mask = ( uint64_t(1) << bits ) - 1;
+
+    uint64_t result = 0;
+    for( size_t i = 0; i < 16; ++i )
+    {
+        result |= ( ( indices >> ( perm[ i ] * bits ) ) & mask ) << ( i * bits );
+    }
+    return result;
+}
+
+static inline void _PermuteColorBlock( _Out_writes_(8) uint8_t* pDest, _In_reads_(8) const uint8_t* pSrc, _In_reads_(16) const uint8_t* perm )
+{
+    // Two RGB565 endpoints followed by 2-bit indices
+    memcpy( pDest, pSrc, 4 );
+
+    uint32_t indices;
+    memcpy( &indices, pSrc + 4, sizeof(indices) );
+    indices = static_cast<uint32_t>( _PermuteIndices( indices, 2, perm ) );
+    memcpy( pDest + 4, &indices, sizeof(indices) );
+}
+
+static inline void _PermuteAlphaBlock( _Out_writes_(8) uint8_t* pDest, _In_reads_(8) const uint8_t* pSrc, _In_reads_(16) const uint8_t* perm )
+{
+    // Two 8-bit endpoints followed by 48 bits of 3-bit indices (BC3 alpha, BC4 and each half of BC5)
+    pDest[0] = pSrc[0];
+    pDest[1] = pSrc[1];
+
+    uint64_t indices = 0;
+    memcpy( &indices, pSrc + 2, 6 );
+    indices = _PermuteIndices( indices, 3, perm );
+    memcpy( pDest + 2, &indices, 6 );
+}
+
+static inline bool _IsBlockAlignedFlipRotate( _In_ size_t width, _In_ size_t height )
+{
+    // Blocks only move as a unit if no partial block is shifted; images smaller than a block are permuted in place
+    return !( ( ( width & 3 ) && width > 4 ) || ( ( height & 3 ) && height > 4 ) );
+}
+
+static HRESULT _PerformFlipRotateBC( _In_ const Image& srcImage, _In_ DWORD flags, _In_ const Image& destImage )
+{
+    if ( !srcImage.pixels || !destImage.pixels )
+        return E_POINTER;
+
+    assert( srcImage.format == destImage.format );
+
+    const size_t width = srcImage.width;
+    const size_t height = srcImage.height;
+
+    if ( !_IsBlockAlignedFlipRotate( width, height ) )
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+
+    size_t bpb;
+    switch( srcImage.format )
+    {
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        bpb = 8;
+        break;
+
+    default:
+        bpb = 16;
+        break;
+    }
+
+    // Texel permutation shared by every block; texels past a partial edge take the nearest valid texel
+    const ptrdiff_t bw = ptrdiff_t( std::min<size_t>( width, 4 ) );
+    const ptrdiff_t bh = ptrdiff_t( std::min<size_t>( height, 4 ) );
+    const bool swap = ( flags & TEX_FR_ROTATE90 ) != 0;
+
+    uint8_t perm[16];
+    for( ptrdiff_t j = 0; j < 4; ++j )
+    {
+        for( ptrdiff_t i = 0; i < 4; ++i )
+        {
+            ptrdiff_t ci = std::min<ptrdiff_t>( i, ( swap ? bh : bw ) - 1 );
+            ptrdiff_t cj = std::min<ptrdiff_t>( j, ( swap ? bw : bh ) - 1 );
+
+            ptrdiff_t si, sj;
+            _MapFlipRotate( flags, bw, bh, ci, cj, si, sj );
+            perm[ j * 4 + i ] = static_cast<uint8_t>( sj * 4 + si );
+        }
+    }
+
+    const ptrdiff_t nbw = ptrdiff_t( std::max<size_t>( 1, ( width + 3 ) / 4 ) );
+    const ptrdiff_t nbh = ptrdiff_t( std::max<size_t>( 1, ( height + 3 ) / 4 ) );
+
+    const size_t nbwDest = std::max<size_t>( 1, ( destImage.width + 3 ) / 4 );
+    const size_t nbhDest = std::max<size_t>( 1, ( destImage.height + 3 ) / 4 );
+
+    for( size_t by = 0; by < nbhDest; ++by )
+    {
+        uint8_t* pDest = destImage.pixels + by * destImage.rowPitch;
+
+        for( size_t bx = 0; bx < nbwDest; ++bx, pDest += bpb )
+        {
+            ptrdiff_t sbx, sby;
+            _MapFlipRotate( flags, nbw, nbh, ptrdiff_t(bx), ptrdiff_t(by), sbx, sby );
+            assert( sbx >= 0 && sbx < nbw && sby >= 0 && sby < nbh );
+
+            const uint8_t* pSrc = srcImage.pixels + sby * srcImage.rowPitch + sbx * bpb;
+
+            switch( srcImage.format )
+            {
+            case DXGI_FORMAT_BC1_TYPELESS:
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC1_UNORM_SRGB:
+                _PermuteColorBlock( pDest, pSrc, perm );
+                break;
+
+            case DXGI_FORMAT_BC2_TYPELESS:
+            case DXGI_FORMAT_BC2_UNORM:
+            case DXGI_FORMAT_BC2_UNORM_SRGB:
+                {
+                    // Explicit 4-bit alpha per texel
+                    uint64_t alpha;
+                    memcpy( &alpha, pSrc, sizeof(alpha) );
+                    alpha = _PermuteIndices( alpha, 4, perm );
+                    memcpy( pDest, &alpha, sizeof(alpha) );
+
+                    _PermuteColorBlock( pDest + 8, pSrc + 8, perm );
+                }
+                break;
+
+            case DXGI_FORMAT_BC3_TYPELESS:
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC3_UNORM_SRGB:
+                _PermuteAlphaBlock( pDest, pSrc, perm );
+                _PermuteColorBlock( pDest + 8, pSrc + 8, perm );
+                break;
+
+            case DXGI_FORMAT_BC4_TYPELESS:
+            case DXGI_FORMAT_BC4_UNORM:
+            case DXGI_FORMAT_BC4_SNORM:
+                _PermuteAlphaBlock( pDest, pSrc, perm );
+                break;
+
+            case DXGI_FORMAT_BC5_TYPELESS:
+            case DXGI_FORMAT_BC5_UNORM:
+            case DXGI_FORMAT_BC5_SNORM:
+                _PermuteAlphaBlock( pDest, pSrc, perm );
+                _PermuteAlphaBlock( pDest + 8, pSrc + 8, perm );
+                break;
+
+            default:
+                return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+            }
+        }
+    }
+
+    return S_OK;
+}
+
+static HRESULT _PerformFlipRotate( _In_ const Image& srcImage, _In_ DWORD flags, _In_ const Image& destImage )
+{
+    if ( IsCompressed( srcImage.format ) )
+        return _PerformFlipRotateBC( srcImage, flags, destImage );
+
+    if ( _IsNativeFlipRotate( srcImage.format ) )
+        return _PerformFlipRotateNative( srcImage, flags, destImage );
+
+    WICPixelFormatGUID pfGUID;
+    if ( _DXGIToWIC( srcImage.format, pfGUID ) )
+    {
+        // Source format is supported by Windows Imaging Component
+        return _PerformFlipRotateUsingWIC( srcImage, flags, pfGUID, destImage );
+    }
+
+    // Source format is not supported by WIC, so we have to convert, flip/rotate, and convert back
+    return _PerformFlipRotateViaF32( srcImage, flags, destImage );
+}
+
+
 //=====================================================================================
 // Entry-points
 //=====================================================================================
@@ -142,9 +474,9 @@ HRESULT FlipRotate( const Image& srcImage, DWORD flags, ScratchImage& image )
         return E_INVALIDARG;
 #endif
 
-    if ( IsCompressed( srcImage.format ) )
+    if ( IsCompressed( srcImage.format ) && !_IsNativeFlipRotate( srcImage.format ) )
     {
-        // We don't support flip/rotate operations on compressed images
+        // We don't support flip/rotate operations on BC6H/BC7 images
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
     }
 
@@ -171,7 +503,8 @@ HRESULT FlipRotate( const Image& srcImage, DWORD flags, ScratchImage& image )
     size_t nwidth = srcImage.width;
     size_t nheight = srcImage.height;
 
-    if (flags & (TEX_FR_ROTATE90|TEX_FR_ROTATE270))
+    // TEX_FR_ROTATE270 includes the TEX_FR_ROTATE90 bit, TEX_FR_ROTATE180 does not
+    if ( flags & TEX_FR_ROTATE90 )
     {
         nwidth = srcImage.height;
         nheight = srcImage.width;
@@ -185,18 +518,7 @@ HRESULT FlipRotate( const Image& srcImage, DWORD flags, ScratchImage& image )
     if ( !rimage )
         return E_POINTER;
 
-    WICPixelFormatGUID pfGUID;
-    if ( _DXGIToWIC( srcImage.format, pfGUID ) )
-    {
-        // Case 1: Source format is supported by Windows Imaging Component
-        hr = _PerformFlipRotateUsingWIC( srcImage, flags, pfGUID, *rimage );
-    }
-    else
-    {
-        // Case 2: Source format is not supported by WIC, so we have to convert, flip/rotate, and convert back
-        hr = _PerformFlipRotateViaF32( srcImage, flags, *rimage );
-    }
-
+    hr = _PerformFlipRotate( srcImage, flags, *rimage );
     if ( FAILED(hr) )
     {
         image.Release();
@@ -217,9 +539,9 @@ HRESULT FlipRotate( const Image* srcImages, size_t nimages, const TexMetadata& m
     if ( !srcImages || !nimages )
         return E_INVALIDARG;
 
-    if ( IsCompressed( metadata.format ) )
+    if ( IsCompressed( metadata.format ) && !_IsNativeFlipRotate( metadata.format ) )
     {
-        // We don't support flip/rotate operations on compressed images
+        // We don't support flip/rotate operations on BC6H/BC7 images
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
     }
 
@@ -246,7 +568,8 @@ HRESULT FlipRotate( const Image* srcImages, size_t nimages, const TexMetadata& m
     TexMetadata mdata2 = metadata;
 
     bool flipwh = false;
-    if (flags & (TEX_FR_ROTATE90|TEX_FR_ROTATE270))
+    // TEX_FR_ROTATE270 includes the TEX_FR_ROTATE90 bit, TEX_FR_ROTATE180 does not
+    if ( flags & TEX_FR_ROTATE90 )
     {
         flipwh = true;
         mdata2.width = metadata.height;
@@ -270,9 +593,6 @@ HRESULT FlipRotate( const Image* srcImages, size_t nimages, const TexMetadata& m
         return E_POINTER;
     }
 
-    WICPixelFormatGUID pfGUID;
-    bool wicpf = _DXGIToWIC( metadata.format, pfGUID );
-
     for( size_t index=0; index < nimages; ++index )
     {
         const Image& src = srcImages[ index ];
@@ -307,22 +627,129 @@ HRESULT FlipRotate( const Image* srcImages, size_t nimages, const TexMetadata& m
             }
         }
 
-        if (wicpf)
+        hr = _PerformFlipRotate( src, flags, dst );
+        if ( FAILED(hr) )
         {
-            // Case 1: Source format is supported by Windows Imaging Component
-            hr = _PerformFlipRotateUsingWIC( src, flags, pfGUID, dst );
+            result.Release();
+            return hr;
         }
-        else
+    }
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Flip/rotate image in place
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT FlipRotate( ScratchImage& image, DWORD flags )
+{
+    const TexMetadata& metadata = image.GetMetadata();
+
+    const Image* images = image.GetImages();
+    const size_t nimages = image.GetImageCount();
+    if ( !images || !nimages )
+        return E_INVALIDARG;
+
+    if ( !flags )
+        return E_INVALIDARG;
+
+    if ( !_IsNativeFlipRotate( metadata.format ) )
+    {
+        // Formats that go through WIC or a floating-point conversion need a separate destination
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+    }
+
+    // Only supports 90, 180, 270, or no rotation flags... not a combination of rotation flags
+    switch ( flags & (TEX_FR_ROTATE90|TEX_FR_ROTATE180|TEX_FR_ROTATE270) )
+    {
+    case 0:
+    case TEX_FR_ROTATE90:
+    case TEX_FR_ROTATE180:
+    case TEX_FR_ROTATE270:
+        break;
+
+    default:
+        return E_INVALIDARG;
+    }
+
+    TexMetadata mdata2 = metadata;
+
+    const bool flipwh = ( flags & TEX_FR_ROTATE90 ) != 0;
+    if ( flipwh )
+    {
+        if ( metadata.dimension == TEX_DIMENSION_TEXTURE1D )
+            return E_INVALIDARG;
+
+        mdata2.width = metadata.height;
+        mdata2.height = metadata.width;
+    }
+
+    // Each image is copied aside and transformed back into its own storage. Swapping the width and
+    // height keeps every slice the same size, so the image offsets do not change. Every image is
+    // checked first so an unsupported mip level fails before any pixels are touched
+    const bool compressed = IsCompressed( metadata.format );
+
+    size_t maxSlice = 0;
+    for( size_t index = 0; index < nimages; ++index )
+    {
+        const Image& img = images[ index ];
+        if ( !img.pixels )
+            return E_POINTER;
+
+        if ( compressed && !_IsBlockAlignedFlipRotate( img.width, img.height ) )
+            return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+
+        maxSlice = std::max<size_t>( maxSlice, img.slicePitch );
+    }
+
+    std::unique_ptr<uint8_t[]> temp( new (std::nothrow) uint8_t[ maxSlice ] );
+    if ( !temp )
+        return E_OUTOFMEMORY;
+
+    uint8_t* pixels = image.GetPixels();
+
+    for( size_t index = 0; index < nimages; ++index )
+    {
+        const Image& img = images[ index ];
+
+        Image src = img;
+        src.pixels = temp.get();
+        memcpy( src.pixels, img.pixels, img.slicePitch );
+
+        Image dst = img;
+        if ( flipwh )
         {
-            // Case 2: Source format is not supported by WIC, so we have to convert, flip/rotate, and convert back
-            hr = _PerformFlipRotateViaF32( src, flags, dst );
+            dst.width = img.height;
+            dst.height = img.width;
+            ComputePitch( img.format, dst.width, dst.height, dst.rowPitch, dst.slicePitch, CP_FLAGS_NONE );
+            assert( dst.slicePitch == img.slicePitch );
         }
 
+        HRESULT hr = _PerformFlipRotate( src, flags, dst );
         if ( FAILED(hr) )
         {
-            result.Release();
+            image.Release();
+            return hr;
+        }
+    }
+
+    if ( flipwh )
+    {
+        // The pixel buffer is already the right size, so this only rebuilds the image array
+        HRESULT hr = image.InitializeReuse( mdata2 );
+        if ( FAILED(hr) )
+        {
+            image.Release();
             return hr;
         }
+
+        if ( image.GetPixels() != pixels )
+        {
+            image.Release();
+            return E_UNEXPECTED;
+        }
     }
 
     return S_OK;
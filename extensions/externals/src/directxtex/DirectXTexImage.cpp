@@ -229,38 +229,36 @@ bool _SetupImageArray( uint8_t *pMemory, size_t pixelSize,
 // ScratchImage - Bitmap image container
 //=====================================================================================
 
-ScratchImage& ScratchImage::operator= (ScratchImage&& moveFrom)
+//-------------------------------------------------------------------------------------
+// Pixel memory comes from the image's allocator when it has one
+//-------------------------------------------------------------------------------------
+static uint8_t* _AllocatePixels( _In_opt_ ImageAllocator* allocator, _In_ size_t size )
 {
-    if ( this != &moveFrom )
-    {
-        Release();
+    void* ptr = ( allocator ) ? allocator->Allocate( size ) : _aligned_malloc( size, 16 );
+    assert( !( reinterpret_cast<uintptr_t>( ptr ) & 0xF ) );
+    return reinterpret_cast<uint8_t*>( ptr );
+}
 
-        _nimages = moveFrom._nimages;
-        _size = moveFrom._size;
-        _metadata = moveFrom._metadata;
-        _image = moveFrom._image;
-        _memory = moveFrom._memory;
+static void _FreePixels( _In_opt_ ImageAllocator* allocator, _In_opt_ uint8_t* memory, _In_ size_t size )
+{
+    if ( !memory )
+        return;
 
-        moveFrom._nimages = 0;
-        moveFrom._size = 0;
-        moveFrom._image = nullptr;
-        moveFrom._memory = nullptr;
-    }
-    return *this;
+    if ( allocator )
+        allocator->Free( memory, size );
+    else
+        _aligned_free( memory );
 }
 
 
 //-------------------------------------------------------------------------------------
-// Methods
+// Validates metadata for Initialize, computing the full mip count if needed
 //-------------------------------------------------------------------------------------
-_Use_decl_annotations_
-HRESULT ScratchImage::Initialize( const TexMetadata& mdata )
+static HRESULT _ValidateMetadata( _In_ const TexMetadata& mdata, _Inout_ size_t& mipLevels )
 {
     if ( !IsValid(mdata.format) || IsVideo(mdata.format) )
         return E_INVALIDARG;
 
-    size_t mipLevels = mdata.mipLevels;
-
     switch( mdata.dimension )
     {
     case TEX_DIMENSION_TEXTURE1D:
@@ -297,6 +295,53 @@ HRESULT ScratchImage::Initialize( const TexMetadata& mdata )
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
     }
 
+    return S_OK;
+}
+
+
+ScratchImage& ScratchImage::operator= (ScratchImage&& moveFrom)
+{
+    if ( this != &moveFrom )
+    {
+        Release();
+
+        _nimages = moveFrom._nimages;
+        _size = moveFrom._size;
+        _capacity = moveFrom._capacity;
+        _metadata = moveFrom._metadata;
+        _image = moveFrom._image;
+        _memory = moveFrom._memory;
+        _allocator = moveFrom._allocator;   // The memory has to go back to the allocator it came from
+
+        moveFrom._nimages = 0;
+        moveFrom._size = 0;
+        moveFrom._capacity = 0;
+        moveFrom._image = nullptr;
+        moveFrom._memory = nullptr;
+    }
+    return *this;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Methods
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void ScratchImage::SetAllocator( ImageAllocator* allocator )
+{
+    Release();
+
+    _allocator = allocator;
+}
+
+_Use_decl_annotations_
+HRESULT ScratchImage::Initialize( const TexMetadata& mdata )
+{
+    size_t mipLevels = mdata.mipLevels;
+    HRESULT hr = _ValidateMetadata( mdata, mipLevels );
+    if ( FAILED(hr) )
+        return hr;
+
     Release();
 
     _metadata.width = mdata.width;
@@ -319,12 +364,57 @@ HRESULT ScratchImage::Initialize( const TexMetadata& mdata )
     _nimages = nimages;
     memset( _image, 0, sizeof(Image) * nimages );
 
-    _memory = reinterpret_cast<uint8_t*>( _aligned_malloc( pixelSize, 16 ) );
+    _memory = _AllocatePixels( _allocator, pixelSize );
     if ( !_memory )
     {
         Release();
         return E_OUTOFMEMORY;
     }
+    _size = _capacity = pixelSize;
+    if ( !_SetupImageArray( _memory, pixelSize, _metadata, CP_FLAGS_NONE, _image, nimages ) )
+    {
+        Release();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT ScratchImage::InitializeReuse( const TexMetadata& mdata )
+{
+    size_t mipLevels = mdata.mipLevels;
+    HRESULT hr = _ValidateMetadata( mdata, mipLevels );
+    if ( FAILED(hr) )
+        return hr;
+
+    TexMetadata mdata2 = mdata;
+    mdata2.mipLevels = mipLevels;
+
+    size_t pixelSize, nimages;
+    _DetermineImageArray( mdata2, CP_FLAGS_NONE, nimages, pixelSize );
+
+    if ( !_memory || pixelSize > _capacity )
+        return Initialize( mdata2 );
+
+    // The pixel buffer is large enough, so only the image array is rebuilt
+    if ( nimages != _nimages )
+    {
+        Image* image = new (std::nothrow) Image[ nimages ];
+        if ( !image )
+        {
+            Release();
+            return E_OUTOFMEMORY;
+        }
+
+        delete [] _image;
+        _image = image;
+        _nimages = nimages;
+    }
+
+    memset( _image, 0, sizeof(Image) * nimages );
+
+    _metadata = mdata2;
     _size = pixelSize;
     if ( !_SetupImageArray( _memory, pixelSize, _metadata, CP_FLAGS_NONE, _image, nimages ) )
     {
@@ -382,13 +472,13 @@ HRESULT ScratchImage::Initialize2D( DXGI_FORMAT fmt, size_t width, size_t height
     _nimages = nimages;
     memset( _image, 0, sizeof(Image) * nimages );
 
-    _memory = reinterpret_cast<uint8_t*>( _aligned_malloc( pixelSize, 16 ) );
+    _memory = _AllocatePixels( _allocator, pixelSize );
     if ( !_memory )
     {
         Release();
         return E_OUTOFMEMORY;
     }
-    _size = pixelSize;
+    _size = _capacity = pixelSize;
     if ( !_SetupImageArray( _memory, pixelSize, _metadata, CP_FLAGS_NONE, _image, nimages ) )
     {
         Release();
@@ -431,13 +521,13 @@ HRESULT ScratchImage::Initialize3D( DXGI_FORMAT fmt, size_t width, size_t height
     _nimages = nimages;
     memset( _image, 0, sizeof(Image) * nimages );
 
-    _memory = reinterpret_cast<uint8_t*>( _aligned_malloc( pixelSize, 16 ) );
+    _memory = _AllocatePixels( _allocator, pixelSize );
     if ( !_memory )
     {
         Release();
         return E_OUTOFMEMORY;
     }
-    _size = pixelSize;
+    _size = _capacity = pixelSize;
 
     if ( !_SetupImageArray( _memory, pixelSize, _metadata, CP_FLAGS_NONE, _image, nimages ) )
     {
@@ -623,9 +713,10 @@ void ScratchImage::Release()
 
     if ( _memory )
     {
-        _aligned_free( _memory );
+        _FreePixels( _allocator, _memory, _capacity );
         _memory = 0;
     }
+    _capacity = 0;
     
     memset(&_metadata, 0, sizeof(_metadata));
 }
@@ -763,4 +854,46 @@ bool ScratchImage::IsAlphaAllOpaque() const
     return true;
 }
 
+
+
+//=====================================================================================
+// MappedImage - Read-only image container backed by a file mapping
+//=====================================================================================
+
+void MappedImage::Release()
+{
+    _nimages = 0;
+    _size = 0;
+    _pixels = 0;
+
+    if ( _image )
+    {
+        delete [] _image;
+        _image = 0;
+    }
+
+    if ( _view )
+    {
+        UnmapViewOfFile( _view );
+        _view = 0;
+    }
+
+    _copy.Release();
+
+    memset(&_metadata, 0, sizeof(_metadata));
+}
+
+_Use_decl_annotations_
+const Image* MappedImage::GetImage(size_t mip, size_t item, size_t slice) const
+{
+    if ( !_image )
+        return nullptr;
+
+    size_t index = _metadata.ComputeIndex( mip, item, slice );
+    if ( index >= _nimages )
+        return nullptr;
+
+    return &_image[index];
+}
+
 }; // namespace
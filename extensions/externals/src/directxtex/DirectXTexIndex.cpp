@@ -0,0 +1,652 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexIndex.cpp
+//
+// DirectX Texture Library - Persistent metadata index for DDS/TGA file libraries
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#include "directxtexp.h"
+
+#include <string>
+
+namespace DirectX
+{
+
+static const uint32_t INDEX_MAGIC = 0x58495854; // "TXIX"
+static const uint32_t INDEX_VERSION = 1;
+
+static const uint32_t INDEX_EMPTY = uint32_t(-1);
+
+// Saved index: this header, then the entries, then the path characters
+struct _IndexHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    entryCount;
+    uint32_t    pathChars;
+};
+
+// One file, in the same layout in memory and on disk
+struct _IndexEntry
+{
+    uint64_t    hash;
+    uint64_t    fileSize;
+    uint64_t    writeTime;
+    uint32_t    pathOffset;     // Characters into the path pool
+    uint32_t    pathLength;
+    uint32_t    ddsFlags;       // DDS_FLAGS the header was decoded with (0 for TGA)
+    int32_t     result;         // The metadata is only valid if this succeeded
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    depth;
+    uint32_t    arraySize;
+    uint32_t    mipLevels;
+    uint32_t    miscFlags;
+    uint32_t    miscFlags2;
+    uint32_t    format;
+    uint32_t    dimension;
+    uint32_t    reserved;
+};
+
+static_assert( sizeof(_IndexEntry) == 80, "Index entry size mismatch" );
+
+//-------------------------------------------------------------------------------------
+// Entries are kept in one array with their paths in one pool; an open-addressed table
+// of entry indices (linear probing) gives the constant-time lookup
+//-------------------------------------------------------------------------------------
+struct TexMetadataIndex::Impl
+{
+    std::vector<_IndexEntry>    entries;
+    std::vector<wchar_t>        paths;
+    std::vector<uint32_t>       slots;      // Power of two in size, at most half full
+
+    uint32_t Find( _In_ uint64_t hash, _In_reads_(length) const wchar_t* path, _In_ size_t length ) const
+    {
+        if ( slots.empty() )
+            return INDEX_EMPTY;
+
+        const size_t mask = slots.size() - 1;
+        for( size_t slot = size_t( hash ) & mask; ; slot = ( slot + 1 ) & mask )
+        {
+            const uint32_t index = slots[ slot ];
+            if ( index == INDEX_EMPTY )
+                return INDEX_EMPTY;
+
+            const _IndexEntry& entry = entries[ index ];
+            if ( entry.hash == hash && entry.pathLength == length
+                 && !wmemcmp( &paths[ entry.pathOffset ], path, length ) )
+                return index;
+        }
+    }
+
+    void Insert( _In_ uint32_t index )
+    {
+        if ( ( entries.size() * 2 ) > slots.size() )
+        {
+            Rebuild();
+            return;
+        }
+
+        const size_t mask = slots.size() - 1;
+        size_t slot = size_t( entries[ index ].hash ) & mask;
+        while( slots[ slot ] != INDEX_EMPTY )
+            slot = ( slot + 1 ) & mask;
+
+        slots[ slot ] = index;
+    }
+
+    void Rebuild()
+    {
+        size_t count = 64;
+        while( count < entries.size() * 2 )
+            count <<= 1;
+
+        slots.assign( count, INDEX_EMPTY );
+
+        const size_t mask = count - 1;
+        for( size_t index = 0; index < entries.size(); ++index )
+        {
+            size_t slot = size_t( entries[ index ].hash ) & mask;
+            while( slots[ slot ] != INDEX_EMPTY )
+                slot = ( slot + 1 ) & mask;
+
+            slots[ slot ] = static_cast<uint32_t>( index );
+        }
+    }
+};
+
+
+//-------------------------------------------------------------------------------------
+// Path helpers
+//-------------------------------------------------------------------------------------
+static uint64_t _HashPath( _In_reads_(length) const wchar_t* path, _In_ size_t length )
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for( size_t i = 0; i < length; ++i )
+    {
+        hash ^= uint64_t( path[ i ] );
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void _LowerPath( _Inout_ std::wstring& path, _In_ size_t offset )
+{
+    if ( offset < path.size() )
+    {
+        CharLowerBuffW( &path[ offset ], static_cast<DWORD>( path.size() - offset ) );
+    }
+}
+
+static HRESULT _GetIndexPath( _In_z_ LPCWSTR szFile, _Out_ std::wstring& path )
+{
+    path.clear();
+
+    DWORD length = GetFullPathNameW( szFile, 0, nullptr, nullptr );
+    if ( !length )
+        return HRESULT_FROM_WIN32( GetLastError() );
+
+    path.resize( length );
+    length = GetFullPathNameW( szFile, length, &path[0], nullptr );
+    if ( !length || length >= path.size() )
+        return E_FAIL;
+
+    path.resize( length );
+
+    // Trailing separators would make directory prefixes compare differently
+    while( path.size() > 1 && ( path.back() == L'\\' || path.back() == L'/' ) )
+        path.pop_back();
+
+    _LowerPath( path, 0 );
+    return S_OK;
+}
+
+static uint64_t _FileTime( _In_ const FILETIME& ft )
+{
+    return ( uint64_t( ft.dwHighDateTime ) << 32 ) | ft.dwLowDateTime;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Parallel header reads for new and changed files
+//-------------------------------------------------------------------------------------
+struct _ScanFile
+{
+    std::wstring    path;
+    uint64_t        hash;
+    uint64_t        fileSize;
+    uint64_t        writeTime;
+    uint32_t        entry;      // Entry to refresh, or INDEX_EMPTY for a new file
+    bool            dds;
+    HRESULT         result;
+    TexMetadata     metadata;
+};
+
+struct _ScanContext
+{
+    _ScanFile*      files;
+    DWORD           ddsFlags;
+};
+
+static bool _ReadHeader( size_t item, void* pContext )
+{
+    auto context = reinterpret_cast<_ScanContext*>( pContext );
+    _ScanFile& file = context->files[ item ];
+
+    memset( &file.metadata, 0, sizeof(TexMetadata) );
+
+    // A file that fails is still indexed, so later scans skip it until it changes
+    if ( file.dds )
+    {
+        file.result = GetMetadataFromDDSFile( file.path.c_str(), context->ddsFlags, file.metadata );
+    }
+    else
+    {
+        file.result = GetMetadataFromTGAFile( file.path.c_str(), file.metadata );
+    }
+
+    return true;
+}
+
+static void _StoreScanFile( _In_ const _ScanFile& file, _In_ DWORD ddsFlags, _Inout_ _IndexEntry& entry )
+{
+    entry.hash = file.hash;
+    entry.fileSize = file.fileSize;
+    entry.writeTime = file.writeTime;
+    entry.ddsFlags = file.dds ? ddsFlags : 0;
+    entry.result = file.result;
+
+    const TexMetadata& mdata = file.metadata;
+    entry.width = static_cast<uint32_t>( mdata.width );
+    entry.height = static_cast<uint32_t>( mdata.height );
+    entry.depth = static_cast<uint32_t>( mdata.depth );
+    entry.arraySize = static_cast<uint32_t>( mdata.arraySize );
+    entry.mipLevels = static_cast<uint32_t>( mdata.mipLevels );
+    entry.miscFlags = mdata.miscFlags;
+    entry.miscFlags2 = mdata.miscFlags2;
+    entry.format = static_cast<uint32_t>( mdata.format );
+    entry.dimension = static_cast<uint32_t>( mdata.dimension );
+    entry.reserved = 0;
+}
+
+
+//=====================================================================================
+// TexMetadataIndex
+//=====================================================================================
+
+// The methods report E_OUTOFMEMORY (or an empty index) if this allocation failed
+TexMetadataIndex::TexMetadataIndex() :
+    _impl( new (std::nothrow) Impl )
+{
+}
+
+TexMetadataIndex::~TexMetadataIndex()
+{
+    delete _impl;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Methods
+//-------------------------------------------------------------------------------------
+size_t TexMetadataIndex::GetCount() const
+{
+    return ( _impl ) ? _impl->entries.size() : 0;
+}
+
+void TexMetadataIndex::Clear()
+{
+    if ( !_impl )
+        return;
+
+    _impl->entries.clear();
+    _impl->paths.clear();
+    _impl->slots.clear();
+}
+
+_Use_decl_annotations_
+bool TexMetadataIndex::Find( LPCWSTR szFile, TexMetadata& metadata ) const
+{
+    memset( &metadata, 0, sizeof(TexMetadata) );
+
+    if ( !szFile || !_impl || _impl->entries.empty() )
+        return false;
+
+    std::wstring path;
+    if ( FAILED( _GetIndexPath( szFile, path ) ) )
+        return false;
+
+    const uint32_t index = _impl->Find( _HashPath( path.c_str(), path.size() ), path.c_str(), path.size() );
+    if ( index == INDEX_EMPTY )
+        return false;
+
+    const _IndexEntry& entry = _impl->entries[ index ];
+    if ( FAILED( entry.result ) )
+        return false;
+
+    metadata.width = entry.width;
+    metadata.height = entry.height;
+    metadata.depth = entry.depth;
+    metadata.arraySize = entry.arraySize;
+    metadata.mipLevels = entry.mipLevels;
+    metadata.miscFlags = entry.miscFlags;
+    metadata.miscFlags2 = entry.miscFlags2;
+    metadata.format = static_cast<DXGI_FORMAT>( entry.format );
+    metadata.dimension = static_cast<TEX_DIMENSION>( entry.dimension );
+
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Load/save the index as a single block read or write
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT TexMetadataIndex::Load( LPCWSTR szFile )
+{
+    if ( !szFile )
+        return E_INVALIDARG;
+
+    if ( !_impl )
+        return E_OUTOFMEMORY;
+
+    Clear();
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile( safe_handle( CreateFile2( szFile, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, 0 ) ) );
+#else
+    ScopedHandle hFile( safe_handle( CreateFileW( szFile, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                                  FILE_FLAG_SEQUENTIAL_SCAN, 0 ) ) );
+#endif
+    if ( !hFile )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    LARGE_INTEGER fileSize = {0};
+    if ( !GetFileSizeEx( hFile.get(), &fileSize ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    if ( fileSize.HighPart > 0 )
+    {
+        return HRESULT_FROM_WIN32( ERROR_FILE_TOO_LARGE );
+    }
+
+    if ( fileSize.LowPart < sizeof(_IndexHeader) )
+    {
+        return E_FAIL;
+    }
+
+    std::unique_ptr<uint8_t[]> data( new (std::nothrow) uint8_t[ fileSize.LowPart ] );
+    if ( !data )
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    DWORD bytesRead = 0;
+    if ( !ReadFile( hFile.get(), data.get(), fileSize.LowPart, &bytesRead, 0 ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    if ( bytesRead != fileSize.LowPart )
+    {
+        return E_FAIL;
+    }
+
+    auto header = reinterpret_cast<const _IndexHeader*>( data.get() );
+    if ( header->magic != INDEX_MAGIC || header->version != INDEX_VERSION )
+    {
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+    }
+
+    const uint64_t expected = sizeof(_IndexHeader) + uint64_t( header->entryCount ) * sizeof(_IndexEntry)
+                              + uint64_t( header->pathChars ) * sizeof(wchar_t);
+    if ( expected != fileSize.LowPart )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+    }
+
+    auto entries = reinterpret_cast<const _IndexEntry*>( data.get() + sizeof(_IndexHeader) );
+    for( size_t index = 0; index < header->entryCount; ++index )
+    {
+        const _IndexEntry& entry = entries[ index ];
+        if ( !entry.pathLength || entry.pathOffset > header->pathChars
+             || entry.pathLength > ( header->pathChars - entry.pathOffset ) )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+    }
+
+    auto paths = reinterpret_cast<const wchar_t*>( entries + header->entryCount );
+
+    _impl->entries.assign( entries, entries + header->entryCount );
+    _impl->paths.assign( paths, paths + header->pathChars );
+    _impl->Rebuild();
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT TexMetadataIndex::Save( LPCWSTR szFile ) const
+{
+    if ( !szFile )
+        return E_INVALIDARG;
+
+    if ( !_impl )
+        return E_OUTOFMEMORY;
+
+    const uint64_t entryBytes = uint64_t( _impl->entries.size() ) * sizeof(_IndexEntry);
+    const uint64_t pathBytes = uint64_t( _impl->paths.size() ) * sizeof(wchar_t);
+    if ( ( sizeof(_IndexHeader) + entryBytes + pathBytes ) > UINT32_MAX )
+    {
+        return HRESULT_FROM_WIN32( ERROR_FILE_TOO_LARGE );
+    }
+
+    _IndexHeader header;
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.entryCount = static_cast<uint32_t>( _impl->entries.size() );
+    header.pathChars = static_cast<uint32_t>( _impl->paths.size() );
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile( safe_handle( CreateFile2( szFile, GENERIC_WRITE, 0, CREATE_ALWAYS, 0 ) ) );
+#else
+    ScopedHandle hFile( safe_handle( CreateFileW( szFile, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0 ) ) );
+#endif
+    if ( !hFile )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    const void* blocks[3] = { &header, _impl->entries.data(), _impl->paths.data() };
+    const DWORD sizes[3] = { sizeof(_IndexHeader), static_cast<DWORD>( entryBytes ), static_cast<DWORD>( pathBytes ) };
+
+    for( size_t i = 0; i < 3; ++i )
+    {
+        if ( !sizes[ i ] )
+            continue;
+
+        DWORD bytesWritten;
+        if ( !WriteFile( hFile.get(), blocks[ i ], sizes[ i ], &bytesWritten, 0 ) )
+        {
+            return HRESULT_FROM_WIN32( GetLastError() );
+        }
+
+        if ( bytesWritten != sizes[ i ] )
+        {
+            return E_FAIL;
+        }
+    }
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Incremental scan: the directory walk only compares sizes and write times; headers of
+// new or changed files are then read in parallel and merged into the index
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT TexMetadataIndex::Scan( LPCWSTR szDirectory, DWORD flags, DWORD ddsFlags, TexIndexStatistics* stats )
+{
+    if ( stats )
+    {
+        memset( stats, 0, sizeof(TexIndexStatistics) );
+    }
+
+    if ( !szDirectory )
+        return E_INVALIDARG;
+
+    if ( !_impl )
+        return E_OUTOFMEMORY;
+
+    std::wstring root;
+    HRESULT hr = _GetIndexPath( szDirectory, root );
+    if ( FAILED(hr) )
+        return hr;
+
+    const bool recursive = ( flags & TEX_INDEX_RECURSIVE ) != 0;
+
+    std::vector<uint8_t> seen( _impl->entries.size(), 0 );
+    std::vector<_ScanFile> files;
+    size_t nFiles = 0;
+
+    std::vector<std::wstring> dirs;
+    dirs.push_back( root );
+
+    while( !dirs.empty() )
+    {
+        std::wstring dir( std::move( dirs.back() ) );
+        dirs.pop_back();
+
+        const std::wstring pattern = dir + L"\\*";
+
+        WIN32_FIND_DATAW findData;
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN7)
+        HANDLE hFind = FindFirstFileExW( pattern.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch,
+                                         nullptr, FIND_FIRST_EX_LARGE_FETCH );
+#else
+        HANDLE hFind = FindFirstFileW( pattern.c_str(), &findData );
+#endif
+        if ( hFind == INVALID_HANDLE_VALUE )
+        {
+            // Subdirectories that can't be listed are skipped, but the root must exist
+            if ( dir.size() == root.size() )
+                return HRESULT_FROM_WIN32( GetLastError() );
+
+            continue;
+        }
+
+        do
+        {
+            const wchar_t* name = findData.cFileName;
+
+            if ( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+            {
+                // Reparse points are not followed so links can't make the walk cycle
+                if ( recursive
+                     && !( findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT )
+                     && wcscmp( name, L"." ) != 0 && wcscmp( name, L".." ) != 0 )
+                {
+                    std::wstring subdir = dir + L"\\" + name;
+                    _LowerPath( subdir, dir.size() + 1 );
+                    dirs.push_back( std::move( subdir ) );
+                }
+                continue;
+            }
+
+            const wchar_t* ext = wcsrchr( name, L'.' );
+            if ( !ext )
+                continue;
+
+            const bool dds = ( _wcsicmp( ext, L".dds" ) == 0 );
+            if ( !dds && _wcsicmp( ext, L".tga" ) != 0 )
+                continue;
+
+            ++nFiles;
+
+            _ScanFile file;
+            file.path = dir + L"\\" + name;
+            _LowerPath( file.path, dir.size() + 1 );
+            file.hash = _HashPath( file.path.c_str(), file.path.size() );
+            file.fileSize = ( uint64_t( findData.nFileSizeHigh ) << 32 ) | findData.nFileSizeLow;
+            file.writeTime = _FileTime( findData.ftLastWriteTime );
+            file.dds = dds;
+            file.result = E_FAIL;
+
+            file.entry = _impl->Find( file.hash, file.path.c_str(), file.path.size() );
+            if ( file.entry != INDEX_EMPTY )
+            {
+                seen[ file.entry ] = 1;
+
+                const _IndexEntry& entry = _impl->entries[ file.entry ];
+                if ( entry.fileSize == file.fileSize && entry.writeTime == file.writeTime
+                     && ( !dds || entry.ddsFlags == ddsFlags ) )
+                    continue;
+            }
+
+            files.push_back( std::move( file ) );
+        }
+        while( FindNextFileW( hFind, &findData ) );
+
+        FindClose( hFind );
+    }
+
+    if ( !files.empty() )
+    {
+        _ScanContext context;
+        context.files = files.data();
+        context.ddsFlags = ddsFlags;
+
+        hr = _ParallelFor( files.size(), _ReadHeader, &context );
+        if ( FAILED(hr) )
+            return hr;
+    }
+
+    // Merge in the order the walk found the files so the result doesn't depend on thread timing
+    size_t nFailed = 0;
+    for( auto it = files.begin(); it != files.end(); ++it )
+    {
+        if ( FAILED( it->result ) )
+            ++nFailed;
+
+        if ( it->entry != INDEX_EMPTY )
+        {
+            _StoreScanFile( *it, ddsFlags, _impl->entries[ it->entry ] );
+            continue;
+        }
+
+        if ( _impl->entries.size() >= INDEX_EMPTY || ( _impl->paths.size() + it->path.size() ) > UINT32_MAX )
+            return E_OUTOFMEMORY;
+
+        _IndexEntry entry;
+        entry.pathOffset = static_cast<uint32_t>( _impl->paths.size() );
+        entry.pathLength = static_cast<uint32_t>( it->path.size() );
+        _StoreScanFile( *it, ddsFlags, entry );
+
+        _impl->paths.insert( _impl->paths.end(), it->path.begin(), it->path.end() );
+        _impl->entries.push_back( entry );
+        _impl->Insert( static_cast<uint32_t>( _impl->entries.size() - 1 ) );
+    }
+
+    // Entries under the scanned directory that the walk didn't see belong to deleted files
+    size_t nRemoved = 0;
+    if ( flags & TEX_INDEX_PRUNE )
+    {
+        const std::wstring prefix = root + L"\\";
+
+        std::vector<_IndexEntry> entries;
+        std::vector<wchar_t> paths;
+        entries.reserve( _impl->entries.size() );
+        paths.reserve( _impl->paths.size() );
+
+        for( size_t index = 0; index < _impl->entries.size(); ++index )
+        {
+            _IndexEntry entry = _impl->entries[ index ];
+            const wchar_t* path = &_impl->paths[ entry.pathOffset ];
+
+            if ( index < seen.size() && !seen[ index ]
+                 && entry.pathLength > prefix.size() && !wmemcmp( path, prefix.c_str(), prefix.size() )
+                 && ( recursive || !wmemchr( path + prefix.size(), L'\\', entry.pathLength - prefix.size() ) ) )
+            {
+                ++nRemoved;
+                continue;
+            }
+
+            entry.pathOffset = static_cast<uint32_t>( paths.size() );
+            paths.insert( paths.end(), path, path + entry.pathLength );
+            entries.push_back( entry );
+        }
+
+        if ( nRemoved )
+        {
+            _impl->entries.swap( entries );
+            _impl->paths.swap( paths );
+            _impl->Rebuild();
+        }
+    }
+
+    if ( stats )
+    {
+        stats->files = nFiles;
+        stats->parsed = files.size();
+        stats->failed = nFailed;
+        stats->removed = nRemoved;
+    }
+
+    return S_OK;
+}
+
+}; // namespace
@@ -414,7 +414,9 @@ static bool _UseWICFiltering( _In_ DXGI_FORMAT format, _In_ DWORD filter )
         break;
 
     case TEX_FILTER_TRIANGLE:
-        // WIC does not implement this filter
+    case TEX_FILTER_LANCZOS:
+    case TEX_FILTER_KAISER:
+        // WIC does not implement these filters
         return false;
     }
 
@@ -684,1175 +686,130 @@ static HRESULT _Generate2DMipsPointFilter( _In_ size_t levels, _In_ const Scratc
 }
 
 
-//--- 2D Box Filter ---
-static HRESULT _Generate2DMipsBoxFilter( _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain, _In_ size_t item )
+//--- 2D Box, Linear, Cubic, and Triangle Filters ---
+static HRESULT _Generate2DMipsSeparableFilter( _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain )
 {
     if ( !mipChain.GetImages() )
         return E_INVALIDARG;
 
-    // This assumes that the base image is already placed into the mipChain at the top level... (see _Setup2DMips)
-
-    assert( levels > 1 );
-
-    size_t width = mipChain.GetMetadata().width;
-    size_t height = mipChain.GetMetadata().height;
-
-    if ( !ispow2(width) || !ispow2(height) )
-        return E_FAIL;
-
-    // Allocate temporary space (3 scanlines)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width*3), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    XMVECTOR* target = scanline.get();
-
-    XMVECTOR* urow0 = target + width;
-    XMVECTOR* urow1 = target + width*2;
-
-    const XMVECTOR* urow2 = urow0 + 1;
-    const XMVECTOR* urow3 = urow1 + 1;
-
-    // Resize base image to each target mip level
-    for( size_t level=1; level < levels; ++level )
-    {
-        if ( height <= 1 )
-        {
-            urow1 = urow0;
-        }
-
-        if ( width <= 1 )
-        {
-            urow2 = urow0;
-            urow3 = urow1;
-        }
-
-        // 2D box filter
-        const Image* src = mipChain.GetImage( level-1, item, 0 );
-        const Image* dest = mipChain.GetImage( level, item, 0 );
-
-        if ( !src || !dest )
-            return E_POINTER;
-
-        const uint8_t* pSrc = src->pixels;
-        uint8_t* pDest = dest->pixels;
-
-        size_t rowPitch = src->rowPitch;
-
-        size_t nwidth = (width > 1) ? (width >> 1) : 1;
-        size_t nheight = (height > 1) ? (height >> 1) : 1;
-
-        for( size_t y = 0; y < nheight; ++y )
-        {
-            if ( !_LoadScanlineLinear( urow0, width, pSrc, rowPitch, src->format, filter ) )
-                return E_FAIL;
-            pSrc += rowPitch;
-
-            if ( urow0 != urow1 )
-            {
-                if ( !_LoadScanlineLinear( urow1, width, pSrc, rowPitch, src->format, filter ) )
-                    return E_FAIL;
-                pSrc += rowPitch;
-            }
-
-            for( size_t x = 0; x < nwidth; ++x )
-            {
-                size_t x2 = x << 1;
-
-                AVERAGE4( target[ x ], urow0[ x2 ], urow1[ x2 ], urow2[ x2 ], urow3[ x2 ] );
-            }
-
-            if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, target, nwidth, filter ) )
-                return E_FAIL;
-            pDest += dest->rowPitch;
-        }
-
-        if ( height > 1 )
-            height >>= 1;
-
-        if ( width > 1 )
-            width >>= 1;
-    }
-
-    return S_OK;
-}
-
-
-//--- 2D Linear Filter ---
-static HRESULT _Generate2DMipsLinearFilter( _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain, _In_ size_t item )
-{
-    if ( !mipChain.GetImages() )
-        return E_INVALIDARG;
-
-    // This assumes that the base image is already placed into the mipChain at the top level... (see _Setup2DMips)
-
-    assert( levels > 1 );
-
-    size_t width = mipChain.GetMetadata().width;
-    size_t height = mipChain.GetMetadata().height;
-
-    // Allocate temporary space (3 scanlines, plus X and Y filters)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width*3), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    std::unique_ptr<LinearFilter[]> lf( new (std::nothrow) LinearFilter[ width+height ] );
-    if ( !lf )
-        return E_OUTOFMEMORY;
-
-    LinearFilter* lfX = lf.get();
-    LinearFilter* lfY = lf.get() + width;
- 
-    XMVECTOR* target = scanline.get();
-
-    XMVECTOR* row0 = target + width;
-    XMVECTOR* row1 = target + width*2;
-
-    // Resize base image to each target mip level
-    for( size_t level=1; level < levels; ++level )
-    {
-        // 2D linear filter
-        const Image* src = mipChain.GetImage( level-1, item, 0 );
-        const Image* dest = mipChain.GetImage( level, item, 0 );
-
-        if ( !src || !dest )
-            return E_POINTER;
-
-        const uint8_t* pSrc = src->pixels;
-        uint8_t* pDest = dest->pixels;
-
-        size_t rowPitch = src->rowPitch;
-
-        size_t nwidth = (width > 1) ? (width >> 1) : 1;
-        _CreateLinearFilter( width, nwidth, (filter & TEX_FILTER_WRAP_U) != 0, lfX );
-
-        size_t nheight = (height > 1) ? (height >> 1) : 1;
-        _CreateLinearFilter( height, nheight, (filter & TEX_FILTER_WRAP_V) != 0, lfY );
-
-#ifdef _DEBUG
-        memset( row0, 0xCD, sizeof(XMVECTOR)*width );
-        memset( row1, 0xDD, sizeof(XMVECTOR)*width );
-#endif
-
-        size_t u0 = size_t(-1);
-        size_t u1 = size_t(-1);
-
-        for( size_t y = 0; y < nheight; ++y )
-        {
-            auto& toY = lfY[ y ];
-
-            if ( toY.u0 != u0 )
-            {
-                if ( toY.u0 != u1 )
-                {
-                    u0 = toY.u0;
-
-                    if ( !_LoadScanlineLinear( row0, width, pSrc + (rowPitch * u0), rowPitch, src->format, filter ) )
-                        return E_FAIL;
-                }
-                else
-                {
-                    u0 = u1;
-                    u1 = size_t(-1);
-
-                    std::swap( row0, row1 );
-                }
-            }
-
-            if ( toY.u1 != u1 )
-            {
-                u1 = toY.u1;
-
-                if ( !_LoadScanlineLinear( row1, width, pSrc + (rowPitch * u1), rowPitch, src->format, filter ) )
-                    return E_FAIL;
-            }
-
-            for( size_t x = 0; x < nwidth; ++x )
-            {
-                auto& toX = lfX[ x ];
-
-                BILINEAR_INTERPOLATE( target[x], toX, toY, row0, row1 );
-            }
-
-            if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, target, nwidth, filter ) )
-                return E_FAIL;
-            pDest += dest->rowPitch;
-        }
-
-        if ( height > 1 )
-            height >>= 1;
-
-        if ( width > 1 )
-            width >>= 1;
-    }
-
-    return S_OK;
-}
-
-
-//--- 2D Cubic Filter ---
-static HRESULT _Generate2DMipsCubicFilter( _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain, _In_ size_t item )
-{
-    if ( !mipChain.GetImages() )
-        return E_INVALIDARG;
-
-    // This assumes that the base image is already placed into the mipChain at the top level... (see _Setup2DMips)
-
-    assert( levels > 1 );
-
-    size_t width = mipChain.GetMetadata().width;
-    size_t height = mipChain.GetMetadata().height;
-
-    // Allocate temporary space (5 scanlines, plus X and Y filters)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width*5), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    std::unique_ptr<CubicFilter[]> cf( new (std::nothrow) CubicFilter[ width+height ] );
-    if ( !cf )
-        return E_OUTOFMEMORY;
-
-    CubicFilter* cfX = cf.get();
-    CubicFilter* cfY = cf.get() + width;
- 
-    XMVECTOR* target = scanline.get();
-
-    XMVECTOR* row0 = target + width;
-    XMVECTOR* row1 = target + width*2;
-    XMVECTOR* row2 = target + width*3;
-    XMVECTOR* row3 = target + width*4;
-
-    // Resize base image to each target mip level
-    for( size_t level=1; level < levels; ++level )
-    {
-        // 2D cubic filter
-        const Image* src = mipChain.GetImage( level-1, item, 0 );
-        const Image* dest = mipChain.GetImage( level, item, 0 );
-
-        if (  !src || !dest )
-            return E_POINTER;
-
-        const uint8_t* pSrc = src->pixels;
-        uint8_t* pDest = dest->pixels;
-
-        size_t rowPitch = src->rowPitch;
-
-        size_t nwidth = (width > 1) ? (width >> 1) : 1;
-        _CreateCubicFilter( width, nwidth, (filter & TEX_FILTER_WRAP_U) != 0, (filter & TEX_FILTER_MIRROR_U) != 0, cfX );
-
-        size_t nheight = (height > 1) ? (height >> 1) : 1;
-        _CreateCubicFilter( height, nheight, (filter & TEX_FILTER_WRAP_V) != 0, (filter & TEX_FILTER_MIRROR_V) != 0, cfY );
-
-#ifdef _DEBUG
-        memset( row0, 0xCD, sizeof(XMVECTOR)*width );
-        memset( row1, 0xDD, sizeof(XMVECTOR)*width );
-        memset( row2, 0xED, sizeof(XMVECTOR)*width );
-        memset( row3, 0xFD, sizeof(XMVECTOR)*width );
-#endif
-
-        size_t u0 = size_t(-1);
-        size_t u1 = size_t(-1);
-        size_t u2 = size_t(-1);
-        size_t u3 = size_t(-1);
-
-        for( size_t y = 0; y < nheight; ++y )
-        {
-            auto& toY = cfY[ y ];
-
-            // Scanline 1
-            if ( toY.u0 != u0 )
-            {
-                if ( toY.u0 != u1 && toY.u0 != u2 && toY.u0 != u3 )
-                {
-                    u0 = toY.u0;
-
-                    if ( !_LoadScanlineLinear( row0, width, pSrc + (rowPitch * u0), rowPitch, src->format, filter ) )
-                        return E_FAIL;
-                }
-                else if ( toY.u0 == u1 )
-                {
-                    u0 = u1;
-                    u1 = size_t(-1);
-
-                    std::swap( row0, row1 );
-                }
-                else if ( toY.u0 == u2 )
-                {
-                    u0 = u2;
-                    u2 = size_t(-1);
-
-                    std::swap( row0, row2 );
-                }
-                else if ( toY.u0 == u3 )
-                {
-                    u0 = u3;
-                    u3 = size_t(-1);
-
-                    std::swap( row0, row3 );
-                }
-            }
-
-            // Scanline 2
-            if ( toY.u1 != u1 )
-            {
-                if ( toY.u1 != u2 && toY.u1 != u3 )
-                {
-                    u1 = toY.u1;
-
-                    if ( !_LoadScanlineLinear( row1, width, pSrc + (rowPitch * u1), rowPitch, src->format, filter ) )
-                        return E_FAIL;
-                }
-                else if ( toY.u1 == u2 )
-                {
-                    u1 = u2;
-                    u2 = size_t(-1);
-
-                    std::swap( row1, row2 );
-                }
-                else if ( toY.u1 == u3 )
-                {
-                    u1 = u3;
-                    u3 = size_t(-1);
-
-                    std::swap( row1, row3 );
-                }
-            }
-
-            // Scanline 3
-            if ( toY.u2 != u2 )
-            {
-                if ( toY.u2 != u3 )
-                {
-                    u2 = toY.u2;
-
-                    if ( !_LoadScanlineLinear( row2, width, pSrc + (rowPitch * u2), rowPitch, src->format, filter ) )
-                        return E_FAIL;
-                }
-                else
-                {
-                    u2 = u3;
-                    u3 = size_t(-1);
-
-                    std::swap( row2, row3 );
-                }
-            }
-
-            // Scanline 4
-            if ( toY.u3 != u3 )
-            {
-                u3 = toY.u3;
-
-                if ( !_LoadScanlineLinear( row3, width, pSrc + (rowPitch * u3), rowPitch, src->format, filter ) )
-                    return E_FAIL;
-            }
-
-            for( size_t x = 0; x < nwidth; ++x )
-            {
-                auto& toX = cfX[ x ];
-
-                XMVECTOR C0, C1, C2, C3;
-
-                CUBIC_INTERPOLATE( C0, toX.x, row0[ toX.u0 ], row0[ toX.u1 ], row0[ toX.u2 ], row0[ toX.u3 ] );
-                CUBIC_INTERPOLATE( C1, toX.x, row1[ toX.u0 ], row1[ toX.u1 ], row1[ toX.u2 ], row1[ toX.u3 ] );
-                CUBIC_INTERPOLATE( C2, toX.x, row2[ toX.u0 ], row2[ toX.u1 ], row2[ toX.u2 ], row2[ toX.u3 ] );
-                CUBIC_INTERPOLATE( C3, toX.x, row3[ toX.u0 ], row3[ toX.u1 ], row3[ toX.u2 ], row3[ toX.u3 ] );
-
-                CUBIC_INTERPOLATE( target[x], toY.x, C0, C1, C2, C3 );
-            }
-
-            if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, target, nwidth, filter ) )
-                return E_FAIL;
-            pDest += dest->rowPitch;
-        }
-
-        if ( height > 1 )
-            height >>= 1;
-
-        if ( width > 1 )
-            width >>= 1;
-    }
-
-    return S_OK;
-}
-
-
-//--- 2D Triangle Filter ---
-static HRESULT _Generate2DMipsTriangleFilter( _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain, _In_ size_t item )
-{
-    if ( !mipChain.GetImages() )
-        return E_INVALIDARG;
-
-    using namespace TriangleFilter;
-
-    // This assumes that the base image is already placed into the mipChain at the top level... (see _Setup2DMips)
-
-    assert( levels > 1 );
-
-    size_t width = mipChain.GetMetadata().width;
-    size_t height = mipChain.GetMetadata().height;
-
-    // Allocate initial temporary space (1 scanline, accumulation rows, plus X and Y filters)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( sizeof(XMVECTOR) * width, 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    std::unique_ptr<TriangleRow[]> rowActive( new (std::nothrow) TriangleRow[ height ] );
-    if ( !rowActive )
-        return E_OUTOFMEMORY;
-
-    TriangleRow * rowFree = nullptr;
-
-    std::unique_ptr<Filter> tfX, tfY;
-
-    XMVECTOR* row = scanline.get();
-
-    // Resize base image to each target mip level
-    for( size_t level=1; level < levels; ++level )
-    {
-        // 2D triangle filter
-        const Image* src = mipChain.GetImage( level-1, item, 0 );
-        const Image* dest = mipChain.GetImage( level, item, 0 );
-
-        if ( !src || !dest )
-            return E_POINTER;
-
-        const uint8_t* pSrc = src->pixels;
-        size_t rowPitch = src->rowPitch;
-        const uint8_t* pEndSrc = pSrc + rowPitch * height;
-
-        uint8_t* pDest = dest->pixels;
-
-        size_t nwidth = (width > 1) ? (width >> 1) : 1;
-        HRESULT hr = _Create( width, nwidth, (filter & TEX_FILTER_WRAP_U) != 0, tfX );
-        if ( FAILED(hr) )
-            return hr;
-        
-        size_t nheight = (height > 1) ? (height >> 1) : 1;
-        hr = _Create( height, nheight, (filter & TEX_FILTER_WRAP_V) != 0, tfY );
-        if ( FAILED(hr) )
-            return hr;
-
-#ifdef _DEBUG
-        memset( row, 0xCD, sizeof(XMVECTOR)*width );
-#endif
-
-        auto xFromEnd = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( tfX.get() ) + tfX->sizeInBytes );
-        auto yFromEnd = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( tfY.get() ) + tfY->sizeInBytes );
-
-        // Count times rows get written (and clear out any leftover accumulation rows from last miplevel)
-        for( FilterFrom* yFrom = tfY->from; yFrom < yFromEnd; )
-        {
-            for ( size_t j = 0; j < yFrom->count; ++j )
-            {
-                size_t v = yFrom->to[ j ].u;
-                assert( v < nheight );
-                TriangleRow* rowAcc = &rowActive.get()[ v ];
-
-                ++rowAcc->remaining;
-
-                if ( rowAcc->scanline )
-                {
-                    memset( rowAcc->scanline.get(), 0, sizeof(XMVECTOR) * nwidth );
-                }
-            }
-
-            yFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( yFrom ) + yFrom->sizeInBytes );
-        }
-
-        // Filter image
-        for( FilterFrom* yFrom = tfY->from; yFrom < yFromEnd; )
-        {
-            // Create accumulation rows as needed
-            for ( size_t j = 0; j < yFrom->count; ++j )
-            {
-                size_t v = yFrom->to[ j ].u;
-                assert( v < nheight );
-                TriangleRow* rowAcc = &rowActive.get()[ v ];
-
-                if ( !rowAcc->scanline )
-                {
-                    if ( rowFree )
-                    {
-                        // Steal and reuse scanline from 'free row' list
-                        // (it will always be at least as wide as nwidth due to loop decending order)
-                        assert( rowFree->scanline != 0 );
-                        rowAcc->scanline.reset( rowFree->scanline.release() );
-                        rowFree = rowFree->next;
-                    }
-                    else
-                    {
-                        rowAcc->scanline.reset( reinterpret_cast<XMVECTOR*>( _aligned_malloc( sizeof(XMVECTOR) * nwidth, 16 ) ) );
-                        if ( !rowAcc->scanline )
-                            return E_OUTOFMEMORY;
-                    }
-
-                    memset( rowAcc->scanline.get(), 0, sizeof(XMVECTOR) * nwidth );
-                }
-            }
-
-            // Load source scanline
-            if ( (pSrc + rowPitch) > pEndSrc )
-                return E_FAIL;
-
-            if ( !_LoadScanlineLinear( row, width, pSrc, rowPitch, src->format, filter ) )
-                return E_FAIL;
-
-            pSrc += rowPitch;
-
-            // Process row
-            size_t x = 0;
-            for( FilterFrom* xFrom = tfX->from; xFrom < xFromEnd; ++x )
-            {
-                for ( size_t j = 0; j < yFrom->count; ++j )
-                {
-                    size_t v = yFrom->to[ j ].u;
-                    assert( v < nheight );
-                    float yweight = yFrom->to[ j ].weight;
-
-                    XMVECTOR* accPtr = rowActive[ v ].scanline.get();
-                    if ( !accPtr )
-                        return E_POINTER;
-
-                    for ( size_t k = 0; k < xFrom->count; ++k )
-                    {
-                        size_t u = xFrom->to[ k ].u;
-                        assert( u < nwidth );
-
-                        XMVECTOR weight = XMVectorReplicate( yweight * xFrom->to[ k ].weight );
-
-                        assert( x < width );
-                        accPtr[ u ] = XMVectorMultiplyAdd( row[ x ], weight, accPtr[ u ] );
-                    }
-                }
-
-                xFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( xFrom ) + xFrom->sizeInBytes );
-            }
-
-            // Write completed accumulation rows
-            for ( size_t j = 0; j < yFrom->count; ++j )
-            {
-                size_t v = yFrom->to[ j ].u;
-                assert( v < nheight );
-                TriangleRow* rowAcc = &rowActive.get()[ v ];
-
-                assert( rowAcc->remaining > 0 );
-                --rowAcc->remaining;
-
-                if ( !rowAcc->remaining )
-                {
-                    XMVECTOR* pAccSrc = rowAcc->scanline.get();
-                    if ( !pAccSrc )
-                        return E_POINTER;
-
-                    switch( dest->format )
-                    {
-                    case DXGI_FORMAT_R10G10B10A2_UNORM:
-                    case DXGI_FORMAT_R10G10B10A2_UINT:
-                        {
-                            // Need to slightly bias results for floating-point error accumulation which can
-                            // be visible with harshly quantized values
-                            static const XMVECTORF32 Bias = { 0.f, 0.f, 0.f, 0.1f };
-                       
-                            XMVECTOR* ptr = pAccSrc;
-                            for( size_t i=0; i < dest->width; ++i, ++ptr )
-                            {
-                                *ptr = XMVectorAdd( *ptr, Bias );
-                            }
-                        }
-                        break;
-                    }
-
-                    // This performs any required clamping
-                    if ( !_StoreScanlineLinear( pDest + (dest->rowPitch * v), dest->rowPitch, dest->format, pAccSrc, dest->width, filter ) )
-                        return E_FAIL;
-
-                    // Put row on freelist to reuse it's allocated scanline
-                    rowAcc->next = rowFree;
-                    rowFree = rowAcc;
-                }
-            }
-
-            yFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( yFrom ) + yFrom->sizeInBytes );
-        }
-
-        if ( height > 1 )
-            height >>= 1;
-
-        if ( width > 1 )
-            width >>= 1;
-    }
-
-    return S_OK;
-}
-
-
-//-------------------------------------------------------------------------------------
-// Generate volume mip-map helpers
-//-------------------------------------------------------------------------------------
-static HRESULT _Setup3DMips( _In_reads_(depth) const Image* baseImages, _In_ size_t depth, size_t levels,
-                             _Out_ ScratchImage& mipChain )
-{
-    if ( !baseImages || !depth )
-        return E_INVALIDARG;
-
-    assert( levels > 1 );
-
-    size_t width = baseImages[0].width;
-    size_t height = baseImages[0].height;
-
-    HRESULT hr = mipChain.Initialize3D( baseImages[0].format, width, height, depth, levels );
-    if ( FAILED(hr) )
-        return hr;
-
-    // Copy base images to top slice
-    for( size_t slice=0; slice < depth; ++slice )
-    {
-        const Image& src = baseImages[slice];
-
-        const Image *dest = mipChain.GetImage( 0, 0, slice );
-        if ( !dest )
-        {
-            mipChain.Release();
-            return E_POINTER;
-        }
-
-        assert( src.format == dest->format );
-
-        uint8_t* pDest = dest->pixels;
-        if ( !pDest )
-        {
-            mipChain.Release();
-            return E_POINTER;
-        }
-
-        const uint8_t *pSrc = src.pixels;
-        size_t rowPitch = src.rowPitch;
-        for( size_t h=0; h < height; ++h )
-        {
-            size_t msize = std::min<size_t>( dest->rowPitch, rowPitch );
-            memcpy_s( pDest, dest->rowPitch, pSrc, msize );  
-            pSrc += rowPitch;
-            pDest += dest->rowPitch;
-        }
-    }
-
-    return S_OK;
-}
-
-
-//--- 3D Point Filter ---
-static HRESULT _Generate3DMipsPointFilter( _In_ size_t depth, _In_ size_t levels, _In_ const ScratchImage& mipChain )
-{
-    if ( !depth || !mipChain.GetImages() )
-        return E_INVALIDARG;
-
-    // This assumes that the base images are already placed into the mipChain at the top level... (see _Setup3DMips)
-
-    assert( levels > 1 );
-
-    size_t width = mipChain.GetMetadata().width;
-    size_t height = mipChain.GetMetadata().height;
-
-    // Allocate temporary space (2 scanlines)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width*2), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    XMVECTOR* target = scanline.get();
-
-    XMVECTOR* row = target + width;
-
-    // Resize base image to each target mip level
-    for( size_t level=1; level < levels; ++level )
-    {
-#ifdef _DEBUG
-        memset( row, 0xCD, sizeof(XMVECTOR)*width );
-#endif
-
-        if ( depth > 1 )
-        {
-            // 3D point filter
-            size_t ndepth = depth >> 1;
-
-            size_t zinc = ( depth << 16 ) / ndepth;
-
-            size_t sz = 0;
-            for( size_t slice=0; slice < ndepth; ++slice )
-            {
-                const Image* src = mipChain.GetImage( level-1, 0, (sz >> 16) );
-                const Image* dest = mipChain.GetImage( level, 0, slice );
-
-                if ( !src || !dest )
-                    return E_POINTER;
-
-                const uint8_t* pSrc = src->pixels;
-                uint8_t* pDest = dest->pixels;
-
-                size_t rowPitch = src->rowPitch;
-
-                size_t nwidth = (width > 1) ? (width >> 1) : 1;
-                size_t nheight = (height > 1) ? (height >> 1) : 1;
-
-                size_t xinc = ( width << 16 ) / nwidth;
-                size_t yinc = ( height << 16 ) / nheight;
-
-                size_t lasty = size_t(-1);
-
-                size_t sy = 0;
-                for( size_t y = 0; y < nheight; ++y )
-                {
-                    if ( (lasty ^ sy) >> 16 )
-                    {
-                        if ( !_LoadScanline( row, width, pSrc + ( rowPitch * (sy >> 16) ), rowPitch, src->format ) )
-                            return E_FAIL;
-                        lasty = sy;
-                    }
-
-                    size_t sx = 0;
-                    for( size_t x = 0; x < nwidth; ++x )
-                    {
-                        target[ x ] = row[ sx >> 16 ];
-                        sx += xinc;
-                    }
-
-                    if ( !_StoreScanline( pDest, dest->rowPitch, dest->format, target, nwidth ) )
-                        return E_FAIL;
-                    pDest += dest->rowPitch;
-
-                    sy += yinc;
-                }
-
-                sz += zinc;
-            }
-        }
-        else
-        {
-            // 2D point filter
-            const Image* src = mipChain.GetImage( level-1, 0, 0 );
-            const Image* dest = mipChain.GetImage( level, 0, 0 );
-
-            if ( !src || !dest )
-                return E_POINTER;
-
-            const uint8_t* pSrc = src->pixels;
-            uint8_t* pDest = dest->pixels;
-
-            size_t rowPitch = src->rowPitch;
-
-            size_t nwidth = (width > 1) ? (width >> 1) : 1;
-            size_t nheight = (height > 1) ? (height >> 1) : 1;
-
-            size_t xinc = ( width << 16 ) / nwidth;
-            size_t yinc = ( height << 16 ) / nheight;
-
-            size_t lasty = size_t(-1);
-
-            size_t sy = 0;
-            for( size_t y = 0; y < nheight; ++y )
-            {
-                if ( (lasty ^ sy) >> 16 )
-                {
-                    if ( !_LoadScanline( row, width, pSrc + ( rowPitch * (sy >> 16) ), rowPitch, src->format ) )
-                        return E_FAIL;
-                    lasty = sy;
-                }
-
-                size_t sx = 0;
-                for( size_t x = 0; x < nwidth; ++x )
-                {
-                    target[ x ] = row[ sx >> 16 ];
-                    sx += xinc;
-                }
-
-                if ( !_StoreScanline( pDest, dest->rowPitch, dest->format, target, nwidth ) )
-                    return E_FAIL;
-                pDest += dest->rowPitch;
-
-                sy += yinc;
-            }
-        }
-
-        if ( height > 1 )
-            height >>= 1;
-
-        if ( width > 1 )
-            width >>= 1;
-
-        if ( depth > 1 )
-            depth >>= 1;
-    }
-
-    return S_OK;
-}
-
-
-//--- 3D Box Filter ---
-static HRESULT _Generate3DMipsBoxFilter( _In_ size_t depth, _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain )
-{
-    if ( !depth || !mipChain.GetImages() )
-        return E_INVALIDARG;
-
-    // This assumes that the base images are already placed into the mipChain at the top level... (see _Setup3DMips)
-
-    assert( levels > 1 );
-
-    size_t width = mipChain.GetMetadata().width;
-    size_t height = mipChain.GetMetadata().height;
-
-    if ( !ispow2(width) || !ispow2(height) || !ispow2(depth) )
-        return E_FAIL;
-
-    // Allocate temporary space (5 scanlines)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width*5), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    XMVECTOR* target = scanline.get();
-
-    XMVECTOR* urow0 = target + width;
-    XMVECTOR* urow1 = target + width*2;
-    XMVECTOR* vrow0 = target + width*3;
-    XMVECTOR* vrow1 = target + width*4;
-
-    const XMVECTOR* urow2 = urow0 + 1;
-    const XMVECTOR* urow3 = urow1 + 1;
-    const XMVECTOR* vrow2 = vrow0 + 1;
-    const XMVECTOR* vrow3 = vrow1 + 1;
-
-    // Resize base image to each target mip level
-    for( size_t level=1; level < levels; ++level )
-    {
-        if ( height <= 1 )
-        {
-            urow1 = urow0;
-            vrow1 = vrow0;
-        }
-
-        if ( width <= 1 )
-        {
-            urow2 = urow0;
-            urow3 = urow1;
-            vrow2 = vrow0;
-            vrow3 = vrow1;
-        }
-
-        if ( depth > 1 )
-        {
-            // 3D box filter
-            size_t ndepth = depth >> 1;
-
-            for( size_t slice=0; slice < ndepth; ++slice )
-            {
-                size_t slicea = std::min<size_t>( slice * 2, depth-1 );
-                size_t sliceb = std::min<size_t>( slicea + 1, depth-1 );
-
-                const Image* srca = mipChain.GetImage( level-1, 0, slicea );
-                const Image* srcb = mipChain.GetImage( level-1, 0, sliceb );
-                const Image* dest = mipChain.GetImage( level, 0, slice );
-
-                if ( !srca || !srcb || !dest )
-                    return E_POINTER;
-
-                const uint8_t* pSrc1 = srca->pixels;
-                const uint8_t* pSrc2 = srcb->pixels;
-                uint8_t* pDest = dest->pixels;
-
-                size_t aRowPitch = srca->rowPitch;
-                size_t bRowPitch = srcb->rowPitch;
-
-                size_t nwidth = (width > 1) ? (width >> 1) : 1;
-                size_t nheight = (height > 1) ? (height >> 1) : 1;
-
-                for( size_t y = 0; y < nheight; ++y )
-                {
-                    if ( !_LoadScanlineLinear( urow0, width, pSrc1, aRowPitch, srca->format, filter ) )
-                        return E_FAIL;
-                    pSrc1 += aRowPitch;
-
-                    if ( urow0 != urow1 )
-                    {
-                        if ( !_LoadScanlineLinear( urow1, width, pSrc1, aRowPitch, srca->format, filter ) )
-                            return E_FAIL;
-                        pSrc1 += aRowPitch;
-                    }
-
-                    if ( !_LoadScanlineLinear( vrow0, width, pSrc2, bRowPitch, srcb->format, filter ) )
-                        return E_FAIL;
-                    pSrc2 += bRowPitch;
-
-                    if ( vrow0 != vrow1 )
-                    {
-                        if ( !_LoadScanlineLinear( vrow1, width, pSrc2, bRowPitch, srcb->format, filter ) )
-                            return E_FAIL;
-                        pSrc2 += bRowPitch;
-                    }
-
-                    for( size_t x = 0; x < nwidth; ++x )
-                    {
-                        size_t x2 = x << 1;
-
-                        AVERAGE8( target[x], urow0[ x2 ], urow1[ x2 ], urow2[ x2 ], urow3[ x2 ],
-                                             vrow0[ x2 ], vrow1[ x2 ], vrow2[ x2 ], vrow3[ x2 ] );
-                    }
-
-                    if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, target, nwidth, filter ) )
-                        return E_FAIL;
-                    pDest += dest->rowPitch;
-                }
-            }
-        }
-        else
-        {
-            // 2D box filter
-            const Image* src = mipChain.GetImage( level-1, 0, 0 );
-            const Image* dest = mipChain.GetImage( level, 0, 0 );
-
-            if ( !src || !dest )
-                return E_POINTER;
-
-            const uint8_t* pSrc = src->pixels;
-            uint8_t* pDest = dest->pixels;
-
-            size_t rowPitch = src->rowPitch;
-
-            size_t nwidth = (width > 1) ? (width >> 1) : 1;
-            size_t nheight = (height > 1) ? (height >> 1) : 1;
-
-            for( size_t y = 0; y < nheight; ++y )
-            {
-                if ( !_LoadScanlineLinear( urow0, width, pSrc, rowPitch, src->format, filter ) )
-                    return E_FAIL;
-                pSrc += rowPitch;
-
-                if ( urow0 != urow1 )
-                {
-                    if ( !_LoadScanlineLinear( urow1, width, pSrc, rowPitch, src->format, filter ) )
-                        return E_FAIL;
-                    pSrc += rowPitch;
-                }
-
-                for( size_t x = 0; x < nwidth; ++x )
-                {
-                    size_t x2 = x << 1;
-
-                    AVERAGE4( target[ x ], urow0[ x2 ], urow1[ x2 ], urow2[ x2 ], urow3[ x2 ] );
-                }
-
-                if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, target, nwidth, filter ) )
-                    return E_FAIL;
-                pDest += dest->rowPitch;
-            }
-        }
-
-        if ( height > 1 )
-            height >>= 1;
-
-        if ( width > 1 )
-            width >>= 1;
-
-        if ( depth > 1 )
-            depth >>= 1;
-    }
-
-    return S_OK;
-}
-
-
-//--- 3D Linear Filter ---
-static HRESULT _Generate3DMipsLinearFilter( _In_ size_t depth, _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain )
-{
-    if ( !depth || !mipChain.GetImages() )
-        return E_INVALIDARG;
-
-    // This assumes that the base images are already placed into the mipChain at the top level... (see _Setup3DMips)
-
-    assert( levels > 1 );
-
-    size_t width = mipChain.GetMetadata().width;
-    size_t height = mipChain.GetMetadata().height;
-
-    // Allocate temporary space (5 scanlines, plus X/Y/Z filters)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width*5), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    std::unique_ptr<LinearFilter[]> lf( new (std::nothrow) LinearFilter[ width+height+depth ] );
-    if ( !lf )
-        return E_OUTOFMEMORY;
-
-    LinearFilter* lfX = lf.get();
-    LinearFilter* lfY = lf.get() + width;
-    LinearFilter* lfZ = lf.get() + width + height;
-
-    XMVECTOR* target = scanline.get();
-
-    XMVECTOR* urow0 = target + width;
-    XMVECTOR* urow1 = target + width*2;
-    XMVECTOR* vrow0 = target + width*3;
-    XMVECTOR* vrow1 = target + width*4;
-
-    // Resize base image to each target mip level
-    for( size_t level=1; level < levels; ++level )
-    {
-        size_t nwidth = (width > 1) ? (width >> 1) : 1;
-        _CreateLinearFilter( width, nwidth, (filter & TEX_FILTER_WRAP_U) != 0, lfX );
-
-        size_t nheight = (height > 1) ? (height >> 1) : 1;
-        _CreateLinearFilter( height, nheight, (filter & TEX_FILTER_WRAP_V) != 0, lfY );
-
-#ifdef _DEBUG
-        memset( urow0, 0xCD, sizeof(XMVECTOR)*width );
-        memset( urow1, 0xDD, sizeof(XMVECTOR)*width );
-        memset( vrow0, 0xED, sizeof(XMVECTOR)*width );
-        memset( vrow1, 0xFD, sizeof(XMVECTOR)*width );
-#endif
-
-        if ( depth > 1 )
-        {
-            // 3D linear filter
-            size_t ndepth = depth >> 1;
-            _CreateLinearFilter( depth, ndepth, (filter & TEX_FILTER_WRAP_W) != 0, lfZ );
+    // This assumes that the base images are already placed into the mipChain at the top level... (see _Setup2DMips)
 
-            for( size_t slice=0; slice < ndepth; ++slice )
-            {
-                auto& toZ = lfZ[ slice ];
-
-                const Image* srca = mipChain.GetImage( level-1, 0, toZ.u0 );
-                const Image* srcb = mipChain.GetImage( level-1, 0, toZ.u1 );
-                if ( !srca || !srcb )
-                    return E_POINTER;
-
-                size_t u0 = size_t(-1);
-                size_t u1 = size_t(-1);
-
-                const Image* dest = mipChain.GetImage( level, 0, slice );
-                if ( !dest )
-                    return E_POINTER;
-
-                uint8_t* pDest = dest->pixels;
-
-                for( size_t y = 0; y < nheight; ++y )
-                {
-                    auto& toY = lfY[ y ];
-
-                    if ( toY.u0 != u0 )
-                    {
-                        if ( toY.u0 != u1 )
-                        {
-                            u0 = toY.u0;
-
-                            if ( !_LoadScanlineLinear( urow0, width, srca->pixels + (srca->rowPitch * u0), srca->rowPitch, srca->format, filter )
-                                 || !_LoadScanlineLinear( vrow0, width, srcb->pixels + (srcb->rowPitch * u0), srcb->rowPitch, srcb->format, filter ) )
-                                return E_FAIL;
-                        }
-                        else
-                        {
-                            u0 = u1;
-                            u1 = size_t(-1);
+    assert( levels > 1 );
 
-                            std::swap( urow0, urow1 );
-                            std::swap( vrow0, vrow1 );
-                        }
-                    }
+    const TexMetadata& metadata = mipChain.GetMetadata();
 
-                    if ( toY.u1 != u1 )
-                    {
-                        u1 = toY.u1;
+    size_t width = metadata.width;
+    size_t height = metadata.height;
 
-                        if ( !_LoadScanlineLinear( urow1, width, srca->pixels + (srca->rowPitch * u1), srca->rowPitch, srca->format, filter )
-                                || !_LoadScanlineLinear( vrow1, width, srcb->pixels + (srcb->rowPitch * u1), srcb->rowPitch, srcb->format, filter ) )
-                            return E_FAIL;
-                    }
+    if ( ( filter & TEX_FILTER_MASK ) == TEX_FILTER_BOX && ( !ispow2(width) || !ispow2(height) ) )
+        return E_FAIL;
 
-                    for( size_t x = 0; x < nwidth; ++x )
-                    {
-                        auto& toX = lfX[ x ];
+    std::vector<Image> srcImages( metadata.arraySize );
+    std::vector<Image> destImages( metadata.arraySize );
 
-                        TRILINEAR_INTERPOLATE( target[x], toX, toY, toZ, urow0, urow1, vrow0, vrow1 );
-                    }
+    SeparableFilter fz;
+    HRESULT hr = _CreateSeparableIdentity( 1, fz );
+    if ( FAILED(hr) )
+        return hr;
 
-                    if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, target, nwidth, filter ) )
-                        return E_FAIL;
-                    pDest += dest->rowPitch;
-                }
-            }
-        }
-        else
+    // Resize base image to each target mip level; all items of a level are filtered together
+    for( size_t level=1; level < levels; ++level )
+    {
+        for( size_t item = 0; item < metadata.arraySize; ++item )
         {
-            // 2D linear filter
-            const Image* src = mipChain.GetImage( level-1, 0, 0 );
-            const Image* dest = mipChain.GetImage( level, 0, 0 );
+            const Image* src = mipChain.GetImage( level-1, item, 0 );
+            const Image* dest = mipChain.GetImage( level, item, 0 );
 
             if ( !src || !dest )
                 return E_POINTER;
 
-            const uint8_t* pSrc = src->pixels;
-            uint8_t* pDest = dest->pixels;
+            srcImages[ item ] = *src;
+            destImages[ item ] = *dest;
+        }
 
-            size_t rowPitch = src->rowPitch;
+        size_t nwidth = (width > 1) ? (width >> 1) : 1;
+        size_t nheight = (height > 1) ? (height >> 1) : 1;
 
-            size_t u0 = size_t(-1);
-            size_t u1 = size_t(-1);
+        SeparableFilter fx, fy;
+        hr = _CreateSeparableFilter( filter, width, nwidth, (filter & TEX_FILTER_WRAP_U) != 0, (filter & TEX_FILTER_MIRROR_U) != 0, fx );
+        if ( FAILED(hr) )
+            return hr;
 
-            for( size_t y = 0; y < nheight; ++y )
-            {
-                auto& toY = lfY[ y ];
+        hr = _CreateSeparableFilter( filter, height, nheight, (filter & TEX_FILTER_WRAP_V) != 0, (filter & TEX_FILTER_MIRROR_V) != 0, fy );
+        if ( FAILED(hr) )
+            return hr;
 
-                if ( toY.u0 != u0 )
-                {
-                    if ( toY.u0 != u1 )
-                    {
-                        u0 = toY.u0;
+        hr = _ResizeSeparable( &srcImages[0], 1, &destImages[0], 1, metadata.arraySize, fx, fy, fz, filter );
+        if ( FAILED(hr) )
+            return hr;
 
-                        if ( !_LoadScanlineLinear( urow0, width, pSrc + (rowPitch * u0), rowPitch, src->format, filter ) )
-                            return E_FAIL;
-                    }
-                    else
-                    {
-                        u0 = u1;
-                        u1 = size_t(-1);
+        if ( height > 1 )
+            height >>= 1;
 
-                        std::swap( urow0, urow1 );
-                    }
-                }
+        if ( width > 1 )
+            width >>= 1;
+    }
 
-                if ( toY.u1 != u1 )
-                {
-                    u1 = toY.u1;
+    return S_OK;
+}
 
-                    if ( !_LoadScanlineLinear( urow1, width, pSrc + (rowPitch * u1), rowPitch, src->format, filter ) )
-                        return E_FAIL;
-                }
 
-                for( size_t x = 0; x < nwidth; ++x )
-                {
-                    auto& toX = lfX[ x ];
+//-------------------------------------------------------------------------------------
+// Generate volume mip-map helpers
+//-------------------------------------------------------------------------------------
+static HRESULT _Setup3DMips( _In_reads_(depth) const Image* baseImages, _In_ size_t depth, size_t levels,
+                             _Out_ ScratchImage& mipChain )
+{
+    if ( !baseImages || !depth )
+        return E_INVALIDARG;
 
-                    BILINEAR_INTERPOLATE( target[x], toX, toY, urow0, urow1 );
-                }
+    assert( levels > 1 );
 
-                if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, target, nwidth, filter ) )
-                    return E_FAIL;
-                pDest += dest->rowPitch;
-            }
+    size_t width = baseImages[0].width;
+    size_t height = baseImages[0].height;
+
+    HRESULT hr = mipChain.Initialize3D( baseImages[0].format, width, height, depth, levels );
+    if ( FAILED(hr) )
+        return hr;
+
+    // Copy base images to top slice
+    for( size_t slice=0; slice < depth; ++slice )
+    {
+        const Image& src = baseImages[slice];
+
+        const Image *dest = mipChain.GetImage( 0, 0, slice );
+        if ( !dest )
+        {
+            mipChain.Release();
+            return E_POINTER;
         }
 
-        if ( height > 1 )
-            height >>= 1;
+        assert( src.format == dest->format );
 
-        if ( width > 1 )
-            width >>= 1;
+        uint8_t* pDest = dest->pixels;
+        if ( !pDest )
+        {
+            mipChain.Release();
+            return E_POINTER;
+        }
 
-        if ( depth > 1 )
-            depth >>= 1;
+        const uint8_t *pSrc = src.pixels;
+        size_t rowPitch = src.rowPitch;
+        for( size_t h=0; h < height; ++h )
+        {
+            size_t msize = std::min<size_t>( dest->rowPitch, rowPitch );
+            memcpy_s( pDest, dest->rowPitch, pSrc, msize );  
+            pSrc += rowPitch;
+            pDest += dest->rowPitch;
+        }
     }
 
     return S_OK;
 }
 
 
-//--- 3D Cubic Filter ---
-static HRESULT _Generate3DMipsCubicFilter( _In_ size_t depth, _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain )
+//--- 3D Point Filter ---
+static HRESULT _Generate3DMipsPointFilter( _In_ size_t depth, _In_ size_t levels, _In_ const ScratchImage& mipChain )
 {
     if ( !depth || !mipChain.GetImages() )
         return E_INVALIDARG;
@@ -1864,232 +821,81 @@ static HRESULT _Generate3DMipsCubicFilter( _In_ size_t depth, _In_ size_t levels
     size_t width = mipChain.GetMetadata().width;
     size_t height = mipChain.GetMetadata().height;
 
-    // Allocate temporary space (17 scanlines, plus X/Y/Z filters)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width*17), 16 ) ) );
+    // Allocate temporary space (2 scanlines)
+    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width*2), 16 ) ) );
     if ( !scanline )
         return E_OUTOFMEMORY;
 
-    std::unique_ptr<CubicFilter[]> cf( new (std::nothrow) CubicFilter[ width+height+depth ] );
-    if ( !cf )
-        return E_OUTOFMEMORY;
-
-    CubicFilter* cfX = cf.get();
-    CubicFilter* cfY = cf.get() + width;
-    CubicFilter* cfZ = cf.get() + width + height;
-
     XMVECTOR* target = scanline.get();
 
-    XMVECTOR* urow[4];
-    XMVECTOR* vrow[4];
-    XMVECTOR* srow[4];
-    XMVECTOR* trow[4];
-
-    XMVECTOR *ptr = scanline.get() + width;
-    for( size_t j = 0; j < 4; ++j )
-    {
-        urow[j] = ptr;  ptr += width;
-        vrow[j] = ptr;  ptr += width;
-        srow[j] = ptr;  ptr += width;
-        trow[j] = ptr;  ptr += width;
-    }
+    XMVECTOR* row = target + width;
 
     // Resize base image to each target mip level
     for( size_t level=1; level < levels; ++level )
     {
-        size_t nwidth = (width > 1) ? (width >> 1) : 1;
-        _CreateCubicFilter( width, nwidth, (filter & TEX_FILTER_WRAP_U) != 0, (filter & TEX_FILTER_MIRROR_U) != 0, cfX );
-
-        size_t nheight = (height > 1) ? (height >> 1) : 1;
-        _CreateCubicFilter( height, nheight, (filter & TEX_FILTER_WRAP_V) != 0, (filter & TEX_FILTER_MIRROR_V) != 0, cfY );
-
 #ifdef _DEBUG
-        for( size_t j = 0; j < 4; ++j )
-        {
-            memset( urow[j], 0xCD, sizeof(XMVECTOR)*width );
-            memset( vrow[j], 0xDD, sizeof(XMVECTOR)*width );
-            memset( srow[j], 0xED, sizeof(XMVECTOR)*width );
-            memset( trow[j], 0xFD, sizeof(XMVECTOR)*width );
-        }
+        memset( row, 0xCD, sizeof(XMVECTOR)*width );
 #endif
 
         if ( depth > 1 )
         {
-            // 3D cubic filter
+            // 3D point filter
             size_t ndepth = depth >> 1;
-            _CreateCubicFilter( depth, ndepth, (filter & TEX_FILTER_WRAP_W) != 0, (filter & TEX_FILTER_MIRROR_W) != 0, cfZ );
 
+            size_t zinc = ( depth << 16 ) / ndepth;
+
+            size_t sz = 0;
             for( size_t slice=0; slice < ndepth; ++slice )
             {
-                auto& toZ = cfZ[ slice ];
-
-                const Image* srca = mipChain.GetImage( level-1, 0, toZ.u0 );
-                const Image* srcb = mipChain.GetImage( level-1, 0, toZ.u1 );
-                const Image* srcc = mipChain.GetImage( level-1, 0, toZ.u2 );
-                const Image* srcd = mipChain.GetImage( level-1, 0, toZ.u3 );
-                if ( !srca || !srcb || !srcc || !srcd )
-                    return E_POINTER;
-
-                size_t u0 = size_t(-1);
-                size_t u1 = size_t(-1);
-                size_t u2 = size_t(-1);
-                size_t u3 = size_t(-1);
-
+                const Image* src = mipChain.GetImage( level-1, 0, (sz >> 16) );
                 const Image* dest = mipChain.GetImage( level, 0, slice );
-                if ( !dest )
+
+                if ( !src || !dest )
                     return E_POINTER;
 
+                const uint8_t* pSrc = src->pixels;
                 uint8_t* pDest = dest->pixels;
 
-                for( size_t y = 0; y < nheight; ++y )
-                {
-                    auto& toY = cfY[ y ];
-
-                    // Scanline 1
-                    if ( toY.u0 != u0 )
-                    {
-                        if ( toY.u0 != u1 && toY.u0 != u2 && toY.u0 != u3 )
-                        {
-                            u0 = toY.u0;
-
-                            if ( !_LoadScanlineLinear( urow[0], width, srca->pixels + (srca->rowPitch * u0), srca->rowPitch, srca->format, filter )
-                                    || !_LoadScanlineLinear( urow[1], width, srcb->pixels + (srcb->rowPitch * u0), srcb->rowPitch, srcb->format, filter )
-                                    || !_LoadScanlineLinear( urow[2], width, srcc->pixels + (srcc->rowPitch * u0), srcc->rowPitch, srcc->format, filter )
-                                    || !_LoadScanlineLinear( urow[3], width, srcd->pixels + (srcd->rowPitch * u0), srcd->rowPitch, srcd->format, filter ) )
-                                return E_FAIL;
-                        }
-                        else if ( toY.u0 == u1 )
-                        {
-                            u0 = u1;
-                            u1 = size_t(-1);
-
-                            std::swap( urow[0], vrow[0] );
-                            std::swap( urow[1], vrow[1] );
-                            std::swap( urow[2], vrow[2] );
-                            std::swap( urow[3], vrow[3] );
-                        }
-                        else if ( toY.u0 == u2 )
-                        {
-                            u0 = u2;
-                            u2 = size_t(-1);
-
-                            std::swap( urow[0], srow[0] );
-                            std::swap( urow[1], srow[1] );
-                            std::swap( urow[2], srow[2] );
-                            std::swap( urow[3], srow[3] );
-                        }
-                        else if ( toY.u0 == u3 )
-                        {
-                            u0 = u3;
-                            u3 = size_t(-1);
-
-                            std::swap( urow[0], trow[0] );
-                            std::swap( urow[1], trow[1] );
-                            std::swap( urow[2], trow[2] );
-                            std::swap( urow[3], trow[3] );
-                        }
-                    }
-
-                    // Scanline 2
-                    if ( toY.u1 != u1 )
-                    {
-                        if ( toY.u1 != u2 && toY.u1 != u3 )
-                        {
-                            u1 = toY.u1;
-
-                            if ( !_LoadScanlineLinear( vrow[0], width, srca->pixels + (srca->rowPitch * u1), srca->rowPitch, srca->format, filter )
-                                    || !_LoadScanlineLinear( vrow[1], width, srcb->pixels + (srcb->rowPitch * u1), srcb->rowPitch, srcb->format, filter )
-                                    || !_LoadScanlineLinear( vrow[2], width, srcc->pixels + (srcc->rowPitch * u1), srcc->rowPitch, srcc->format, filter )
-                                    || !_LoadScanlineLinear( vrow[3], width, srcd->pixels + (srcd->rowPitch * u1), srcd->rowPitch, srcd->format, filter ) )
-                                return E_FAIL;
-                        }
-                        else if ( toY.u1 == u2 )
-                        {
-                            u1 = u2;
-                            u2 = size_t(-1);
-
-                            std::swap( vrow[0], srow[0] );
-                            std::swap( vrow[1], srow[1] );
-                            std::swap( vrow[2], srow[2] );
-                            std::swap( vrow[3], srow[3] );
-                        }
-                        else if ( toY.u1 == u3 )
-                        {
-                            u1 = u3;
-                            u3 = size_t(-1);
-
-                            std::swap( vrow[0], trow[0] );
-                            std::swap( vrow[1], trow[1] );
-                            std::swap( vrow[2], trow[2] );
-                            std::swap( vrow[3], trow[3] );
-                        }
-                    }
+                size_t rowPitch = src->rowPitch;
 
-                    // Scanline 3
-                    if ( toY.u2 != u2 )
-                    {
-                        if ( toY.u2 != u3 )
-                        {
-                            u2 = toY.u2;
+                size_t nwidth = (width > 1) ? (width >> 1) : 1;
+                size_t nheight = (height > 1) ? (height >> 1) : 1;
 
-                            if ( !_LoadScanlineLinear( srow[0], width, srca->pixels + (srca->rowPitch * u2), srca->rowPitch, srca->format, filter )
-                                    || !_LoadScanlineLinear( srow[1], width, srcb->pixels + (srcb->rowPitch * u2), srcb->rowPitch, srcb->format, filter )
-                                    || !_LoadScanlineLinear( srow[2], width, srcc->pixels + (srcc->rowPitch * u2), srcc->rowPitch, srcc->format, filter )
-                                    || !_LoadScanlineLinear( srow[3], width, srcd->pixels + (srcd->rowPitch * u2), srcd->rowPitch, srcd->format, filter ) )
-                                return E_FAIL;
-                        }
-                        else
-                        {
-                            u2 = u3;
-                            u3 = size_t(-1);
+                size_t xinc = ( width << 16 ) / nwidth;
+                size_t yinc = ( height << 16 ) / nheight;
 
-                            std::swap( srow[0], trow[0] );
-                            std::swap( srow[1], trow[1] );
-                            std::swap( srow[2], trow[2] );
-                            std::swap( srow[3], trow[3] );
-                        }
-                    }
+                size_t lasty = size_t(-1);
 
-                    // Scanline 4
-                    if ( toY.u3 != u3 )
+                size_t sy = 0;
+                for( size_t y = 0; y < nheight; ++y )
+                {
+                    if ( (lasty ^ sy) >> 16 )
                     {
-                        u3 = toY.u3;
-
-                        if ( !_LoadScanlineLinear( trow[0], width, srca->pixels + (srca->rowPitch * u3), srca->rowPitch, srca->format, filter )
-                                || !_LoadScanlineLinear( trow[1], width, srcb->pixels + (srcb->rowPitch * u3), srcb->rowPitch, srcb->format, filter )
-                                || !_LoadScanlineLinear( trow[2], width, srcc->pixels + (srcc->rowPitch * u3), srcc->rowPitch, srcc->format, filter )
-                                || !_LoadScanlineLinear( trow[3], width, srcd->pixels + (srcd->rowPitch * u3), srcd->rowPitch, srcd->format, filter ) )
+                        if ( !_LoadScanline( row, width, pSrc + ( rowPitch * (sy >> 16) ), rowPitch, src->format ) )
                             return E_FAIL;
+                        lasty = sy;
                     }
 
+                    size_t sx = 0;
                     for( size_t x = 0; x < nwidth; ++x )
                     {
-                        auto& toX = cfX[ x ];
-
-                        XMVECTOR D[4];
-
-                        for( size_t j=0; j < 4; ++j )
-                        {
-                            XMVECTOR C0, C1, C2, C3;
-                            CUBIC_INTERPOLATE( C0, toX.x, urow[j][ toX.u0 ], urow[j][ toX.u1 ], urow[j][ toX.u2 ], urow[j][ toX.u3 ] );
-                            CUBIC_INTERPOLATE( C1, toX.x, vrow[j][ toX.u0 ], vrow[j][ toX.u1 ], vrow[j][ toX.u2 ], vrow[j][ toX.u3 ] );
-                            CUBIC_INTERPOLATE( C2, toX.x, srow[j][ toX.u0 ], srow[j][ toX.u1 ], srow[j][ toX.u2 ], srow[j][ toX.u3 ] );
-                            CUBIC_INTERPOLATE( C3, toX.x, trow[j][ toX.u0 ], trow[j][ toX.u1 ], trow[j][ toX.u2 ], trow[j][ toX.u3 ] );
-
-                            CUBIC_INTERPOLATE( D[j], toY.x, C0, C1, C2, C3 );
-                        }
-
-                        CUBIC_INTERPOLATE( target[x], toZ.x, D[0], D[1], D[2], D[3] );
+                        target[ x ] = row[ sx >> 16 ];
+                        sx += xinc;
                     }
 
-                    if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, target, nwidth, filter ) )
+                    if ( !_StoreScanline( pDest, dest->rowPitch, dest->format, target, nwidth ) )
                         return E_FAIL;
                     pDest += dest->rowPitch;
+
+                    sy += yinc;
                 }
+
+                sz += zinc;
             }
         }
         else
         {
-            // 2D cubic filter
+            // 2D point filter
             const Image* src = mipChain.GetImage( level-1, 0, 0 );
             const Image* dest = mipChain.GetImage( level, 0, 0 );
 
@@ -2101,118 +907,36 @@ static HRESULT _Generate3DMipsCubicFilter( _In_ size_t depth, _In_ size_t levels
 
             size_t rowPitch = src->rowPitch;
 
-            size_t u0 = size_t(-1);
-            size_t u1 = size_t(-1);
-            size_t u2 = size_t(-1);
-            size_t u3 = size_t(-1);
-
-            for( size_t y = 0; y < nheight; ++y )
-            {
-                auto& toY = cfY[ y ];
-
-                // Scanline 1
-                if ( toY.u0 != u0 )
-                {
-                    if ( toY.u0 != u1 && toY.u0 != u2 && toY.u0 != u3 )
-                    {
-                        u0 = toY.u0;
-
-                        if ( !_LoadScanlineLinear( urow[0], width, pSrc + (rowPitch * u0), rowPitch, src->format, filter ) )
-                            return E_FAIL;
-                    }
-                    else if ( toY.u0 == u1 )
-                    {
-                        u0 = u1;
-                        u1 = size_t(-1);
-
-                        std::swap( urow[0], vrow[0] );
-                    }
-                    else if ( toY.u0 == u2 )
-                    {
-                        u0 = u2;
-                        u2 = size_t(-1);
-
-                        std::swap( urow[0], srow[0] );
-                    }
-                    else if ( toY.u0 == u3 )
-                    {
-                        u0 = u3;
-                        u3 = size_t(-1);
-
-                        std::swap( urow[0], trow[0] );
-                    }
-                }
-
-                // Scanline 2
-                if ( toY.u1 != u1 )
-                {
-                    if ( toY.u1 != u2 && toY.u1 != u3 )
-                    {
-                        u1 = toY.u1;
-
-                        if ( !_LoadScanlineLinear( vrow[0], width, pSrc + (rowPitch * u1), rowPitch, src->format, filter ) )
-                            return E_FAIL;
-                    }
-                    else if ( toY.u1 == u2 )
-                    {
-                        u1 = u2;
-                        u2 = size_t(-1);
-
-                        std::swap( vrow[0], srow[0] );
-                    }
-                    else if ( toY.u1 == u3 )
-                    {
-                        u1 = u3;
-                        u3 = size_t(-1);
-
-                        std::swap( vrow[0], trow[0] );
-                    }
-                }
-
-                // Scanline 3
-                if ( toY.u2 != u2 )
-                {
-                    if ( toY.u2 != u3 )
-                    {
-                        u2 = toY.u2;
-
-                        if ( !_LoadScanlineLinear( srow[0], width, pSrc + (rowPitch * u2), rowPitch, src->format, filter ) )
-                            return E_FAIL;
-                    }
-                    else
-                    {
-                        u2 = u3;
-                        u3 = size_t(-1);
+            size_t nwidth = (width > 1) ? (width >> 1) : 1;
+            size_t nheight = (height > 1) ? (height >> 1) : 1;
 
-                        std::swap( srow[0], trow[0] );
-                    }
-                }
+            size_t xinc = ( width << 16 ) / nwidth;
+            size_t yinc = ( height << 16 ) / nheight;
 
-                // Scanline 4
-                if ( toY.u3 != u3 )
-                {
-                    u3 = toY.u3;
+            size_t lasty = size_t(-1);
 
-                    if ( !_LoadScanlineLinear( trow[0], width, pSrc + (rowPitch * u3), rowPitch, src->format, filter ) )
+            size_t sy = 0;
+            for( size_t y = 0; y < nheight; ++y )
+            {
+                if ( (lasty ^ sy) >> 16 )
+                {
+                    if ( !_LoadScanline( row, width, pSrc + ( rowPitch * (sy >> 16) ), rowPitch, src->format ) )
                         return E_FAIL;
+                    lasty = sy;
                 }
 
+                size_t sx = 0;
                 for( size_t x = 0; x < nwidth; ++x )
                 {
-                    auto& toX = cfX[ x ];
-
-                    XMVECTOR C0, C1, C2, C3;
-                    CUBIC_INTERPOLATE( C0, toX.x, urow[0][ toX.u0 ], urow[0][ toX.u1 ], urow[0][ toX.u2 ], urow[0][ toX.u3 ] );
-                    CUBIC_INTERPOLATE( C1, toX.x, vrow[0][ toX.u0 ], vrow[0][ toX.u1 ], vrow[0][ toX.u2 ], vrow[0][ toX.u3 ] );
-                    CUBIC_INTERPOLATE( C2, toX.x, srow[0][ toX.u0 ], srow[0][ toX.u1 ], srow[0][ toX.u2 ], srow[0][ toX.u3 ] );
-                    CUBIC_INTERPOLATE( C3, toX.x, trow[0][ toX.u0 ], trow[0][ toX.u1 ], trow[0][ toX.u2 ], trow[0][ toX.u3 ] );
-
-                    CUBIC_INTERPOLATE( target[x], toY.x, C0, C1, C2, C3 );
+                    target[ x ] = row[ sx >> 16 ];
+                    sx += xinc;
                 }
 
-                if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, target, nwidth, filter ) )
+                if ( !_StoreScanline( pDest, dest->rowPitch, dest->format, target, nwidth ) )
                     return E_FAIL;
                 pDest += dest->rowPitch;
+
+                sy += yinc;
             }
         }
 
@@ -2230,14 +954,12 @@ static HRESULT _Generate3DMipsCubicFilter( _In_ size_t depth, _In_ size_t levels
 }
 
 
-//--- 3D Triangle Filter ---
-static HRESULT _Generate3DMipsTriangleFilter( _In_ size_t depth, _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain )
+//--- 3D Box, Linear, Cubic, and Triangle Filters ---
+static HRESULT _Generate3DMipsSeparableFilter( _In_ size_t depth, _In_ size_t levels, _In_ DWORD filter, _In_ const ScratchImage& mipChain )
 {
     if ( !depth || !mipChain.GetImages() )
         return E_INVALIDARG;
 
-    using namespace TriangleFilter;
-
     // This assumes that the base images are already placed into the mipChain at the top level... (see _Setup3DMips)
 
     assert( levels > 1 );
@@ -2245,216 +967,39 @@ static HRESULT _Generate3DMipsTriangleFilter( _In_ size_t depth, _In_ size_t lev
     size_t width = mipChain.GetMetadata().width;
     size_t height = mipChain.GetMetadata().height;
 
-    // Allocate initial temporary space (1 scanline, accumulation rows, plus X/Y/Z filters)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( sizeof(XMVECTOR) * width, 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    std::unique_ptr<TriangleRow[]> sliceActive( new (std::nothrow) TriangleRow[ depth ] );
-    if ( !sliceActive )
-        return E_OUTOFMEMORY;
-
-    TriangleRow * sliceFree = nullptr;
-
-    std::unique_ptr<Filter> tfX, tfY, tfZ;
-
-    XMVECTOR* row = scanline.get();
+    if ( ( filter & TEX_FILTER_MASK ) == TEX_FILTER_BOX && ( !ispow2(width) || !ispow2(height) || !ispow2(depth) ) )
+        return E_FAIL;
 
     // Resize base image to each target mip level
     for( size_t level=1; level < levels; ++level )
     {
+        // The slices of a volume mip level are contiguous
+        const Image* src = mipChain.GetImage( level-1, 0, 0 );
+        const Image* dest = mipChain.GetImage( level, 0, 0 );
+
+        if ( !src || !dest )
+            return E_POINTER;
+
         size_t nwidth = (width > 1) ? (width >> 1) : 1;
-        HRESULT hr = _Create( width, nwidth, (filter & TEX_FILTER_WRAP_U) != 0, tfX );
+        size_t nheight = (height > 1) ? (height >> 1) : 1;
+        size_t ndepth = (depth > 1) ? (depth >> 1) : 1;
+
+        SeparableFilter fx, fy, fz;
+        HRESULT hr = _CreateSeparableFilter( filter, width, nwidth, (filter & TEX_FILTER_WRAP_U) != 0, (filter & TEX_FILTER_MIRROR_U) != 0, fx );
         if ( FAILED(hr) )
             return hr;
 
-        size_t nheight = (height > 1) ? (height >> 1) : 1;
-        hr = _Create( height, nheight, (filter & TEX_FILTER_WRAP_V) != 0, tfY );
+        hr = _CreateSeparableFilter( filter, height, nheight, (filter & TEX_FILTER_WRAP_V) != 0, (filter & TEX_FILTER_MIRROR_V) != 0, fy );
         if ( FAILED(hr) )
             return hr;
 
-        size_t ndepth = (depth > 1 ) ? (depth >> 1) : 1;
-        hr = _Create( depth, ndepth, (filter & TEX_FILTER_WRAP_W) != 0, tfZ );
+        hr = _CreateSeparableFilter( filter, depth, ndepth, (filter & TEX_FILTER_WRAP_W) != 0, (filter & TEX_FILTER_MIRROR_W) != 0, fz );
         if ( FAILED(hr) )
             return hr;
 
-#ifdef _DEBUG
-        memset( row, 0xCD, sizeof(XMVECTOR)*width );
-#endif
-
-        auto xFromEnd = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( tfX.get() ) + tfX->sizeInBytes );
-        auto yFromEnd = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( tfY.get() ) + tfY->sizeInBytes );
-        auto zFromEnd = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( tfZ.get() ) + tfZ->sizeInBytes );
-
-        // Count times slices get written (and clear out any leftover accumulation slices from last miplevel)
-        for( FilterFrom* zFrom = tfZ->from; zFrom < zFromEnd; )
-        {
-            for ( size_t j = 0; j < zFrom->count; ++j )
-            {
-                size_t w = zFrom->to[ j ].u;
-                assert( w < ndepth );
-                TriangleRow* sliceAcc = &sliceActive.get()[ w ];
-
-                ++sliceAcc->remaining;
-
-                if ( sliceAcc->scanline )
-                {
-                    memset( sliceAcc->scanline.get(), 0, sizeof(XMVECTOR) * nwidth * nheight );
-                }
-            }
-
-            zFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( zFrom ) + zFrom->sizeInBytes );
-        }
-
-        // Filter image
-        size_t z = 0;
-        for( FilterFrom* zFrom = tfZ->from; zFrom < zFromEnd; ++z )
-        {
-            // Create accumulation slices as needed
-            for ( size_t j = 0; j < zFrom->count; ++j )
-            {
-                size_t w = zFrom->to[ j ].u;
-                assert( w < ndepth );
-                TriangleRow* sliceAcc = &sliceActive.get()[ w ];
-
-                if ( !sliceAcc->scanline )
-                {
-                    if ( sliceFree )
-                    {
-                        // Steal and reuse scanline from 'free slice' list
-                        // (it will always be at least as large as nwidth*nheight due to loop decending order)
-                        assert( sliceFree->scanline != 0 );
-                        sliceAcc->scanline.reset( sliceFree->scanline.release() );
-                        sliceFree = sliceFree->next;
-                    }
-                    else
-                    {
-                        size_t bytes = sizeof(XMVECTOR) * nwidth * nheight;
-                        sliceAcc->scanline.reset( reinterpret_cast<XMVECTOR*>( _aligned_malloc( bytes, 16 ) ) );
-                        if ( !sliceAcc->scanline )
-                            return E_OUTOFMEMORY;
-                    }
-
-                    memset( sliceAcc->scanline.get(), 0, sizeof(XMVECTOR) * nwidth * nheight );
-                }
-            }
-
-            assert( z < depth );
-            const Image* src = mipChain.GetImage( level-1, 0, z );
-            if ( !src )
-                return E_POINTER;
-
-            const uint8_t* pSrc = src->pixels;
-            size_t rowPitch = src->rowPitch;
-            const uint8_t* pEndSrc = pSrc + rowPitch * height;
-
-            for( FilterFrom* yFrom = tfY->from; yFrom < yFromEnd; )
-            {
-                // Load source scanline
-                if ( (pSrc + rowPitch) > pEndSrc )
-                    return E_FAIL;
-
-                if ( !_LoadScanlineLinear( row, width, pSrc, rowPitch, src->format, filter ) )
-                    return E_FAIL;
-
-                pSrc += rowPitch;
-
-                // Process row
-                size_t x = 0;
-                for( FilterFrom* xFrom = tfX->from; xFrom < xFromEnd; ++x )
-                {
-                    for ( size_t j = 0; j < zFrom->count; ++j )
-                    {
-                        size_t w = zFrom->to[ j ].u;
-                        assert( w < ndepth );
-                        float zweight = zFrom->to[ j ].weight;
-
-                        XMVECTOR* accSlice = sliceActive[ w ].scanline.get();
-                        if ( !accSlice )
-                            return E_POINTER;
-
-                        for ( size_t k = 0; k < yFrom->count; ++k )
-                        {
-                            size_t v = yFrom->to[ k ].u;
-                            assert( v < nheight );
-                            float yweight = yFrom->to[ k ].weight;
-
-                            XMVECTOR * accPtr = accSlice + v * nwidth;
-
-                            for ( size_t l = 0; l < xFrom->count; ++l )
-                            {
-                                size_t u = xFrom->to[ l ].u;
-                                assert( u < nwidth );
-
-                                XMVECTOR weight = XMVectorReplicate( zweight * yweight * xFrom->to[ l ].weight );
-
-                                assert( x < width );
-                                accPtr[ u ] = XMVectorMultiplyAdd( row[ x ], weight, accPtr[ u ] );
-                            }
-                        }
-                    }
-
-                    xFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( xFrom ) + xFrom->sizeInBytes );
-                }
-
-                yFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( yFrom ) + yFrom->sizeInBytes );
-            }
-
-            // Write completed accumulation slices
-            for ( size_t j = 0; j < zFrom->count; ++j )
-            {
-                size_t w = zFrom->to[ j ].u;
-                assert( w < ndepth );
-                TriangleRow* sliceAcc = &sliceActive.get()[ w ];
-
-                assert( sliceAcc->remaining > 0 );
-                --sliceAcc->remaining;
-
-                if ( !sliceAcc->remaining )
-                {
-                    const Image* dest = mipChain.GetImage( level, 0, w );
-                    XMVECTOR* pAccSrc = sliceAcc->scanline.get();
-                    if ( !dest || !pAccSrc )
-                        return E_POINTER;
-
-                    uint8_t* pDest = dest->pixels;
-
-                    for( size_t h = 0; h < nheight; ++h )
-                    {
-                        switch( dest->format )
-                        {
-                        case DXGI_FORMAT_R10G10B10A2_UNORM:
-                        case DXGI_FORMAT_R10G10B10A2_UINT:
-                            {
-                                // Need to slightly bias results for floating-point error accumulation which can
-                                // be visible with harshly quantized values
-                                static const XMVECTORF32 Bias = { 0.f, 0.f, 0.f, 0.1f };
-                       
-                                XMVECTOR* ptr = pAccSrc;
-                                for( size_t i=0; i < dest->width; ++i, ++ptr )
-                                {
-                                    *ptr = XMVectorAdd( *ptr, Bias );
-                                }
-                            }
-                            break;
-                        }
-
-                        // This performs any required clamping
-                        if ( !_StoreScanlineLinear( pDest, dest->rowPitch, dest->format, pAccSrc, dest->width, filter ) )
-                            return E_FAIL;
-
-                        pDest += dest->rowPitch;
-                        pAccSrc += nwidth;
-                    }
-
-                    // Put slice on freelist to reuse it's allocated scanline
-                    sliceAcc->next = sliceFree;
-                    sliceFree = sliceAcc;
-                }
-            }
-
-            zFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( zFrom ) + zFrom->sizeInBytes );
-        }
+        hr = _ResizeSeparable( src, depth, dest, ndepth, 1, fx, fy, fz, filter );
+        if ( FAILED(hr) )
+            return hr;
 
         if ( height > 1 )
             height >>= 1;
@@ -2470,10 +1015,6 @@ static HRESULT _Generate3DMipsTriangleFilter( _In_ size_t depth, _In_ size_t lev
 }
 
 
-//=====================================================================================
-// Entry-points
-//=====================================================================================
-
 //-------------------------------------------------------------------------------------
 // Generate mipmap chain
 //-------------------------------------------------------------------------------------
@@ -2582,51 +1123,26 @@ HRESULT GenerateMipMaps( const Image& baseImage, DWORD filter, size_t levels, Sc
         switch( filter_select )
         {
             case TEX_FILTER_BOX:
-                hr = _Setup2DMips( &baseImage, 1, mdata, mipChain );
-                if ( FAILED(hr) )
-                    return hr;
-
-                hr = _Generate2DMipsBoxFilter( levels, filter, mipChain, 0 );
-                if ( FAILED(hr) )
-                    mipChain.Release();
-                return hr;
-
-            case TEX_FILTER_POINT:
-                hr = _Setup2DMips( &baseImage, 1, mdata, mipChain );
-                if ( FAILED(hr) )
-                    return hr;
-
-                hr = _Generate2DMipsPointFilter( levels, mipChain, 0 );
-                if ( FAILED(hr) )
-                    mipChain.Release();
-                return hr;
-
             case TEX_FILTER_LINEAR:
-                hr = _Setup2DMips( &baseImage, 1, mdata, mipChain );
-                if ( FAILED(hr) )
-                    return hr;
-
-                hr = _Generate2DMipsLinearFilter( levels, filter, mipChain, 0 );
-                if ( FAILED(hr) )
-                    mipChain.Release();
-                return hr;
-
             case TEX_FILTER_CUBIC:
+            case TEX_FILTER_TRIANGLE:
+            case TEX_FILTER_LANCZOS:
+            case TEX_FILTER_KAISER:
                 hr = _Setup2DMips( &baseImage, 1, mdata, mipChain );
                 if ( FAILED(hr) )
                     return hr;
 
-                hr = _Generate2DMipsCubicFilter( levels, filter, mipChain, 0 );
+                hr = _Generate2DMipsSeparableFilter( levels, ( filter & ~TEX_FILTER_MASK ) | filter_select, mipChain );
                 if ( FAILED(hr) )
                     mipChain.Release();
                 return hr;
 
-            case TEX_FILTER_TRIANGLE:
+            case TEX_FILTER_POINT:
                 hr = _Setup2DMips( &baseImage, 1, mdata, mipChain );
                 if ( FAILED(hr) )
                     return hr;
 
-                hr = _Generate2DMipsTriangleFilter( levels, filter, mipChain, 0 );
+                hr = _Generate2DMipsPointFilter( levels, mipChain, 0 );
                 if ( FAILED(hr) )
                     mipChain.Release();
                 return hr;
@@ -2767,65 +1283,28 @@ HRESULT GenerateMipMaps( const Image* srcImages, size_t nimages, const TexMetada
         switch( filter_select )
         {
             case TEX_FILTER_BOX:
-                hr = _Setup2DMips( &baseImages[0], metadata.arraySize, mdata2, mipChain );
-                if ( FAILED(hr) )
-                    return hr;
-
-                for( size_t item = 0; item < metadata.arraySize; ++item )
-                {
-                    hr = _Generate2DMipsBoxFilter( levels, filter, mipChain, item );
-                    if ( FAILED(hr) )
-                        mipChain.Release();
-                }
-                return hr;
-
-            case TEX_FILTER_POINT:
-                hr = _Setup2DMips( &baseImages[0], metadata.arraySize, mdata2, mipChain );
-                if ( FAILED(hr) )
-                    return hr;
-
-                for( size_t item = 0; item < metadata.arraySize; ++item )
-                {
-                    hr = _Generate2DMipsPointFilter( levels, mipChain, item );
-                    if ( FAILED(hr) )
-                        mipChain.Release();
-                }
-                return hr;
-
             case TEX_FILTER_LINEAR:
-                hr = _Setup2DMips( &baseImages[0], metadata.arraySize, mdata2, mipChain );
-                if ( FAILED(hr) )
-                    return hr;
-
-                for( size_t item = 0; item < metadata.arraySize; ++item )
-                {
-                    hr = _Generate2DMipsLinearFilter( levels, filter, mipChain, item );
-                    if ( FAILED(hr) )
-                        mipChain.Release();
-                }
-                return hr;
-
             case TEX_FILTER_CUBIC:
+            case TEX_FILTER_TRIANGLE:
+            case TEX_FILTER_LANCZOS:
+            case TEX_FILTER_KAISER:
                 hr = _Setup2DMips( &baseImages[0], metadata.arraySize, mdata2, mipChain );
                 if ( FAILED(hr) )
                     return hr;
 
-                for( size_t item = 0; item < metadata.arraySize; ++item )
-                {
-                    hr = _Generate2DMipsCubicFilter( levels, filter, mipChain, item );
-                    if ( FAILED(hr) )
-                        mipChain.Release();
-                }
+                hr = _Generate2DMipsSeparableFilter( levels, ( filter & ~TEX_FILTER_MASK ) | filter_select, mipChain );
+                if ( FAILED(hr) )
+                    mipChain.Release();
                 return hr;
 
-            case TEX_FILTER_TRIANGLE:
+            case TEX_FILTER_POINT:
                 hr = _Setup2DMips( &baseImages[0], metadata.arraySize, mdata2, mipChain );
                 if ( FAILED(hr) )
                     return hr;
 
                 for( size_t item = 0; item < metadata.arraySize; ++item )
                 {
-                    hr = _Generate2DMipsTriangleFilter( levels, filter, mipChain, item );
+                    hr = _Generate2DMipsPointFilter( levels, mipChain, item );
                     if ( FAILED(hr) )
                         mipChain.Release();
                 }
@@ -2889,51 +1368,26 @@ HRESULT GenerateMipMaps3D( const Image* baseImages, size_t depth, DWORD filter,
     switch( filter_select )
     {
     case TEX_FILTER_BOX:
-        hr = _Setup3DMips( baseImages, depth, levels, mipChain );
-        if ( FAILED(hr) )
-            return hr;
-
-        hr = _Generate3DMipsBoxFilter( depth, levels, filter, mipChain );
-        if ( FAILED(hr) )
-            mipChain.Release();
-        return hr;
-
-    case TEX_FILTER_POINT:
-        hr = _Setup3DMips( baseImages, depth, levels, mipChain );
-        if ( FAILED(hr) )
-            return hr;
-
-        hr = _Generate3DMipsPointFilter( depth, levels, mipChain );
-        if ( FAILED(hr) )
-            mipChain.Release();
-        return hr;
-
     case TEX_FILTER_LINEAR:
-        hr = _Setup3DMips( baseImages, depth, levels, mipChain );
-        if ( FAILED(hr) )
-            return hr;
-
-        hr = _Generate3DMipsLinearFilter( depth, levels, filter, mipChain );
-        if ( FAILED(hr) )
-            mipChain.Release();
-        return hr;
-
     case TEX_FILTER_CUBIC:
+    case TEX_FILTER_TRIANGLE:
+    case TEX_FILTER_LANCZOS:
+    case TEX_FILTER_KAISER:
         hr = _Setup3DMips( baseImages, depth, levels, mipChain );
         if ( FAILED(hr) )
             return hr;
 
-        hr = _Generate3DMipsCubicFilter( depth, levels, filter, mipChain );
+        hr = _Generate3DMipsSeparableFilter( depth, levels, ( filter & ~TEX_FILTER_MASK ) | filter_select, mipChain );
         if ( FAILED(hr) )
             mipChain.Release();
         return hr;
 
-    case TEX_FILTER_TRIANGLE:
+    case TEX_FILTER_POINT:
         hr = _Setup3DMips( baseImages, depth, levels, mipChain );
         if ( FAILED(hr) )
             return hr;
 
-        hr = _Generate3DMipsTriangleFilter( depth, levels, filter, mipChain );
+        hr = _Generate3DMipsPointFilter( depth, levels, mipChain );
         if ( FAILED(hr) )
             mipChain.Release();
         return hr;
@@ -2997,51 +1451,26 @@ HRESULT GenerateMipMaps3D( const Image* srcImages, size_t nimages, const TexMeta
     switch( filter_select )
     {
     case TEX_FILTER_BOX:
-        hr = _Setup3DMips( &baseImages[0], metadata.depth, levels, mipChain );
-        if ( FAILED(hr) )
-            return hr;
-
-        hr = _Generate3DMipsBoxFilter( metadata.depth, levels, filter, mipChain );
-        if ( FAILED(hr) )
-            mipChain.Release();
-        return hr;
-
-    case TEX_FILTER_POINT:
-        hr = _Setup3DMips( &baseImages[0], metadata.depth, levels, mipChain );
-        if ( FAILED(hr) )
-            return hr;
-
-        hr = _Generate3DMipsPointFilter( metadata.depth, levels, mipChain );
-        if ( FAILED(hr) )
-            mipChain.Release();
-        return hr;
-
     case TEX_FILTER_LINEAR:
-        hr = _Setup3DMips( &baseImages[0], metadata.depth, levels, mipChain );
-        if ( FAILED(hr) )
-            return hr;
-
-        hr = _Generate3DMipsLinearFilter( metadata.depth, levels, filter, mipChain );
-        if ( FAILED(hr) )
-            mipChain.Release();
-        return hr;
-
     case TEX_FILTER_CUBIC:
+    case TEX_FILTER_TRIANGLE:
+    case TEX_FILTER_LANCZOS:
+    case TEX_FILTER_KAISER:
         hr = _Setup3DMips( &baseImages[0], metadata.depth, levels, mipChain );
         if ( FAILED(hr) )
             return hr;
 
-        hr = _Generate3DMipsCubicFilter( metadata.depth, levels, filter, mipChain );
+        hr = _Generate3DMipsSeparableFilter( metadata.depth, levels, ( filter & ~TEX_FILTER_MASK ) | filter_select, mipChain );
         if ( FAILED(hr) )
             mipChain.Release();
         return hr;
 
-    case TEX_FILTER_TRIANGLE:
+    case TEX_FILTER_POINT:
         hr = _Setup3DMips( &baseImages[0], metadata.depth, levels, mipChain );
         if ( FAILED(hr) )
             return hr;
 
-        hr = _Generate3DMipsTriangleFilter( metadata.depth, levels, filter, mipChain );
+        hr = _Generate3DMipsPointFilter( metadata.depth, levels, mipChain );
         if ( FAILED(hr) )
             mipChain.Release();
         return hr;
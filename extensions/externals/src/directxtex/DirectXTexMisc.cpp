@@ -19,33 +19,24 @@ namespace DirectX
 {
 static const XMVECTORF32 g_Gamma22 = { 2.2f, 2.2f, 2.2f, 1.f };
 
-//-------------------------------------------------------------------------------------
-static HRESULT _ComputeMSE( _In_ const Image& image1, _In_ const Image& image2,
-                            _Out_ float& mse, _Out_writes_opt_(4) float* mseV,
-                            _In_ DWORD flags )
-{
-    if ( !image1.pixels || !image2.pixels )
-        return E_POINTER;
-
-    assert( image1.width == image2.width && image1.height == image2.height );
-    assert( !IsCompressed( image1.format ) && !IsCompressed( image2.format )  );
+// Size of the SSIM windows; quality bands are a whole number of window rows
+static const size_t QUALITY_WINDOW = 8;
 
-    const size_t width = image1.width;
+// Each task compares a band of rows at least this many texels in size
+static const size_t QUALITY_BAND_TEXELS = 16384;
 
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width)*2, 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    // Flags implied from image formats
-    switch( image1.format )
+//-------------------------------------------------------------------------------------
+// Flags implied from image formats
+//-------------------------------------------------------------------------------------
+static DWORD _ImpliedFormatFlags( _In_ DXGI_FORMAT format, _In_ DWORD srgbFlag )
+{
+    switch( format )
     {
     case DXGI_FORMAT_B8G8R8X8_UNORM:
-        flags |= CMSE_IGNORE_ALPHA;
-        break;
+        return CMSE_IGNORE_ALPHA;
 
     case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
-        flags |= CMSE_IMAGE1_SRGB | CMSE_IGNORE_ALPHA;
-        break;
+        return srgbFlag | CMSE_IGNORE_ALPHA;
 
     case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
     case DXGI_FORMAT_BC1_UNORM_SRGB:
@@ -53,113 +44,360 @@ static HRESULT _ComputeMSE( _In_ const Image& image1, _In_ const Image& image2,
     case DXGI_FORMAT_BC3_UNORM_SRGB:
     case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
     case DXGI_FORMAT_BC7_UNORM_SRGB:
-        flags |= CMSE_IMAGE1_SRGB;
-        break;
+        return srgbFlag;
+
+    default:
+        return 0;
     }
+}
 
-    switch( image2.format )
-    {
-    case DXGI_FORMAT_B8G8R8X8_UNORM:
-        flags |= CMSE_IGNORE_ALPHA;
-        break;
+//-------------------------------------------------------------------------------------
+// Loads a scanline and applies the gamma, bias and channel mask selected by the flags
+//-------------------------------------------------------------------------------------
+static bool _LoadQualityScanline( _Out_writes_(width) XMVECTOR* pDestination, _In_ size_t width,
+                                  _In_reads_bytes_(rowPitch) const uint8_t* pSource, _In_ size_t rowPitch, _In_ DXGI_FORMAT format,
+                                  _In_ bool srgb, _In_ bool bias, _In_ FXMVECTOR ignore, _In_ bool masked )
+{
+    if ( !_LoadScanline( pDestination, width, pSource, rowPitch, format ) )
+        return false;
 
-    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
-        flags |= CMSE_IMAGE2_SRGB | CMSE_IGNORE_ALPHA;
-        break;
+    if ( !srgb && !bias && !masked )
+        return true;
 
-    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
-    case DXGI_FORMAT_BC1_UNORM_SRGB:
-    case DXGI_FORMAT_BC2_UNORM_SRGB:
-    case DXGI_FORMAT_BC3_UNORM_SRGB:
-    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
-    case DXGI_FORMAT_BC7_UNORM_SRGB:
-        flags |= CMSE_IMAGE2_SRGB;
-        break;
+    static const XMVECTORF32 two = { 2.0f, 2.0f, 2.0f, 2.0f };
+
+    XMVECTOR* ptr = pDestination;
+    for( size_t i = 0; i < width; ++i, ++ptr )
+    {
+        XMVECTOR v = *ptr;
+        if ( srgb )
+        {
+            v = XMVectorPow( v, g_Gamma22 );
+        }
+        if ( bias )
+        {
+            v = XMVectorMultiplyAdd( v, two, g_XMNegativeOne );
+        }
+
+        // Ignored channels are zero in both images, so they have no error and an SSIM of 1
+        *ptr = XMVectorSelect( v, g_XMZero, ignore );
     }
 
-    const uint8_t *pSrc1 = image1.pixels;
-    const size_t rowPitch1 = image1.rowPitch;
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Parallel comparison
+//-------------------------------------------------------------------------------------
+struct _QualityImage
+{
+    const Image*    image1;
+    const Image*    image2;
+    DWORD           flags;
+    size_t          bandHeight;
+};
+
+struct _QualityBand
+{
+    XMFLOAT4        sqErr;      // sum[ (I1 - I2)^2 ]
+    XMFLOAT4        ssim;       // sum of window SSIM
+    size_t          windows;
+};
+
+struct _QualityContext
+{
+    std::vector<_QualityImage>  images;
+    std::vector<size_t>         firstBand;
+    _QualityBand*               bands;
+    bool                        ssim;
+};
+
+static bool _CompareBand( _In_ size_t band, _In_opt_ void* pContext )
+{
+    const _QualityContext* context = reinterpret_cast<const _QualityContext*>( pContext );
+    assert( context );
+
+    // Find the image that contains the band
+    const size_t index = ( std::upper_bound( context->firstBand.begin(), context->firstBand.end(), band ) - context->firstBand.begin() ) - 1;
+    assert( index < context->images.size() );
+
+    const _QualityImage& qi = context->images[ index ];
+    const Image& image1 = *qi.image1;
+    const Image& image2 = *qi.image2;
+    const DWORD flags = qi.flags;
+    const size_t width = image1.width;
+
+    const size_t y0 = ( band - context->firstBand[ index ] ) * qi.bandHeight;
+    const size_t y1 = std::min<size_t>( y0 + qi.bandHeight, image1.height );
+    assert( y0 < y1 );
 
-    const uint8_t *pSrc2 = image2.pixels;
-    const size_t rowPitch2 = image2.rowPitch;
+    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( ( sizeof(XMVECTOR) * width ) * QUALITY_WINDOW * 2, 16 ) ) );
+    if ( !scanline )
+        return false;
 
-    XMVECTOR acc = g_XMZero;
-    static XMVECTORF32 two = { 2.0f, 2.0f, 2.0f, 2.0f };
+    XMVECTOR* rows1 = scanline.get();
+    XMVECTOR* rows2 = scanline.get() + width * QUALITY_WINDOW;
 
-    for( size_t h = 0; h < image1.height; ++h )
+    const XMVECTORU32 ignore = { ( flags & CMSE_IGNORE_RED ) ? 0xFFFFFFFFu : 0u,
+                                 ( flags & CMSE_IGNORE_GREEN ) ? 0xFFFFFFFFu : 0u,
+                                 ( flags & CMSE_IGNORE_BLUE ) ? 0xFFFFFFFFu : 0u,
+                                 ( flags & CMSE_IGNORE_ALPHA ) ? 0xFFFFFFFFu : 0u };
+    const bool masked = ( flags & ( CMSE_IGNORE_RED | CMSE_IGNORE_GREEN | CMSE_IGNORE_BLUE | CMSE_IGNORE_ALPHA ) ) != 0;
+
+    // SSIM stabilizing constants for a dynamic range of 1.0
+    static const XMVECTORF32 C1 = { 0.0001f, 0.0001f, 0.0001f, 0.0001f };
+    static const XMVECTORF32 C2 = { 0.0009f, 0.0009f, 0.0009f, 0.0009f };
+    static const XMVECTORF32 two = { 2.0f, 2.0f, 2.0f, 2.0f };
+
+    XMVECTOR sqErr = g_XMZero;
+    XMVECTOR ssim = g_XMZero;
+    size_t windows = 0;
+
+    for( size_t y = y0; y < y1; y += QUALITY_WINDOW )
     {
-        XMVECTOR* ptr1 = scanline.get();
-        if ( !_LoadScanline( ptr1, width, pSrc1, rowPitch1, image1.format ) )
-            return E_FAIL;
+        const size_t wh = std::min<size_t>( QUALITY_WINDOW, y1 - y );
 
-        XMVECTOR* ptr2 = scanline.get() + width;
-        if ( !_LoadScanline( ptr2, width, pSrc2, rowPitch2, image2.format ) )
-            return E_FAIL;
+        for( size_t j = 0; j < wh; ++j )
+        {
+            if ( !_LoadQualityScanline( rows1 + width * j, width, image1.pixels + image1.rowPitch * ( y + j ), image1.rowPitch, image1.format,
+                                        ( flags & CMSE_IMAGE1_SRGB ) != 0, ( flags & CMSE_IMAGE1_X2_BIAS ) != 0, ignore, masked ) )
+                return false;
+
+            if ( !_LoadQualityScanline( rows2 + width * j, width, image2.pixels + image2.rowPitch * ( y + j ), image2.rowPitch, image2.format,
+                                        ( flags & CMSE_IMAGE2_SRGB ) != 0, ( flags & CMSE_IMAGE2_X2_BIAS ) != 0, ignore, masked ) )
+                return false;
+        }
 
-        for( size_t i = 0; i < width; ++i )
+        if ( !context->ssim )
         {
-            XMVECTOR v1 = *(ptr1++);
-            if ( flags & CMSE_IMAGE1_SRGB )
+            // Partial sums per scanline keep float accumulation error down on wide images
+            for( size_t j = 0; j < wh; ++j )
             {
-                v1 = XMVectorPow( v1, g_Gamma22 );
-            }
-            if ( flags & CMSE_IMAGE1_X2_BIAS )
-            {
-                v1 = XMVectorMultiplyAdd( v1, two, g_XMNegativeOne );
-            }
+                const XMVECTOR* ptr1 = rows1 + width * j;
+                const XMVECTOR* ptr2 = rows2 + width * j;
 
-            XMVECTOR v2 = *(ptr2++);
-            if ( flags & CMSE_IMAGE2_SRGB )
-            {
-                v2 = XMVectorPow( v2, g_Gamma22 );
-            }
-            if ( flags & CMSE_IMAGE2_X2_BIAS )
-            {
-                v1 = XMVectorMultiplyAdd( v2, two, g_XMNegativeOne );
-            }
+                XMVECTOR acc = g_XMZero;
+                for( size_t i = 0; i < width; ++i )
+                {
+                    XMVECTOR v = XMVectorSubtract( ptr1[ i ], ptr2[ i ] );
+                    acc = XMVectorMultiplyAdd( v, v, acc );
+                }
 
-            // sum[ (I1 - I2)^2 ]
-            XMVECTOR v = XMVectorSubtract( v1, v2 );
-            if ( flags & CMSE_IGNORE_RED )
-            {
-                v = XMVectorSelect( v, g_XMZero, g_XMMaskX );
+                sqErr = XMVectorAdd( sqErr, acc );
             }
-            if ( flags & CMSE_IGNORE_GREEN )
-            {
-                v = XMVectorSelect( v, g_XMZero, g_XMMaskY );
-            }
-            if ( flags & CMSE_IGNORE_BLUE )
+            continue;
+        }
+
+        for( size_t x = 0; x < width; x += QUALITY_WINDOW )
+        {
+            const size_t ww = std::min<size_t>( QUALITY_WINDOW, width - x );
+
+            XMVECTOR s1 = g_XMZero;
+            XMVECTOR s2 = g_XMZero;
+            XMVECTOR s11 = g_XMZero;
+            XMVECTOR s22 = g_XMZero;
+            XMVECTOR s12 = g_XMZero;
+            XMVECTOR sd = g_XMZero;
+
+            for( size_t j = 0; j < wh; ++j )
             {
-                v = XMVectorSelect( v, g_XMZero, g_XMMaskZ );
+                const XMVECTOR* ptr1 = rows1 + width * j + x;
+                const XMVECTOR* ptr2 = rows2 + width * j + x;
+
+                for( size_t i = 0; i < ww; ++i )
+                {
+                    XMVECTOR v1 = ptr1[ i ];
+                    XMVECTOR v2 = ptr2[ i ];
+
+                    s1 = XMVectorAdd( s1, v1 );
+                    s2 = XMVectorAdd( s2, v2 );
+                    s11 = XMVectorMultiplyAdd( v1, v1, s11 );
+                    s22 = XMVectorMultiplyAdd( v2, v2, s22 );
+                    s12 = XMVectorMultiplyAdd( v1, v2, s12 );
+
+                    XMVECTOR v = XMVectorSubtract( v1, v2 );
+                    sd = XMVectorMultiplyAdd( v, v, sd );
+                }
             }
-            if ( flags & CMSE_IGNORE_ALPHA )
+
+            sqErr = XMVectorAdd( sqErr, sd );
+
+            // SSIM = ( 2*u1*u2 + C1 )( 2*cov12 + C2 ) / ( ( u1^2 + u2^2 + C1 )( var1 + var2 + C2 ) )
+            XMVECTOR n = XMVectorReplicate( 1.f / float( ww * wh ) );
+
+            XMVECTOR u1 = XMVectorMultiply( s1, n );
+            XMVECTOR u2 = XMVectorMultiply( s2, n );
+            XMVECTOR u11 = XMVectorMultiply( u1, u1 );
+            XMVECTOR u22 = XMVectorMultiply( u2, u2 );
+            XMVECTOR u12 = XMVectorMultiply( u1, u2 );
+
+            XMVECTOR var = XMVectorSubtract( XMVectorMultiply( XMVectorAdd( s11, s22 ), n ), XMVectorAdd( u11, u22 ) );
+            XMVECTOR cov = XMVectorSubtract( XMVectorMultiply( s12, n ), u12 );
+
+            XMVECTOR num = XMVectorMultiply( XMVectorMultiplyAdd( u12, two, C1 ), XMVectorMultiplyAdd( cov, two, C2 ) );
+            XMVECTOR den = XMVectorMultiply( XMVectorAdd( XMVectorAdd( u11, u22 ), C1 ), XMVectorAdd( var, C2 ) );
+
+            ssim = XMVectorAdd( ssim, XMVectorDivide( num, den ) );
+            ++windows;
+        }
+    }
+
+    _QualityBand& result = context->bands[ band ];
+    XMStoreFloat4( &result.sqErr, sqErr );
+    XMStoreFloat4( &result.ssim, ssim );
+    result.windows = windows;
+
+    return true;
+}
+
+static HRESULT _ComputeQuality( _In_reads_(nimages) const Image* images1, _In_reads_(nimages) const Image* images2, _In_ size_t nimages,
+                                _Out_writes_(nimages) ImageQuality* results, _In_ DWORD flags, _In_ bool ssim, _In_ bool parallel )
+{
+    if ( !images1 || !images2 || !nimages || !results )
+        return E_INVALIDARG;
+
+    // Expand compressed images to RGBA32F
+    std::unique_ptr<ScratchImage[]> temps;
+
+    _QualityContext context;
+    context.images.reserve( nimages );
+    context.firstBand.reserve( nimages );
+    context.ssim = ssim;
+
+    size_t nBands = 0;
+    for( size_t index = 0; index < nimages; ++index )
+    {
+        const Image* image1 = &images1[ index ];
+        const Image* image2 = &images2[ index ];
+
+        if ( !image1->pixels || !image2->pixels )
+            return E_POINTER;
+
+        if ( image1->width != image2->width || image1->height != image2->height )
+            return E_INVALIDARG;
+
+        const Image** images[2] = { &image1, &image2 };
+        for( size_t k = 0; k < 2; ++k )
+        {
+            if ( !IsCompressed( (*images[ k ])->format ) )
+                continue;
+
+            if ( !temps )
             {
-                v = XMVectorSelect( v, g_XMZero, g_XMMaskW );
+                temps.reset( new (std::nothrow) ScratchImage[ nimages * 2 ] );
+                if ( !temps )
+                    return E_OUTOFMEMORY;
             }
 
-            acc = XMVectorMultiplyAdd( v, v, acc );
+            ScratchImage& temp = temps[ index * 2 + k ];
+            HRESULT hr = Decompress( **images[ k ], DXGI_FORMAT_R32G32B32A32_FLOAT, parallel ? TEX_DECOMPRESS_PARALLEL : 0, temp );
+            if ( FAILED(hr) )
+                return hr;
+
+            *images[ k ] = temp.GetImage(0,0,0);
+            if ( !*images[ k ] )
+                return E_POINTER;
         }
 
-        pSrc1 += rowPitch1;
-        pSrc2 += rowPitch2;
+        // Implied flags come from the formats actually loaded; Decompress already linearizes BC*_SRGB data
+        _QualityImage qi;
+        qi.flags = flags | _ImpliedFormatFlags( image1->format, CMSE_IMAGE1_SRGB ) | _ImpliedFormatFlags( image2->format, CMSE_IMAGE2_SRGB );
+        qi.image1 = image1;
+        qi.image2 = image2;
+
+        qi.bandHeight = std::max<size_t>( 1, QUALITY_BAND_TEXELS / ( image1->width * QUALITY_WINDOW ) ) * QUALITY_WINDOW;
+
+        context.images.push_back( qi );
+        context.firstBand.push_back( nBands );
+
+        nBands += ( image1->height + qi.bandHeight - 1 ) / qi.bandHeight;
     }
 
-    // MSE = sum[ (I1 - I2)^2 ] / w*h
-    XMVECTOR d = XMVectorReplicate( float(image1.width * image1.height) );
-    XMVECTOR v = XMVectorDivide( acc, d );
-    if ( mseV )
+    if ( !nBands )
+        return E_FAIL;
+
+    std::unique_ptr<_QualityBand[]> bands( new (std::nothrow) _QualityBand[ nBands ] );
+    if ( !bands )
+        return E_OUTOFMEMORY;
+
+    context.bands = bands.get();
+
+    if ( parallel )
     {
-        XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( mseV ), v );
-        mse = mseV[0] + mseV[1] + mseV[2] + mseV[3];
+        HRESULT hr = _ParallelFor( nBands, _CompareBand, &context );
+        if ( FAILED(hr) )
+            return hr;
     }
     else
     {
-        XMFLOAT4 _mseV;
-        XMStoreFloat4( &_mseV, v );
-        mse = _mseV.x + _mseV.y + _mseV.z + _mseV.w;
+        for( size_t band = 0; band < nBands; ++band )
+        {
+            if ( !_CompareBand( band, &context ) )
+                return E_FAIL;
+        }
+    }
+
+    // Reduce the bands of each image
+    size_t band = 0;
+    for( size_t index = 0; index < nimages; ++index )
+    {
+        const _QualityImage& qi = context.images[ index ];
+        const size_t lastBand = ( index + 1 < nimages ) ? context.firstBand[ index + 1 ] : nBands;
+
+        double sqErr[4] = { 0, 0, 0, 0 };
+        double ssimSum[4] = { 0, 0, 0, 0 };
+        size_t windows = 0;
+
+        for( ; band < lastBand; ++band )
+        {
+            const _QualityBand& b = bands[ band ];
+
+            sqErr[0] += b.sqErr.x;  ssimSum[0] += b.ssim.x;
+            sqErr[1] += b.sqErr.y;  ssimSum[1] += b.ssim.y;
+            sqErr[2] += b.sqErr.z;  ssimSum[2] += b.ssim.z;
+            sqErr[3] += b.sqErr.w;  ssimSum[3] += b.ssim.w;
+
+            windows += b.windows;
+        }
+
+        ImageQuality& result = results[ index ];
+
+        // MSE = sum[ (I1 - I2)^2 ] / w*h
+        const double pixels = double( qi.image1->width ) * double( qi.image1->height );
+
+        result.mse = 0.f;
+        result.ssim = 0.f;
+
+        size_t channels = 0;
+        for( size_t c = 0; c < 4; ++c )
+        {
+            result.mseV[ c ] = float( sqErr[ c ] / pixels );
+            result.mse += result.mseV[ c ];
+
+            result.ssimV[ c ] = ( windows > 0 ) ? float( ssimSum[ c ] / double( windows ) ) : 1.f;
+            if ( !( qi.flags & ( CMSE_IGNORE_RED << c ) ) )
+            {
+                result.ssim += result.ssimV[ c ];
+                ++channels;
+            }
+        }
+
+        if ( channels > 0 )
+        {
+            result.ssim /= float( channels );
+
+            double mse = double( result.mse ) / double( channels );
+            result.psnr = ( mse > 0 ) ? float( -10.0 * log10( mse ) ) : XMVectorGetX( g_XMInfinity );
+        }
+        else
+        {
+            result.ssim = 1.f;
+            result.psnr = XMVectorGetX( g_XMInfinity );
+        }
     }
 
-    return S_OK; 
+    return S_OK;
 }
 
 
@@ -284,65 +522,28 @@ HRESULT ComputeMSE( const Image& image1, const Image& image2, float& mse, float*
     if ( image1.width != image2.width || image1.height != image2.height )
         return E_INVALIDARG;
 
-    if ( IsCompressed(image1.format) )
-    {
-        if ( IsCompressed(image2.format) )
-        {
-            // Case 1: both images are compressed, expand to RGBA32F
-            ScratchImage temp1;
-            HRESULT hr = Decompress( image1, DXGI_FORMAT_R32G32B32A32_FLOAT, temp1 );
-            if ( FAILED(hr) )
-                return hr;
-
-            ScratchImage temp2;
-            hr = Decompress(  image2, DXGI_FORMAT_R32G32B32A32_FLOAT, temp2 );
-            if ( FAILED(hr) )
-                return hr;
-
-            const Image* img1 = temp1.GetImage(0,0,0);
-            const Image* img2 = temp2.GetImage(0,0,0);
-            if ( !img1 || !img2 )
-                return E_POINTER;
-
-            return _ComputeMSE( *img1, *img2, mse, mseV, flags );
-        }
-        else
-        {
-            // Case 2: image1 is compressed, expand to RGBA32F
-            ScratchImage temp;
-            HRESULT hr = Decompress( image1, DXGI_FORMAT_R32G32B32A32_FLOAT, temp );
-            if ( FAILED(hr) )
-                return hr;
-
-            const Image* img = temp.GetImage(0,0,0);
-            if ( !img )
-                return E_POINTER;
+    ImageQuality quality;
+    HRESULT hr = _ComputeQuality( &image1, &image2, 1, &quality, flags, false, false );
+    if ( FAILED(hr) )
+        return hr;
 
-            return _ComputeMSE( *img, image2, mse, mseV, flags );
-        }
-    }
-    else
+    mse = quality.mse;
+    if ( mseV )
     {
-        if ( IsCompressed(image2.format) )
-        {
-            // Case 3: image2 is compressed, expand to RGBA32F
-            ScratchImage temp;
-            HRESULT hr = Decompress( image2, DXGI_FORMAT_R32G32B32A32_FLOAT, temp );
-            if ( FAILED(hr) )
-                return hr;
+        memcpy( mseV, quality.mseV, sizeof(quality.mseV) );
+    }
 
-            const Image* img = temp.GetImage(0,0,0);
-            if ( !img )
-                return E_POINTER;
+    return S_OK;
+}
 
-            return _ComputeMSE( image1, *img, mse, mseV, flags );
-        }
-        else
-        {
-            // Case 4: neither image is compressed
-            return _ComputeMSE( image1, image2, mse, mseV, flags );
-        }
-    }
+
+//-------------------------------------------------------------------------------------
+// Computes MSE, PSNR and SSIM for each pair of images using multiple threads
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT ComputeQuality( const Image* images1, const Image* images2, size_t nimages, ImageQuality* results, DWORD flags )
+{
+    return _ComputeQuality( images1, images2, nimages, results, flags, true, true );
 }
 
 }; // namespace
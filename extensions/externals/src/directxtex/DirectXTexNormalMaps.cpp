@@ -54,195 +54,332 @@ static void _EvaluateRow( _In_reads_(width) const XMVECTOR* pSource, _Out_writes
     assert( pSource && pDest );
     assert( width > 0 );
 
-    for( size_t x = 0; x < width; ++x )
+    // Select the channel once for the whole row
+    switch( flags & 0xf )
     {
-        pDest[x+1] = _EvaluateColor( pSource[x], flags );
+    case CNMAP_CHANNEL_GREEN:
+        for( size_t x = 0; x < width; ++x )
+            pDest[x+1] = XMVectorGetY( pSource[x] );
+        break;
+
+    case CNMAP_CHANNEL_BLUE:
+        for( size_t x = 0; x < width; ++x )
+            pDest[x+1] = XMVectorGetZ( pSource[x] );
+        break;
+
+    case CNMAP_CHANNEL_ALPHA:
+        for( size_t x = 0; x < width; ++x )
+            pDest[x+1] = XMVectorGetW( pSource[x] );
+        break;
+
+    case CNMAP_CHANNEL_LUMINANCE:
+        for( size_t x = 0; x < width; ++x )
+            pDest[x+1] = _EvaluateColor( pSource[x], flags );
+        break;
+
+    default:
+        for( size_t x = 0; x < width; ++x )
+            pDest[x+1] = XMVectorGetX( pSource[x] );
+        break;
     }
 
     if ( flags & CNMAP_MIRROR_U )
     {
         // Mirror in U
-        pDest[0] = _EvaluateColor( pSource[0], flags );
-        pDest[width+1] = _EvaluateColor( pSource[width-1], flags );
+        pDest[0] = pDest[1];
+        pDest[width+1] = pDest[width];
     }
     else
     {
         // Wrap in U
-        pDest[0] = _EvaluateColor( pSource[width-1], flags );
-        pDest[width+1] = _EvaluateColor( pSource[0], flags );
+        pDest[0] = pDest[width];
+        pDest[width+1] = pDest[1];
     }
 }
 
-static HRESULT _ComputeNMap( _In_ const Image& srcImage, _In_ DWORD flags, _In_ float amplitude,
-                             _In_ DXGI_FORMAT format, _In_ const Image& normalMap )
+//-------------------------------------------------------------------------------------
+// Computes the normals (and alpha) of four adjacent pixels from three evaluated rows.
+// Results are returned structure-of-arrays in nx, ny, nz and alpha
+//-------------------------------------------------------------------------------------
+static void _ComputeNormals4( _In_reads_(6) const float* val0, _In_reads_(6) const float* val1, _In_reads_(6) const float* val2,
+                              _In_ DWORD flags, _In_ float amplitude,
+                              _Out_ XMVECTOR& nx, _Out_ XMVECTOR& ny, _Out_ XMVECTOR& nz, _Out_ XMVECTOR& alpha )
 {
-    if ( !srcImage.pixels || !normalMap.pixels )
-        return E_INVALIDARG;
+    // Left, center and right neighbors of each of the four pixels
+    XMVECTOR l0 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( val0 ) );
+    XMVECTOR c0 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( val0 + 1 ) );
+    XMVECTOR r0 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( val0 + 2 ) );
 
-    assert( !IsCompressed(format) && !IsTypeless( format ) );
+    XMVECTOR l1 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( val1 ) );
+    XMVECTOR c1 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( val1 + 1 ) );
+    XMVECTOR r1 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( val1 + 2 ) );
 
-    const DWORD convFlags = _GetConvertFlags( format );
-    if ( !convFlags )
-        return E_FAIL;
+    XMVECTOR l2 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( val2 ) );
+    XMVECTOR c2 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( val2 + 1 ) );
+    XMVECTOR r2 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( val2 + 2 ) );
 
-    if ( !( convFlags & (CONVF_UNORM | CONVF_SNORM | CONVF_FLOAT) ) )
-        HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
-
-    const size_t width = srcImage.width;
-    const size_t height = srcImage.height;
-    if ( width != normalMap.width || height != normalMap.height )
-        return E_FAIL;
+    XMVECTOR deltaZX, deltaZY;
+    if ( flags & CNMAP_SOBEL )
+    {
+        // Sobel: the center row and column are weighted twice
+        XMVECTOR scale = XMVectorReplicate( amplitude / 8.f );
 
-    // Allocate temporary space (4 scanlines and 3 evaluated rows)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width*4), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
+        XMVECTOR totDelta = XMVectorAdd( XMVectorAdd( XMVectorSubtract( l0, r0 ), XMVectorSubtract( l2, r2 ) ),
+                                         XMVectorScale( XMVectorSubtract( l1, r1 ), 2.f ) );
+        deltaZX = XMVectorMultiply( totDelta, scale );
 
-    ScopedAlignedArrayFloat buffer( reinterpret_cast<float*>( _aligned_malloc( ( ( sizeof(float) * ( width + 2 ) ) * 3 ), 16 ) ) );
-    if ( !buffer )
-        return E_OUTOFMEMORY;
-
-    uint8_t* pDest = normalMap.pixels;
-    if ( !pDest )
-        return E_POINTER;
+        totDelta = XMVectorAdd( XMVectorAdd( XMVectorSubtract( l0, l2 ), XMVectorSubtract( r0, r2 ) ),
+                                XMVectorScale( XMVectorSubtract( c0, c2 ), 2.f ) );
+        deltaZY = XMVectorMultiply( totDelta, scale );
+    }
+    else
+    {
+        // Central differencing averaged over three rows/columns
+        XMVECTOR scale = XMVectorReplicate( amplitude / 6.f );
 
-    XMVECTOR* row0 = scanline.get();
-    XMVECTOR* row1 = row0 + width;
-    XMVECTOR* row2 = row1 + width;
-    XMVECTOR* target = row2 + width;
+        XMVECTOR totDelta = XMVectorAdd( XMVectorAdd( XMVectorSubtract( l0, r0 ), XMVectorSubtract( l1, r1 ) ), XMVectorSubtract( l2, r2 ) );
+        deltaZX = XMVectorMultiply( totDelta, scale );
 
-    float* val0 = buffer.get();
-    float* val1 = val0 + width + 2;
-    float* val2 = val1 + width + 2;
+        totDelta = XMVectorAdd( XMVectorAdd( XMVectorSubtract( l0, l2 ), XMVectorSubtract( c0, c2 ) ), XMVectorSubtract( r0, r2 ) );
+        deltaZY = XMVectorMultiply( totDelta, scale );
+    }
 
-    const size_t rowPitch = srcImage.rowPitch;
-    const uint8_t* pSrc = srcImage.pixels;
+    // cross( (-1, 0, deltaZX), (0, -1, deltaZY) ) = (deltaZX, deltaZY, 1)
+    XMVECTOR length = XMVectorSqrt( XMVectorMultiplyAdd( deltaZX, deltaZX, XMVectorMultiplyAdd( deltaZY, deltaZY, g_XMOne ) ) );
+    XMVECTOR invLength = XMVectorReciprocal( length );
 
-    // Read first scanline row into 'row1'
-    if ( !_LoadScanline( row1, width, pSrc, rowPitch, srcImage.format ) )
-        return E_FAIL;
+    nx = XMVectorMultiply( deltaZX, invLength );
+    ny = XMVectorMultiply( deltaZY, invLength );
+    nz = invLength;
 
-    // Setup 'row0'
-    if ( flags & CNMAP_MIRROR_V )
+    // Compute alpha (1.0 or an occlusion term)
+    if ( flags & CNMAP_COMPUTE_OCCLUSION )
     {
-        // Mirror first row
-        memcpy_s( row0, rowPitch, row1, rowPitch );
+        XMVECTOR delta = XMVectorMax( XMVectorSubtract( l0, c1 ), g_XMZero );
+        delta = XMVectorAdd( delta, XMVectorMax( XMVectorSubtract( c0, c1 ), g_XMZero ) );
+        delta = XMVectorAdd( delta, XMVectorMax( XMVectorSubtract( r0, c1 ), g_XMZero ) );
+        delta = XMVectorAdd( delta, XMVectorMax( XMVectorSubtract( l1, c1 ), g_XMZero ) );
+        // Skip current pixel
+        delta = XMVectorAdd( delta, XMVectorMax( XMVectorSubtract( r1, c1 ), g_XMZero ) );
+        delta = XMVectorAdd( delta, XMVectorMax( XMVectorSubtract( l2, c1 ), g_XMZero ) );
+        delta = XMVectorAdd( delta, XMVectorMax( XMVectorSubtract( c2, c1 ), g_XMZero ) );
+        delta = XMVectorAdd( delta, XMVectorMax( XMVectorSubtract( r2, c1 ), g_XMZero ) );
+
+        // Average delta (divide by 8, scale by amplitude factor)
+        delta = XMVectorScale( delta, 0.125f * amplitude );
+
+        // If <= 0, then no occlusion
+        XMVECTOR r = XMVectorSqrt( XMVectorMultiplyAdd( delta, delta, g_XMOne ) );
+        XMVECTOR occlusion = XMVectorDivide( XMVectorSubtract( r, delta ), r );
+
+        alpha = XMVectorSelect( g_XMOne, occlusion, XMVectorGreater( delta, g_XMZero ) );
     }
     else
     {
-        // Read last row (Wrap V)
-        if ( !_LoadScanline( row0, width, pSrc + (rowPitch * (height-1)), rowPitch, srcImage.format ) )
-            return E_FAIL;
+        alpha = g_XMOne;
     }
+}
+
+
+//-------------------------------------------------------------------------------------
+// Parallel normal map generation
+//-------------------------------------------------------------------------------------
+
+// Each task generates a band of rows at least this many texels in size
+static const size_t NMAP_BAND_TEXELS = 65536;
+
+struct _NMapContext
+{
+    const Image*            srcImages;
+    const Image*            destImages;
+    DWORD                   flags;
+    float                   amplitude;
+    DWORD                   convFlags;
+    std::vector<size_t>     bandHeight;
+    std::vector<size_t>     firstBand;
+};
+
+static bool _ComputeNMapBand( _In_ size_t band, _In_opt_ void* pContext )
+{
+    const _NMapContext* context = reinterpret_cast<const _NMapContext*>( pContext );
+    assert( context );
+
+    // Find the image that contains the band
+    const size_t index = ( std::upper_bound( context->firstBand.begin(), context->firstBand.end(), band ) - context->firstBand.begin() ) - 1;
+    assert( index < context->firstBand.size() );
+
+    const Image& srcImage = context->srcImages[ index ];
+    const Image& normalMap = context->destImages[ index ];
+    const DWORD flags = context->flags;
+    const float amplitude = context->amplitude;
 
-    // Evaluate the initial rows
-    _EvaluateRow( row0, val0, width, flags );
-    _EvaluateRow( row1, val1, width, flags );
+    const size_t width = srcImage.width;
+    const size_t height = srcImage.height;
 
-    pSrc += rowPitch;
+    const size_t bandHeight = context->bandHeight[ index ];
+    const size_t y0 = ( band - context->firstBand[ index ] ) * bandHeight;
+    const size_t y1 = std::min<size_t>( y0 + bandHeight, height );
+    assert( y0 < y1 );
 
-    for( size_t y = 0; y < height; ++y )
+    // Evaluated rows are padded so the last group of four pixels can read past the edge
+    const size_t pitch = ( ( width + 3 ) & ~size_t(3) ) + 4;
+    const size_t nrows = ( y1 - y0 ) + 2;
+
+    // Allocate temporary space (2 scanlines and the evaluated rows of the band plus one above and below)
+    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( ( sizeof(XMVECTOR) * ( ( width + 3 ) & ~size_t(3) ) ) * 2, 16 ) ) );
+    if ( !scanline )
+        return false;
+
+    ScopedAlignedArrayFloat buffer( reinterpret_cast<float*>( _aligned_malloc( sizeof(float) * pitch * nrows, 16 ) ) );
+    if ( !buffer )
+        return false;
+
+    memset( buffer.get(), 0, sizeof(float) * pitch * nrows );
+
+    XMVECTOR* row = scanline.get();
+    XMVECTOR* target = row + ( ( width + 3 ) & ~size_t(3) );
+
+    const size_t rowPitch = srcImage.rowPitch;
+
+    // Evaluate rows y0-1 through y1 (mirrored or wrapped at the top and bottom edges)
+    for( size_t j = 0; j < nrows; ++j )
     {
-        // Load next scanline of source image
-        if ( y < (height-1) )
+        size_t sy;
+        if ( !j && !y0 )
+        {
+            sy = ( flags & CNMAP_MIRROR_V ) ? 0 : ( height - 1 );
+        }
+        else if ( ( y0 + j ) > height )
         {
-            if ( !_LoadScanline( row2, width, pSrc, rowPitch, srcImage.format ) )
-                return E_FAIL;
+            sy = ( flags & CNMAP_MIRROR_V ) ? ( height - 1 ) : 0;
         }
         else
         {
-            if ( flags & CNMAP_MIRROR_V )
-            {
-                // Use last row of source image
-                if ( !_LoadScanline( row2, width, srcImage.pixels + (rowPitch * (height-1)), rowPitch, srcImage.format ) )
-                    return E_FAIL;
-            }
-            else
-            {
-                // Use first row of source image (Wrap V)
-                if ( !_LoadScanline( row2, width, srcImage.pixels, rowPitch, srcImage.format ) )
-                    return E_FAIL;
-            }
+            sy = y0 + j - 1;
         }
 
-        // Evaluate row
-        _EvaluateRow( row2, val2, width, flags );
+        if ( !_LoadScanline( row, width, srcImage.pixels + ( rowPitch * sy ), rowPitch, srcImage.format ) )
+            return false;
 
-        // Generate target scanline
-        XMVECTOR *dptr = target;
-        for( size_t x = 0; x < width; ++x )
-        {
-            // Compute normal via central differencing
-            float totDelta = ( val0[x] - val0[x+2] ) + ( val1[x] - val1[x+2] ) + ( val2[x] - val2[x+2] );
-            float deltaZX = totDelta * amplitude / 6.f;
-
-            totDelta = ( val0[x] - val2[x] ) + ( val0[x+1] - val2[x+1] ) + ( val0[x+2] - val2[x+2] );
-            float deltaZY = totDelta * amplitude / 6.f;
+        _EvaluateRow( row, buffer.get() + ( pitch * j ), width, flags );
+    }
 
-            XMVECTOR vx = XMVectorSetZ( g_XMNegIdentityR0, deltaZX );   // (-1.0f, 0.0f, deltaZX)
-            XMVECTOR vy = XMVectorSetZ( g_XMNegIdentityR1, deltaZY );   // (0.0f, -1.0f, deltaZY)
+    const bool unorm = ( context->convFlags & CONVF_UNORM ) != 0;
+    const bool invert = ( flags & CNMAP_INVERT_SIGN ) != 0;
 
-            XMVECTOR normal = XMVector3Normalize( XMVector3Cross( vx, vy ) );
+    uint8_t* pDest = normalMap.pixels + ( normalMap.rowPitch * y0 );
 
-            // Compute alpha (1.0 or an occlusion term)
-            float alpha = 1.f;
+    for( size_t y = y0; y < y1; ++y )
+    {
+        const float* val0 = buffer.get() + ( pitch * ( y - y0 ) );
+        const float* val1 = val0 + pitch;
+        const float* val2 = val1 + pitch;
 
-            if ( flags & CNMAP_COMPUTE_OCCLUSION )
-            {
-                float delta = 0.f;
-                float c = val1[x+1];
-
-                float t = val0[x] - c;  if ( t > 0.f ) delta += t;
-                t = val0[x+1]   - c;    if ( t > 0.f ) delta += t;
-                t = val0[x+2]   - c;    if ( t > 0.f ) delta += t;
-                t = val1[x]     - c;    if ( t > 0.f ) delta += t;
-                // Skip current pixel
-                t = val1[x+2]   - c;    if ( t > 0.f ) delta += t;
-                t = val2[x]     - c;    if ( t > 0.f ) delta += t;
-                t = val2[x+1]   - c;    if ( t > 0.f ) delta += t;
-                t = val2[x+2]   - c;    if ( t > 0.f ) delta += t;
-
-                // Average delta (divide by 8, scale by amplitude factor)
-                delta *= 0.125f * amplitude;
-                if ( delta > 0.f )
-                {
-                    // If < 0, then no occlusion
-                    float r = sqrtf( 1.f + delta*delta );
-                    alpha = (r - delta) / r;
-                }
-            }
+        XMVECTOR* dptr = target;
+        for( size_t x = 0; x < width; x += 4 )
+        {
+            XMVECTOR nx, ny, nz, alpha;
+            _ComputeNormals4( val0 + x, val1 + x, val2 + x, flags, amplitude, nx, ny, nz, alpha );
 
             // Encode based on target format
-            if ( convFlags & CONVF_UNORM )
+            if ( unorm )
             {
                 // 0.5f*normal + 0.5f -or- invert sign case: -0.5f*normal + 0.5f
-                XMVECTOR n1 = XMVectorMultiplyAdd( (flags & CNMAP_INVERT_SIGN) ? g_XMNegativeOneHalf : g_XMOneHalf, normal, g_XMOneHalf ); 
-                *dptr++ = XMVectorSetW( n1, alpha );
-            }
-            else if ( flags & CNMAP_INVERT_SIGN )
-            {
-                *dptr++ = XMVectorSetW( XMVectorNegate( normal ), alpha );
+                XMVECTOR scale = invert ? g_XMNegativeOneHalf : g_XMOneHalf;
+                nx = XMVectorMultiplyAdd( scale, nx, g_XMOneHalf );
+                ny = XMVectorMultiplyAdd( scale, ny, g_XMOneHalf );
+                nz = XMVectorMultiplyAdd( scale, nz, g_XMOneHalf );
             }
-            else
+            else if ( invert )
             {
-                *dptr++ = XMVectorSetW( normal, alpha );
+                nx = XMVectorNegate( nx );
+                ny = XMVectorNegate( ny );
+                nz = XMVectorNegate( nz );
             }
+
+            // Transpose to one vector per pixel
+            XMVECTOR xy01 = XMVectorMergeXY( nx, ny );
+            XMVECTOR zw01 = XMVectorMergeXY( nz, alpha );
+            XMVECTOR xy23 = XMVectorMergeZW( nx, ny );
+            XMVECTOR zw23 = XMVectorMergeZW( nz, alpha );
+
+            *dptr++ = XMVectorPermute<0, 1, 4, 5>( xy01, zw01 );
+            *dptr++ = XMVectorPermute<2, 3, 6, 7>( xy01, zw01 );
+            *dptr++ = XMVectorPermute<0, 1, 4, 5>( xy23, zw23 );
+            *dptr++ = XMVectorPermute<2, 3, 6, 7>( xy23, zw23 );
         }
 
-        if ( !_StoreScanline( pDest, normalMap.rowPitch, format, target, width ) )
+        if ( !_StoreScanline( pDest, normalMap.rowPitch, normalMap.format, target, width ) )
+            return false;
+
+        pDest += normalMap.rowPitch;
+    }
+
+    return true;
+}
+
+static HRESULT _ComputeNMap( _In_reads_(nimages) const Image* srcImages, _In_reads_(nimages) const Image* destImages, _In_ size_t nimages,
+                             _In_ DWORD flags, _In_ float amplitude )
+{
+    if ( !srcImages || !destImages || !nimages )
+        return E_INVALIDARG;
+
+    const DXGI_FORMAT format = destImages[0].format;
+
+    assert( !IsCompressed(format) && !IsTypeless( format ) );
+
+    const DWORD convFlags = _GetConvertFlags( format );
+    if ( !convFlags )
+        return E_FAIL;
+
+    if ( !( convFlags & (CONVF_UNORM | CONVF_SNORM | CONVF_FLOAT) ) )
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+
+    _NMapContext context;
+    context.srcImages = srcImages;
+    context.destImages = destImages;
+    context.flags = flags;
+    context.amplitude = amplitude;
+    context.convFlags = convFlags;
+    context.bandHeight.reserve( nimages );
+    context.firstBand.reserve( nimages );
+
+    size_t nBands = 0;
+    for( size_t index = 0; index < nimages; ++index )
+    {
+        const Image& srcImage = srcImages[ index ];
+        const Image& normalMap = destImages[ index ];
+
+        if ( !srcImage.pixels || !normalMap.pixels )
+            return E_INVALIDARG;
+
+        if ( srcImage.width != normalMap.width || srcImage.height != normalMap.height )
             return E_FAIL;
 
-        // Cycle buffers
-        float* temp = val0;
-        val0 = val1;
-        val1 = val2;
-        val2 = temp;
+        assert( normalMap.format == format );
 
-        pSrc += rowPitch;
-        pDest += normalMap.rowPitch;
+        const size_t bandHeight = std::max<size_t>( 1, NMAP_BAND_TEXELS / srcImage.width );
+
+        context.bandHeight.push_back( bandHeight );
+        context.firstBand.push_back( nBands );
+
+        nBands += ( srcImage.height + bandHeight - 1 ) / bandHeight;
     }
 
-    return S_OK;
+    return _ParallelFor( nBands, _ComputeNMapBand, &context );
+}
+
+//-------------------------------------------------------------------------------------
+// BC5 output is generated as two-channel R8G8 and then compressed
+//-------------------------------------------------------------------------------------
+static DXGI_FORMAT _NMapIntermediateFormat( _In_ DXGI_FORMAT format )
+{
+    switch( format )
+    {
+    case DXGI_FORMAT_BC5_UNORM: return DXGI_FORMAT_R8G8_UNORM;
+    case DXGI_FORMAT_BC5_SNORM: return DXGI_FORMAT_R8G8_SNORM;
+    default:                    return format;
+    }
 }
 
 
@@ -257,7 +394,11 @@ _Use_decl_annotations_
 HRESULT ComputeNormalMap( const Image& srcImage, DWORD flags, float amplitude,
                           DXGI_FORMAT format, ScratchImage& normalMap )
 {
-    if ( !srcImage.pixels || !IsValid(format) || IsCompressed( format ) || IsTypeless( format ) )
+    if ( !srcImage.pixels || !IsValid(format) || IsTypeless( format ) )
+        return E_INVALIDARG;
+
+    const DXGI_FORMAT nformat = _NMapIntermediateFormat( format );
+    if ( IsCompressed( nformat ) )
         return E_INVALIDARG;
 
     static_assert( CNMAP_CHANNEL_RED == 0x1, "CNMAP_CHANNEL_ flag values don't match mask" );
@@ -281,24 +422,34 @@ HRESULT ComputeNormalMap( const Image& srcImage, DWORD flags, float amplitude,
     // Setup target image
     normalMap.Release();
 
-    HRESULT hr = normalMap.Initialize2D( format, srcImage.width, srcImage.height, 1, 1 );
+    ScratchImage temp;
+    ScratchImage& nmap = ( nformat != format ) ? temp : normalMap;
+
+    HRESULT hr = nmap.Initialize2D( nformat, srcImage.width, srcImage.height, 1, 1 );
     if ( FAILED(hr) )
         return hr;
 
-    const Image *img = normalMap.GetImage( 0, 0, 0 );
+    const Image *img = nmap.GetImage( 0, 0, 0 );
     if ( !img )
     {
-        normalMap.Release();
+        nmap.Release();
         return E_POINTER;
     }
 
-    hr = _ComputeNMap( srcImage, flags, amplitude, format, *img );
+    hr = _ComputeNMap( &srcImage, img, 1, flags, amplitude );
     if ( FAILED(hr) )
     {
-        normalMap.Release();
+        nmap.Release();
         return hr;
     }
 
+    if ( nformat != format )
+    {
+        hr = Compress( *img, format, TEX_COMPRESS_PARALLEL, 0.5f, normalMap );
+        if ( FAILED(hr) )
+            return hr;
+    }
+
     return S_OK;
 }
 
@@ -309,7 +460,11 @@ HRESULT ComputeNormalMap( const Image* srcImages, size_t nimages, const TexMetad
     if ( !srcImages || !nimages )
         return E_INVALIDARG;
 
-    if ( !IsValid(format) || IsCompressed(format) || IsTypeless(format) )
+    if ( !IsValid(format) || IsTypeless(format) )
+        return E_INVALIDARG;
+
+    const DXGI_FORMAT nformat = _NMapIntermediateFormat( format );
+    if ( IsCompressed( nformat ) )
         return E_INVALIDARG;
 
     static_assert( CNMAP_CHANNEL_RED == 0x1, "CNMAP_CHANNEL_ flag values don't match mask" );
@@ -329,48 +484,59 @@ HRESULT ComputeNormalMap( const Image* srcImages, size_t nimages, const TexMetad
 
     normalMaps.Release();
 
+    ScratchImage temp;
+    ScratchImage& nmaps = ( nformat != format ) ? temp : normalMaps;
+
     TexMetadata mdata2 = metadata;
-    mdata2.format = format;
-    HRESULT hr = normalMaps.Initialize( mdata2 );
+    mdata2.format = nformat;
+    HRESULT hr = nmaps.Initialize( mdata2 );
     if ( FAILED(hr) )
         return hr;
 
-    if ( nimages != normalMaps.GetImageCount() )
+    if ( nimages != nmaps.GetImageCount() )
     {
-        normalMaps.Release();
+        nmaps.Release();
         return E_FAIL;
     }
 
-    const Image* dest = normalMaps.GetImages();
+    const Image* dest = nmaps.GetImages();
     if ( !dest )
     {
-        normalMaps.Release();
+        nmaps.Release();
         return E_POINTER;
     }
 
     for( size_t index=0; index < nimages; ++index )
     {
-        assert( dest[ index ].format == format );
+        assert( dest[ index ].format == nformat );
 
         const Image& src = srcImages[ index ];
         if ( IsCompressed( src.format ) || IsTypeless( src.format ) )
         {
-            normalMaps.Release();
+            nmaps.Release();
             return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
         }
 
         if ( src.width != dest[ index ].width || src.height != dest[ index ].height )
         {
-            normalMaps.Release();
+            nmaps.Release();
             return E_FAIL;
         }
+    }
 
-        hr = _ComputeNMap( src, flags, amplitude, format, dest[ index ] );
+    // All images are processed in one parallel pass
+    hr = _ComputeNMap( srcImages, dest, nimages, flags, amplitude );
+    if ( FAILED(hr) )
+    {
+        nmaps.Release();
+        return hr;
+    }
+
+    if ( nformat != format )
+    {
+        hr = Compress( dest, nimages, nmaps.GetMetadata(), format, TEX_COMPRESS_PARALLEL, 0.5f, normalMaps );
         if ( FAILED(hr) )
-        {
-            normalMaps.Release();
             return hr;
-        }
     }
 
     return S_OK;
@@ -18,6 +18,300 @@
 namespace DirectX
 {
 
+//-------------------------------------------------------------------------------------
+// Integer premultiply for 8-bit and 16-bit UNORM formats with alpha in the last channel
+//-------------------------------------------------------------------------------------
+static const uint32_t LINEAR_MAX = 0xFFFFFF;
+
+struct _PMAlphaTables
+{
+    uint32_t    linear[256];        // sRGB UNORM8 -> linear 0.24
+    uint32_t    threshold[256];     // Smallest linear 0.24 value that stores as each sRGB UNORM8 value
+    uint8_t     coarse[4096];       // sRGB UNORM8 for the top 12 bits of a linear 0.24 value
+};
+
+static bool _BuildPMAlphaTables( _Out_ _PMAlphaTables& tables )
+{
+    // Quantize through the same load/store routines the scanline path uses so the results match
+    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( sizeof(XMVECTOR) * 256, 16 ) ) );
+    if ( !scanline )
+        return false;
+
+    uint32_t texels[256];
+    for( uint32_t i = 0; i < 256; ++i )
+    {
+        texels[ i ] = i | ( i << 8 ) | ( i << 16 ) | 0xFF000000;
+    }
+
+    if ( !_LoadScanlineLinear( scanline.get(), 256, texels, sizeof(texels), DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, TEX_FILTER_SRGB ) )
+        return false;
+
+    for( size_t i = 0; i < 256; ++i )
+    {
+        float f = XMVectorGetX( scanline.get()[ i ] );
+        tables.linear[ i ] = static_cast<uint32_t>( double( std::min<float>( std::max<float>( f, 0.f ), 1.f ) ) * LINEAR_MAX + 0.5 );
+    }
+
+    // Binary search for the first linear value of each sRGB code
+    tables.threshold[0] = 0;
+    for( uint32_t code = 1; code < 256; ++code )
+    {
+        uint32_t lo = tables.threshold[ code - 1 ];
+        uint32_t hi = LINEAR_MAX + 1;
+        while( lo < hi )
+        {
+            uint32_t mid = ( lo + hi ) / 2;
+
+            XMVECTOR* v = scanline.get();
+            *v = XMVectorReplicate( float( double( mid ) / LINEAR_MAX ) );
+
+            uint32_t texel;
+            if ( !_StoreScanlineLinear( &texel, sizeof(texel), DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, v, 1, TEX_FILTER_SRGB ) )
+                return false;
+
+            if ( ( texel & 0xFF ) >= code )
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+
+        tables.threshold[ code ] = std::min<uint32_t>( lo, LINEAR_MAX );
+    }
+
+    uint32_t code = 0;
+    for( uint32_t i = 0; i < 4096; ++i )
+    {
+        while( code < 255 && tables.threshold[ code + 1 ] <= ( i << 12 ) )
+            ++code;
+        tables.coarse[ i ] = static_cast<uint8_t>( code );
+    }
+
+    return true;
+}
+
+static inline uint8_t _PremultiplySRGB( _In_ uint8_t c, _In_ uint32_t a, _In_ const _PMAlphaTables& tables )
+{
+    uint32_t l = ( tables.linear[ c ] * a + 127 ) / 255;
+
+    uint32_t code = tables.coarse[ l >> 12 ];
+    while( code < 255 && tables.threshold[ code + 1 ] <= l )
+        ++code;
+
+    return static_cast<uint8_t>( code );
+}
+
+static void _PremultiplyRow8( _Out_writes_(count*4) uint8_t* pDest, _In_reads_(count*4) const uint8_t* pSrc, _In_ size_t count )
+{
+    size_t i = 0;
+
+#if defined(_XM_SSE_INTRINSICS_)
+    // c * a / 255 rounded as ( t + ( t >> 8 ) ) >> 8 with t = c * a + 128, four pixels at a time
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16( 128 );
+    const __m128i alphaMask = _mm_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0 );
+
+    for( ; ( i + 4 ) <= count; i += 4 )
+    {
+        __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + i * 4 ) );
+
+        __m128i c[2] = { _mm_unpacklo_epi8( v, zero ), _mm_unpackhi_epi8( v, zero ) };
+        for( size_t j = 0; j < 2; ++j )
+        {
+            __m128i a = _mm_shufflehi_epi16( _mm_shufflelo_epi16( c[ j ], _MM_SHUFFLE(3,3,3,3) ), _MM_SHUFFLE(3,3,3,3) );
+            __m128i t = _mm_add_epi16( _mm_mullo_epi16( c[ j ], a ), bias );
+            t = _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+            c[ j ] = _mm_or_si128( _mm_andnot_si128( alphaMask, t ), _mm_and_si128( alphaMask, c[ j ] ) );
+        }
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pDest + i * 4 ), _mm_packus_epi16( c[0], c[1] ) );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        const uint8_t* sPtr = pSrc + i * 4;
+        uint8_t* dPtr = pDest + i * 4;
+
+        const uint32_t a = sPtr[3];
+        for( size_t j = 0; j < 3; ++j )
+        {
+            uint32_t t = sPtr[ j ] * a + 128;
+            dPtr[ j ] = static_cast<uint8_t>( ( t + ( t >> 8 ) ) >> 8 );
+        }
+        dPtr[3] = sPtr[3];
+    }
+}
+
+static void _PremultiplyRow8SRGB( _Out_writes_(count*4) uint8_t* pDest, _In_reads_(count*4) const uint8_t* pSrc, _In_ size_t count,
+                                  _In_ const _PMAlphaTables& tables )
+{
+    for( size_t i = 0; i < count; ++i )
+    {
+        const uint8_t* sPtr = pSrc + i * 4;
+        uint8_t* dPtr = pDest + i * 4;
+
+        const uint32_t a = sPtr[3];
+        if ( a == 255 )
+        {
+            *reinterpret_cast<uint32_t*>( dPtr ) = *reinterpret_cast<const uint32_t*>( sPtr );
+            continue;
+        }
+
+        dPtr[0] = _PremultiplySRGB( sPtr[0], a, tables );
+        dPtr[1] = _PremultiplySRGB( sPtr[1], a, tables );
+        dPtr[2] = _PremultiplySRGB( sPtr[2], a, tables );
+        dPtr[3] = sPtr[3];
+    }
+}
+
+static void _PremultiplyRow16( _Out_writes_(count*4) uint16_t* pDest, _In_reads_(count*4) const uint16_t* pSrc, _In_ size_t count )
+{
+    size_t i = 0;
+
+#if defined(_XM_SSE_INTRINSICS_)
+    // c * a / 65535 rounded as ( t + ( t >> 16 ) ) >> 16 with t = c * a + 32768, two pixels at a time
+    const __m128i bias = _mm_set1_epi32( 32768 );
+    const __m128i sign = _mm_set1_epi16( -32768 );
+    const __m128i alphaMask = _mm_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0 );
+
+    for( ; ( i + 2 ) <= count; i += 2 )
+    {
+        __m128i c = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + i * 4 ) );
+        __m128i a = _mm_shufflehi_epi16( _mm_shufflelo_epi16( c, _MM_SHUFFLE(3,3,3,3) ), _MM_SHUFFLE(3,3,3,3) );
+
+        __m128i plo = _mm_mullo_epi16( c, a );
+        __m128i phi = _mm_mulhi_epu16( c, a );
+
+        __m128i t0 = _mm_add_epi32( _mm_unpacklo_epi16( plo, phi ), bias );
+        __m128i t1 = _mm_add_epi32( _mm_unpackhi_epi16( plo, phi ), bias );
+        t0 = _mm_srli_epi32( _mm_add_epi32( t0, _mm_srli_epi32( t0, 16 ) ), 16 );
+        t1 = _mm_srli_epi32( _mm_add_epi32( t1, _mm_srli_epi32( t1, 16 ) ), 16 );
+
+        // SSE2 only has a signed 32 -> 16 pack, so offset into signed range and back
+        t0 = _mm_sub_epi32( t0, bias );
+        t1 = _mm_sub_epi32( t1, bias );
+        __m128i r = _mm_xor_si128( _mm_packs_epi32( t0, t1 ), sign );
+
+        r = _mm_or_si128( _mm_andnot_si128( alphaMask, r ), _mm_and_si128( alphaMask, c ) );
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pDest + i * 4 ), r );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        const uint16_t* sPtr = pSrc + i * 4;
+        uint16_t* dPtr = pDest + i * 4;
+
+        const uint32_t a = sPtr[3];
+        for( size_t j = 0; j < 3; ++j )
+        {
+            uint32_t t = sPtr[ j ] * a + 32768;
+            dPtr[ j ] = static_cast<uint16_t>( ( t + ( t >> 16 ) ) >> 16 );
+        }
+        dPtr[3] = sPtr[3];
+    }
+}
+
+//-------------------------------------------------------------------------------------
+// Returns true if the integer path applies; srgb is set if it must work in linear space
+//-------------------------------------------------------------------------------------
+static bool _UseIntegerPMAlpha( _In_ DXGI_FORMAT format, _In_ DWORD flags, _Out_ bool& srgb )
+{
+    srgb = false;
+
+    switch( format )
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        if ( !( flags & TEX_PMALPHA_IGNORE_SRGB ) )
+        {
+            if ( format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB )
+                flags |= TEX_PMALPHA_SRGB;
+
+            // Mixed conversions (only in or only out) go through the floating-point path
+            switch( flags & TEX_PMALPHA_SRGB )
+            {
+            case 0:                     break;
+            case TEX_PMALPHA_SRGB:      srgb = true; break;
+            default:                    return false;
+            }
+        }
+        return true;
+
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+        return ( flags & TEX_PMALPHA_IGNORE_SRGB ) || !( flags & TEX_PMALPHA_SRGB );
+
+    default:
+        return false;
+    }
+}
+
+static HRESULT _CreatePMAlphaTables( _In_ DXGI_FORMAT format, _In_ DWORD flags, _Inout_ std::unique_ptr<_PMAlphaTables>& tables )
+{
+    // The sRGB tables only depend on the format, so build them once per call rather than per image
+    bool srgb;
+    if ( !_UseIntegerPMAlpha( format, flags, srgb ) || !srgb )
+        return S_OK;
+
+    tables.reset( new (std::nothrow) _PMAlphaTables );
+    if ( !tables )
+        return E_OUTOFMEMORY;
+
+    if ( !_BuildPMAlphaTables( *tables ) )
+    {
+        tables.reset();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+static HRESULT _PremultiplyAlphaInteger( _In_ const Image& srcImage, _In_ bool srgb, _In_opt_ const _PMAlphaTables* tables,
+                                         _In_ const Image& destImage )
+{
+    assert( srcImage.width == destImage.width );
+    assert( srcImage.height == destImage.height );
+    assert( srcImage.format == destImage.format );
+
+    const uint8_t *pSrc = srcImage.pixels;
+    uint8_t *pDest = destImage.pixels;
+    if ( !pSrc || !pDest )
+        return E_POINTER;
+
+    if ( srgb && !tables )
+        return E_POINTER;
+
+    const bool wide = ( srcImage.format == DXGI_FORMAT_R16G16B16A16_UNORM );
+
+    for( size_t h = 0; h < srcImage.height; ++h )
+    {
+        if ( wide )
+        {
+            _PremultiplyRow16( reinterpret_cast<uint16_t*>( pDest ), reinterpret_cast<const uint16_t*>( pSrc ), srcImage.width );
+        }
+        else if ( srgb )
+        {
+            _PremultiplyRow8SRGB( pDest, pSrc, srcImage.width, *tables );
+        }
+        else
+        {
+            _PremultiplyRow8( pDest, pSrc, srcImage.width );
+        }
+
+        pSrc += srcImage.rowPitch;
+        pDest += destImage.rowPitch;
+    }
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Floating-point premultiply for all other formats
+//-------------------------------------------------------------------------------------
 static HRESULT _PremultiplyAlpha( _In_ const Image& srcImage, _In_ const Image& destImage )
 {
     assert( srcImage.width == destImage.width );
@@ -100,6 +394,17 @@ static HRESULT _PremultiplyAlphaLinear( _In_ const Image& srcImage, _In_ DWORD f
 }
 
 
+static HRESULT _PremultiplyAlphaImage( _In_ const Image& srcImage, _In_ DWORD flags, _In_opt_ const _PMAlphaTables* tables,
+                                       _In_ const Image& destImage )
+{
+    bool srgb;
+    if ( _UseIntegerPMAlpha( srcImage.format, flags, srgb ) )
+        return _PremultiplyAlphaInteger( srcImage, srgb, tables, destImage );
+
+    return ( flags & TEX_PMALPHA_IGNORE_SRGB ) ? _PremultiplyAlpha( srcImage, destImage ) : _PremultiplyAlphaLinear( srcImage, flags, destImage );
+}
+
+
 //=====================================================================================
 // Entry-points
 //=====================================================================================
@@ -124,7 +429,12 @@ HRESULT PremultiplyAlpha( const Image& srcImage, DWORD flags, ScratchImage& imag
         return E_INVALIDARG;
 #endif
 
-    HRESULT hr = image.Initialize2D( srcImage.format, srcImage.width, srcImage.height, 1, 1 );
+    std::unique_ptr<_PMAlphaTables> tables;
+    HRESULT hr = _CreatePMAlphaTables( srcImage.format, flags, tables );
+    if ( FAILED(hr) )
+        return hr;
+
+    hr = image.Initialize2D( srcImage.format, srcImage.width, srcImage.height, 1, 1 );
     if ( FAILED(hr) )
         return hr;
    
@@ -135,7 +445,7 @@ HRESULT PremultiplyAlpha( const Image& srcImage, DWORD flags, ScratchImage& imag
         return E_POINTER;
     }
 
-    hr = ( flags & TEX_PMALPHA_IGNORE_SRGB ) ? _PremultiplyAlpha( srcImage, *rimage ) : _PremultiplyAlphaLinear( srcImage, flags, *rimage );
+    hr = _PremultiplyAlphaImage( srcImage, flags, tables.get(), *rimage );
     if ( FAILED(hr) )
     {
         image.Release();
@@ -172,9 +482,14 @@ HRESULT PremultiplyAlpha( const Image* srcImages, size_t nimages, const TexMetad
         return E_FAIL;
     }
 
+    std::unique_ptr<_PMAlphaTables> tables;
+    HRESULT hr = _CreatePMAlphaTables( metadata.format, flags, tables );
+    if ( FAILED(hr) )
+        return hr;
+
     TexMetadata mdata2 = metadata;
     mdata2.SetAlphaMode(TEX_ALPHA_MODE_PREMULTIPLIED);
-    HRESULT hr = result.Initialize( mdata2 );
+    hr = result.Initialize( mdata2 );
     if ( FAILED(hr) )
         return hr;
 
@@ -213,7 +528,7 @@ HRESULT PremultiplyAlpha( const Image* srcImages, size_t nimages, const TexMetad
             return E_FAIL;
         }
 
-        hr = ( flags & TEX_PMALPHA_IGNORE_SRGB ) ? _PremultiplyAlpha( src, dst ) : _PremultiplyAlphaLinear( src, flags, dst );
+        hr = _PremultiplyAlphaImage( src, flags, tables.get(), dst );
         if ( FAILED(hr) )
         {
             result.Release();
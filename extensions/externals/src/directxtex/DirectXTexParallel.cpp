@@ -0,0 +1,254 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexParallel.cpp
+//
+// DirectX Texture Library - Work-stealing task scheduler for parallel operations
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#include "directxtexp.h"
+
+#include <process.h>
+
+namespace DirectX
+{
+
+static size_t s_maxThreads = 0;
+
+//-------------------------------------------------------------------------------------
+// Each worker owns a range of items; it takes items from the front of its own range
+// and, once that is empty, steals the back half of another worker's range
+//-------------------------------------------------------------------------------------
+struct _WorkRange
+{
+    CRITICAL_SECTION    cs;
+    size_t              begin;
+    size_t              end;
+    uint8_t             pad[64];    // Keeps the ranges of different workers off the same cache line
+};
+
+struct _WorkQueue
+{
+    PARALLEL_TASK       pfTask;
+    void*               pContext;
+    _WorkRange*         ranges;
+    size_t              nWorkers;
+    volatile LONG       failed;
+};
+
+struct _WorkerParam
+{
+    _WorkQueue*         queue;
+    size_t              index;
+};
+
+//-------------------------------------------------------------------------------------
+static bool _TakeItem( _Inout_ _WorkRange& range, _Out_ size_t& item )
+{
+    bool result = false;
+
+    EnterCriticalSection( &range.cs );
+    if ( range.begin < range.end )
+    {
+        item = range.begin++;
+        result = true;
+    }
+    LeaveCriticalSection( &range.cs );
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------
+static bool _StealItems( _Inout_ _WorkQueue& queue, _In_ size_t self )
+{
+    for( size_t k = 1; k < queue.nWorkers; ++k )
+    {
+        _WorkRange& victim = queue.ranges[ ( self + k ) % queue.nWorkers ];
+
+        size_t begin = 0;
+        size_t end = 0;
+
+        EnterCriticalSection( &victim.cs );
+        if ( victim.begin < victim.end )
+        {
+            size_t count = ( victim.end - victim.begin + 1 ) / 2;
+            end = victim.end;
+            begin = end - count;
+            victim.end = begin;
+        }
+        LeaveCriticalSection( &victim.cs );
+
+        if ( begin < end )
+        {
+            // Only this worker adds to its own range, and it is empty at this point
+            _WorkRange& range = queue.ranges[ self ];
+            EnterCriticalSection( &range.cs );
+            range.begin = begin;
+            range.end = end;
+            LeaveCriticalSection( &range.cs );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//-------------------------------------------------------------------------------------
+static void _RunWorker( _Inout_ _WorkQueue& queue, _In_ size_t self )
+{
+    _WorkRange& range = queue.ranges[ self ];
+
+    for(;;)
+    {
+        size_t item;
+        while ( _TakeItem( range, item ) )
+        {
+            if ( queue.failed )
+                return;
+
+            if ( !queue.pfTask( item, queue.pContext ) )
+            {
+                InterlockedExchange( &queue.failed, 1 );
+                return;
+            }
+        }
+
+        // Items are never added once the work starts, so when there is nothing
+        // left to steal every remaining item is already owned by a running worker
+        if ( !_StealItems( queue, self ) )
+            return;
+    }
+}
+
+static unsigned __stdcall _WorkerThreadProc( _In_ void* pParam )
+{
+    _WorkerParam* param = reinterpret_cast<_WorkerParam*>( pParam );
+    _RunWorker( *param->queue, param->index );
+    return 0;
+}
+
+
+//=====================================================================================
+// Internal functions
+//=====================================================================================
+
+//-------------------------------------------------------------------------------------
+// Returns the number of workers to use for the given number of items
+//-------------------------------------------------------------------------------------
+size_t _GetThreadCount( size_t nItems )
+{
+    size_t nThreads = s_maxThreads;
+    if ( !nThreads )
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo( &info );
+        nThreads = info.dwNumberOfProcessors;
+    }
+
+    return std::max<size_t>( 1, std::min<size_t>( nThreads, nItems ) );
+}
+
+
+//-------------------------------------------------------------------------------------
+// Runs pfTask for every item in [0, nItems) on a pool of worker threads; the calling
+// thread is one of the workers. Fails if any task fails, skipping the remaining items
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT _ParallelFor( size_t nItems, PARALLEL_TASK pfTask, void* pContext )
+{
+    if ( !pfTask )
+        return E_INVALIDARG;
+
+    if ( !nItems )
+        return S_OK;
+
+    const size_t nWorkers = _GetThreadCount( nItems );
+    if ( nWorkers == 1 )
+    {
+        for( size_t item = 0; item < nItems; ++item )
+        {
+            if ( !pfTask( item, pContext ) )
+                return E_FAIL;
+        }
+
+        return S_OK;
+    }
+
+    std::unique_ptr<_WorkRange[]> ranges( new (std::nothrow) _WorkRange[ nWorkers ] );
+    std::unique_ptr<_WorkerParam[]> params( new (std::nothrow) _WorkerParam[ nWorkers ] );
+    std::unique_ptr<HANDLE[]> threads( new (std::nothrow) HANDLE[ nWorkers ] );
+    if ( !ranges || !params || !threads )
+        return E_OUTOFMEMORY;
+
+    _WorkQueue queue;
+    queue.pfTask = pfTask;
+    queue.pContext = pContext;
+    queue.ranges = ranges.get();
+    queue.nWorkers = nWorkers;
+    queue.failed = 0;
+
+    // Start with an even split; stealing rebalances uneven item costs
+    for( size_t i = 0; i < nWorkers; ++i )
+    {
+        InitializeCriticalSection( &ranges[ i ].cs );
+        ranges[ i ].begin = ( nItems * i ) / nWorkers;
+        ranges[ i ].end = ( nItems * ( i + 1 ) ) / nWorkers;
+
+        params[ i ].queue = &queue;
+        params[ i ].index = i;
+    }
+
+    // If a thread can't be created the other workers steal its items
+    size_t nThreads = 0;
+    for( size_t i = 1; i < nWorkers; ++i )
+    {
+        HANDLE hThread = reinterpret_cast<HANDLE>( _beginthreadex( nullptr, 0, _WorkerThreadProc, &params[ i ], 0, nullptr ) );
+        if ( hThread )
+        {
+            threads[ nThreads++ ] = hThread;
+        }
+    }
+
+    _RunWorker( queue, 0 );
+
+    for( size_t i = 0; i < nThreads; ++i )
+    {
+        WaitForSingleObject( threads[ i ], INFINITE );
+        CloseHandle( threads[ i ] );
+    }
+
+    for( size_t i = 0; i < nWorkers; ++i )
+    {
+        DeleteCriticalSection( &ranges[ i ].cs );
+    }
+
+    return ( queue.failed ) ? E_FAIL : S_OK;
+}
+
+
+//=====================================================================================
+// Entry-points
+//=====================================================================================
+
+//-------------------------------------------------------------------------------------
+// Thread count used by parallel operations
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void SetMaxThreadCount( size_t threads )
+{
+    s_maxThreads = threads;
+}
+
+size_t GetMaxThreadCount()
+{
+    return s_maxThreads;
+}
+
+}; // namespace
@@ -0,0 +1,592 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexPipeline.cpp
+//
+// DirectX Texture Library - Fused conversion, mip-map generation, and compression
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#include "directxtexp.h"
+
+#include "filters.h"
+
+namespace DirectX
+{
+
+extern bool _CalculateMipLevels( _In_ size_t width, _In_ size_t height, _Inout_ size_t& mipLevels );
+
+// The top level is pushed through the pipeline in bands of whole block rows of at least this many texels
+static const size_t PIPELINE_BAND_TEXELS = 65536;
+
+// Each conversion task handles whole block rows of at least this many texels
+static const size_t PIPELINE_CONVERT_TEXELS = 8192;
+
+// Alpha threshold used when converting to formats with 1-bit alpha
+static const float PIPELINE_THRESHOLD = 0.5f;
+
+inline static bool ispow2( _In_ size_t x )
+{
+    return ((x != 0) && !(x & (x - 1)));
+}
+
+//-------------------------------------------------------------------------------------
+// Each mip level only holds the rows that are still waiting to be compressed or that
+// the next level down still has to read
+//-------------------------------------------------------------------------------------
+struct _PipelineLevel
+{
+    size_t                      width;
+    size_t                      height;
+    size_t                      rowPitch;
+    const Image*                source;     // The level is the source image itself (top level without conversion)
+    std::unique_ptr<uint8_t[]>  buffer;     // Rows [base, base + count) of the level
+    size_t                      capacity;
+    size_t                      base;
+    size_t                      count;
+    size_t                      emitted;    // Rows copied or compressed into the result so far
+    SeparableFilter             fx;         // Filters from the level above to this level
+    SeparableFilter             fy;
+    std::unique_ptr<size_t[]>   firstRow;   // Lowest row of the level above that this row or any later row reads
+    std::unique_ptr<size_t[]>   lastRow;    // Highest row of the level above that this row reads
+
+    _PipelineLevel() : width(0), height(0), rowPitch(0), source(nullptr), capacity(0), base(0), count(0), emitted(0) {}
+};
+
+struct _Pipeline
+{
+    std::unique_ptr<_PipelineLevel[]>   levels;
+    size_t                              nlevels;
+    DXGI_FORMAT                         mipFormat;
+    DXGI_FORMAT                         format;
+    DWORD                               filter;
+    DWORD                               compress;
+    float                               alphaRef;
+    const ScratchImage*                 result;
+    SeparableFilter                     fz;
+};
+
+static Image _GetRows( _In_ const _PipelineLevel& level, _In_ DXGI_FORMAT format, _In_ size_t y, _In_ size_t nrows )
+{
+    assert( y >= level.base && ( y + nrows ) <= ( level.base + level.count ) );
+
+    Image img;
+    img.width = level.width;
+    img.height = nrows;
+    img.format = format;
+    img.rowPitch = level.rowPitch;
+    img.slicePitch = level.rowPitch * nrows;
+    img.pixels = ( level.source ) ? level.source->pixels + ( y * level.rowPitch )
+                                  : level.buffer.get() + ( ( y - level.base ) * level.rowPitch );
+    return img;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Drops the rows no longer needed and makes room for nrows more
+//-------------------------------------------------------------------------------------
+static HRESULT _ReserveRows( _Inout_ _Pipeline& pipeline, _In_ size_t index, _In_ size_t nrows )
+{
+    _PipelineLevel& level = pipeline.levels[ index ];
+    assert( !level.source );
+
+    size_t keep = level.emitted;
+    if ( ( index + 1 ) < pipeline.nlevels )
+    {
+        const _PipelineLevel& next = pipeline.levels[ index + 1 ];
+        const size_t produced = next.base + next.count;
+        if ( produced < next.height )
+            keep = std::min<size_t>( keep, next.firstRow[ produced ] );
+    }
+
+    assert( keep >= level.base && keep <= ( level.base + level.count ) );
+
+    const size_t drop = keep - level.base;
+    if ( drop > 0 )
+    {
+        level.count -= drop;
+        level.base = keep;
+
+        if ( level.count > 0 )
+            memmove( level.buffer.get(), level.buffer.get() + ( drop * level.rowPitch ), level.count * level.rowPitch );
+    }
+
+    if ( ( level.count + nrows ) > level.capacity )
+    {
+        // Filters that wrap keep the whole level, so grow as needed
+        size_t capacity = std::max<size_t>( level.count + nrows, level.capacity * 2 );
+
+        std::unique_ptr<uint8_t[]> buffer( new (std::nothrow) uint8_t[ capacity * level.rowPitch ] );
+        if ( !buffer )
+            return E_OUTOFMEMORY;
+
+        if ( level.count > 0 )
+            memcpy( buffer.get(), level.buffer.get(), level.count * level.rowPitch );
+
+        level.buffer.swap( buffer );
+        level.capacity = capacity;
+    }
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Converts a band of source rows into the top level, in chunks of block rows
+//-------------------------------------------------------------------------------------
+struct _ConvertBandContext
+{
+    Image   srcImage;
+    Image   destImage;
+    DWORD   filter;
+    size_t  taskRows;
+};
+
+static bool _ConvertChunk( _In_ size_t task, _In_opt_ void* pContext )
+{
+    const _ConvertBandContext* context = reinterpret_cast<const _ConvertBandContext*>( pContext );
+    assert( context );
+
+    const size_t y = task * context->taskRows;
+    const size_t nrows = std::min<size_t>( context->taskRows, context->srcImage.height - y );
+
+    Image src = context->srcImage;
+    src.height = nrows;
+    src.pixels += y * src.rowPitch;
+
+    Image dest = context->destImage;
+    dest.height = nrows;
+    dest.pixels += y * dest.rowPitch;
+
+    return SUCCEEDED( _ConvertRows( src, context->filter, dest, PIPELINE_THRESHOLD ) );
+}
+
+static HRESULT _ConvertBand( _In_ const _Pipeline& pipeline, _In_ const Image& srcImage, _In_ const Image& destImage )
+{
+    _ConvertBandContext context;
+    context.srcImage = srcImage;
+    context.destImage = destImage;
+    context.filter = pipeline.filter;
+    context.taskRows = std::max<size_t>( 4, ( ( PIPELINE_CONVERT_TEXELS / srcImage.width ) + 3 ) & ~size_t(3) );
+
+    const size_t ntasks = ( srcImage.height + context.taskRows - 1 ) / context.taskRows;
+
+    if ( pipeline.compress & TEX_COMPRESS_PARALLEL )
+        return _ParallelFor( ntasks, _ConvertChunk, &context );
+
+    for( size_t task = 0; task < ntasks; ++task )
+    {
+        if ( !_ConvertChunk( task, &context ) )
+            return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Copies or compresses the finished rows of a level into the result
+//-------------------------------------------------------------------------------------
+static HRESULT _EmitRows( _Inout_ _Pipeline& pipeline, _In_ size_t index )
+{
+    _PipelineLevel& level = pipeline.levels[ index ];
+
+    const bool compressed = IsCompressed( pipeline.format );
+
+    size_t end = level.base + level.count;
+    if ( compressed && end < level.height )
+    {
+        // Only whole block rows until the bottom edge
+        end &= ~size_t(3);
+    }
+
+    if ( end <= level.emitted )
+        return S_OK;
+
+    const Image* dest = pipeline.result->GetImage( index, 0, 0 );
+    if ( !dest )
+        return E_POINTER;
+
+    const size_t nrows = end - level.emitted;
+    Image src = _GetRows( level, pipeline.mipFormat, level.emitted, nrows );
+
+    if ( compressed )
+    {
+        Image blocks = *dest;
+        blocks.height = nrows;
+        blocks.pixels += ( level.emitted >> 2 ) * dest->rowPitch;
+        blocks.slicePitch = ( ( nrows + 3 ) >> 2 ) * dest->rowPitch;
+
+        HRESULT hr = _CompressImages( &src, &blocks, 1, pipeline.compress, pipeline.alphaRef );
+        if ( FAILED(hr) )
+            return hr;
+    }
+    else
+    {
+        const size_t rowPitch = std::min<size_t>( src.rowPitch, dest->rowPitch );
+
+        const uint8_t* pSrc = src.pixels;
+        uint8_t* pDest = dest->pixels + ( level.emitted * dest->rowPitch );
+        for( size_t y = 0; y < nrows; ++y )
+        {
+            memcpy_s( pDest, dest->rowPitch, pSrc, rowPitch );
+            pSrc += src.rowPitch;
+            pDest += dest->rowPitch;
+        }
+    }
+
+    level.emitted = end;
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Emits the new rows of a level, then filters every row of the next level whose source
+// rows are now all available and carries on down the chain
+//-------------------------------------------------------------------------------------
+static HRESULT _AdvanceLevel( _Inout_ _Pipeline& pipeline, _In_ size_t index )
+{
+    HRESULT hr = _EmitRows( pipeline, index );
+    if ( FAILED(hr) )
+        return hr;
+
+    if ( ( index + 1 ) >= pipeline.nlevels )
+        return S_OK;
+
+    const _PipelineLevel& level = pipeline.levels[ index ];
+    _PipelineLevel& next = pipeline.levels[ index + 1 ];
+
+    const size_t produced = level.base + level.count;
+
+    const size_t y0 = next.base + next.count;
+    size_t y1 = y0;
+    while ( y1 < next.height && next.lastRow[ y1 ] < produced )
+        ++y1;
+
+    if ( y1 == y0 )
+        return S_OK;
+
+    hr = _ReserveRows( pipeline, index + 1, y1 - y0 );
+    if ( FAILED(hr) )
+        return hr;
+
+    // Rebase the vertical filter on the rows the level above still holds
+    const SeparableFilter& fy = next.fy;
+
+    SeparableFilter band;
+    hr = _AllocateSeparableFilter( level.count, y1 - y0, fy.taps, band );
+    if ( FAILED(hr) )
+        return hr;
+
+    for( size_t y = y0; y < y1; ++y )
+    {
+        const FilterTap* tap = &fy.tap[ y * fy.taps ];
+        FilterTap* dest = &band.tap[ ( y - y0 ) * fy.taps ];
+        for( size_t k = 0; k < fy.taps; ++k )
+        {
+            if ( tap[ k ].weight == 0.f )
+                continue;
+
+            assert( tap[ k ].u >= level.base && tap[ k ].u < produced );
+            dest[ k ].u = tap[ k ].u - level.base;
+            dest[ k ].weight = tap[ k ].weight;
+        }
+    }
+
+    next.count += y1 - y0;
+
+    Image src = _GetRows( level, pipeline.mipFormat, level.base, level.count );
+    Image dest = _GetRows( next, pipeline.mipFormat, y0, y1 - y0 );
+
+    hr = _ResizeSeparable( &src, 1, &dest, 1, 1, next.fx, band, pipeline.fz, pipeline.filter );
+    if ( FAILED(hr) )
+        return hr;
+
+    return _AdvanceLevel( pipeline, index + 1 );
+}
+
+
+//-------------------------------------------------------------------------------------
+// Sets up the filters of a level and the range of rows above that each of its rows reads
+//-------------------------------------------------------------------------------------
+static HRESULT _SetupLevel( _Inout_ _PipelineLevel& level, _In_ const _PipelineLevel& above, _In_ DWORD filter )
+{
+    HRESULT hr = _CreateSeparableFilter( filter, above.width, level.width, (filter & TEX_FILTER_WRAP_U) != 0, (filter & TEX_FILTER_MIRROR_U) != 0, level.fx );
+    if ( FAILED(hr) )
+        return hr;
+
+    hr = _CreateSeparableFilter( filter, above.height, level.height, (filter & TEX_FILTER_WRAP_V) != 0, (filter & TEX_FILTER_MIRROR_V) != 0, level.fy );
+    if ( FAILED(hr) )
+        return hr;
+
+    level.firstRow.reset( new (std::nothrow) size_t[ level.height ] );
+    level.lastRow.reset( new (std::nothrow) size_t[ level.height ] );
+    if ( !level.firstRow || !level.lastRow )
+        return E_OUTOFMEMORY;
+
+    const SeparableFilter& fy = level.fy;
+
+    size_t first = above.height;
+    for( size_t y = level.height; y-- > 0; )
+    {
+        const FilterTap* tap = &fy.tap[ y * fy.taps ];
+
+        // Taps with no weight are padding and never read
+        size_t last = 0;
+        for( size_t k = 0; k < fy.taps; ++k )
+        {
+            if ( tap[ k ].weight == 0.f )
+                continue;
+
+            first = std::min<size_t>( first, tap[ k ].u );
+            last = std::max<size_t>( last, tap[ k ].u );
+        }
+
+        level.firstRow[ y ] = first;
+        level.lastRow[ y ] = last;
+    }
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Runs the stages one after another for the cases the pipeline doesn't stream
+//-------------------------------------------------------------------------------------
+static HRESULT _ProcessTextureSerial( _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ DWORD filter, _In_ size_t levels,
+                                      _In_ DWORD compress, _In_ float alphaRef, _Out_ ScratchImage& result )
+{
+    filter |= TEX_FILTER_FORCE_NON_WIC;
+    filter &= ~TEX_FILTER_FORCE_WIC;
+
+    const DXGI_FORMAT mipFormat = IsCompressed( format ) ? srcImage.format : format;
+
+    ScratchImage converted;
+    const Image* baseImage = &srcImage;
+    if ( srcImage.format != mipFormat )
+    {
+        HRESULT hr = Convert( srcImage, mipFormat, filter, PIPELINE_THRESHOLD, converted );
+        if ( FAILED(hr) )
+            return hr;
+
+        baseImage = converted.GetImage( 0, 0, 0 );
+        if ( !baseImage )
+            return E_POINTER;
+    }
+
+    if ( !IsCompressed( format ) )
+    {
+        if ( levels > 1 )
+            return GenerateMipMaps( *baseImage, filter, levels, result );
+
+        return result.InitializeFromImage( *baseImage );
+    }
+
+    if ( levels > 1 )
+    {
+        ScratchImage mipChain;
+        HRESULT hr = GenerateMipMaps( *baseImage, filter, levels, mipChain );
+        if ( FAILED(hr) )
+            return hr;
+
+        return Compress( mipChain.GetImages(), mipChain.GetImageCount(), mipChain.GetMetadata(), format, compress, alphaRef, result );
+    }
+
+    return Compress( *baseImage, format, compress, alphaRef, result );
+}
+
+
+//=====================================================================================
+// Entry-points
+//=====================================================================================
+
+//-------------------------------------------------------------------------------------
+// Convert, generate mip-maps, and compress in bands of rows
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT ProcessTexture( const Image& srcImage, DXGI_FORMAT format, DWORD filter, size_t levels,
+                        DWORD compress, float alphaRef, ScratchImage& result )
+{
+    if ( !IsValid( srcImage.format ) || !IsValid( format ) || IsTypeless( format ) )
+        return E_INVALIDARG;
+
+    if ( !srcImage.pixels )
+        return E_POINTER;
+
+    if ( IsCompressed( srcImage.format ) || IsVideo( srcImage.format ) || IsVideo( format ) )
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+
+    if ( !_CalculateMipLevels( srcImage.width, srcImage.height, levels ) )
+        return E_INVALIDARG;
+
+    static_assert( TEX_FILTER_POINT == 0x100000, "TEX_FILTER_ flag values don't match TEX_FILTER_MASK" );
+
+    DWORD filter_select = ( filter & TEX_FILTER_MASK );
+    if ( !filter_select )
+    {
+        // Default filter choice
+        filter_select = ( ispow2(srcImage.width) && ispow2(srcImage.height) ) ? TEX_FILTER_BOX : TEX_FILTER_LINEAR;
+    }
+
+    bool streamed = !( filter & TEX_FILTER_DITHER_DIFFUSION );
+    if ( levels > 1 )
+    {
+        switch( filter_select )
+        {
+        case TEX_FILTER_BOX:
+            if ( !ispow2(srcImage.width) || !ispow2(srcImage.height) )
+                streamed = false;
+            break;
+
+        case TEX_FILTER_LINEAR:
+        case TEX_FILTER_CUBIC:
+        case TEX_FILTER_TRIANGLE:
+        case TEX_FILTER_LANCZOS:
+        case TEX_FILTER_KAISER:
+            break;
+
+        default:
+            streamed = false;
+            break;
+        }
+    }
+
+    if ( !streamed )
+    {
+        HRESULT hr = _ProcessTextureSerial( srcImage, format, filter, levels, compress, alphaRef, result );
+        if ( FAILED(hr) )
+            result.Release();
+        return hr;
+    }
+
+    _Pipeline pipeline;
+    pipeline.levels.reset( new (std::nothrow) _PipelineLevel[ levels ] );
+    if ( !pipeline.levels )
+        return E_OUTOFMEMORY;
+
+    pipeline.nlevels = levels;
+    pipeline.mipFormat = IsCompressed( format ) ? srcImage.format : format;
+    pipeline.format = format;
+    pipeline.filter = ( filter & ~TEX_FILTER_MASK ) | filter_select;
+    pipeline.compress = compress;
+    pipeline.alphaRef = alphaRef;
+    pipeline.result = &result;
+
+    HRESULT hr = _CreateSeparableIdentity( 1, pipeline.fz );
+    if ( FAILED(hr) )
+        return hr;
+
+    // Set up the levels
+    size_t width = srcImage.width;
+    size_t height = srcImage.height;
+    for( size_t index = 0; index < levels; ++index )
+    {
+        _PipelineLevel& level = pipeline.levels[ index ];
+        level.width = width;
+        level.height = height;
+
+        if ( !index && srcImage.format == pipeline.mipFormat )
+        {
+            level.source = &srcImage;
+            level.rowPitch = srcImage.rowPitch;
+        }
+        else
+        {
+            size_t slicePitch;
+            ComputePitch( pipeline.mipFormat, width, height, level.rowPitch, slicePitch, CP_FLAGS_NONE );
+        }
+
+        if ( index > 0 )
+        {
+            hr = _SetupLevel( level, pipeline.levels[ index - 1 ], pipeline.filter );
+            if ( FAILED(hr) )
+                return hr;
+        }
+
+        if ( height > 1 )
+            height >>= 1;
+
+        if ( width > 1 )
+            width >>= 1;
+    }
+
+    hr = result.Initialize2D( format, srcImage.width, srcImage.height, 1, levels );
+    if ( FAILED(hr) )
+        return hr;
+
+    // Feed the source through in bands
+    _PipelineLevel& top = pipeline.levels[ 0 ];
+
+    const size_t bandHeight = std::max<size_t>( 4, ( PIPELINE_BAND_TEXELS / srcImage.width ) & ~size_t(3) );
+
+    for( size_t y = 0; y < srcImage.height; y += bandHeight )
+    {
+        const size_t nrows = std::min<size_t>( bandHeight, srcImage.height - y );
+
+        if ( top.source )
+        {
+            top.count += nrows;
+        }
+        else
+        {
+            hr = _ReserveRows( pipeline, 0, nrows );
+            if ( FAILED(hr) )
+                break;
+
+            top.count += nrows;
+
+            Image src = srcImage;
+            src.height = nrows;
+            src.pixels += y * srcImage.rowPitch;
+
+            hr = _ConvertBand( pipeline, src, _GetRows( top, pipeline.mipFormat, y, nrows ) );
+            if ( FAILED(hr) )
+                break;
+        }
+
+        hr = _AdvanceLevel( pipeline, 0 );
+        if ( FAILED(hr) )
+            break;
+    }
+
+    if ( SUCCEEDED(hr) )
+    {
+        for( size_t index = 0; index < levels; ++index )
+        {
+            if ( pipeline.levels[ index ].emitted != pipeline.levels[ index ].height )
+            {
+                hr = E_FAIL;
+                break;
+            }
+        }
+    }
+
+    if ( FAILED(hr) )
+        result.Release();
+
+    return hr;
+}
+
+_Use_decl_annotations_
+HRESULT ProcessTexture( const Image& srcImage, DXGI_FORMAT format, DWORD filter, size_t levels,
+                        DWORD compress, float alphaRef, DWORD ddsFlags, LPCWSTR szFile )
+{
+    if ( !szFile )
+        return E_INVALIDARG;
+
+    ScratchImage result;
+    HRESULT hr = ProcessTexture( srcImage, format, filter, levels, compress, alphaRef, result );
+    if ( FAILED(hr) )
+        return hr;
+
+    return SaveToDDSFile( result.GetImages(), result.GetImageCount(), result.GetMetadata(), ddsFlags, szFile );
+}
+
+}; // namespace
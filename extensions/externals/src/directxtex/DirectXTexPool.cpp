@@ -0,0 +1,202 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexPool.cpp
+//
+// DirectX Texture Library - Pooled pixel memory allocator for ScratchImage
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#include "directxtexp.h"
+
+namespace DirectX
+{
+
+// Blocks are never smaller than this
+static const size_t POOL_MIN_SHIFT = 12;
+static const size_t POOL_MIN_BLOCK = size_t(1) << POOL_MIN_SHIFT;
+
+// Released blocks are chained through their first bytes
+struct _PoolBlock
+{
+    _PoolBlock* next;
+};
+
+//-------------------------------------------------------------------------------------
+// Maps a request to its size class. There are four classes per power of two, so a
+// block is never more than 25% larger than the request
+//-------------------------------------------------------------------------------------
+static size_t _SizeClass( _In_ size_t size, _Out_ size_t& classSize )
+{
+    if ( size <= POOL_MIN_BLOCK )
+    {
+        classSize = POOL_MIN_BLOCK;
+        return 0;
+    }
+
+    // (size - 1) lies in [2^p, 2^(p+1)); its next two bits pick the quarter
+    const size_t s = size - 1;
+
+    // The top power of two cannot hold a rounded-up class
+    if ( s >> ( sizeof(size_t) * 8 - 1 ) )
+        return size_t(-1);
+
+    size_t p = POOL_MIN_SHIFT;
+    while( ( s >> ( p + 1 ) ) != 0 )
+        ++p;
+
+    const size_t quarter = ( s >> ( p - 2 ) ) & 3;
+
+    classSize = ( size_t(1) << p ) + ( ( quarter + 1 ) << ( p - 2 ) );
+    if ( classSize < size )
+        return size_t(-1); // Overflow
+
+    return ( ( p - POOL_MIN_SHIFT ) * 4 ) + quarter + 1;
+}
+
+
+//=====================================================================================
+// ImagePool
+//=====================================================================================
+
+_Use_decl_annotations_
+ImagePool::ImagePool( size_t maxCachedBytes ) :
+    _maxCachedBytes( maxCachedBytes )
+{
+    InitializeCriticalSection( &_cs );
+
+    memset( _free, 0, sizeof(_free) );
+    memset( &_stats, 0, sizeof(_stats) );
+}
+
+ImagePool::~ImagePool()
+{
+    // Blocks still owned by live ScratchImage objects are not tracked; they must be released first
+    assert( _stats.heapBytes == _stats.cachedBytes );
+
+    Trim();
+
+    DeleteCriticalSection( &_cs );
+}
+
+
+//-------------------------------------------------------------------------------------
+// Methods
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void* ImagePool::Allocate( size_t size )
+{
+    if ( !size )
+        return nullptr;
+
+    size_t classSize;
+    const size_t index = _SizeClass( size, classSize );
+    if ( index >= MAX_CLASSES )
+        return nullptr;
+
+    EnterCriticalSection( &_cs );
+
+    ++_stats.allocations;
+
+    auto block = reinterpret_cast<_PoolBlock*>( _free[ index ] );
+    if ( block )
+    {
+        _free[ index ] = block->next;
+        _stats.cachedBytes -= classSize;
+    }
+
+    LeaveCriticalSection( &_cs );
+
+    if ( block )
+        return block;
+
+    // Nothing cached in this class, so go to the heap outside the lock
+    void* ptr = _aligned_malloc( classSize, 16 );
+    if ( !ptr )
+        return nullptr;
+
+    EnterCriticalSection( &_cs );
+
+    ++_stats.heapAllocations;
+    _stats.heapBytes += classSize;
+    _stats.peakHeapBytes = std::max<size_t>( _stats.peakHeapBytes, _stats.heapBytes );
+
+    LeaveCriticalSection( &_cs );
+
+    return ptr;
+}
+
+_Use_decl_annotations_
+void ImagePool::Free( void* ptr, size_t size )
+{
+    if ( !ptr )
+        return;
+
+    size_t classSize;
+    const size_t index = _SizeClass( size, classSize );
+    assert( index < MAX_CLASSES );
+
+    EnterCriticalSection( &_cs );
+
+    bool cache = !_maxCachedBytes || ( _stats.cachedBytes + classSize <= _maxCachedBytes );
+    if ( cache )
+    {
+        auto block = reinterpret_cast<_PoolBlock*>( ptr );
+        block->next = reinterpret_cast<_PoolBlock*>( _free[ index ] );
+        _free[ index ] = block;
+        _stats.cachedBytes += classSize;
+    }
+    else
+    {
+        _stats.heapBytes -= classSize;
+    }
+
+    LeaveCriticalSection( &_cs );
+
+    if ( !cache )
+        _aligned_free( ptr );
+}
+
+void ImagePool::Trim()
+{
+    void* lists[ MAX_CLASSES ];
+
+    EnterCriticalSection( &_cs );
+
+    memcpy( lists, _free, sizeof(lists) );
+    memset( _free, 0, sizeof(_free) );
+
+    _stats.heapBytes -= _stats.cachedBytes;
+    _stats.cachedBytes = 0;
+
+    LeaveCriticalSection( &_cs );
+
+    for( size_t index = 0; index < MAX_CLASSES; ++index )
+    {
+        auto block = reinterpret_cast<_PoolBlock*>( lists[ index ] );
+        while( block )
+        {
+            _PoolBlock* next = block->next;
+            _aligned_free( block );
+            block = next;
+        }
+    }
+}
+
+_Use_decl_annotations_
+void ImagePool::GetStatistics( ImagePoolStatistics& stats ) const
+{
+    EnterCriticalSection( &_cs );
+
+    stats = _stats;
+
+    LeaveCriticalSection( &_cs );
+}
+
+}; // namespace
@@ -210,7 +210,9 @@ static bool _UseWICFiltering( _In_ DXGI_FORMAT format, _In_ DWORD filter )
         break;
 
     case TEX_FILTER_TRIANGLE:
-        // WIC does not implement this filter
+    case TEX_FILTER_LANCZOS:
+    case TEX_FILTER_KAISER:
+        // WIC does not implement these filters
         return false;
     }
 
@@ -280,498 +282,61 @@ static HRESULT _ResizePointFilter( _In_ const Image& srcImage, _In_ const Image&
 }
 
 
-//--- Box Filter ---
-static HRESULT _ResizeBoxFilter( _In_ const Image& srcImage, _In_ DWORD filter, _In_ const Image& destImage )
+//--- Separable filters (box, linear, cubic, triangle, Lanczos, Kaiser) ---
+static HRESULT _ResizeSeparableFilter( _In_reads_(nimages) const Image* srcImages, _In_reads_(nimages) const Image* destImages,
+                                       _In_ size_t nimages, _In_ DWORD filter )
 {
-    assert( srcImage.pixels && destImage.pixels );
-    assert( srcImage.format == destImage.format );
-
-    if ( ( (destImage.width << 1) != srcImage.width ) || ( (destImage.height << 1) != srcImage.height ) )
-        return E_FAIL;
-
-    // Allocate temporary space (3 scanlines)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc(
-                                         ( sizeof(XMVECTOR) * ( srcImage.width*2 + destImage.width ) ), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    XMVECTOR* target = scanline.get();
-
-    XMVECTOR* urow0 = target + destImage.width;
-    XMVECTOR* urow1 = urow0 + srcImage.width;
-
-#ifdef _DEBUG
-    memset( urow0, 0xCD, sizeof(XMVECTOR)*srcImage.width );
-    memset( urow1, 0xDD, sizeof(XMVECTOR)*srcImage.width );
-#endif
-
-    const XMVECTOR* urow2 = urow0 + 1;
-    const XMVECTOR* urow3 = urow1 + 1;
-
-    const uint8_t* pSrc = srcImage.pixels;
-    uint8_t* pDest = destImage.pixels;
-
-    size_t rowPitch = srcImage.rowPitch;
-
-    for( size_t y = 0; y < destImage.height; ++y )
-    {
-        if ( !_LoadScanlineLinear( urow0, srcImage.width, pSrc, rowPitch, srcImage.format, filter ) )
-            return E_FAIL;
-        pSrc += rowPitch;
-
-        if ( urow0 != urow1 )
-        {
-            if ( !_LoadScanlineLinear( urow1, srcImage.width, pSrc, rowPitch, srcImage.format, filter ) )
-                return E_FAIL;
-            pSrc += rowPitch;
-        }
-
-        for( size_t x = 0; x < destImage.width; ++x )
-        {
-            size_t x2 = x << 1;
-
-            AVERAGE4( target[ x ], urow0[ x2 ], urow1[ x2 ], urow2[ x2 ], urow3[ x2 ] );
-        }
-
-        if ( !_StoreScanlineLinear( pDest, destImage.rowPitch, destImage.format, target, destImage.width, filter ) )
-            return E_FAIL;
-        pDest += destImage.rowPitch;
-    }
-
-    return S_OK;
-}
-
-
-//--- Linear Filter ---
-static HRESULT _ResizeLinearFilter( _In_ const Image& srcImage, _In_ DWORD filter, _In_ const Image& destImage )
-{
-    assert( srcImage.pixels && destImage.pixels );
-    assert( srcImage.format == destImage.format );
-
-    // Allocate temporary space (3 scanlines, plus X and Y filters)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc(
-                                         ( sizeof(XMVECTOR) * ( srcImage.width*2 + destImage.width ) ), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    std::unique_ptr<LinearFilter[]> lf( new (std::nothrow) LinearFilter[ destImage.width + destImage.height ] );
-    if ( !lf )
-        return E_OUTOFMEMORY;
+    assert( srcImages && destImages && nimages > 0 );
 
-    LinearFilter* lfX = lf.get();
-    LinearFilter* lfY = lf.get() + destImage.width;
+    const size_t width = srcImages[0].width;
+    const size_t height = srcImages[0].height;
+    const size_t nwidth = destImages[0].width;
+    const size_t nheight = destImages[0].height;
 
-    _CreateLinearFilter( srcImage.width, destImage.width, (filter & TEX_FILTER_WRAP_U) != 0, lfX );
-    _CreateLinearFilter( srcImage.height, destImage.height, (filter & TEX_FILTER_WRAP_V) != 0, lfY );
-
-    XMVECTOR* target = scanline.get();
-
-    XMVECTOR* row0 = target + destImage.width;
-    XMVECTOR* row1 = row0 + srcImage.width;
-
-#ifdef _DEBUG
-    memset( row0, 0xCD, sizeof(XMVECTOR)*srcImage.width );
-    memset( row1, 0xDD, sizeof(XMVECTOR)*srcImage.width );
-#endif
-
-    const uint8_t* pSrc = srcImage.pixels;
-    uint8_t* pDest = destImage.pixels;
-
-    size_t rowPitch = srcImage.rowPitch;
-
-    size_t u0 = size_t(-1);
-    size_t u1 = size_t(-1);
-
-    for( size_t y = 0; y < destImage.height; ++y )
+    if ( ( filter & TEX_FILTER_MASK ) == TEX_FILTER_BOX )
     {
-        auto& toY = lfY[ y ];
-
-        if ( toY.u0 != u0 )
-        {
-            if ( toY.u0 != u1 )
-            {
-                u0 = toY.u0;
-
-                if ( !_LoadScanlineLinear( row0, srcImage.width, pSrc + (rowPitch * u0), rowPitch, srcImage.format, filter ) )
-                    return E_FAIL;
-            }
-            else
-            {
-                u0 = u1;
-                u1 = size_t(-1);
-
-                std::swap( row0, row1 );
-            }
-        }
-
-        if ( toY.u1 != u1 )
-        {
-            u1 = toY.u1;
-
-            if ( !_LoadScanlineLinear( row1, srcImage.width, pSrc + (rowPitch * u1), rowPitch, srcImage.format, filter ) )
-                return E_FAIL;
-        }
-
-        for( size_t x = 0; x < destImage.width; ++x )
-        {
-            auto& toX = lfX[ x ];
-
-            BILINEAR_INTERPOLATE( target[x], toX, toY, row0, row1 );
-        }
-
-        if ( !_StoreScanlineLinear( pDest, destImage.rowPitch, destImage.format, target, destImage.width, filter ) )
+        if ( ( (nwidth << 1) != width ) || ( (nheight << 1) != height ) )
             return E_FAIL;
-        pDest += destImage.rowPitch;
     }
 
-    return S_OK;
-}
-
-
-//--- Cubic Filter ---
-static HRESULT _ResizeCubicFilter( _In_ const Image& srcImage, _In_ DWORD filter, _In_ const Image& destImage )
-{
-    assert( srcImage.pixels && destImage.pixels );
-    assert( srcImage.format == destImage.format );
-
-    // Allocate temporary space (5 scanlines, plus X and Y filters)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc(
-                                         ( sizeof(XMVECTOR) * ( srcImage.width*4 + destImage.width ) ), 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    std::unique_ptr<CubicFilter[]> cf( new (std::nothrow) CubicFilter[ destImage.width + destImage.height ] );
-    if ( !cf )
-        return E_OUTOFMEMORY;
-
-    CubicFilter* cfX = cf.get();
-    CubicFilter* cfY = cf.get() + destImage.width;
-
-    _CreateCubicFilter( srcImage.width, destImage.width, (filter & TEX_FILTER_WRAP_U) != 0, (filter & TEX_FILTER_MIRROR_U) != 0, cfX );
-    _CreateCubicFilter( srcImage.height, destImage.height, (filter & TEX_FILTER_WRAP_V) != 0, (filter & TEX_FILTER_MIRROR_V) != 0, cfY );
-
-    XMVECTOR* target = scanline.get();
-
-    XMVECTOR* row0 = target + destImage.width;
-    XMVECTOR* row1 = row0 + srcImage.width;
-    XMVECTOR* row2 = row0 + srcImage.width*2;
-    XMVECTOR* row3 = row0 + srcImage.width*3;
-
-#ifdef _DEBUG
-    memset( row0, 0xCD, sizeof(XMVECTOR)*srcImage.width );
-    memset( row1, 0xDD, sizeof(XMVECTOR)*srcImage.width );
-    memset( row2, 0xED, sizeof(XMVECTOR)*srcImage.width );
-    memset( row3, 0xFD, sizeof(XMVECTOR)*srcImage.width );
-#endif
-
-    const uint8_t* pSrc = srcImage.pixels;
-    uint8_t* pDest = destImage.pixels;
-
-    size_t rowPitch = srcImage.rowPitch;
-
-    size_t u0 = size_t(-1);
-    size_t u1 = size_t(-1);
-    size_t u2 = size_t(-1);
-    size_t u3 = size_t(-1);
-
-    for( size_t y = 0; y < destImage.height; ++y )
-    {
-        auto& toY = cfY[ y ];
-
-        // Scanline 1
-        if ( toY.u0 != u0 )
-        {
-            if ( toY.u0 != u1 && toY.u0 != u2 && toY.u0 != u3 )
-            {
-                u0 = toY.u0;
-
-                if ( !_LoadScanlineLinear( row0, srcImage.width, pSrc + (rowPitch * u0), rowPitch, srcImage.format, filter ) )
-                    return E_FAIL;
-            }
-            else if ( toY.u0 == u1 )
-            {
-                u0 = u1;
-                u1 = size_t(-1);
-
-                std::swap( row0, row1 );
-            }
-            else if ( toY.u0 == u2 )
-            {
-                u0 = u2;
-                u2 = size_t(-1);
-
-                std::swap( row0, row2 );
-            }
-            else if ( toY.u0 == u3 )
-            {
-                u0 = u3;
-                u3 = size_t(-1);
-
-                std::swap( row0, row3 );
-            }
-        }
-
-        // Scanline 2
-        if ( toY.u1 != u1 )
-        {
-            if ( toY.u1 != u2 && toY.u1 != u3 )
-            {
-                u1 = toY.u1;
-
-                if ( !_LoadScanlineLinear( row1, srcImage.width, pSrc + (rowPitch * u1), rowPitch, srcImage.format, filter ) )
-                    return E_FAIL;
-            }
-            else if ( toY.u1 == u2 )
-            {
-                u1 = u2;
-                u2 = size_t(-1);
-
-                std::swap( row1, row2 );
-            }
-            else if ( toY.u1 == u3 )
-            {
-                u1 = u3;
-                u3 = size_t(-1);
-
-                std::swap( row1, row3 );
-            }
-        }
-
-        // Scanline 3
-        if ( toY.u2 != u2 )
-        {
-            if ( toY.u2 != u3 )
-            {
-                u2 = toY.u2;
-
-                if ( !_LoadScanlineLinear( row2, srcImage.width, pSrc + (rowPitch * u2), rowPitch, srcImage.format, filter ) )
-                    return E_FAIL;
-            }
-            else
-            {
-                u2 = u3;
-                u3 = size_t(-1);
-
-                std::swap( row2, row3 );
-            }
-        }
-
-        // Scanline 4
-        if ( toY.u3 != u3 )
-        {
-            u3 = toY.u3;
-
-            if ( !_LoadScanlineLinear( row3, srcImage.width, pSrc + (rowPitch * u3), rowPitch, srcImage.format, filter ) )
-                return E_FAIL;
-        }
-
-        for( size_t x = 0; x < destImage.width; ++x )
-        {
-            auto& toX = cfX[ x ];
-
-            XMVECTOR C0, C1, C2, C3;
-
-            CUBIC_INTERPOLATE( C0, toX.x, row0[ toX.u0 ], row0[ toX.u1 ], row0[ toX.u2 ], row0[ toX.u3 ] );
-            CUBIC_INTERPOLATE( C1, toX.x, row1[ toX.u0 ], row1[ toX.u1 ], row1[ toX.u2 ], row1[ toX.u3 ] );
-            CUBIC_INTERPOLATE( C2, toX.x, row2[ toX.u0 ], row2[ toX.u1 ], row2[ toX.u2 ], row2[ toX.u3 ] );
-            CUBIC_INTERPOLATE( C3, toX.x, row3[ toX.u0 ], row3[ toX.u1 ], row3[ toX.u2 ], row3[ toX.u3 ] );
-
-            CUBIC_INTERPOLATE( target[x], toY.x, C0, C1, C2, C3 );
-        }
-
-        if ( !_StoreScanlineLinear( pDest, destImage.rowPitch, destImage.format, target, destImage.width, filter ) )
-            return E_FAIL;
-        pDest += destImage.rowPitch;
-    }
-
-    return S_OK;
-}
-
-
-//--- Triangle Filter ---
-static HRESULT _ResizeTriangleFilter( _In_ const Image& srcImage, _In_ DWORD filter, _In_ const Image& destImage )
-{
-    assert( srcImage.pixels && destImage.pixels );
-    assert( srcImage.format == destImage.format );
-
-    using namespace TriangleFilter;
-
-    // Allocate initial temporary space (1 scanline, accumulation rows, plus X and Y filters)
-    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( sizeof(XMVECTOR) * srcImage.width, 16 ) ) );
-    if ( !scanline )
-        return E_OUTOFMEMORY;
-
-    std::unique_ptr<TriangleRow[]> rowActive( new (std::nothrow) TriangleRow[ destImage.height ] );
-    if ( !rowActive )
-        return E_OUTOFMEMORY;
-
-    TriangleRow * rowFree = nullptr;
-
-    std::unique_ptr<Filter> tfX;
-    HRESULT hr = _Create( srcImage.width, destImage.width, (filter & TEX_FILTER_WRAP_U) != 0, tfX );
+    SeparableFilter fx, fy, fz;
+    HRESULT hr = _CreateSeparableFilter( filter, width, nwidth, (filter & TEX_FILTER_WRAP_U) != 0, (filter & TEX_FILTER_MIRROR_U) != 0, fx );
     if ( FAILED(hr) )
         return hr;
 
-    std::unique_ptr<Filter> tfY;
-    hr = _Create( srcImage.height, destImage.height, (filter & TEX_FILTER_WRAP_V) != 0, tfY );
+    hr = _CreateSeparableFilter( filter, height, nheight, (filter & TEX_FILTER_WRAP_V) != 0, (filter & TEX_FILTER_MIRROR_V) != 0, fy );
     if ( FAILED(hr) )
         return hr;
 
-    XMVECTOR* row = scanline.get();
-
-#ifdef _DEBUG
-    memset( row, 0xCD, sizeof(XMVECTOR)*srcImage.width );
-#endif
-
-    auto xFromEnd = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( tfX.get() ) + tfX->sizeInBytes );
-    auto yFromEnd = reinterpret_cast<const FilterFrom*>( reinterpret_cast<const uint8_t*>( tfY.get() ) + tfY->sizeInBytes );
-
-    // Count times rows get written
-    for( FilterFrom* yFrom = tfY->from; yFrom < yFromEnd; )
-    {
-        for ( size_t j = 0; j < yFrom->count; ++j )
-        {
-            size_t v = yFrom->to[ j ].u;
-            assert( v < destImage.height );
-            ++rowActive.get()[ v ].remaining;
-        }
+    hr = _CreateSeparableIdentity( 1, fz );
+    if ( FAILED(hr) )
+        return hr;
 
-        yFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( yFrom ) + yFrom->sizeInBytes );
-    }
+    // Every image is filtered in bands of rows on the thread pool
+    return _ResizeSeparable( srcImages, 1, destImages, 1, nimages, fx, fy, fz, filter );
+}
 
-    // Filter image
-    const uint8_t* pSrc = srcImage.pixels;
-    size_t rowPitch = srcImage.rowPitch;
-    const uint8_t* pEndSrc = pSrc + rowPitch * srcImage.height;
 
-    uint8_t* pDest = destImage.pixels;
+//--- Custom filter resize ---
+static HRESULT _PerformResizeUsingCustomFilters( _In_reads_(nimages) const Image* srcImages, _In_reads_(nimages) const Image* destImages,
+                                                 _In_ size_t nimages, _In_ DWORD filter )
+{
+    if ( !srcImages || !destImages || !nimages )
+        return E_INVALIDARG;
 
-    for( FilterFrom* yFrom = tfY->from; yFrom < yFromEnd; )
+    for( size_t index = 0; index < nimages; ++index )
     {
-        // Create accumulation rows as needed
-        for ( size_t j = 0; j < yFrom->count; ++j )
-        {
-            size_t v = yFrom->to[ j ].u;
-            assert( v < destImage.height );
-            TriangleRow* rowAcc = &rowActive.get()[ v ];
-
-            if ( !rowAcc->scanline )
-            {
-                if ( rowFree )
-                {
-                    // Steal and reuse scanline from 'free row' list
-                    assert( rowFree->scanline != 0 );
-                    rowAcc->scanline.reset( rowFree->scanline.release() );
-                    rowFree = rowFree->next;
-                }
-                else
-                {
-                    rowAcc->scanline.reset( reinterpret_cast<XMVECTOR*>( _aligned_malloc( sizeof(XMVECTOR) * destImage.width, 16 ) ) );
-                    if ( !rowAcc->scanline )
-                        return E_OUTOFMEMORY;
-                }
-
-                memset( rowAcc->scanline.get(), 0, sizeof(XMVECTOR) * destImage.width );
-            }
-        }
-
-        // Load source scanline
-        if ( (pSrc + rowPitch) > pEndSrc )
-            return E_FAIL;
-
-        if ( !_LoadScanlineLinear( row, srcImage.width, pSrc, rowPitch, srcImage.format, filter ) )
-            return E_FAIL;
-
-        pSrc += rowPitch;
-
-        // Process row
-        size_t x = 0;
-        for( FilterFrom* xFrom = tfX->from; xFrom < xFromEnd; ++x )
-        {
-            for ( size_t j = 0; j < yFrom->count; ++j )
-            {
-                size_t v = yFrom->to[ j ].u;
-                assert( v < destImage.height );
-                float yweight = yFrom->to[ j ].weight;
-
-                XMVECTOR* accPtr = rowActive[ v ].scanline.get();
-                if ( !accPtr )
-                    return E_POINTER;
-
-                for ( size_t k = 0; k < xFrom->count; ++k )
-                {
-                    size_t u = xFrom->to[ k ].u;
-                    assert( u < destImage.width );
-
-                    XMVECTOR weight = XMVectorReplicate( yweight * xFrom->to[ k ].weight );
-
-                    assert( x < srcImage.width );
-                    accPtr[ u ] = XMVectorMultiplyAdd( row[ x ], weight, accPtr[ u ] );
-                }
-            }
-
-            xFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( xFrom ) + xFrom->sizeInBytes );
-        }
-
-        // Write completed accumulation rows
-        for ( size_t j = 0; j < yFrom->count; ++j )
-        {
-            size_t v = yFrom->to[ j ].u;
-            assert( v < destImage.height );
-            TriangleRow* rowAcc = &rowActive.get()[ v ];
-
-            assert( rowAcc->remaining > 0 );
-            --rowAcc->remaining;
-
-            if ( !rowAcc->remaining )
-            {
-                XMVECTOR* pAccSrc = rowAcc->scanline.get();
-                if ( !pAccSrc )
-                    return E_POINTER;
+        if ( !srcImages[ index ].pixels || !destImages[ index ].pixels )
+            return E_POINTER;
 
-                switch( destImage.format )
-                {
-                case DXGI_FORMAT_R10G10B10A2_UNORM:
-                case DXGI_FORMAT_R10G10B10A2_UINT:
-                    {
-                        // Need to slightly bias results for floating-point error accumulation which can
-                        // be visible with harshly quantized values
-                        static const XMVECTORF32 Bias = { 0.f, 0.f, 0.f, 0.1f };
-                       
-                        XMVECTOR* ptr = pAccSrc;
-                        for( size_t i=0; i < destImage.width; ++i, ++ptr )
-                        {
-                            *ptr = XMVectorAdd( *ptr, Bias );
-                        }
-                    }
-                    break;
-                }
-
-                // This performs any required clamping
-                if ( !_StoreScanlineLinear( pDest + (destImage.rowPitch * v), destImage.rowPitch, destImage.format, pAccSrc, destImage.width, filter ) )
-                    return E_FAIL;
-
-                // Put row on freelist to reuse it's allocated scanline
-                rowAcc->next = rowFree;
-                rowFree = rowAcc;
-            }
-        }
-
-        yFrom = reinterpret_cast<FilterFrom*>( reinterpret_cast<uint8_t*>( yFrom ) + yFrom->sizeInBytes );
+        assert( srcImages[ index ].format == destImages[ index ].format );
     }
 
-    return S_OK;
-}
-
-
-//--- Custom filter resize ---
-static HRESULT _PerformResizeUsingCustomFilters( _In_ const Image& srcImage, _In_ DWORD filter, _In_ const Image& destImage )
-{
-    if ( !srcImage.pixels || !destImage.pixels )
-        return E_POINTER;
-
     static_assert( TEX_FILTER_POINT == 0x100000, "TEX_FILTER_ flag values don't match TEX_FILTER_MASK" );
 
+    const Image& srcImage = srcImages[0];
+    const Image& destImage = destImages[0];
+
     DWORD filter_select = ( filter & TEX_FILTER_MASK );
     if ( !filter_select )
     {
@@ -783,19 +348,21 @@ static HRESULT _PerformResizeUsingCustomFilters( _In_ const Image& srcImage, _In
     switch( filter_select )
     {
     case TEX_FILTER_POINT:
-        return _ResizePointFilter( srcImage, destImage );
-        
-    case TEX_FILTER_BOX:
-        return _ResizeBoxFilter( srcImage, filter, destImage );
+        for( size_t index = 0; index < nimages; ++index )
+        {
+            HRESULT hr = _ResizePointFilter( srcImages[ index ], destImages[ index ] );
+            if ( FAILED(hr) )
+                return hr;
+        }
+        return S_OK;
 
+    case TEX_FILTER_BOX:
     case TEX_FILTER_LINEAR:
-        return _ResizeLinearFilter( srcImage, filter, destImage );
-
     case TEX_FILTER_CUBIC:
-        return _ResizeCubicFilter( srcImage, filter, destImage );
-
     case TEX_FILTER_TRIANGLE:
-        return _ResizeTriangleFilter( srcImage, filter, destImage );
+    case TEX_FILTER_LANCZOS:
+    case TEX_FILTER_KAISER:
+        return _ResizeSeparableFilter( srcImages, destImages, nimages, ( filter & ~TEX_FILTER_MASK ) | filter_select );
 
     default:
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
@@ -857,7 +424,7 @@ HRESULT Resize( const Image& srcImage, size_t width, size_t height, DWORD filter
     }
     else
     {
-        hr = _PerformResizeUsingCustomFilters( srcImage, filter, *rimage );
+        hr = _PerformResizeUsingCustomFilters( &srcImage, rimage, 1, filter );
     }
 
     if ( FAILED(hr) )
@@ -898,6 +465,10 @@ HRESULT Resize( const Image* srcImages, size_t nimages, const TexMetadata& metad
     WICPixelFormatGUID pfGUID = {0};
     bool wicpf = ( usewic ) ? _DXGIToWIC( metadata.format, pfGUID, true ) : false;
 
+    // Without WIC all the images are resized together after validation
+    std::vector<Image> srcList;
+    std::vector<Image> destList;
+
     switch ( metadata.dimension )
     {
     case TEX_DIMENSION_TEXTURE1D:
@@ -951,7 +522,8 @@ HRESULT Resize( const Image* srcImages, size_t nimages, const TexMetadata& metad
             else
             {
                 // Case 3: not using WIC resizing
-                hr = _PerformResizeUsingCustomFilters( *srcimg, filter, *destimg );
+                srcList.push_back( *srcimg );
+                destList.push_back( *destimg );
             }
 
             if ( FAILED(hr) )
@@ -1012,7 +584,8 @@ HRESULT Resize( const Image* srcImages, size_t nimages, const TexMetadata& metad
             else
             {
                 // Case 3: not using WIC resizing
-                hr = _PerformResizeUsingCustomFilters( *srcimg, filter, *destimg );
+                srcList.push_back( *srcimg );
+                destList.push_back( *destimg );
             }
 
             if ( FAILED(hr) )
@@ -1028,6 +601,16 @@ HRESULT Resize( const Image* srcImages, size_t nimages, const TexMetadata& metad
         return E_FAIL;
     }
 
+    if ( !usewic )
+    {
+        hr = _PerformResizeUsingCustomFilters( &srcList[0], &destList[0], srcList.size(), filter );
+        if ( FAILED(hr) )
+        {
+            result.Release();
+            return hr;
+        }
+    }
+
     return S_OK;
 }
 
@@ -20,7 +20,7 @@
 //      * Does not support files that contain color maps (these are rare in practice)
 //      * Interleaved files are not supported (deprecated aspect of TGA format)
 //      * Only supports 8-bit grayscale; 16-, 24-, and 32-bit truecolor images
-//      * Always writes uncompressed files (i.e. can read RLE compression, but does not write it)
+//      * Writes uncompressed files unless TGA_FLAGS_RLE is given
 //
 
 enum TGAImageType
@@ -249,6 +249,42 @@ static HRESULT _SetAlphaChannelToOpaque( _In_ const Image* image )
 }
 
 
+//-------------------------------------------------------------------------------------
+// Fills a span of 8, 16, or 32-bit pixels with one value (expands RLE repeat packets)
+//-------------------------------------------------------------------------------------
+static void _FillPixels( _Out_writes_bytes_(count*bpp) void* pDestination, _In_ size_t count, _In_ size_t bpp, _In_ uint32_t value )
+{
+    assert( pDestination && count > 0 );
+    assert( bpp == 1 || bpp == 2 || bpp == 4 );
+
+    auto dPtr = reinterpret_cast<uint8_t*>( pDestination );
+    size_t bytes = count * bpp;
+
+#if defined(_XM_SSE_INTRINSICS_)
+    if ( bytes >= 16 )
+    {
+        __m128i v;
+        switch( bpp )
+        {
+        case 1:     v = _mm_set1_epi8( static_cast<char>( value ) ); break;
+        case 2:     v = _mm_set1_epi16( static_cast<short>( value ) ); break;
+        default:    v = _mm_set1_epi32( static_cast<int>( value ) ); break;
+        }
+
+        for( ; bytes >= 16; bytes -= 16, dPtr += 16 )
+        {
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( dPtr ), v );
+        }
+    }
+#endif
+
+    for( ; bytes > 0; bytes -= bpp, dPtr += bpp )
+    {
+        memcpy( dPtr, &value, bpp );
+    }
+}
+
+
 //-------------------------------------------------------------------------------------
 // Uncompress pixel data from a TGA into the target image
 //-------------------------------------------------------------------------------------
@@ -274,6 +310,9 @@ static HRESULT _UncompressPixels( _In_reads_bytes_(size) LPCVOID pSource, size_t
     auto sPtr = reinterpret_cast<const uint8_t*>( pSource );
     const uint8_t* endPtr = sPtr + size;
 
+    // Packets are expanded a whole span at a time; right-to-left scanlines fill the span ending at dPtr
+    const ptrdiff_t step = ( convFlags & CONV_FLAGS_INVERTX ) ? -1 : 1;
+
     switch( image->format )
     {
     //--------------------------------------------------------------------------- 8-bit
@@ -292,50 +331,45 @@ static HRESULT _UncompressPixels( _In_reads_bytes_(size) LPCVOID pSource, size_t
                 if ( sPtr >= endPtr )
                     return E_FAIL;
 
+                size_t j = (*sPtr & 0x7F) + 1;
+                if ( x + j > image->width )
+                    return E_FAIL;
+
                 if ( *sPtr & 0x80 )
                 {
                     // Repeat
-                    size_t j = (*sPtr & 0x7F) + 1;
                     if ( ++sPtr >= endPtr )
                         return E_FAIL;
 
-                    for( ; j > 0; --j, ++x )
-                    {
-                        if ( x >= image->width )
-                            return E_FAIL;
-
-                        *dPtr = *sPtr;
-
-                        if ( convFlags & CONV_FLAGS_INVERTX )
-                            --dPtr;
-                        else
-                            ++dPtr;
-                    }
+                    memset( ( step < 0 ) ? ( dPtr - j + 1 ) : dPtr, *sPtr, j );
+                    dPtr += step * ptrdiff_t(j);
 
                     ++sPtr;
                 }
                 else
                 {
                     // Literal
-                    size_t j = (*sPtr & 0x7F) + 1;
                     ++sPtr;
 
                     if ( sPtr+j > endPtr )
                         return E_FAIL;
 
-                    for( ; j > 0; --j, ++x )
+                    if ( step < 0 )
                     {
-                        if ( x >= image->width )
-                            return E_FAIL;
-
-                        *dPtr = *(sPtr++);
-
-                        if ( convFlags & CONV_FLAGS_INVERTX )
-                            --dPtr;
-                        else
-                            ++dPtr;
+                        for( size_t k = 0; k < j; ++k )
+                        {
+                            *(dPtr--) = *(sPtr++);
+                        }
+                    }
+                    else
+                    {
+                        memcpy( dPtr, sPtr, j );
+                        dPtr += j;
+                        sPtr += j;
                     }
                 }
+
+                x += j;
             }
         }
         break;
@@ -358,10 +392,13 @@ static HRESULT _UncompressPixels( _In_reads_bytes_(size) LPCVOID pSource, size_t
                     if ( sPtr >= endPtr )
                         return E_FAIL;
 
+                    size_t j = (*sPtr & 0x7F) + 1;
+                    if ( x + j > image->width )
+                        return E_FAIL;
+
                     if ( *sPtr & 0x80 )
                     {
                         // Repeat
-                        size_t j = (*sPtr & 0x7F) + 1;
                         ++sPtr;
 
                         if ( sPtr+1 >= endPtr )
@@ -372,45 +409,30 @@ static HRESULT _UncompressPixels( _In_reads_bytes_(size) LPCVOID pSource, size_t
                             nonzeroa = true;
                         sPtr += 2;
 
-                        for( ; j > 0; --j, ++x )
-                        {
-                            if ( x >= image->width )
-                                return E_FAIL;
-
-                            *dPtr = t;
-
-                            if ( convFlags & CONV_FLAGS_INVERTX )
-                                --dPtr;
-                            else
-                                ++dPtr;
-                        }
+                        _FillPixels( ( step < 0 ) ? ( dPtr - j + 1 ) : dPtr, j, sizeof(uint16_t), t );
+                        dPtr += step * ptrdiff_t(j);
                     }
                     else
                     {
                         // Literal
-                        size_t j = (*sPtr & 0x7F) + 1;
                         ++sPtr;
 
                         if ( sPtr+(j*2) > endPtr )
                             return E_FAIL;
 
-                        for( ; j > 0; --j, ++x )
+                        for( size_t k = 0; k < j; ++k )
                         {
-                            if ( x >= image->width )
-                                return E_FAIL;
-
                             uint16_t t =  *sPtr | (*(sPtr+1) << 8);
                             if ( t & 0x8000 )
                                 nonzeroa = true;
                             sPtr += 2;
-                            *dPtr = t;
 
-                            if ( convFlags & CONV_FLAGS_INVERTX )
-                                --dPtr;
-                            else
-                                ++dPtr;
+                            *dPtr = t;
+                            dPtr += step;
                         }
                     }
+
+                    x += j;
                 }
             }
 
@@ -427,10 +449,13 @@ static HRESULT _UncompressPixels( _In_reads_bytes_(size) LPCVOID pSource, size_t
     //----------------------------------------------------------------------- 24/32-bit
     case DXGI_FORMAT_R8G8B8A8_UNORM:
         {
-            bool nonzeroa = false;
+            const size_t bpp = ( convFlags & CONV_FLAGS_EXPAND ) ? 3 : 4;
+
+            bool nonzeroa = ( convFlags & CONV_FLAGS_EXPAND ) != 0;
             for( size_t y=0; y < image->height; ++y )
             {
                 size_t offset = ( (convFlags & CONV_FLAGS_INVERTX ) ? (image->width - 1) : 0 );
+                assert( offset*bpp < rowPitch);
 
                 uint32_t* dPtr = reinterpret_cast<uint32_t*>( reinterpret_cast<uint8_t*>( image->pixels )
                               + ( image->rowPitch * ( (convFlags & CONV_FLAGS_INVERTY) ? y : (image->height - y - 1) ) ) )
@@ -441,97 +466,59 @@ static HRESULT _UncompressPixels( _In_reads_bytes_(size) LPCVOID pSource, size_t
                     if ( sPtr >= endPtr )
                         return E_FAIL;
 
+                    size_t j = (*sPtr & 0x7F) + 1;
+                    if ( x + j > image->width )
+                        return E_FAIL;
+
                     if ( *sPtr & 0x80 )
                     {
                         // Repeat
-                        size_t j = (*sPtr & 0x7F) + 1;
                         ++sPtr;
 
-                        DWORD t;
+                        if ( sPtr+bpp > endPtr )
+                            return E_FAIL;
+
+                        uint32_t t;
                         if ( convFlags & CONV_FLAGS_EXPAND )
                         {
-                            assert( offset*3 < rowPitch);
-
-                            if ( sPtr+2 >= endPtr )
-                                return E_FAIL;
-
                             // BGR -> RGBA
                             t = ( *sPtr << 16 ) | ( *(sPtr+1) << 8 ) | ( *(sPtr+2) ) | 0xFF000000;
-                            sPtr += 3;
-
-                            nonzeroa = true;
                         }
                         else
                         {
-                            assert( offset*4 < rowPitch);
-
-                            if ( sPtr+3 >= endPtr )
-                                return E_FAIL;
-
                             // BGRA -> RGBA
                             t = ( *sPtr << 16 ) | ( *(sPtr+1) << 8 ) | ( *(sPtr+2) ) | ( *(sPtr+3) << 24 );
 
                             if ( *(sPtr+3) > 0 )
                                 nonzeroa = true;
-
-                            sPtr += 4;
                         }
+                        sPtr += bpp;
 
-                        for( ; j > 0; --j, ++x )
-                        {
-                            if ( x >= image->width )
-                                return E_FAIL;
-
-                            *dPtr = t;
-
-                            if ( convFlags & CONV_FLAGS_INVERTX )
-                                --dPtr;
-                            else
-                                ++dPtr;
-                        }
+                        _FillPixels( ( step < 0 ) ? ( dPtr - j + 1 ) : dPtr, j, sizeof(uint32_t), t );
+                        dPtr += step * ptrdiff_t(j);
                     }
                     else
                     {
                         // Literal
-                        size_t j = (*sPtr & 0x7F) + 1;
                         ++sPtr;
 
-                        if ( convFlags & CONV_FLAGS_EXPAND )
-                        {
-                            if ( sPtr+(j*3) > endPtr )
-                                return E_FAIL;
-                        }
-                        else
-                        {
-                            if ( sPtr+(j*4) > endPtr )
-                                return E_FAIL;
-                        }
+                        if ( sPtr+(j*bpp) > endPtr )
+                            return E_FAIL;
 
-                        for( ; j > 0; --j, ++x )
+                        if ( convFlags & CONV_FLAGS_EXPAND )
                         {
-                            if ( x >= image->width )
-                                return E_FAIL;
-
-                            if ( convFlags & CONV_FLAGS_EXPAND )
+                            for( size_t k = 0; k < j; ++k )
                             {
-                                assert( offset*3 < rowPitch);
-
-                                if ( sPtr+2 >= endPtr )
-                                    return E_FAIL;
-
                                 // BGR -> RGBA
                                 *dPtr = ( *sPtr << 16 ) | ( *(sPtr+1) << 8 ) | ( *(sPtr+2) ) | 0xFF000000;
                                 sPtr += 3;
-
-                                nonzeroa = true;
+                                dPtr += step;
                             }
-                            else
+                        }
+                        else
+                        {
+                            for( size_t k = 0; k < j; ++k )
                             {
-                                assert( offset*4 < rowPitch);
-
-                                if ( sPtr+3 >= endPtr )
-                                    return E_FAIL;
-
                                 // BGRA -> RGBA
                                 *dPtr = ( *sPtr << 16 ) | ( *(sPtr+1) << 8 ) | ( *(sPtr+2) ) | ( *(sPtr+3) << 24 );
 
@@ -539,14 +526,12 @@ static HRESULT _UncompressPixels( _In_reads_bytes_(size) LPCVOID pSource, size_t
                                     nonzeroa = true;
 
                                 sPtr += 4;
+                                dPtr += step;
                             }
-
-                            if ( convFlags & CONV_FLAGS_INVERTX )
-                                --dPtr;
-                            else
-                                ++dPtr;
                         }
                     }
+
+                    x += j;
                 }
             }
 
@@ -736,7 +721,7 @@ static HRESULT _CopyPixels( _In_reads_bytes_(size) LPCVOID pSource, size_t size,
 //-------------------------------------------------------------------------------------
 // Encodes TGA file header
 //-------------------------------------------------------------------------------------
-static HRESULT _EncodeTGAHeader( _In_ const Image& image, _Out_ TGA_HEADER& header, _Inout_ DWORD& convFlags )
+static HRESULT _EncodeTGAHeader( _In_ const Image& image, _In_ DWORD flags, _Out_ TGA_HEADER& header, _Inout_ DWORD& convFlags )
 {
     assert( IsValid( image.format ) && !IsVideo( image.format ) );
 
@@ -793,10 +778,106 @@ static HRESULT _EncodeTGAHeader( _In_ const Image& image, _Out_ TGA_HEADER& head
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
     }
 
+    if ( flags & TGA_FLAGS_RLE )
+    {
+        header.bImageType = ( header.bImageType == TGA_BLACK_AND_WHITE ) ? TGA_BLACK_AND_WHITE_RLE : TGA_TRUECOLOR_RLE;
+        convFlags |= CONV_FLAGS_RLE;
+    }
+
     return S_OK;
 }
 
 
+//-------------------------------------------------------------------------------------
+// Counts how many pixels (at most maxCount) repeat the first pixel at pSource
+//-------------------------------------------------------------------------------------
+static size_t _CountRun( _In_reads_bytes_(maxCount*bpp) const uint8_t* pSource, _In_ size_t maxCount, _In_ size_t bpp )
+{
+    assert( pSource && maxCount > 0 && bpp > 0 );
+
+    // Every pixel matches the previous one exactly when every byte matches the byte bpp
+    // earlier, so the scan works on bytes regardless of the pixel size
+    const size_t bytes = maxCount * bpp;
+    size_t k = bpp;
+
+#if defined(_XM_SSE_INTRINSICS_)
+    for( ; ( k + 16 ) <= bytes; k += 16 )
+    {
+        __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSource + k ) );
+        __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSource + k - bpp ) );
+        if ( _mm_movemask_epi8( _mm_cmpeq_epi8( a, b ) ) != 0xFFFF )
+            break;
+    }
+#endif
+
+    for( ; ( k < bytes ) && ( pSource[ k ] == pSource[ k - bpp ] ); ++k ) {}
+
+    return k / bpp;
+}
+
+
+//-------------------------------------------------------------------------------------
+// RLE compresses one scanline of TGA pixel data (packets never cross scanlines)
+//-------------------------------------------------------------------------------------
+inline size_t _CompressedScanlineSize( _In_ size_t width, _In_ size_t bpp )
+{
+    // Worst case: every repeat packet saves at least a byte, which pays for ending a literal
+    // packet early, so only the 128 pixel limit on literal packets adds to the raw size
+    return width * bpp + ( width / 128 ) + 1;
+}
+
+static size_t _CompressScanline( _Out_writes_bytes_to_(outSize, return) uint8_t* pDestination, _In_ size_t outSize,
+                                 _In_reads_bytes_(width*bpp) const uint8_t* pSource, _In_ size_t width, _In_ size_t bpp )
+{
+    assert( pDestination && outSize > 0 );
+    assert( pSource && width > 0 && bpp > 0 );
+
+    // A repeat packet of single byte pixels only saves space once the run is 3 long
+    const size_t minRun = ( bpp > 1 ) ? 2 : 3;
+
+    uint8_t* dPtr = pDestination;
+    const uint8_t* endPtr = pDestination + outSize;
+
+    for( size_t x = 0; x < width; )
+    {
+        size_t run = _CountRun( pSource + ( x * bpp ), std::min<size_t>( width - x, 128 ), bpp );
+        if ( run >= minRun )
+        {
+            // Repeat
+            if ( dPtr + 1 + bpp > endPtr )
+                return 0;
+
+            *(dPtr++) = static_cast<uint8_t>( 0x80 | ( run - 1 ) );
+            memcpy( dPtr, pSource + ( x * bpp ), bpp );
+            dPtr += bpp;
+            x += run;
+            continue;
+        }
+
+        // Literal, up to the start of the next run worth encoding
+        const size_t start = x;
+        for( x += run; ( x < width ) && ( ( x - start ) < 128 ); x += run )
+        {
+            run = _CountRun( pSource + ( x * bpp ), std::min<size_t>( width - x, 128 ), bpp );
+            if ( run >= minRun )
+                break;
+        }
+
+        const size_t count = std::min<size_t>( x - start, 128 );
+        x = start + count;
+
+        if ( dPtr + 1 + ( count * bpp ) > endPtr )
+            return 0;
+
+        *(dPtr++) = static_cast<uint8_t>( count - 1 );
+        memcpy( dPtr, pSource + ( start * bpp ), count * bpp );
+        dPtr += count * bpp;
+    }
+
+    return static_cast<size_t>( dPtr - pDestination );
+}
+
+
 //-------------------------------------------------------------------------------------
 // Copies BGRX data to form BGR 24bpp data
 //-------------------------------------------------------------------------------------
@@ -1214,13 +1295,19 @@ HRESULT LoadFromTGAFile( LPCWSTR szFile, TexMetadata* metadata, ScratchImage& im
 //-------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT SaveToTGAMemory( const Image& image, Blob& blob )
+{
+    return SaveToTGAMemory( image, TGA_FLAGS_NONE, blob );
+}
+
+_Use_decl_annotations_
+HRESULT SaveToTGAMemory( const Image& image, DWORD flags, Blob& blob )
 {
     if ( !image.pixels )
         return E_POINTER;
 
     TGA_HEADER tga_header;
     DWORD convFlags = 0;
-    HRESULT hr = _EncodeTGAHeader( image, tga_header, convFlags );
+    HRESULT hr = _EncodeTGAHeader( image, flags, tga_header, convFlags );
     if ( FAILED(hr) )
         return hr;
 
@@ -1238,6 +1325,19 @@ HRESULT SaveToTGAMemory( const Image& image, Blob& blob )
         ComputePitch( image.format, image.width, image.height, rowPitch, slicePitch, CP_FLAGS_NONE );
     }
 
+    // RLE scanlines are built in a temporary buffer and compressed into a blob sized for the worst case
+    const size_t bpp = tga_header.bBitsPerPixel / 8;
+
+    std::unique_ptr<uint8_t[]> temp;
+    if ( convFlags & CONV_FLAGS_RLE )
+    {
+        slicePitch = image.height * _CompressedScanlineSize( image.width, bpp );
+
+        temp.reset( new (std::nothrow) uint8_t[ rowPitch ] );
+        if ( !temp )
+            return E_OUTOFMEMORY;
+    }
+
     hr = blob.Initialize( sizeof(TGA_HEADER) + slicePitch );
     if ( FAILED(hr) )
         return hr;
@@ -1248,29 +1348,58 @@ HRESULT SaveToTGAMemory( const Image& image, Blob& blob )
     memcpy_s( dPtr, blob.GetBufferSize(), &tga_header, sizeof(TGA_HEADER) );
     dPtr += sizeof(TGA_HEADER);
 
+    const uint8_t* endPtr = reinterpret_cast<const uint8_t*>( blob.GetBufferPointer() ) + blob.GetBufferSize();
+
     auto pPixels = reinterpret_cast<const uint8_t*>( image.pixels );
     assert( pPixels );
 
     for( size_t y = 0; y < image.height; ++y )
     {
+        uint8_t* pRow = ( convFlags & CONV_FLAGS_RLE ) ? temp.get() : dPtr;
+
         // Copy pixels
         if ( convFlags & CONV_FLAGS_888 )
         {
-            _Copy24bppScanline( dPtr, rowPitch, pPixels, image.rowPitch );
+            _Copy24bppScanline( pRow, rowPitch, pPixels, image.rowPitch );
         }
         else if ( convFlags & CONV_FLAGS_SWIZZLE )
         {
-            _SwizzleScanline( dPtr, rowPitch, pPixels, image.rowPitch, image.format, TEXP_SCANLINE_NONE );
+            _SwizzleScanline( pRow, rowPitch, pPixels, image.rowPitch, image.format, TEXP_SCANLINE_NONE );
         }
         else
         {
-            _CopyScanline( dPtr, rowPitch, pPixels, image.rowPitch, image.format, TEXP_SCANLINE_NONE );
+            _CopyScanline( pRow, rowPitch, pPixels, image.rowPitch, image.format, TEXP_SCANLINE_NONE );
+        }
+
+        if ( convFlags & CONV_FLAGS_RLE )
+        {
+            size_t bytes = _CompressScanline( dPtr, static_cast<size_t>( endPtr - dPtr ), pRow, image.width, bpp );
+            if ( !bytes )
+            {
+                blob.Release();
+                return E_FAIL;
+            }
+
+            dPtr += bytes;
+        }
+        else
+        {
+            dPtr += rowPitch;
         }
 
-        dPtr += rowPitch;
         pPixels += image.rowPitch;
     }
 
+    if ( convFlags & CONV_FLAGS_RLE )
+    {
+        hr = blob.Trim( static_cast<size_t>( dPtr - reinterpret_cast<uint8_t*>( blob.GetBufferPointer() ) ) );
+        if ( FAILED(hr) )
+        {
+            blob.Release();
+            return hr;
+        }
+    }
+
     return S_OK;
 }
 
@@ -1280,6 +1409,12 @@ HRESULT SaveToTGAMemory( const Image& image, Blob& blob )
 //-------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT SaveToTGAFile( const Image& image, LPCWSTR szFile )
+{
+    return SaveToTGAFile( image, TGA_FLAGS_NONE, szFile );
+}
+
+_Use_decl_annotations_
+HRESULT SaveToTGAFile( const Image& image, DWORD flags, LPCWSTR szFile )
 {
     if ( !szFile )
         return E_INVALIDARG;
@@ -1289,7 +1424,7 @@ HRESULT SaveToTGAFile( const Image& image, LPCWSTR szFile )
 
     TGA_HEADER tga_header;
     DWORD convFlags = 0;
-    HRESULT hr = _EncodeTGAHeader( image, tga_header, convFlags );
+    HRESULT hr = _EncodeTGAHeader( image, flags, tga_header, convFlags );
     if ( FAILED(hr) )
         return hr;
 
@@ -1321,7 +1456,7 @@ HRESULT SaveToTGAFile( const Image& image, LPCWSTR szFile )
         // For small images, it is better to create an in-memory file and write it out
         Blob blob;
 
-        hr = SaveToTGAMemory( image, blob );
+        hr = SaveToTGAMemory( image, flags, blob );
         if ( FAILED(hr) )
             return hr;
 
@@ -1342,7 +1477,10 @@ HRESULT SaveToTGAFile( const Image& image, LPCWSTR szFile )
     else
     {
         // Otherwise, write the image one scanline at a time...
-        std::unique_ptr<uint8_t[]> temp( new (std::nothrow) uint8_t[ rowPitch ] );
+        const size_t bpp = tga_header.bBitsPerPixel / 8;
+        const size_t rleSize = ( convFlags & CONV_FLAGS_RLE ) ? _CompressedScanlineSize( image.width, bpp ) : 0;
+
+        std::unique_ptr<uint8_t[]> temp( new (std::nothrow) uint8_t[ rowPitch + rleSize ] );
         if ( !temp )
             return E_OUTOFMEMORY;
 
@@ -1377,12 +1515,22 @@ HRESULT SaveToTGAFile( const Image& image, LPCWSTR szFile )
 
             pPixels += image.rowPitch;
 
-            if ( !WriteFile( hFile.get(), temp.get(), static_cast<DWORD>( rowPitch ), &bytesWritten, 0 ) )
+            const uint8_t* pData = temp.get();
+            size_t bytesToWrite = rowPitch;
+            if ( convFlags & CONV_FLAGS_RLE )
+            {
+                pData = temp.get() + rowPitch;
+                bytesToWrite = _CompressScanline( temp.get() + rowPitch, rleSize, temp.get(), image.width, bpp );
+                if ( !bytesToWrite )
+                    return E_FAIL;
+            }
+
+            if ( !WriteFile( hFile.get(), pData, static_cast<DWORD>( bytesToWrite ), &bytesWritten, 0 ) )
             {
                 return HRESULT_FROM_WIN32( GetLastError() );
             }
 
-            if ( bytesWritten != rowPitch )
+            if ( bytesWritten != bytesToWrite )
                 return E_FAIL;
         }
     }
@@ -15,6 +15,10 @@
 
 #include "directxtexp.h"
 
+#if defined(_XM_SSE_INTRINSICS_)
+#include <intrin.h>
+#endif
+
 //-------------------------------------------------------------------------------------
 // WIC Pixel Format Translation Data
 //-------------------------------------------------------------------------------------
@@ -266,6 +270,30 @@ REFGUID GetWICCodec( WICCodecs codec )
 }
 
 
+//=====================================================================================
+// CPU Utilities
+//=====================================================================================
+
+//-------------------------------------------------------------------------------------
+// Returns true if the processor and OS both support AVX (256-bit float) instructions
+//-------------------------------------------------------------------------------------
+bool _IsAVXSupported()
+{
+#if defined(_XM_SSE_INTRINSICS_)
+    int info[4];
+    __cpuid( info, 1 );
+
+    // Requires both AVX and OSXSAVE, and the OS must preserve the YMM registers
+    if ( (info[2] & 0x18000000) != 0x18000000 )
+        return false;
+
+    return ( _xgetbv( 0 ) & 0x6 ) == 0x6;
+#else
+    return false;
+#endif
+}
+
+
 //=====================================================================================
 // DXGI Format Utilities
 //=====================================================================================
@@ -957,4 +985,21 @@ HRESULT Blob::Initialize( size_t size )
     return S_OK;
 }
 
+_Use_decl_annotations_
+HRESULT Blob::Trim( size_t size )
+{
+    if ( !size )
+        return E_INVALIDARG;
+
+    if ( !_buffer )
+        return E_UNEXPECTED;
+
+    if ( size > _size )
+        return E_INVALIDARG;
+
+    _size = size;
+
+    return S_OK;
+}
+
 }; // namespace
@@ -0,0 +1,345 @@
+//-------------------------------------------------------------------------------------
+// BenchBC4BC5.cpp
+//
+// DirectX Texture Library benchmark - BC4/BC5 encoding of masks and normal maps
+//
+// Encodes every block with the library encoders (which emit constant, two-value and
+// ramp blocks directly) and with the previous endpoint search, then decodes both.
+// No block may come out with a higher error than the previous encoder gave.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#include "directxtexbench.h"
+
+#include <stdio.h>
+
+using namespace DirectX;
+
+namespace DirectXTexBench
+{
+
+namespace
+{
+    typedef void (*BC_ENCODE_REF)( uint8_t *pBC, const XMVECTOR *pColor );
+    typedef void (*BC_ENCODE)( uint8_t *pBC, const XMVECTOR *pColor, DWORD flags );
+    typedef void (*BC_DECODE)( XMVECTOR *pColor, const uint8_t *pBC );
+
+    struct BCCodec
+    {
+        const char*     name;
+        size_t          blockSize;
+        size_t          channels;
+        bool            snorm;
+        BC_ENCODE_REF   pfReference;
+        BC_ENCODE       pfEncode;
+        BC_DECODE       pfDecode;
+    };
+
+    const BCCodec g_Codecs[] =
+    {
+        { "bc4u", 8,  1, false, Reference::EncodeBC4U, D3DXEncodeBC4U, D3DXDecodeBC4U },
+        { "bc4s", 8,  1, true,  Reference::EncodeBC4S, D3DXEncodeBC4S, D3DXDecodeBC4S },
+        { "bc5u", 16, 2, false, Reference::EncodeBC5U, D3DXEncodeBC5U, D3DXDecodeBC5U },
+        { "bc5s", 16, 2, true,  Reference::EncodeBC5S, D3DXEncodeBC5S, D3DXDecodeBC5S },
+    };
+
+    const size_t SYNTHETIC_SIZE = 1024;
+    const size_t SYNTHETIC_QUICK_SIZE = 256;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Source images, always R32G32B32A32_FLOAT
+//-------------------------------------------------------------------------------------
+static HRESULT _LoadMask( _In_z_ const wchar_t* szFile, _Out_ ScratchImage& image )
+{
+    wchar_t ext[_MAX_EXT];
+    _wsplitpath_s( szFile, nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT );
+
+    ScratchImage loaded;
+    HRESULT hr;
+    if ( !_wcsicmp( ext, L".dds" ) )
+    {
+        hr = LoadFromDDSFile( szFile, DDS_FLAGS_NONE, nullptr, loaded );
+    }
+    else if ( !_wcsicmp( ext, L".tga" ) )
+    {
+        hr = LoadFromTGAFile( szFile, nullptr, loaded );
+    }
+    else
+    {
+        hr = LoadFromWICFile( szFile, WIC_FLAGS_NONE, nullptr, loaded );
+    }
+
+    if ( FAILED(hr) )
+        return hr;
+
+    const Image* img = loaded.GetImage( 0, 0, 0 );
+    if ( !img )
+        return E_POINTER;
+
+    if ( IsCompressed( img->format ) )
+        return Decompress( *img, DXGI_FORMAT_R32G32B32A32_FLOAT, image );
+
+    if ( img->format == DXGI_FORMAT_R32G32B32A32_FLOAT )
+        return image.InitializeFromImage( *img );
+
+    return _ConvertToR32G32B32A32( *img, image );
+}
+
+// Anti-aliased shapes over a flat background, with a soft gradient band: mostly constant
+// and two-value blocks, like the masks these encoders see in practice
+static HRESULT _CreateMask( _In_ size_t size, _Out_ ScratchImage& image )
+{
+    HRESULT hr = image.Initialize2D( DXGI_FORMAT_R32G32B32A32_FLOAT, size, size, 1, 1 );
+    if ( FAILED(hr) )
+        return hr;
+
+    const Image& img = *image.GetImage( 0, 0, 0 );
+    for( size_t y = 0; y < size; ++y )
+    {
+        auto pDest = reinterpret_cast<XMFLOAT4*>( img.pixels + y * img.rowPitch );
+        for( size_t x = 0; x < size; ++x )
+        {
+            float u = float( x ) / float( size );
+            float v = float( y ) / float( size );
+
+            // Circle with a 2 texel edge
+            float du = u - 0.35f;
+            float dv = v - 0.4f;
+            float d = ( sqrtf( du * du + dv * dv ) - 0.22f ) * float( size ) * 0.5f;
+            float circle = std::min( std::max( 0.5f - d, 0.f ), 1.f );
+
+            // Hard-edged stripes in one corner
+            float stripes = ( u > 0.6f && v > 0.6f && ( ( x / 24 ) & 1 ) ) ? 1.f : 0.f;
+
+            // Gradient band along the bottom
+            float band = ( v > 0.85f ) ? u : 0.f;
+
+            float r = std::max( std::max( circle, stripes ), band );
+            float g = ( u < 0.5f ) ? 1.f - r : r;
+
+            pDest[ x ] = XMFLOAT4( r, g, 0.f, 1.f );
+        }
+    }
+
+    return S_OK;
+}
+
+// Tangent-space normals of a smooth height field; few blocks are exact so this mostly
+// measures the cost of the classification on blocks that still need the full search
+static HRESULT _CreateNormalMap( _In_ size_t size, _Out_ ScratchImage& image )
+{
+    HRESULT hr = image.Initialize2D( DXGI_FORMAT_R32G32B32A32_FLOAT, size, size, 1, 1 );
+    if ( FAILED(hr) )
+        return hr;
+
+    const float freq = XM_2PI * 6.f / float( size );
+
+    const Image& img = *image.GetImage( 0, 0, 0 );
+    for( size_t y = 0; y < size; ++y )
+    {
+        auto pDest = reinterpret_cast<XMFLOAT4*>( img.pixels + y * img.rowPitch );
+        for( size_t x = 0; x < size; ++x )
+        {
+            float dx = 0.6f * cosf( float( x ) * freq ) * sinf( float( y ) * freq * 0.7f );
+            float dy = 0.6f * sinf( float( x ) * freq ) * cosf( float( y ) * freq * 0.7f );
+
+            XMVECTOR n = XMVector3Normalize( XMVectorSet( -dx, -dy, 1.f, 0.f ) );
+            n = XMVectorMultiplyAdd( n, g_XMOneHalf, g_XMOneHalf );
+
+            XMStoreFloat4( &pDest[ x ], XMVectorSetW( n, 1.f ) );
+        }
+    }
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Runs every codec over one image and prints a line for each
+//-------------------------------------------------------------------------------------
+static bool _BenchBC4BC5Image( _In_ const Image& img, _In_z_ const char* name, _In_ size_t repeat )
+{
+    const size_t bw = ( img.width + 3 ) / 4;
+    const size_t bh = ( img.height + 3 ) / 4;
+    const size_t nblocks = bw * bh;
+
+    ScopedAlignedArrayXMVECTOR blocks( reinterpret_cast<XMVECTOR*>( _aligned_malloc( sizeof(XMVECTOR) * NUM_PIXELS_PER_BLOCK * nblocks * 2, 16 ) ) );
+    if ( !blocks )
+    {
+        printf( "%-20s FAILED: out of memory\n", name );
+        return false;
+    }
+
+    // UNORM and SNORM copies of every block, clamping at the right and bottom edges
+    XMVECTOR* unorm = blocks.get();
+    XMVECTOR* snorm = blocks.get() + NUM_PIXELS_PER_BLOCK * nblocks;
+
+    for( size_t by = 0; by < bh; ++by )
+    {
+        for( size_t bx = 0; bx < bw; ++bx )
+        {
+            const size_t base = ( by * bw + bx ) * NUM_PIXELS_PER_BLOCK;
+            for( size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i )
+            {
+                size_t x = std::min( bx * 4 + ( i & 3 ), img.width - 1 );
+                size_t y = std::min( by * 4 + ( i >> 2 ), img.height - 1 );
+
+                XMVECTOR v = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( img.pixels + y * img.rowPitch ) + x );
+                v = XMVectorSaturate( v );
+
+                unorm[ base + i ] = v;
+                snorm[ base + i ] = XMVectorSubtract( XMVectorAdd( v, v ), g_XMOne );
+            }
+        }
+    }
+
+    std::unique_ptr<uint8_t[]> encoded( new (std::nothrow) uint8_t[ nblocks * 16 * 2 ] );
+    if ( !encoded )
+    {
+        printf( "%-20s FAILED: out of memory\n", name );
+        return false;
+    }
+
+    bool passed = true;
+
+    for( size_t c = 0; c < _countof(g_Codecs); ++c )
+    {
+        const BCCodec& codec = g_Codecs[ c ];
+        const XMVECTOR* pixels = ( codec.snorm ) ? snorm : unorm;
+
+        uint8_t* oldBlocks = encoded.get();
+        uint8_t* newBlocks = encoded.get() + nblocks * codec.blockSize;
+
+        double start = GetTime();
+        for( size_t r = 0; r < repeat; ++r )
+        {
+            for( size_t b = 0; b < nblocks; ++b )
+            {
+                codec.pfReference( oldBlocks + b * codec.blockSize, pixels + b * NUM_PIXELS_PER_BLOCK );
+            }
+        }
+        const double oldTime = ( GetTime() - start ) / double( repeat );
+
+        start = GetTime();
+        for( size_t r = 0; r < repeat; ++r )
+        {
+            for( size_t b = 0; b < nblocks; ++b )
+            {
+                codec.pfEncode( newBlocks + b * codec.blockSize, pixels + b * NUM_PIXELS_PER_BLOCK, 0 );
+            }
+        }
+        const double newTime = ( GetTime() - start ) / double( repeat );
+
+        double oldError = 0.0;
+        double newError = 0.0;
+        size_t identical = 0;
+        size_t worse = 0;
+
+        for( size_t b = 0; b < nblocks; ++b )
+        {
+            const XMVECTOR* src = pixels + b * NUM_PIXELS_PER_BLOCK;
+
+            XMVECTOR oldDecoded[ NUM_PIXELS_PER_BLOCK ];
+            XMVECTOR newDecoded[ NUM_PIXELS_PER_BLOCK ];
+            codec.pfDecode( oldDecoded, oldBlocks + b * codec.blockSize );
+            codec.pfDecode( newDecoded, newBlocks + b * codec.blockSize );
+
+            XMVECTOR oldSum = g_XMZero;
+            XMVECTOR newSum = g_XMZero;
+            for( size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i )
+            {
+                XMVECTOR od = XMVectorSubtract( oldDecoded[ i ], src[ i ] );
+                XMVECTOR nd = XMVectorSubtract( newDecoded[ i ], src[ i ] );
+                oldSum = XMVectorMultiplyAdd( od, od, oldSum );
+                newSum = XMVectorMultiplyAdd( nd, nd, newSum );
+            }
+
+            float blockOld = XMVectorGetX( oldSum ) + ( ( codec.channels > 1 ) ? XMVectorGetY( oldSum ) : 0.f );
+            float blockNew = XMVectorGetX( newSum ) + ( ( codec.channels > 1 ) ? XMVectorGetY( newSum ) : 0.f );
+
+            oldError += blockOld;
+            newError += blockNew;
+
+            if ( blockNew > blockOld )
+                ++worse;
+
+            if ( !memcmp( oldBlocks + b * codec.blockSize, newBlocks + b * codec.blockSize, codec.blockSize ) )
+                ++identical;
+        }
+
+        const double samples = double( nblocks * NUM_PIXELS_PER_BLOCK * codec.channels );
+
+        printf( "%-20s %s  old %8.2f ms  new %8.2f ms  %6.2fx  mse old %.3g new %.3g  identical %5.1f%%  worse %u%s\n",
+                name, codec.name, oldTime * 1000.0, newTime * 1000.0, ( newTime > 0.0 ) ? oldTime / newTime : 0.0,
+                oldError / samples, newError / samples, 100.0 * double( identical ) / double( nblocks ),
+                static_cast<unsigned int>( worse ), worse ? "  FAILED" : "" );
+
+        if ( worse )
+            passed = false;
+    }
+
+    return passed;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Entry-point
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+bool BenchBC4BC5( const wchar_t* const* files, size_t nfiles, bool quick )
+{
+    printf( "\nBC4/BC5: previous endpoint search (old) vs classified encoders (new)\n" );
+
+    const size_t repeat = ( quick ) ? 1 : 3;
+
+    bool passed = true;
+
+    if ( !nfiles )
+    {
+        const size_t size = ( quick ) ? SYNTHETIC_QUICK_SIZE : SYNTHETIC_SIZE;
+
+        ScratchImage mask;
+        HRESULT hr = _CreateMask( size, mask );
+        if ( FAILED(hr) || !_BenchBC4BC5Image( *mask.GetImage( 0, 0, 0 ), "synthetic mask", repeat ) )
+            passed = false;
+
+        ScratchImage normals;
+        hr = _CreateNormalMap( size, normals );
+        if ( FAILED(hr) || !_BenchBC4BC5Image( *normals.GetImage( 0, 0, 0 ), "synthetic normals", repeat ) )
+            passed = false;
+
+        return passed;
+    }
+
+    for( size_t i = 0; i < nfiles; ++i )
+    {
+        char name[32];
+        sprintf_s( name, "%.31ls", files[ i ] );
+
+        ScratchImage image;
+        HRESULT hr = _LoadMask( files[ i ], image );
+        if ( FAILED(hr) )
+        {
+            printf( "%-20s FAILED: could not load (%08X)\n", name, static_cast<unsigned int>( hr ) );
+            passed = false;
+            continue;
+        }
+
+        if ( !_BenchBC4BC5Image( *image.GetImage( 0, 0, 0 ), name, repeat ) )
+            passed = false;
+    }
+
+    return passed;
+}
+
+}; // namespace
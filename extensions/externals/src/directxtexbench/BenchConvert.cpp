@@ -0,0 +1,235 @@
+//-------------------------------------------------------------------------------------
+// BenchConvert.cpp
+//
+// DirectX Texture Library benchmark - Format conversion matrix
+//
+// Runs Convert with TEX_FILTER_FORCE_NON_WIC, which takes the direct scanline
+// converters where one exists, against the generic load/convert/store path for every
+// pair of formats in each group. The outputs must be bit-identical.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#include "directxtexbench.h"
+
+#include <stdio.h>
+
+using namespace DirectX;
+
+namespace DirectXTexBench
+{
+
+namespace
+{
+    struct ConvertFormat
+    {
+        DXGI_FORMAT     format;
+        const char*     name;
+    };
+
+    const ConvertFormat g_Convert8888[] =
+    {
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       "rgba8" },
+        { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  "rgba8_srgb" },
+        { DXGI_FORMAT_B8G8R8A8_UNORM,       "bgra8" },
+        { DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,  "bgra8_srgb" },
+        { DXGI_FORMAT_B8G8R8X8_UNORM,       "bgrx8" },
+        { DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,  "bgrx8_srgb" },
+        { DXGI_FORMAT_R10G10B10A2_UNORM,    "rgb10a2" },
+    };
+
+    const ConvertFormat g_ConvertFloat[] =
+    {
+        { DXGI_FORMAT_R16_FLOAT,            "r16f" },
+        { DXGI_FORMAT_R32_FLOAT,            "r32f" },
+        { DXGI_FORMAT_R16G16_FLOAT,         "rg16f" },
+        { DXGI_FORMAT_R32G32_FLOAT,         "rg32f" },
+        { DXGI_FORMAT_R16G16B16A16_FLOAT,   "rgba16f" },
+        { DXGI_FORMAT_R32G32B32A32_FLOAT,   "rgba32f" },
+    };
+
+    struct ConvertFilter
+    {
+        DWORD           filter;
+        const char*     name;
+    };
+
+    // TEX_FILTER_SRGB leaves sRGB <-> sRGB pairs as plain relabels
+    const ConvertFilter g_ConvertFilters[] =
+    {
+        { TEX_FILTER_DEFAULT,   "" },
+        { TEX_FILTER_SRGB,      "srgb" },
+    };
+}
+
+
+//-------------------------------------------------------------------------------------
+// The generic path Convert takes when there is no direct converter (no dithering)
+//-------------------------------------------------------------------------------------
+static HRESULT _ConvertGeneric( _In_ const Image& srcImage, _In_ DWORD filter, _In_ const Image& destImage, _In_ float threshold )
+{
+    assert( srcImage.width == destImage.width );
+    assert( srcImage.height == destImage.height );
+
+    const uint8_t *pSrc = srcImage.pixels;
+    uint8_t *pDest = destImage.pixels;
+    if ( !pSrc || !pDest )
+        return E_POINTER;
+
+    size_t width = srcImage.width;
+
+    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*width), 16 ) ) );
+    if ( !scanline )
+        return E_OUTOFMEMORY;
+
+    for( size_t h = 0; h < srcImage.height; ++h )
+    {
+        if ( !_LoadScanline( scanline.get(), width, pSrc, srcImage.rowPitch, srcImage.format ) )
+            return E_FAIL;
+
+        _ConvertScanline( scanline.get(), width, destImage.format, srcImage.format, filter );
+
+        if ( !_StoreScanline( pDest, destImage.rowPitch, destImage.format, scanline.get(), width, threshold ) )
+            return E_FAIL;
+
+        pSrc += srcImage.rowPitch;
+        pDest += destImage.rowPitch;
+    }
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Runs one pair through both paths and prints a line for it
+//-------------------------------------------------------------------------------------
+static bool _BenchConvert( _In_ const ScratchImage& source, _In_ const ConvertFormat& src, _In_ const ConvertFormat& dest,
+                           _In_ const ConvertFilter& filter, _In_ size_t repeat )
+{
+    const Image& srcImage = *source.GetImage( 0, 0, 0 );
+
+    ScratchImage reference;
+    HRESULT hr = reference.Initialize2D( dest.format, srcImage.width, srcImage.height, 1, 1 );
+    if ( FAILED(hr) )
+    {
+        printf( "%-12s -> %-12s %-5s FAILED: setup returned %08X\n", src.name, dest.name, filter.name, static_cast<unsigned int>( hr ) );
+        return false;
+    }
+
+    double start = GetTime();
+
+    for( size_t i = 0; SUCCEEDED(hr) && i < repeat; ++i )
+    {
+        hr = _ConvertGeneric( srcImage, filter.filter, *reference.GetImage( 0, 0, 0 ), 0.5f );
+    }
+
+    const double oldTime = ( GetTime() - start ) / double( repeat );
+
+    if ( FAILED(hr) )
+    {
+        printf( "%-12s -> %-12s %-5s FAILED: generic path returned %08X\n", src.name, dest.name, filter.name, static_cast<unsigned int>( hr ) );
+        return false;
+    }
+
+    ScratchImage result;
+    start = GetTime();
+
+    for( size_t i = 0; SUCCEEDED(hr) && i < repeat; ++i )
+    {
+        hr = Convert( srcImage, dest.format, filter.filter | TEX_FILTER_FORCE_NON_WIC, 0.5f, result );
+    }
+
+    const double newTime = ( GetTime() - start ) / double( repeat );
+
+    if ( FAILED(hr) )
+    {
+        printf( "%-12s -> %-12s %-5s FAILED: library returned %08X\n", src.name, dest.name, filter.name, static_cast<unsigned int>( hr ) );
+        return false;
+    }
+
+    // Rows are compared without their padding
+    const Image& a = *reference.GetImage( 0, 0, 0 );
+    const Image& b = *result.GetImage( 0, 0, 0 );
+    const size_t rowBytes = ( BitsPerPixel( dest.format ) * a.width + 7 ) / 8;
+
+    size_t mismatches = 0;
+    for( size_t h = 0; h < a.height; ++h )
+    {
+        if ( memcmp( a.pixels + h * a.rowPitch, b.pixels + h * b.rowPitch, rowBytes ) != 0 )
+            ++mismatches;
+    }
+
+    printf( "%-12s -> %-12s %-5s old %8.2f ms  new %8.2f ms  %6.2fx%s\n",
+            src.name, dest.name, filter.name, oldTime * 1000.0, newTime * 1000.0,
+            ( newTime > 0.0 ) ? oldTime / newTime : 0.0, mismatches ? "  FAILED: rows differ" : "" );
+
+    return !mismatches;
+}
+
+static bool _BenchConvertGroup( _In_reads_(count) const ConvertFormat* formats, _In_ size_t count, _In_ size_t width, _In_ size_t height,
+                                _In_ size_t repeat )
+{
+    bool passed = true;
+
+    for( size_t s = 0; s < count; ++s )
+    {
+        ScratchImage source;
+        HRESULT hr = source.Initialize2D( formats[ s ].format, width, height, 1, 1 );
+        if ( FAILED(hr) )
+        {
+            printf( "Failed to create a %s image (%08X)\n", formats[ s ].name, static_cast<unsigned int>( hr ) );
+            passed = false;
+            continue;
+        }
+
+        FillNoise( source, static_cast<uint32_t>( s + 1 ) );
+
+        for( size_t d = 0; d < count; ++d )
+        {
+            if ( d == s )
+                continue;
+
+            for( size_t f = 0; f < _countof(g_ConvertFilters); ++f )
+            {
+                // The flags only make a difference between 8-bit formats
+                if ( g_ConvertFilters[ f ].filter && formats != g_Convert8888 )
+                    continue;
+
+                if ( !_BenchConvert( source, formats[ s ], formats[ d ], g_ConvertFilters[ f ], repeat ) )
+                    passed = false;
+            }
+        }
+    }
+
+    return passed;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Entry-point
+//-------------------------------------------------------------------------------------
+bool BenchConvert( bool quick )
+{
+    const size_t width = ( quick ) ? 256 : 2048;
+    const size_t height = ( quick ) ? 256 : 2048;
+    const size_t repeat = ( quick ) ? 1 : 4;
+
+    printf( "\nConvert %ux%u: generic scanline path (old) vs Convert with TEX_FILTER_FORCE_NON_WIC (new)\n",
+            static_cast<unsigned int>( width ), static_cast<unsigned int>( height ) );
+
+    bool passed = _BenchConvertGroup( g_Convert8888, _countof(g_Convert8888), width, height, repeat );
+
+    if ( !_BenchConvertGroup( g_ConvertFloat, _countof(g_ConvertFloat), width, height, repeat ) )
+        passed = false;
+
+    return passed;
+}
+
+}; // namespace
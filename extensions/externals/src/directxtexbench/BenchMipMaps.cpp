@@ -0,0 +1,331 @@
+//-------------------------------------------------------------------------------------
+// BenchMipMaps.cpp
+//
+// DirectX Texture Library benchmark - Non-WIC mip-map generation
+//
+// Runs GenerateMipMaps/GenerateMipMaps3D with TEX_FILTER_FORCE_NON_WIC (the separable
+// engine) and the previous per-scanline kernels on the same base levels, and compares
+// every generated level.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#include "directxtexbench.h"
+
+#include <stdio.h>
+
+using namespace DirectX;
+
+namespace DirectXTexBench
+{
+
+namespace
+{
+    struct MipFormat
+    {
+        DXGI_FORMAT     format;
+        const char*     name;
+        float           tolerance;
+    };
+
+    // The engine accumulates in a different order, so 8-bit results may round one step apart
+    const MipFormat g_MipFormats[] =
+    {
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       "rgba8",        1.0001f / 255.f },
+        { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  "rgba8_srgb",   1.0001f / 255.f },
+        { DXGI_FORMAT_R32G32B32A32_FLOAT,   "rgba32f",      1e-5f },
+    };
+
+    struct MipFilter
+    {
+        DWORD           filter;
+        const char*     name;
+    };
+
+    const MipFilter g_MipFilters[] =
+    {
+        { TEX_FILTER_BOX,                           "box" },
+        { TEX_FILTER_LINEAR,                        "linear" },
+        { TEX_FILTER_CUBIC,                         "cubic" },
+        { TEX_FILTER_TRIANGLE,                      "triangle" },
+        { TEX_FILTER_LINEAR | TEX_FILTER_WRAP,      "linear-wrap" },
+        { TEX_FILTER_CUBIC | TEX_FILTER_MIRROR,     "cubic-mirror" },
+        { TEX_FILTER_TRIANGLE | TEX_FILTER_WRAP,    "triangle-wrap" },
+    };
+
+    struct MipSize
+    {
+        size_t          width;
+        size_t          height;
+        size_t          depth;      // Array size for 2D cases
+    };
+
+    const MipSize g_Mip2DSizes[] =
+    {
+        { 2048, 2048, 1 },
+        { 1024, 1024, 1 },
+        { 256, 256, 6 },
+        { 512, 128, 1 },
+        { 640, 360, 1 },
+        { 37, 19, 2 },
+        { 1, 64, 1 },
+    };
+
+    const MipSize g_Mip2DQuickSizes[] =
+    {
+        { 256, 256, 1 },
+        { 64, 64, 6 },
+        { 64, 16, 1 },
+        { 37, 19, 2 },
+        { 1, 64, 1 },
+    };
+
+    const MipSize g_Mip3DSizes[] =
+    {
+        { 128, 128, 64 },
+        { 64, 32, 16 },
+        { 17, 9, 5 },
+    };
+
+    const MipSize g_Mip3DQuickSizes[] =
+    {
+        { 32, 32, 16 },
+        { 17, 9, 5 },
+    };
+}
+
+inline static bool ispow2( _In_ size_t x )
+{
+    return ((x != 0) && !(x & (x - 1)));
+}
+
+
+//-------------------------------------------------------------------------------------
+// Compares every image below the top level, returning the largest channel difference
+//-------------------------------------------------------------------------------------
+static HRESULT _CompareMips( _In_ const ScratchImage& expected, _In_ const ScratchImage& actual, _Out_ float& maxDiff )
+{
+    maxDiff = 0.f;
+
+    const TexMetadata& metadata = expected.GetMetadata();
+    if ( metadata.mipLevels != actual.GetMetadata().mipLevels
+         || expected.GetImageCount() != actual.GetImageCount() )
+        return E_FAIL;
+
+    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( (sizeof(XMVECTOR)*metadata.width*2), 16 ) ) );
+    if ( !scanline )
+        return E_OUTOFMEMORY;
+
+    XMVECTOR* rowA = scanline.get();
+    XMVECTOR* rowB = scanline.get() + metadata.width;
+
+    XMVECTOR vmax = g_XMZero;
+
+    const size_t items = ( metadata.dimension == TEX_DIMENSION_TEXTURE3D ) ? 1 : metadata.arraySize;
+    for( size_t item = 0; item < items; ++item )
+    {
+        for( size_t level = 1; level < metadata.mipLevels; ++level )
+        {
+            const size_t slices = ( metadata.dimension == TEX_DIMENSION_TEXTURE3D ) ? std::max<size_t>( 1, metadata.depth >> level ) : 1;
+            for( size_t slice = 0; slice < slices; ++slice )
+            {
+                const Image* a = expected.GetImage( level, item, slice );
+                const Image* b = actual.GetImage( level, item, slice );
+                if ( !a || !b || a->width != b->width || a->height != b->height )
+                    return E_FAIL;
+
+                const uint8_t* pA = a->pixels;
+                const uint8_t* pB = b->pixels;
+
+                for( size_t h = 0; h < a->height; ++h )
+                {
+                    if ( !_LoadScanline( rowA, a->width, pA, a->rowPitch, a->format )
+                         || !_LoadScanline( rowB, b->width, pB, b->rowPitch, b->format ) )
+                        return E_FAIL;
+
+                    for( size_t x = 0; x < a->width; ++x )
+                    {
+                        vmax = XMVectorMax( vmax, XMVectorAbs( XMVectorSubtract( rowA[ x ], rowB[ x ] ) ) );
+                    }
+
+                    pA += a->rowPitch;
+                    pB += b->rowPitch;
+                }
+            }
+        }
+    }
+
+    XMFLOAT4 m;
+    XMStoreFloat4( &m, vmax );
+    maxDiff = std::max( std::max( m.x, m.y ), std::max( m.z, m.w ) );
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Sets up a mip chain holding the base level, as GenerateMipMaps does before filtering
+//-------------------------------------------------------------------------------------
+static HRESULT _SetupMips( _In_ const ScratchImage& base, _In_ size_t levels, _Out_ ScratchImage& mipChain )
+{
+    TexMetadata mdata = base.GetMetadata();
+    mdata.mipLevels = levels;
+
+    HRESULT hr = mipChain.Initialize( mdata );
+    if ( FAILED(hr) )
+        return hr;
+
+    const size_t items = ( mdata.dimension == TEX_DIMENSION_TEXTURE3D ) ? mdata.depth : mdata.arraySize;
+    for( size_t item = 0; item < items; ++item )
+    {
+        const Image* src = ( mdata.dimension == TEX_DIMENSION_TEXTURE3D ) ? base.GetImage( 0, 0, item ) : base.GetImage( 0, item, 0 );
+        const Image* dest = ( mdata.dimension == TEX_DIMENSION_TEXTURE3D ) ? mipChain.GetImage( 0, 0, item ) : mipChain.GetImage( 0, item, 0 );
+        if ( !src || !dest || src->slicePitch != dest->slicePitch )
+            return E_FAIL;
+
+        memcpy_s( dest->pixels, dest->slicePitch, src->pixels, src->slicePitch );
+    }
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Runs one case through both paths and prints a line for it
+//-------------------------------------------------------------------------------------
+static bool _BenchMips( _In_ const ScratchImage& base, _In_ const MipFormat& format, _In_ const MipFilter& filter, _In_ const char* label )
+{
+    const TexMetadata& metadata = base.GetMetadata();
+    const bool volume = ( metadata.dimension == TEX_DIMENSION_TEXTURE3D );
+
+    ScratchImage result;
+    double start = GetTime();
+
+    HRESULT hr = ( volume )
+                 ? GenerateMipMaps3D( base.GetImages(), base.GetImageCount(), metadata, filter.filter | TEX_FILTER_FORCE_NON_WIC, 0, result )
+                 : GenerateMipMaps( base.GetImages(), base.GetImageCount(), metadata, filter.filter | TEX_FILTER_FORCE_NON_WIC, 0, result );
+
+    const double newTime = GetTime() - start;
+
+    if ( FAILED(hr) )
+    {
+        printf( "%-14s %-12s %-14s FAILED: library returned %08X\n", label, format.name, filter.name, static_cast<unsigned int>( hr ) );
+        return false;
+    }
+
+    const size_t levels = result.GetMetadata().mipLevels;
+
+    ScratchImage reference;
+    hr = _SetupMips( base, levels, reference );
+    if ( FAILED(hr) )
+    {
+        printf( "%-14s %-12s %-14s FAILED: setup returned %08X\n", label, format.name, filter.name, static_cast<unsigned int>( hr ) );
+        return false;
+    }
+
+    start = GetTime();
+
+    if ( volume )
+    {
+        hr = Reference::Generate3DMips( filter.filter, metadata.depth, levels, reference );
+    }
+    else
+    {
+        for( size_t item = 0; SUCCEEDED(hr) && item < metadata.arraySize; ++item )
+        {
+            hr = Reference::Generate2DMips( filter.filter, levels, reference, item );
+        }
+    }
+
+    const double oldTime = GetTime() - start;
+
+    if ( FAILED(hr) )
+    {
+        printf( "%-14s %-12s %-14s FAILED: reference returned %08X\n", label, format.name, filter.name, static_cast<unsigned int>( hr ) );
+        return false;
+    }
+
+    float maxDiff;
+    hr = _CompareMips( reference, result, maxDiff );
+
+    const bool passed = SUCCEEDED(hr) && ( maxDiff <= format.tolerance );
+
+    printf( "%-14s %-12s %-14s old %9.2f ms  new %9.2f ms  %6.2fx  max diff %.3g%s\n",
+            label, format.name, filter.name, oldTime * 1000.0, newTime * 1000.0,
+            ( newTime > 0.0 ) ? oldTime / newTime : 0.0, maxDiff, passed ? "" : "  FAILED" );
+
+    return passed;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Entry-point
+//-------------------------------------------------------------------------------------
+bool BenchMipMaps( bool quick )
+{
+    printf( "\nMip-maps: previous scanline kernels (old, one thread) vs separable engine (new)\n" );
+
+    bool passed = true;
+
+    const MipSize* sizes2D = ( quick ) ? g_Mip2DQuickSizes : g_Mip2DSizes;
+    const size_t count2D = ( quick ) ? _countof(g_Mip2DQuickSizes) : _countof(g_Mip2DSizes);
+
+    const MipSize* sizes3D = ( quick ) ? g_Mip3DQuickSizes : g_Mip3DSizes;
+    const size_t count3D = ( quick ) ? _countof(g_Mip3DQuickSizes) : _countof(g_Mip3DSizes);
+
+    for( size_t f = 0; f < _countof(g_MipFormats); ++f )
+    {
+        const MipFormat& format = g_MipFormats[ f ];
+
+        for( size_t s = 0; s < count2D + count3D; ++s )
+        {
+            const bool volume = ( s >= count2D );
+            const MipSize& size = ( volume ) ? sizes3D[ s - count2D ] : sizes2D[ s ];
+
+            ScratchImage base;
+            HRESULT hr = ( volume )
+                         ? base.Initialize3D( format.format, size.width, size.height, size.depth, 1 )
+                         : base.Initialize2D( format.format, size.width, size.height, size.depth, 1 );
+            if ( FAILED(hr) )
+            {
+                printf( "Failed to create a %ux%ux%u image (%08X)\n",
+                        static_cast<unsigned int>( size.width ), static_cast<unsigned int>( size.height ),
+                        static_cast<unsigned int>( size.depth ), static_cast<unsigned int>( hr ) );
+                passed = false;
+                continue;
+            }
+
+            FillNoise( base, static_cast<uint32_t>( s + 1 ) );
+
+            char label[32];
+            sprintf_s( label, "%s%ux%u%s%u", volume ? "3D " : "", static_cast<unsigned int>( size.width ), static_cast<unsigned int>( size.height ),
+                       volume ? "x" : "[", static_cast<unsigned int>( size.depth ) );
+            if ( !volume )
+                strcat_s( label, "]" );
+
+            for( size_t i = 0; i < _countof(g_MipFilters); ++i )
+            {
+                const MipFilter& filter = g_MipFilters[ i ];
+
+                // The previous box kernels only handled power-of-2 sizes
+                if ( ( filter.filter & TEX_FILTER_MASK ) == TEX_FILTER_BOX
+                     && ( !ispow2( size.width ) || !ispow2( size.height ) || ( volume && !ispow2( size.depth ) ) ) )
+                    continue;
+
+                if ( !_BenchMips( base, format, filter, label ) )
+                    passed = false;
+            }
+        }
+    }
+
+    return passed;
+}
+
+}; // namespace
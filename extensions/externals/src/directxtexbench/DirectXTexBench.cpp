@@ -0,0 +1,151 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexBench.cpp
+//
+// DirectX Texture Library benchmark - Checks and times the optimized library paths
+// against the kernels they replaced
+//
+//   directxtexbench [-quick] [-mips] [-convert] [-bc45] [mask textures...]
+//
+// With no suite selected every suite runs. The exit code is non-zero if any output
+// from the library is outside the tolerance of the reference path.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#include "directxtexbench.h"
+
+#include <stdio.h>
+
+using namespace DirectX;
+
+namespace DirectXTexBench
+{
+
+//-------------------------------------------------------------------------------------
+// Helpers
+//-------------------------------------------------------------------------------------
+double GetTime()
+{
+    static LARGE_INTEGER s_frequency = { 0 };
+    if ( !s_frequency.QuadPart )
+        QueryPerformanceFrequency( &s_frequency );
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter( &now );
+
+    return double( now.QuadPart ) / double( s_frequency.QuadPart );
+}
+
+_Use_decl_annotations_
+void FillNoise( const ScratchImage& image, uint32_t seed )
+{
+    const Image* images = image.GetImages();
+    if ( !images )
+        return;
+
+    size_t width = image.GetMetadata().width;
+
+    ScopedAlignedArrayXMVECTOR scanline( reinterpret_cast<XMVECTOR*>( _aligned_malloc( sizeof(XMVECTOR)*width, 16 ) ) );
+    if ( !scanline )
+        return;
+
+    // Values are written through the library's own store routine so they are valid for any format
+    for( size_t index = 0; index < image.GetImageCount(); ++index )
+    {
+        const Image& img = images[ index ];
+        uint8_t* pDest = img.pixels;
+
+        for( size_t h = 0; h < img.height; ++h )
+        {
+            for( size_t x = 0; x < img.width; ++x )
+            {
+                float v[4];
+                for( size_t c = 0; c < 4; ++c )
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    v[ c ] = float( seed >> 8 ) / float( 1 << 24 );
+                }
+
+                scanline.get()[ x ] = XMVectorSet( v[0], v[1], v[2], v[3] );
+            }
+
+            _StoreScanline( pDest, img.rowPitch, img.format, scanline.get(), img.width );
+            pDest += img.rowPitch;
+        }
+    }
+}
+
+}; // namespace
+
+
+//-------------------------------------------------------------------------------------
+// Entry-point
+//-------------------------------------------------------------------------------------
+int __cdecl wmain( _In_ int argc, _In_z_count_(argc) wchar_t* argv[] )
+{
+    using namespace DirectXTexBench;
+
+    bool quick = false;
+    bool mips = false;
+    bool convert = false;
+    bool bc45 = false;
+
+    std::vector<const wchar_t*> files;
+
+    for( int arg = 1; arg < argc; ++arg )
+    {
+        const wchar_t* pArg = argv[ arg ];
+
+        if ( !_wcsicmp( pArg, L"-quick" ) )
+            quick = true;
+        else if ( !_wcsicmp( pArg, L"-mips" ) )
+            mips = true;
+        else if ( !_wcsicmp( pArg, L"-convert" ) )
+            convert = true;
+        else if ( !_wcsicmp( pArg, L"-bc45" ) )
+            bc45 = true;
+        else if ( pArg[0] == L'-' )
+        {
+            printf( "Usage: directxtexbench [-quick] [-mips] [-convert] [-bc45] [mask textures...]\n" );
+            return 1;
+        }
+        else
+            files.push_back( pArg );
+    }
+
+    if ( !mips && !convert && !bc45 )
+    {
+        mips = convert = bc45 = true;
+    }
+
+    // Needed to load mask textures through WIC
+    HRESULT hr = CoInitializeEx( nullptr, COINIT_MULTITHREADED );
+    if ( FAILED(hr) )
+    {
+        printf( "CoInitializeEx failed (%08X)\n", static_cast<unsigned int>( hr ) );
+        return 1;
+    }
+
+    bool passed = true;
+
+    if ( mips && !BenchMipMaps( quick ) )
+        passed = false;
+
+    if ( convert && !BenchConvert( quick ) )
+        passed = false;
+
+    if ( bc45 && !BenchBC4BC5( files.empty() ? nullptr : &files[0], files.size(), quick ) )
+        passed = false;
+
+    CoUninitialize();
+
+    printf( passed ? "\nAll checks passed\n" : "\nSome checks FAILED\n" );
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexBench.h
+//
+// DirectX Texture Library benchmark - Checks and times the optimized library paths
+// against the kernels they replaced
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+#if defined(_MSC_VER) && (_MSC_VER > 1000)
+#pragma once
+#endif
+
+#include "directxtexp.h"
+
+#include "BC.h"
+
+namespace DirectXTexBench
+{
+    //---------------------------------------------------------------------------------
+    // Benchmark suites
+    //
+    // Each suite prints one line per case and returns false if any output from the
+    // library falls outside the tolerance of the reference path. 'quick' runs a smaller
+    // set of sizes so the checks can be run as part of a build.
+    bool BenchMipMaps( _In_ bool quick );
+
+    bool BenchConvert( _In_ bool quick );
+
+    bool BenchBC4BC5( _In_reads_(nfiles) const wchar_t* const* files, _In_ size_t nfiles, _In_ bool quick );
+        // Encodes the given mask textures, or synthetic masks and normal maps if nfiles is 0
+
+    //---------------------------------------------------------------------------------
+    // Helpers
+    double GetTime();
+        // Seconds from a monotonic clock
+
+    void FillNoise( _In_ const DirectX::ScratchImage& image, _In_ uint32_t seed );
+        // Fills every image with repeatable values that are valid for the format
+
+    //---------------------------------------------------------------------------------
+    // Previous implementations
+    namespace Reference
+    {
+        HRESULT Generate2DMips( _In_ DWORD filter, _In_ size_t levels, _In_ const DirectX::ScratchImage& mipChain, _In_ size_t item );
+        HRESULT Generate3DMips( _In_ DWORD filter, _In_ size_t depth, _In_ size_t levels, _In_ const DirectX::ScratchImage& mipChain );
+            // The mip chain must already hold the base level, as set up by GenerateMipMaps
+
+        void EncodeBC4U( _Out_writes_(8) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const DirectX::XMVECTOR *pColor );
+        void EncodeBC4S( _Out_writes_(8) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const DirectX::XMVECTOR *pColor );
+        void EncodeBC5U( _Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const DirectX::XMVECTOR *pColor );
+        void EncodeBC5S( _Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const DirectX::XMVECTOR *pColor );
+    };
+};
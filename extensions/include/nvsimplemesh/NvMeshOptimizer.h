@@ -0,0 +1,71 @@
+//----------------------------------------------------------------------------------
+// File:        include\nvsimplemesh/NvMeshOptimizer.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#pragma once
+
+// Post-transform vertex cache behaviour of an index buffer, simulated with a FIFO cache
+struct NvVertexCacheStatistics
+{
+    UINT iVerticesTransformed;
+    float fACMR;        // Average cache miss ratio: vertices transformed per triangle
+    float fATVR;        // Average transform to vertex ratio: vertices transformed per vertex referenced
+};
+
+/*
+    Reorders indexed triangle lists to make them cheaper to draw. Vertices hold their position as the first three floats.
+
+    OptimizeVertexCache orders triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007).
+    OptimizeOverdraw then cuts that order into clusters and draws clusters that face away from the mesh center first,
+    so they occlude the rest; fThreshold is how much ACMR it may give up (1.05 allows 5%).
+    OptimizeVertexFetch renumbers vertices in the order the indices first use them, so vertex fetches walk memory in order.
+*/
+class NvMeshOptimizer
+{
+public:
+
+    static const UINT DEFAULT_CACHE_SIZE = 16;
+
+    static void OptimizeVertexCache(UINT *pIndices, UINT iNumIndices, UINT iNumVertices, UINT iCacheSize = DEFAULT_CACHE_SIZE);
+    static void OptimizeOverdraw(UINT *pIndices, UINT iNumIndices, const void *pVertices, UINT iVertexStride, UINT iNumVertices,
+                                 float fThreshold = 1.05f, UINT iCacheSize = DEFAULT_CACHE_SIZE);
+
+    // Unreferenced vertices are kept after the referenced ones; returns the number of referenced vertices
+    static UINT OptimizeVertexFetch(void *pVertices, UINT iVertexStride, UINT iNumVertices, UINT *pIndices, UINT iNumIndices);
+
+    static void AnalyzeVertexCache(const UINT *pIndices, UINT iNumIndices, UINT iNumVertices, UINT iCacheSize, NvVertexCacheStatistics *pStats);
+
+    // Runs all three passes. pRangeStarts holds iNumRanges + 1 index offsets (such as material subsets); triangles are
+    // only reordered within their range. Pass NULL to treat the whole buffer as one range. pBefore/pAfter may be NULL.
+    static void OptimizeMesh(void *pVertices, UINT iVertexStride, UINT iNumVertices, UINT *pIndices, UINT iNumIndices,
+                             const UINT *pRangeStarts, UINT iNumRanges,
+                             NvVertexCacheStatistics *pBefore, NvVertexCacheStatistics *pAfter);
+};
@@ -41,6 +41,11 @@ class NvSimpleRawMesh;
 
 /*
     Allow loading of various mesh file formats and then simple extraction of various vertex/index streams
+
+    After the first import the extracted meshes are written to a binary cache next to the source file
+    (<source>.nvmesh). Later loads of an unchanged source map the cache instead of running assimp, and the
+    meshes' vertex and index data point straight into the mapped view. The cache is keyed on the source
+    file's contents only, so files the source references (such as an .obj's .mtl) are not tracked.
 */
 class NvSimpleMeshLoader
 {
@@ -49,7 +54,7 @@ public:
     NvSimpleMeshLoader();
     ~NvSimpleMeshLoader();
 
-    bool LoadFile(LPWSTR szFilename);
+    bool LoadFile(LPWSTR szFilename, bool bUseCache = true);
     void RecurseAddMeshes(const aiScene *scene, aiNode*pNode,D3DXMATRIX *pParentCompositeTransformD3D, bool bFlattenTransforms);
 
     int NumMeshes;
@@ -57,5 +62,9 @@ public:
         
 protected:
 
+    bool LoadCache(LPCWSTR szCacheFilename, UINT64 sourceHash, UINT64 sourceSize);
+    void SaveCache(LPCWSTR szCacheFilename, UINT64 sourceHash, UINT64 sourceSize);
+
     std::string mediaPath;
+    void *pCacheView;       // Mapped .nvmesh file the meshes point into, if loaded from the cache
 };
@@ -33,6 +33,8 @@
 //----------------------------------------------------------------------------------
 #pragma once
 
+#include "NvMeshOptimizer.h"
+
 class NvSimpleRawMesh
 {
 public:
@@ -76,6 +78,10 @@ public:
     float m_extents[3];
     float m_center[3];
 
+    // Post-transform vertex cache behaviour of the index data before and after the loader reordered it
+    NvVertexCacheStatistics m_CacheStatsBefore;
+    NvVertexCacheStatistics m_CacheStatsAfter;
+
     WCHAR m_szMeshFilename[MAX_PATH];
     WCHAR m_szDiffuseTexture[MAX_PATH];
     WCHAR m_szNormalTexture[MAX_PATH];
@@ -0,0 +1,79 @@
+//----------------------------------------------------------------------------------
+// File:        include\nvsimplemesh/NvVertexWelder.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#pragma once
+#include <vector>
+
+/*
+    Welds vertices that share a key, such as the position/texcoord/normal index triple of an .obj
+    face vertex or the raw contents of a loaded vertex. Keys are fixed-size blocks of 32-bit words
+    kept in one flat array and found through an open-addressing table, so nothing is allocated
+    per vertex.
+*/
+class NvVertexWelder
+{
+public:
+
+    NvVertexWelder(UINT iKeySize);    // Key size in bytes; must be a multiple of 4
+    ~NvVertexWelder();
+
+    void Reserve(UINT iNumVertices);
+
+    // Returns the index stored with an identical key, or stores iNewIndex and returns it if there is none
+    UINT Weld(const void *pKey, UINT iNewIndex, bool *pbAdded = NULL);
+
+    UINT GetNumVertices() const { return UINT(m_Values.size()); }
+
+    // Releases all memory
+    void Clear();
+
+    // Welds an array of vertices by their contents. pRemap receives the new index of each vertex, with
+    // unique vertices numbered in the order they first appear; returns the number of unique vertices
+    static UINT WeldVertices(const void *pVertices, UINT iStride, UINT iNumVertices, UINT *pRemap);
+
+private:
+
+    UINT HashKey(const UINT *pKey) const;
+    void Rehash(size_t iNumSlots);
+
+    struct Slot
+    {
+        UINT iEntry;                // Entry index + 1, or 0 for an empty slot
+        UINT hash;
+    };
+
+    UINT m_iKeyWords;
+    std::vector<UINT> m_Keys;       // m_iKeyWords words per entry
+    std::vector<UINT> m_Values;
+    std::vector<Slot> m_Slots;
+    UINT m_iSlotMask;
+};
@@ -0,0 +1,399 @@
+//----------------------------------------------------------------------------------
+// File:        src\nvsimplemesh/NvMeshOptimizer.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <windows.h>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "NvMeshOptimizer.h"
+
+// FIFO cache simulation: a vertex is in the cache if fewer than iCacheSize vertices have been transformed since it was
+static inline UINT CacheMisses(const UINT *pTriangle, std::vector<UINT> &cacheTimestamps, UINT &timestamp, UINT iCacheSize)
+{
+    UINT misses = 0;
+    for(UINT k = 0; k < 3; k++)
+    {
+        UINT v = pTriangle[k];
+        if(timestamp - cacheTimestamps[v] > iCacheSize)
+        {
+            cacheTimestamps[v] = timestamp++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+static inline const float *GetPosition(const void *pVertices, UINT iVertexStride, UINT v)
+{
+    return reinterpret_cast<const float*>(static_cast<const BYTE*>(pVertices) + size_t(v) * iVertexStride);
+}
+
+void NvMeshOptimizer::OptimizeVertexCache(UINT *pIndices, UINT iNumIndices, UINT iNumVertices, UINT iCacheSize)
+{
+    const UINT iNumTriangles = iNumIndices / 3;
+    if(iNumTriangles == 0)
+        return;
+
+    // Triangles using each vertex, and how many of those are still to be emitted
+    std::vector<UINT> liveTriangles(iNumVertices, 0);
+    for(UINT i = 0; i < iNumTriangles * 3; i++)
+    {
+        assert(pIndices[i] < iNumVertices);
+        liveTriangles[pIndices[i]]++;
+    }
+
+    std::vector<UINT> adjacencyOffsets(iNumVertices + 1, 0);
+    for(UINT v = 0; v < iNumVertices; v++)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+    std::vector<UINT> adjacency(iNumTriangles * 3);
+    std::vector<UINT> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for(UINT i = 0; i < iNumTriangles * 3; i++)
+        adjacency[adjacencyFill[pIndices[i]]++] = i / 3;
+
+    std::vector<UINT> cacheTimestamps(iNumVertices, 0);
+    std::vector<BYTE> emitted(iNumTriangles, 0);
+    std::vector<UINT> deadEnd;
+    std::vector<UINT> candidates;
+    std::vector<UINT> output;
+    deadEnd.reserve(iNumTriangles * 3);
+    output.reserve(iNumTriangles * 3);
+
+    UINT timestamp = iCacheSize + 1;
+    UINT cursor = 0;
+    int fanningVertex = 0;
+
+    while(fanningVertex >= 0)
+    {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for(UINT a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; a++)
+        {
+            const UINT t = adjacency[a];
+            if(emitted[t])
+                continue;
+
+            for(UINT k = 0; k < 3; k++)
+            {
+                const UINT v = pIndices[t * 3 + k];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if(timestamp - cacheTimestamps[v] > iCacheSize)
+                    cacheTimestamps[v] = timestamp++;
+            }
+            emitted[t] = 1;
+        }
+
+        // Fan next around the oldest candidate that will still be cached once its own triangles are emitted
+        fanningVertex = -1;
+        int bestPriority = -1;
+        for(size_t c = 0; c < candidates.size(); c++)
+        {
+            const UINT v = candidates[c];
+            if(liveTriangles[v] == 0)
+                continue;
+
+            int priority = 0;
+            if(timestamp - cacheTimestamps[v] + 2 * liveTriangles[v] <= iCacheSize)
+                priority = int(timestamp - cacheTimestamps[v]);
+
+            if(priority > bestPriority)
+            {
+                bestPriority = priority;
+                fanningVertex = int(v);
+            }
+        }
+
+        // Dead end: back up through recently used vertices, then scan for any vertex with triangles left
+        while(fanningVertex < 0 && !deadEnd.empty())
+        {
+            const UINT v = deadEnd.back();
+            deadEnd.pop_back();
+            if(liveTriangles[v] > 0)
+                fanningVertex = int(v);
+        }
+        while(fanningVertex < 0 && cursor < iNumVertices)
+        {
+            if(liveTriangles[cursor] > 0)
+                fanningVertex = int(cursor);
+            else
+                cursor++;
+        }
+    }
+
+    assert(output.size() == iNumTriangles * 3);
+    memcpy(pIndices, &output[0], output.size() * sizeof(UINT));
+}
+
+void NvMeshOptimizer::OptimizeOverdraw(UINT *pIndices, UINT iNumIndices, const void *pVertices, UINT iVertexStride, UINT iNumVertices,
+                                       float fThreshold, UINT iCacheSize)
+{
+    const UINT iNumTriangles = iNumIndices / 3;
+    if(iNumTriangles < 2)
+        return;
+
+    std::vector<UINT> cacheTimestamps(iNumVertices, 0);
+    UINT timestamp = iCacheSize + 1;
+
+    // Hard boundaries are triangles that miss on all three vertices, which is where the cache order jumped
+    std::vector<UINT> hardClusters;
+    for(UINT t = 0; t < iNumTriangles; t++)
+    {
+        if(CacheMisses(&pIndices[t * 3], cacheTimestamps, timestamp, iCacheSize) == 3 || t == 0)
+            hardClusters.push_back(t);
+    }
+    hardClusters.push_back(iNumTriangles);
+
+    // Split each hard cluster further as soon as its running ACMR comes within fThreshold of the whole cluster's
+    std::vector<UINT> clusters;
+    for(size_t h = 0; h + 1 < hardClusters.size(); h++)
+    {
+        const UINT start = hardClusters[h];
+        const UINT end = hardClusters[h + 1];
+
+        timestamp += iCacheSize + 1;
+        UINT clusterMisses = 0;
+        for(UINT t = start; t < end; t++)
+            clusterMisses += CacheMisses(&pIndices[t * 3], cacheTimestamps, timestamp, iCacheSize);
+
+        const float fClusterThreshold = fThreshold * float(clusterMisses) / float(end - start);
+
+        clusters.push_back(start);
+        timestamp += iCacheSize + 1;
+
+        UINT runningMisses = 0;
+        UINT runningTriangles = 0;
+        for(UINT t = start; t + 1 < end; t++)
+        {
+            runningMisses += CacheMisses(&pIndices[t * 3], cacheTimestamps, timestamp, iCacheSize);
+            runningTriangles++;
+
+            if(float(runningMisses) <= fClusterThreshold * float(runningTriangles))
+            {
+                clusters.push_back(t + 1);
+                timestamp += iCacheSize + 1;
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+    }
+    clusters.push_back(iNumTriangles);
+
+    const size_t iNumClusters = clusters.size() - 1;
+    if(iNumClusters < 2)
+        return;
+
+    // Mesh center
+    float meshCenter[3] = { 0.f, 0.f, 0.f };
+    for(UINT v = 0; v < iNumVertices; v++)
+    {
+        const float *p = GetPosition(pVertices, iVertexStride, v);
+        meshCenter[0] += p[0];
+        meshCenter[1] += p[1];
+        meshCenter[2] += p[2];
+    }
+    for(int m = 0; m < 3; m++)
+        meshCenter[m] /= float(max(iNumVertices, 1u));
+
+    // Sort clusters by how far their area weighted center lies out along their average normal
+    std::vector<std::pair<float, UINT> > sortKeys(iNumClusters);
+    for(size_t c = 0; c < iNumClusters; c++)
+    {
+        float center[3] = { 0.f, 0.f, 0.f };
+        float normal[3] = { 0.f, 0.f, 0.f };
+        float area = 0.f;
+
+        for(UINT t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            const float *p0 = GetPosition(pVertices, iVertexStride, pIndices[t * 3 + 0]);
+            const float *p1 = GetPosition(pVertices, iVertexStride, pIndices[t * 3 + 1]);
+            const float *p2 = GetPosition(pVertices, iVertexStride, pIndices[t * 3 + 2]);
+
+            const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            const float triangleArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for(int m = 0; m < 3; m++)
+            {
+                center[m] += (p0[m] + p1[m] + p2[m]) * (triangleArea / 3.f);
+                normal[m] += n[m];
+            }
+            area += triangleArea;
+        }
+
+        const float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+        float key = 0.f;
+        if(area > 0.f && normalLength > 0.f)
+        {
+            for(int m = 0; m < 3; m++)
+                key += (center[m] / area - meshCenter[m]) * normal[m];
+            key /= normalLength;
+        }
+
+        sortKeys[c] = std::make_pair(-key, UINT(c));
+    }
+    std::stable_sort(sortKeys.begin(), sortKeys.end());
+
+    std::vector<UINT> output;
+    output.reserve(iNumTriangles * 3);
+    for(size_t i = 0; i < iNumClusters; i++)
+    {
+        const UINT c = sortKeys[i].second;
+        output.insert(output.end(), pIndices + clusters[c] * 3, pIndices + clusters[c + 1] * 3);
+    }
+
+    memcpy(pIndices, &output[0], output.size() * sizeof(UINT));
+}
+
+UINT NvMeshOptimizer::OptimizeVertexFetch(void *pVertices, UINT iVertexStride, UINT iNumVertices, UINT *pIndices, UINT iNumIndices)
+{
+    const UINT NOT_REMAPPED = UINT(-1);
+    std::vector<UINT> remap(iNumVertices, NOT_REMAPPED);
+
+    UINT iNextVertex = 0;
+    for(UINT i = 0; i < iNumIndices; i++)
+    {
+        UINT &newIndex = remap[pIndices[i]];
+        if(newIndex == NOT_REMAPPED)
+            newIndex = iNextVertex++;
+        pIndices[i] = newIndex;
+    }
+
+    const UINT iNumReferenced = iNextVertex;
+    for(UINT v = 0; v < iNumVertices; v++)
+    {
+        if(remap[v] == NOT_REMAPPED)
+            remap[v] = iNextVertex++;
+    }
+
+    std::vector<BYTE> original(static_cast<BYTE*>(pVertices), static_cast<BYTE*>(pVertices) + size_t(iNumVertices) * iVertexStride);
+    for(UINT v = 0; v < iNumVertices; v++)
+        memcpy(static_cast<BYTE*>(pVertices) + size_t(remap[v]) * iVertexStride, &original[size_t(v) * iVertexStride], iVertexStride);
+
+    return iNumReferenced;
+}
+
+void NvMeshOptimizer::AnalyzeVertexCache(const UINT *pIndices, UINT iNumIndices, UINT iNumVertices, UINT iCacheSize, NvVertexCacheStatistics *pStats)
+{
+    std::vector<UINT> cacheTimestamps(iNumVertices, 0);
+    std::vector<BYTE> referenced(iNumVertices, 0);
+    UINT timestamp = iCacheSize + 1;
+    UINT iNumReferenced = 0;
+
+    const UINT iNumTriangles = iNumIndices / 3;
+    UINT misses = 0;
+    for(UINT t = 0; t < iNumTriangles; t++)
+    {
+        misses += CacheMisses(&pIndices[t * 3], cacheTimestamps, timestamp, iCacheSize);
+        for(UINT k = 0; k < 3; k++)
+        {
+            BYTE &bReferenced = referenced[pIndices[t * 3 + k]];
+            iNumReferenced += bReferenced ? 0 : 1;
+            bReferenced = 1;
+        }
+    }
+
+    pStats->iVerticesTransformed = misses;
+    pStats->fACMR = iNumTriangles ? float(misses) / float(iNumTriangles) : 0.f;
+    pStats->fATVR = iNumReferenced ? float(misses) / float(iNumReferenced) : 0.f;
+}
+
+void NvMeshOptimizer::OptimizeMesh(void *pVertices, UINT iVertexStride, UINT iNumVertices, UINT *pIndices, UINT iNumIndices,
+                                   const UINT *pRangeStarts, UINT iNumRanges,
+                                   NvVertexCacheStatistics *pBefore, NvVertexCacheStatistics *pAfter)
+{
+    if(pBefore)
+        AnalyzeVertexCache(pIndices, iNumIndices, iNumVertices, DEFAULT_CACHE_SIZE, pBefore);
+
+    const UINT wholeBuffer[2] = { 0, iNumIndices };
+    if(!pRangeStarts)
+    {
+        pRangeStarts = wholeBuffer;
+        iNumRanges = 1;
+    }
+
+    // Each range is optimized on compact local indices, so the passes cost its own size rather than the whole mesh's
+    const UINT NOT_MAPPED = UINT(-1);
+    std::vector<UINT> localIndex(iNumVertices, NOT_MAPPED);
+    std::vector<UINT> localVertices;
+    std::vector<float> localPositions;
+    std::vector<UINT> localIndices;
+
+    for(UINT r = 0; r < iNumRanges; r++)
+    {
+        const UINT start = pRangeStarts[r];
+        const UINT count = pRangeStarts[r + 1] - start;
+        assert(start % 3 == 0 && count % 3 == 0);
+
+        localVertices.clear();
+        localPositions.clear();
+        localIndices.resize(count);
+        for(UINT i = 0; i < count; i++)
+        {
+            const UINT v = pIndices[start + i];
+            if(localIndex[v] == NOT_MAPPED)
+            {
+                localIndex[v] = UINT(localVertices.size());
+                localVertices.push_back(v);
+
+                const float *p = GetPosition(pVertices, iVertexStride, v);
+                localPositions.insert(localPositions.end(), p, p + 3);
+            }
+            localIndices[i] = localIndex[v];
+        }
+
+        if(count >= 3)
+        {
+            const UINT iNumLocal = UINT(localVertices.size());
+            OptimizeVertexCache(&localIndices[0], count, iNumLocal);
+            OptimizeOverdraw(&localIndices[0], count, &localPositions[0], 3 * sizeof(float), iNumLocal);
+        }
+
+        for(UINT i = 0; i < count; i++)
+            pIndices[start + i] = localVertices[localIndices[i]];
+
+        for(size_t v = 0; v < localVertices.size(); v++)
+            localIndex[localVertices[v]] = NOT_MAPPED;
+    }
+
+    OptimizeVertexFetch(pVertices, iVertexStride, iNumVertices, pIndices, iNumIndices);
+
+    if(pAfter)
+        AnalyzeVertexCache(pIndices, iNumIndices, iNumVertices, DEFAULT_CACHE_SIZE, pAfter);
+}
@@ -69,7 +69,11 @@
 
 
 #include "strsafe.h"
+#include <process.h>
+#include <xmmintrin.h>
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "assimp\assimp.hpp"
 #include "assimp\aiScene.h"
@@ -81,30 +85,417 @@ using namespace Assimp;
 
 #include "NvSimpleRawMesh.h"
 #include "NvSimpleMeshLoader.h"
+#include "NvMeshOptimizer.h"
+
+
+// Post-processing run on import. Both sets of flags are stored in the cache, so changing them invalidates old caches
+static const UINT NV_MESH_IMPORT_FLAGS = aiProcess_Triangulate|    // only higher order primitives will be triangulated
+                                         aiProcess_GenNormals|    // if normals exist, will not be generated
+                                         aiProcess_CalcTangentSpace|
+                                         aiProcess_PreTransformVertices| // rolls all node hierarchy(if existant) into the local space of meshes
+                                         //aiProcess_RemoveRedundantMaterials|
+                                         //aiProcess_FixInfacingNormals|
+                                         aiProcess_FindDegenerates|
+                                         aiProcess_SortByPType|
+                                         aiProcess_RemoveComponent|    // processes the flags below to remove data we don't want
+                                         aiProcess_FindInvalidData|
+                                         aiProcess_GenUVCoords|
+                                         aiProcess_TransformUVCoords|
+                                         aiProcess_OptimizeMeshes |
+
+                                         aiProcessPreset_TargetRealtime_Quality;
+
+static const UINT NV_MESH_REMOVE_COMPONENTS = aiComponent_ANIMATIONS | aiComponent_BONEWEIGHTS | aiComponent_COLORS | aiComponent_LIGHTS | aiComponent_CAMERAS;
+
+/*
+    .nvmesh cache layout: a header, one record per mesh, then each mesh's vertex and index data ready for
+    upload. Data blocks are aligned to NV_MESH_CACHE_ALIGNMENT bytes within the file.
+*/
+static const DWORD NV_MESH_CACHE_MAGIC = MAKEFOURCC('N','V','M','C');
+static const DWORD NV_MESH_CACHE_VERSION = 4;
+static const UINT64 NV_MESH_CACHE_ALIGNMENT = 16;
+
+struct NvMeshCacheHeader
+{
+    DWORD dwMagic;
+    DWORD dwVersion;
+    UINT64 SourceHash;
+    UINT64 SourceSize;
+    DWORD dwImportFlags;
+    DWORD dwRemoveComponents;
+    DWORD dwVertexStride;
+    DWORD dwNumMeshes;
+    UINT64 FileSize;
+};
+
+struct NvMeshCacheRecord
+{
+    UINT64 VertexOffset;
+    UINT64 IndexOffset;
+    UINT NumVertices;
+    UINT NumIndices;
+    UINT IndexSize;
+    float Extents[3];
+    float Center[3];
+    NvVertexCacheStatistics CacheStatsBefore;
+    NvVertexCacheStatistics CacheStatsAfter;
+    CHAR szDiffuseTexture[MAX_PATH];    // Relative to the source file's folder, or empty
+    CHAR szNormalTexture[MAX_PATH];
+};
+
+static UINT64 AlignCacheOffset(UINT64 offset)
+{
+    return (offset + NV_MESH_CACHE_ALIGNMENT - 1) & ~(NV_MESH_CACHE_ALIGNMENT - 1);
+}
+
+// 64 bit FNV-1a over whole words, with the high bits folded back down each step so every byte reaches the low bits
+static UINT64 HashCacheSource(const BYTE *pData, SIZE_T size)
+{
+    UINT64 hash = 14695981039346656037ULL;
+    const UINT64 prime = 1099511628211ULL;
+
+    SIZE_T i = 0;
+    for(;i + sizeof(UINT64) <= size;i += sizeof(UINT64))
+    {
+        UINT64 word;
+        memcpy(&word,pData + i,sizeof(UINT64));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 32;
+    }
+    for(;i < size;i++)
+    {
+        hash = (hash ^ pData[i]) * prime;
+    }
+
+    return hash;
+}
+
+static bool HashSourceFile(LPCWSTR szFilename, UINT64 *pHash, UINT64 *pSize)
+{
+    HANDLE hFile = CreateFileW(szFilename,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+    if(hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool bHashed = false;
+
+    LARGE_INTEGER fileSize;
+    if(GetFileSizeEx(hFile,&fileSize) && fileSize.QuadPart > 0 && UINT64(fileSize.QuadPart) <= SIZE_T(-1))
+    {
+        HANDLE hMapping = CreateFileMappingW(hFile,NULL,PAGE_READONLY,0,0,NULL);
+        if(hMapping)
+        {
+            const BYTE *pData = (const BYTE*)MapViewOfFile(hMapping,FILE_MAP_READ,0,0,0);
+            if(pData)
+            {
+                *pHash = HashCacheSource(pData,SIZE_T(fileSize.QuadPart));
+                *pSize = UINT64(fileSize.QuadPart);
+                bHashed = true;
+
+                UnmapViewOfFile(pData);
+            }
+            CloseHandle(hMapping);
+        }
+    }
+    CloseHandle(hFile);
+
+    return bHashed;
+}
+
+// Texture paths are stored relative to the media path so a cache stays valid if the media folder moves
+static bool MakeRelativeTexturePath(const std::string &mediaPath, const WCHAR *szTexture, CHAR *szRelative)
+{
+    szRelative[0] = 0;
+    if(szTexture[0] == 0)
+        return true;
+
+    CHAR szTextureA[MAX_PATH];
+    if(!WideCharToMultiByte(CP_ACP,0,szTexture,-1,szTextureA,MAX_PATH,NULL,NULL))
+        return false;
+
+    if(strncmp(szTextureA,mediaPath.c_str(),mediaPath.size()) != 0 || szTextureA[mediaPath.size()] == 0)
+        return false;
+
+    return SUCCEEDED(StringCchCopyA(szRelative,MAX_PATH,szTextureA + mediaPath.size()));
+}
+
+// Texture paths reported by assimp are relative to the media path
+static void QualifyTexturePath(const std::string &mediaPath, const CHAR *szRelative, WCHAR *szTexture)
+{
+    std::string qualifiedPath = mediaPath + szRelative;
+
+    CHAR szFilenameA[MAX_PATH];
+    StringCchCopyA(szFilenameA,MAX_PATH,qualifiedPath.c_str());
+    MultiByteToWideChar(CP_ACP,0,szFilenameA,MAX_PATH,szTexture,MAX_PATH);
+}
+
+// Writes a block at the given offset, zero filling the gap left by alignment since the previous block
+static bool WriteCacheBlock(HANDLE hFile, UINT64 *pPosition, UINT64 offset, const void *pData, UINT64 size)
+{
+    static const BYTE padding[NV_MESH_CACHE_ALIGNMENT] = {0};
+    assert(offset >= *pPosition && offset - *pPosition < NV_MESH_CACHE_ALIGNMENT);
+
+    DWORD dwWritten;
+    DWORD dwPadding = DWORD(offset - *pPosition);
+    if(dwPadding > 0 && (!WriteFile(hFile,padding,dwPadding,&dwWritten,NULL) || dwWritten != dwPadding))
+        return false;
+
+    *pPosition = offset;
+
+    const BYTE *pBytes = (const BYTE*)pData;
+    while(size > 0)
+    {
+        DWORD dwChunk = DWORD(min(size,UINT64(1) << 30));
+        if(!WriteFile(hFile,pBytes,dwChunk,&dwWritten,NULL) || dwWritten != dwChunk)
+            return false;
+
+        pBytes += dwChunk;
+        size -= dwChunk;
+        *pPosition += dwChunk;
+    }
+
+    return true;
+}
+
+// A submesh referenced by the node tree, converted on whichever thread picks it up
+struct NvMeshImportJob
+{
+    UINT iMesh;
+    D3DXMATRIX Transform;   // aiProcess_PreTransformVertices has already applied this to the vertices
+};
+
+struct NvMeshImportContext
+{
+    const aiScene *scene;
+    NvSimpleRawMesh *pMeshes;
+    const std::string *pMediaPath;
+    const NvMeshImportJob *pJobs;
+    LONG numJobs;
+    volatile LONG nextJob;
+};
+
+static void CollectMeshJobs(const aiScene *scene, aiNode *pNode, const D3DXMATRIX *pParentCompositeTransformD3D, bool bFlattenTransforms,
+                            std::vector<NvMeshImportJob> &jobs, std::vector<bool> &bMeshQueued)
+{
+    D3DXMATRIX LocalFrameTransformD3D;
+    D3DXMatrixTranspose(&LocalFrameTransformD3D,(D3DXMATRIX*)&pNode->mTransformation);    // transpose to convert from ai to d3d
+
+    D3DXMATRIX LocalCompositeTransformD3D;
+    D3DXMatrixMultiply(&LocalCompositeTransformD3D,&LocalFrameTransformD3D,pParentCompositeTransformD3D);
+
+    D3DXMATRIX *pActiveTransform = &LocalFrameTransformD3D;
+    if(bFlattenTransforms) pActiveTransform = &LocalCompositeTransformD3D;
+
+    for(int iSubMesh=0;iSubMesh < (int)pNode->mNumMeshes;iSubMesh++)
+    {
+        // Each mesh is converted once, even if several nodes instance it
+        UINT iMesh = pNode->mMeshes[iSubMesh];
+        if(bMeshQueued[iMesh])
+            continue;
+        bMeshQueued[iMesh] = true;
+
+        NvMeshImportJob job;
+        job.iMesh = iMesh;
+        job.Transform = *pActiveTransform;
+        jobs.push_back(job);
+    }
+
+    for(int iChild=0;iChild<(int)pNode->mNumChildren;iChild++)
+    {
+        CollectMeshJobs(scene,pNode->mChildren[iChild],&LocalCompositeTransformD3D,bFlattenTransforms,jobs,bMeshQueued);
+    }
+}
+
+/*
+    Interleaves positions, normals, uvs and tangents into our vertex struct and accumulates the position bounds.
+    Every source stream is 12 bytes per vertex, so each SSE load picks up the first float of the next vertex, and
+    the 16 byte tangent store spills into the next vertex's position before that vertex is written. The last
+    vertex is done in scalar code so neither runs past the end of an array.
+*/
+static void ConvertVertices(const aiMesh *pMesh, NvSimpleRawMesh::Vertex *pVertices, float emin[3], float emax[3])
+{
+    static_assert(sizeof(NvSimpleRawMesh::Vertex) == 11 * sizeof(float),"ConvertVertices assumes a packed position/normal/uv/tangent vertex");
+
+    const float *pPositions = &pMesh->mVertices[0].x;
+    const float *pNormals = &pMesh->mNormals[0].x;
+    const float *pUVs = &pMesh->mTextureCoords[0][0].x;
+    const float *pTangents = &pMesh->mTangents[0].x;
+    const UINT numVertices = pMesh->mNumVertices;
+
+    __m128 vMin = _mm_setr_ps(emin[0],emin[1],emin[2],0.f);
+    __m128 vMax = _mm_setr_ps(emax[0],emax[1],emax[2],0.f);
+
+    UINT i = 0;
+    for(;i + 1 < numVertices;i++)
+    {
+        __m128 vPosition = _mm_loadu_ps(pPositions + i * 3);    // p0 p1 p2 -
+        __m128 vNormal = _mm_loadu_ps(pNormals + i * 3);        // n0 n1 n2 -
+        __m128 vUV = _mm_loadu_ps(pUVs + i * 3);                // u0 u1 -  -
+        __m128 vTangent = _mm_loadu_ps(pTangents + i * 3);      // t0 t1 t2 -
+
+        __m128 vP2N0 = _mm_shuffle_ps(vPosition,vNormal,_MM_SHUFFLE(0,0,2,2));
+        float *pOut = pVertices[i].Position;
+        _mm_storeu_ps(pOut,_mm_shuffle_ps(vPosition,vP2N0,_MM_SHUFFLE(2,0,1,0)));   // p0 p1 p2 n0
+        _mm_storeu_ps(pOut + 4,_mm_shuffle_ps(vNormal,vUV,_MM_SHUFFLE(1,0,2,1)));   // n1 n2 u0 u1
+        _mm_storeu_ps(pOut + 8,vTangent);                                            // t0 t1 t2, spills
+
+        vMin = _mm_min_ps(vMin,vPosition);
+        vMax = _mm_max_ps(vMax,vPosition);
+    }
+
+    // The fourth lane saw the next vertex's x, which is already counted in the first lane
+    float fMin[4], fMax[4];
+    _mm_storeu_ps(fMin,vMin);
+    _mm_storeu_ps(fMax,vMax);
+
+    for(int m=0;m<3;m++)
+    {
+        emin[m] = fMin[m];
+        emax[m] = fMax[m];
+    }
+
+    if(i < numVertices)
+    {
+        memcpy((void*)&(pVertices[i].Position),(void*)&(pMesh->mVertices[i]),sizeof(aiVector3D));
+        memcpy((void*)&(pVertices[i].Normal),(void*)&(pMesh->mNormals[i]),sizeof(aiVector3D));
+        memcpy((void*)&(pVertices[i].Tangent),(void*)&(pMesh->mTangents[i]),sizeof(aiVector3D));
+        memcpy((void*)&(pVertices[i].UV),(void*)&(pMesh->mTextureCoords[0][i]),sizeof(aiVector2D));
+
+        for(int m=0;m<3;m++)
+        {
+            emin[m] = min(emin[m],pVertices[i].Position[m]);
+            emax[m] = max(emax[m],pVertices[i].Position[m]);
+        }
+    }
+}
+
+static void ConvertMesh(const aiScene *scene, UINT iMesh, NvSimpleRawMesh &activeMesh, const std::string &mediaPath)
+{
+    const aiMesh *pMesh = scene->mMeshes[iMesh];
+
+    if(!(pMesh->HasPositions() && pMesh->HasNormals() && pMesh->HasTextureCoords(0) && pMesh->HasTangentsAndBitangents()))
+        return;
+
+    float emin[3]; ::ZeroMemory(emin,3*sizeof(float));
+    float emax[3]; ::ZeroMemory(emax,3*sizeof(float));
+
+    activeMesh.m_iNumIndices = pMesh->mNumFaces*3;
+    activeMesh.m_iNumVertices = pMesh->mNumVertices;
+
+    // copy loaded mesh data into our vertex struct
+    activeMesh.m_pVertexData = new NvSimpleRawMesh::Vertex[pMesh->mNumVertices];
+    ConvertVertices(pMesh,activeMesh.m_pVertexData,emin,emax);
+
+    std::vector<UINT> indices(pMesh->mNumFaces * 3);
+    for(unsigned int i=0;i<pMesh->mNumFaces;i++)
+    {
+        assert(pMesh->mFaces[i].mNumIndices == 3);
+        memcpy(&indices[i*3],pMesh->mFaces[i].mIndices,3*sizeof(UINT));
+    }
+
+    // reorder for the vertex cache, overdraw and vertex fetch; this is done before caching, so warm loads get it for free
+    if(!indices.empty())
+    {
+        NvMeshOptimizer::OptimizeMesh(activeMesh.m_pVertexData,sizeof(NvSimpleRawMesh::Vertex),activeMesh.m_iNumVertices,&indices[0],UINT(indices.size()),NULL,0,
+                                      &activeMesh.m_CacheStatsBefore,&activeMesh.m_CacheStatsAfter);
+    }
+
+    // create an index buffer
+    activeMesh.m_IndexSize = sizeof(UINT16);
+    if(pMesh->mNumFaces > MAXINT16)
+        activeMesh.m_IndexSize = sizeof(UINT32);
+
+    activeMesh.m_pIndexData = new BYTE[pMesh->mNumFaces * 3 * activeMesh.m_IndexSize];
+    if(activeMesh.m_IndexSize == sizeof(UINT32))
+    {
+        memcpy(activeMesh.m_pIndexData,&indices[0],indices.size()*sizeof(UINT32));
+    }
+    else    // 16 bit indices
+    {
+        UINT16*pIndices16 = (UINT16*)activeMesh.m_pIndexData;
+        for(size_t i=0;i<indices.size();i++)
+            pIndices16[i] = (UINT16)indices[i];
+    }
+
+    // assign extents
+    activeMesh.m_extents[0] = (emax[0] - emin[0]) * 0.5f;
+    activeMesh.m_extents[1] = (emax[1] - emin[1]) * 0.5f;
+    activeMesh.m_extents[2] = (emax[2] - emin[2]) * 0.5f;
+
+    // get the center
+    activeMesh.m_center[0] = emin[0] + activeMesh.m_extents[0];
+    activeMesh.m_center[1] = emin[1] + activeMesh.m_extents[1];
+    activeMesh.m_center[2] = emin[2] + activeMesh.m_extents[2];
+
+    // materials
+    if(scene->HasMaterials())
+    {
+        const aiMaterial *pMaterial = scene->mMaterials[pMesh->mMaterialIndex];
+
+        if(pMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0)
+        {
+            aiString texPath;
+            pMaterial->GetTexture(aiTextureType_DIFFUSE,0,&texPath);
+            QualifyTexturePath(mediaPath,texPath.data,activeMesh.m_szDiffuseTexture);
+        }
+        if(pMaterial->GetTextureCount(aiTextureType_NORMALS) > 0)
+        {
+            aiString texPath;
+            pMaterial->GetTexture(aiTextureType_NORMALS,0,&texPath);
+            QualifyTexturePath(mediaPath,texPath.data,activeMesh.m_szNormalTexture);
+        }
+    }
+}
+
+static void ConvertMeshJobs(NvMeshImportContext &context)
+{
+    for(;;)
+    {
+        LONG iJob = InterlockedIncrement(&context.nextJob) - 1;
+        if(iJob >= context.numJobs)
+            break;
+
+        const UINT iMesh = context.pJobs[iJob].iMesh;
+        ConvertMesh(context.scene,iMesh,context.pMeshes[iMesh],*context.pMediaPath);
+    }
+}
+
+static unsigned __stdcall ConvertMeshJobsThread(void *pParam)
+{
+    ConvertMeshJobs(*reinterpret_cast<NvMeshImportContext*>(pParam));
+    return 0;
+}
 
 
 NvSimpleMeshLoader::NvSimpleMeshLoader()
 {
     pMeshes = NULL;
     NumMeshes = 0;
+    pCacheView = NULL;
 }
 
 NvSimpleMeshLoader::~NvSimpleMeshLoader()
 {
+    if(pCacheView)
+    {
+        // Meshes loaded from the cache point into the mapped view and must not free their data
+        for(int iMesh=0;iMesh<NumMeshes;iMesh++)
+        {
+            pMeshes[iMesh].m_pVertexData = NULL;
+            pMeshes[iMesh].m_pIndexData = NULL;
+        }
+    }
+
     SAFE_DELETE_ARRAY(pMeshes);
+
+    if(pCacheView)
+        UnmapViewOfFile(pCacheView);
 }
 
-bool NvSimpleMeshLoader::LoadFile(LPWSTR szFilename)
+bool NvSimpleMeshLoader::LoadFile(LPWSTR szFilename, bool bUseCache)
 {
     bool bLoaded = false;
     (void)bLoaded;
 
-    // Create a logger instance 
-    Assimp::DefaultLogger::create("",Logger::VERBOSE);
-
-    // Create an instance of the Importer class
-    Assimp::Importer importer;
-
     CHAR szFilenameA[MAX_PATH];
     WideCharToMultiByte(CP_ACP,0,szFilename,MAX_PATH,szFilenameA,MAX_PATH,NULL,false);
 
@@ -115,28 +506,32 @@ bool NvSimpleMeshLoader::LoadFile(LPWSTR szFilename)
     else
         mediaPath = ".\\";
 
+    // An up to date cache skips the importer entirely
+    WCHAR szCacheFilename[MAX_PATH];
+    UINT64 sourceHash = 0;
+    UINT64 sourceSize = 0;
+    if(bUseCache)
+    {
+        bUseCache = SUCCEEDED(StringCchCopyW(szCacheFilename,MAX_PATH,szFilename)) &&
+                    SUCCEEDED(StringCchCatW(szCacheFilename,MAX_PATH,L".nvmesh")) &&
+                    HashSourceFile(szFilename,&sourceHash,&sourceSize);
+
+        if(bUseCache && LoadCache(szCacheFilename,sourceHash,sourceSize))
+            return true;
+    }
+
+    // Create a logger instance 
+    Assimp::DefaultLogger::create("",Logger::VERBOSE);
+
+    // Create an instance of the Importer class
+    Assimp::Importer importer;
+
     // Set some flags for the removal of various data that we don't use
-    importer.SetPropertyInteger("AI_CONFIG_PP_RVC_FLAGS",aiComponent_ANIMATIONS | aiComponent_BONEWEIGHTS | aiComponent_COLORS | aiComponent_LIGHTS | aiComponent_CAMERAS);
+    importer.SetPropertyInteger("AI_CONFIG_PP_RVC_FLAGS",NV_MESH_REMOVE_COMPONENTS);
     //importer.SetPropertyInteger("AI_CONFIG_PP_SBP_REMOVE",aiPrimitiveType_POINTS | aiPrimitiveType_LINES );
 
     // load the scene and preprocess it into the form we want
-    const aiScene *scene = importer.ReadFile(szFilenameA,
-                                                aiProcess_Triangulate|    // only higher order primitives will be triangulated
-                                                aiProcess_GenNormals|    // if normals exist, will not be generated
-                                                aiProcess_CalcTangentSpace|
-                                                aiProcess_PreTransformVertices| // rolls all node hierarchy(if existant) into the local space of meshes
-                                                //aiProcess_RemoveRedundantMaterials|
-                                                //aiProcess_FixInfacingNormals|
-                                                aiProcess_FindDegenerates|
-                                                aiProcess_SortByPType|
-                                                aiProcess_RemoveComponent|    // processes the above flags set to remove data we don't want
-                                                aiProcess_FindInvalidData|
-                                                aiProcess_GenUVCoords|
-                                                aiProcess_TransformUVCoords|
-                                                aiProcess_OptimizeMeshes |
-
-                                                aiProcessPreset_TargetRealtime_Quality
-                                                );
+    const aiScene *scene = importer.ReadFile(szFilenameA,NV_MESH_IMPORT_FLAGS);
 
     // can't load?
     if(!scene)
@@ -156,131 +551,228 @@ bool NvSimpleMeshLoader::LoadFile(LPWSTR szFilename)
     // cleanup
     Assimp::DefaultLogger::kill();
 
+    if(bUseCache && NumMeshes > 0)
+        SaveCache(szCacheFilename,sourceHash,sourceSize);
+
     return NumMeshes > 0;
 }
 
-void NvSimpleMeshLoader::RecurseAddMeshes(const aiScene *scene, aiNode*pNode,D3DXMATRIX *pParentCompositeTransformD3D, bool bFlattenTransforms)
+bool NvSimpleMeshLoader::LoadCache(LPCWSTR szCacheFilename, UINT64 sourceHash, UINT64 sourceSize)
 {
-    D3DXMATRIX LocalFrameTransformD3D;
-    D3DXMatrixTranspose(&LocalFrameTransformD3D,(D3DXMATRIX*)&pNode->mTransformation);    // transpose to convert from ai to d3d
-
-    D3DXMATRIX LocalCompositeTransformD3D;
-    D3DXMatrixMultiply(&LocalCompositeTransformD3D,&LocalFrameTransformD3D,pParentCompositeTransformD3D);
+    HANDLE hFile = CreateFileW(szCacheFilename,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if(hFile == INVALID_HANDLE_VALUE)
+        return false;
 
-    D3DXMATRIX *pActiveTransform = &LocalFrameTransformD3D;
-    if(bFlattenTransforms) pActiveTransform = &LocalCompositeTransformD3D;
+    BYTE *pData = NULL;
 
-    if(pNode->mNumMeshes > 0)
+    LARGE_INTEGER fileSize;
+    if(GetFileSizeEx(hFile,&fileSize) && UINT64(fileSize.QuadPart) >= sizeof(NvMeshCacheHeader) && UINT64(fileSize.QuadPart) <= SIZE_T(-1))
     {
-        for(int iSubMesh=0;iSubMesh < (int)pNode->mNumMeshes;iSubMesh++)
+        // Copy on write, so callers can still modify the vertex and index data in place
+        HANDLE hMapping = CreateFileMappingW(hFile,NULL,PAGE_WRITECOPY,0,0,NULL);
+        if(hMapping)
         {
-            aiMesh *pMesh = scene->mMeshes[pNode->mMeshes[iSubMesh]];
-            NvSimpleRawMesh &activeMesh = pMeshes[pNode->mMeshes[iSubMesh]];    // we'll use the same ordering as the aiScene
+            pData = (BYTE*)MapViewOfFile(hMapping,FILE_MAP_COPY,0,0,0);
+            CloseHandle(hMapping);
+        }
+    }
+    CloseHandle(hFile);
 
-            float emin[3]; ::ZeroMemory(emin,3*sizeof(float));
-            float emax[3]; ::ZeroMemory(emax,3*sizeof(float));
+    if(!pData)
+        return false;
 
-            if(pMesh->HasPositions() && pMesh->HasNormals() && pMesh->HasTextureCoords(0) && pMesh->HasTangentsAndBitangents())
-            {
-                activeMesh.m_iNumIndices = pMesh->mNumFaces*3;
-                activeMesh.m_iNumVertices = pMesh->mNumVertices;
-
-                // copy loaded mesh data into our vertex struct
-                activeMesh.m_pVertexData = new NvSimpleRawMesh::Vertex[pMesh->mNumVertices];
-                for(unsigned int i=0;i<pMesh->mNumVertices;i++)
-                {
-                    memcpy((void*)&(activeMesh.m_pVertexData[i].Position),(void*)&(pMesh->mVertices[i]),sizeof(aiVector3D));
-                    memcpy((void*)&(activeMesh.m_pVertexData[i].Normal),(void*)&(pMesh->mNormals[i]),sizeof(aiVector3D));
-                    memcpy((void*)&(activeMesh.m_pVertexData[i].Tangent),(void*)&(pMesh->mTangents[i]),sizeof(aiVector3D));
-                    memcpy((void*)&(activeMesh.m_pVertexData[i].UV),(void*)&(pMesh->mTextureCoords[0][i]),sizeof(aiVector2D));
-
-                    for(int m=0;m<3;m++)
-                    {
-                        emin[m] = min(emin[m],activeMesh.m_pVertexData[i].Position[m]);
-                        emax[m] = max(emin[m],activeMesh.m_pVertexData[i].Position[m]);
-                    }
-                }
-
-                // create an index buffer
-                activeMesh.m_IndexSize = sizeof(UINT16);
-                if(pMesh->mNumFaces > MAXINT16)
-                    activeMesh.m_IndexSize = sizeof(UINT32);
-
-                activeMesh.m_pIndexData = new BYTE[pMesh->mNumFaces * 3 * activeMesh.m_IndexSize];
-                for(unsigned int i=0;i<pMesh->mNumFaces;i++)
-                {
-                    assert(pMesh->mFaces[i].mNumIndices == 3);
-                    if(activeMesh.m_IndexSize == sizeof(UINT32))
-                    {
-                        memcpy((void*)&(activeMesh.m_pIndexData[i*3*activeMesh.m_IndexSize]),(void*)pMesh->mFaces[i].mIndices,sizeof(3*activeMesh.m_IndexSize));
-                    }
-                    else    // 16 bit indices
-                    {
-                        UINT16*pFaceIndices = (UINT16*)&(activeMesh.m_pIndexData[i*3*activeMesh.m_IndexSize]);
-                        pFaceIndices[0] = (UINT16)pMesh->mFaces[i].mIndices[0];
-                        pFaceIndices[1] = (UINT16)pMesh->mFaces[i].mIndices[1];
-                        pFaceIndices[2] = (UINT16)pMesh->mFaces[i].mIndices[2];
-                    }
-                }
-
-                // assign extents
-                activeMesh.m_extents[0] = (emax[0] - emin[0]) * 0.5f;
-                activeMesh.m_extents[1] = (emax[1] - emin[1]) * 0.5f;
-                activeMesh.m_extents[2] = (emax[2] - emin[2]) * 0.5f;
-
-                // get the center
-                activeMesh.m_center[0] = emin[0] + activeMesh.m_extents[0];
-                activeMesh.m_center[1] = emin[1] + activeMesh.m_extents[1];
-                activeMesh.m_center[2] = emin[2] + activeMesh.m_extents[2];
-
-                // materials
-                if(scene->HasMaterials())
-                {
-                    aiMaterial *pMaterial = scene->mMaterials[pMesh->mMaterialIndex];
-
-                    if(pMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0)
-                    {
-                        aiString texPath;
-                        pMaterial->GetTexture(aiTextureType_DIFFUSE,0,&texPath);
-
-                        CHAR szFilenameA[MAX_PATH];
-                        StringCchCopyA(szFilenameA,MAX_PATH,texPath.data);
-                        MultiByteToWideChar(CP_ACP,0,szFilenameA,MAX_PATH,activeMesh.m_szDiffuseTexture,MAX_PATH);
-
-                        WCHAR szFullPath[MAX_PATH];
-                        //if(DXUTFindDXSDKMediaFileCch(szFullPath,MAX_PATH,activeMesh.m_szDiffuseTexture) != S_OK)
-                        {
-                            std::string qualifiedPath = mediaPath + texPath.data;
-
-                            StringCchCopyA(szFilenameA,MAX_PATH,qualifiedPath.c_str());
-                            MultiByteToWideChar(CP_ACP,0,szFilenameA,MAX_PATH,activeMesh.m_szDiffuseTexture,MAX_PATH);
-                        }    
-                    }
-                    if(pMaterial->GetTextureCount(aiTextureType_NORMALS) > 0)
-                    {
-                        aiString texPath;
-                        pMaterial->GetTexture(aiTextureType_NORMALS,0,&texPath);
-
-                        CHAR szFilenameA[MAX_PATH];
-                        StringCchCopyA(szFilenameA,MAX_PATH,texPath.data);
-                        MultiByteToWideChar(CP_ACP,0,szFilenameA,MAX_PATH,activeMesh.m_szNormalTexture,MAX_PATH);
-
-                        WCHAR szFullPath[MAX_PATH];
-                        //if(DXUTFindDXSDKMediaFileCch(szFullPath,MAX_PATH,activeMesh.m_szNormalTexture) != S_OK)
-                        {
-                            std::string qualifiedPath = mediaPath + texPath.data;
-
-                            StringCchCopyA(szFilenameA,MAX_PATH,qualifiedPath.c_str());
-                            MultiByteToWideChar(CP_ACP,0,szFilenameA,MAX_PATH,activeMesh.m_szNormalTexture,MAX_PATH);
-                        }    
-                    }
-                }
-            }
-        }
+    // Validate everything before any mesh points into the view
+    const UINT64 size = UINT64(fileSize.QuadPart);
+    const NvMeshCacheHeader *pHeader = (const NvMeshCacheHeader*)pData;
+    const NvMeshCacheRecord *pRecords = (const NvMeshCacheRecord*)(pData + sizeof(NvMeshCacheHeader));
+
+    bool bValid = pHeader->dwMagic == NV_MESH_CACHE_MAGIC &&
+                  pHeader->dwVersion == NV_MESH_CACHE_VERSION &&
+                  pHeader->SourceHash == sourceHash &&
+                  pHeader->SourceSize == sourceSize &&
+                  pHeader->dwImportFlags == NV_MESH_IMPORT_FLAGS &&
+                  pHeader->dwRemoveComponents == NV_MESH_REMOVE_COMPONENTS &&
+                  pHeader->dwVertexStride == sizeof(NvSimpleRawMesh::Vertex) &&
+                  pHeader->FileSize == size &&
+                  pHeader->dwNumMeshes > 0 &&
+                  pHeader->dwNumMeshes <= (size - sizeof(NvMeshCacheHeader)) / sizeof(NvMeshCacheRecord);
+
+    for(UINT iMesh=0;bValid && iMesh<pHeader->dwNumMeshes;iMesh++)
+    {
+        const NvMeshCacheRecord &record = pRecords[iMesh];
+        const UINT64 vertexSize = UINT64(record.NumVertices) * sizeof(NvSimpleRawMesh::Vertex);
+        const UINT64 indexSize = UINT64(record.NumIndices) * record.IndexSize;
+
+        bValid = (record.IndexSize == sizeof(UINT16) || record.IndexSize == sizeof(UINT32)) &&
+                 (record.VertexOffset % NV_MESH_CACHE_ALIGNMENT) == 0 &&
+                 (record.IndexOffset % NV_MESH_CACHE_ALIGNMENT) == 0 &&
+                 record.VertexOffset <= size && vertexSize <= size - record.VertexOffset &&
+                 record.IndexOffset <= size && indexSize <= size - record.IndexOffset &&
+                 memchr(record.szDiffuseTexture,0,MAX_PATH) != NULL &&
+                 memchr(record.szNormalTexture,0,MAX_PATH) != NULL;
     }
 
-    for(int iChild=0;iChild<(int)pNode->mNumChildren;iChild++)
+    if(!bValid)
+    {
+        UnmapViewOfFile(pData);
+        return false;
+    }
+
+    NumMeshes = pHeader->dwNumMeshes;
+    pMeshes = new NvSimpleRawMesh[NumMeshes];
+
+    for(int iMesh=0;iMesh<NumMeshes;iMesh++)
+    {
+        const NvMeshCacheRecord &record = pRecords[iMesh];
+        NvSimpleRawMesh &activeMesh = pMeshes[iMesh];
+
+        activeMesh.m_iNumVertices = record.NumVertices;
+        activeMesh.m_iNumIndices = record.NumIndices;
+        activeMesh.m_IndexSize = record.IndexSize;
+        if(record.NumVertices > 0)
+            activeMesh.m_pVertexData = (NvSimpleRawMesh::Vertex*)(pData + record.VertexOffset);
+        if(record.NumIndices > 0)
+            activeMesh.m_pIndexData = pData + record.IndexOffset;
+
+        memcpy(activeMesh.m_extents,record.Extents,sizeof(record.Extents));
+        memcpy(activeMesh.m_center,record.Center,sizeof(record.Center));
+        activeMesh.m_CacheStatsBefore = record.CacheStatsBefore;
+        activeMesh.m_CacheStatsAfter = record.CacheStatsAfter;
+
+        if(record.szDiffuseTexture[0] != 0)
+            QualifyTexturePath(mediaPath,record.szDiffuseTexture,activeMesh.m_szDiffuseTexture);
+        if(record.szNormalTexture[0] != 0)
+            QualifyTexturePath(mediaPath,record.szNormalTexture,activeMesh.m_szNormalTexture);
+    }
+
+    pCacheView = pData;
+
+    return true;
+}
+
+void NvSimpleMeshLoader::SaveCache(LPCWSTR szCacheFilename, UINT64 sourceHash, UINT64 sourceSize)
+{
+    NvMeshCacheHeader header;
+    ::ZeroMemory(&header,sizeof(NvMeshCacheHeader));
+    header.dwMagic = NV_MESH_CACHE_MAGIC;
+    header.dwVersion = NV_MESH_CACHE_VERSION;
+    header.SourceHash = sourceHash;
+    header.SourceSize = sourceSize;
+    header.dwImportFlags = NV_MESH_IMPORT_FLAGS;
+    header.dwRemoveComponents = NV_MESH_REMOVE_COMPONENTS;
+    header.dwVertexStride = sizeof(NvSimpleRawMesh::Vertex);
+    header.dwNumMeshes = NumMeshes;
+
+    // Lay out the data blocks after the header and records
+    std::vector<NvMeshCacheRecord> records(NumMeshes);
+    ::ZeroMemory(&records[0],NumMeshes * sizeof(NvMeshCacheRecord));
+
+    UINT64 offset = sizeof(NvMeshCacheHeader) + NumMeshes * sizeof(NvMeshCacheRecord);
+    for(int iMesh=0;iMesh<NumMeshes;iMesh++)
+    {
+        const NvSimpleRawMesh &activeMesh = pMeshes[iMesh];
+        NvMeshCacheRecord &record = records[iMesh];
+
+        record.NumVertices = activeMesh.m_pVertexData ? activeMesh.m_iNumVertices : 0;
+        record.NumIndices = activeMesh.m_pIndexData ? activeMesh.m_iNumIndices : 0;
+        record.IndexSize = activeMesh.m_IndexSize;
+
+        record.VertexOffset = AlignCacheOffset(offset);
+        offset = record.VertexOffset + UINT64(record.NumVertices) * sizeof(NvSimpleRawMesh::Vertex);
+        record.IndexOffset = AlignCacheOffset(offset);
+        offset = record.IndexOffset + UINT64(record.NumIndices) * record.IndexSize;
+
+        memcpy(record.Extents,activeMesh.m_extents,sizeof(record.Extents));
+        memcpy(record.Center,activeMesh.m_center,sizeof(record.Center));
+        record.CacheStatsBefore = activeMesh.m_CacheStatsBefore;
+        record.CacheStatsAfter = activeMesh.m_CacheStatsAfter;
+
+        // A texture outside the media path can't be relocated, so leave such meshes uncached
+        if(!MakeRelativeTexturePath(mediaPath,activeMesh.m_szDiffuseTexture,record.szDiffuseTexture) ||
+           !MakeRelativeTexturePath(mediaPath,activeMesh.m_szNormalTexture,record.szNormalTexture))
+            return;
+    }
+    header.FileSize = offset;
+
+    // Write to a temporary file and rename it, so a failed write never leaves a truncated cache behind
+    WCHAR szTempFilename[MAX_PATH];
+    if(FAILED(StringCchCopyW(szTempFilename,MAX_PATH,szCacheFilename)) ||
+       FAILED(StringCchCatW(szTempFilename,MAX_PATH,L".tmp")))
+        return;
+
+    HANDLE hFile = CreateFileW(szTempFilename,GENERIC_WRITE,0,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_NORMAL,NULL);
+    if(hFile == INVALID_HANDLE_VALUE)
+        return;
+
+    UINT64 position = 0;
+    bool bWritten = WriteCacheBlock(hFile,&position,0,&header,sizeof(NvMeshCacheHeader)) &&
+                    WriteCacheBlock(hFile,&position,position,&records[0],NumMeshes * sizeof(NvMeshCacheRecord));
+
+    for(int iMesh=0;bWritten && iMesh<NumMeshes;iMesh++)
+    {
+        const NvMeshCacheRecord &record = records[iMesh];
+        bWritten = WriteCacheBlock(hFile,&position,record.VertexOffset,pMeshes[iMesh].m_pVertexData,UINT64(record.NumVertices) * sizeof(NvSimpleRawMesh::Vertex)) &&
+                   WriteCacheBlock(hFile,&position,record.IndexOffset,pMeshes[iMesh].m_pIndexData,UINT64(record.NumIndices) * record.IndexSize);
+    }
+    CloseHandle(hFile);
+
+    if(!bWritten || !MoveFileExW(szTempFilename,szCacheFilename,MOVEFILE_REPLACE_EXISTING))
+        DeleteFileW(szTempFilename);
+}
+
+void NvSimpleMeshLoader::RecurseAddMeshes(const aiScene *scene, aiNode*pNode,D3DXMATRIX *pParentCompositeTransformD3D, bool bFlattenTransforms)
+{
+    // Walk the node tree on this thread, then convert the meshes it references in parallel
+    std::vector<NvMeshImportJob> jobs;
+    std::vector<bool> bMeshQueued(scene->mNumMeshes,false);
+    CollectMeshJobs(scene,pNode,pParentCompositeTransformD3D,bFlattenTransforms,jobs,bMeshQueued);
+
+    if(jobs.empty())
+        return;
+
+    // Largest meshes first, so a big mesh picked up last doesn't leave the other threads idle
+    std::sort(jobs.begin(),jobs.end(),[scene](const NvMeshImportJob &a, const NvMeshImportJob &b)
+    {
+        const aiMesh *pA = scene->mMeshes[a.iMesh];
+        const aiMesh *pB = scene->mMeshes[b.iMesh];
+        return UINT64(pA->mNumVertices) + pA->mNumFaces > UINT64(pB->mNumVertices) + pB->mNumFaces;
+    });
+
+    NvMeshImportContext context;
+    context.scene = scene;
+    context.pMeshes = pMeshes;
+    context.pMediaPath = &mediaPath;
+    context.pJobs = &jobs[0];
+    context.numJobs = LONG(jobs.size());
+    context.nextJob = 0;
+
+    // Small scenes aren't worth a thread per processor
+    UINT64 totalVertices = 0;
+    for(size_t iJob=0;iJob<jobs.size();iJob++)
+        totalVertices += scene->mMeshes[jobs[iJob].iMesh]->mNumVertices;
+
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+
+    const UINT64 minVerticesPerThread = 16384;
+    UINT64 numThreads = min(UINT64(sysInfo.dwNumberOfProcessors),UINT64(jobs.size()));
+    numThreads = min(numThreads,max(UINT64(1),totalVertices / minVerticesPerThread));
+    numThreads = min(numThreads,UINT64(MAXIMUM_WAIT_OBJECTS));
+
+    std::vector<HANDLE> threads;
+    for(UINT64 iThread=1;iThread<numThreads;iThread++)
+    {
+        HANDLE hThread = (HANDLE)_beginthreadex(NULL,0,ConvertMeshJobsThread,&context,0,NULL);
+        if(hThread)
+            threads.push_back(hThread);
+    }
+
+    ConvertMeshJobs(context);
+
+    if(!threads.empty())
     {
-        RecurseAddMeshes(scene, pNode->mChildren[iChild],&LocalCompositeTransformD3D,bFlattenTransforms);
+        WaitForMultipleObjects(DWORD(threads.size()),&threads[0],TRUE,INFINITE);
+        for(size_t iThread=0;iThread<threads.size();iThread++)
+            CloseHandle(threads[iThread]);
     }
 }
@@ -95,6 +95,9 @@ NvSimpleRawMesh::NvSimpleRawMesh() :
 
     m_extents[0] = m_extents[1] = m_extents[2] = 0.f;
     m_center[0] = m_center[1] = m_center[2] = 0.f;
+
+    ::ZeroMemory(&m_CacheStatsBefore,sizeof(NvVertexCacheStatistics));
+    ::ZeroMemory(&m_CacheStatsAfter,sizeof(NvVertexCacheStatistics));
 }
 
 
@@ -0,0 +1,165 @@
+//----------------------------------------------------------------------------------
+// File:        src\nvsimplemesh/NvVertexWelder.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <windows.h>
+#include <assert.h>
+#include <string.h>
+#include "NvVertexWelder.h"
+
+static inline UINT RotateLeft(UINT x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+NvVertexWelder::NvVertexWelder(UINT iKeySize) :
+    m_iKeyWords(iKeySize / sizeof(UINT)),
+    m_iSlotMask(0)
+{
+    assert(iKeySize > 0 && (iKeySize % sizeof(UINT)) == 0);
+}
+
+NvVertexWelder::~NvVertexWelder()
+{
+}
+
+void NvVertexWelder::Reserve(UINT iNumVertices)
+{
+    m_Keys.reserve(size_t(iNumVertices) * m_iKeyWords);
+    m_Values.reserve(iNumVertices);
+
+    // Keep the table at most half full
+    size_t iNumSlots = 16;
+    while(iNumSlots < size_t(iNumVertices) * 2)
+        iNumSlots *= 2;
+
+    if(iNumSlots > m_Slots.size())
+        Rehash(iNumSlots);
+}
+
+void NvVertexWelder::Clear()
+{
+    std::vector<UINT>().swap(m_Keys);
+    std::vector<UINT>().swap(m_Values);
+    std::vector<Slot>().swap(m_Slots);
+    m_iSlotMask = 0;
+}
+
+// MurmurHash3 over the key words; index triples are small sequential integers, so they need good mixing
+UINT NvVertexWelder::HashKey(const UINT *pKey) const
+{
+    UINT h = 0;
+    for(UINT i = 0; i < m_iKeyWords; i++)
+    {
+        UINT k = pKey[i] * 0xcc9e2d51;
+        k = RotateLeft(k, 15) * 0x1b873593;
+        h = RotateLeft(h ^ k, 13) * 5 + 0xe6546b64;
+    }
+
+    h ^= m_iKeyWords * 4;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+// Resizes the table to a power of two and reinserts every occupied slot
+void NvVertexWelder::Rehash(size_t iNumSlots)
+{
+    std::vector<Slot> OldSlots(iNumSlots);
+    OldSlots.swap(m_Slots);
+    m_iSlotMask = UINT(iNumSlots - 1);
+
+    for(size_t i = 0; i < OldSlots.size(); i++)
+    {
+        if(OldSlots[i].iEntry == 0)
+            continue;
+
+        UINT iSlot = OldSlots[i].hash & m_iSlotMask;
+        while(m_Slots[iSlot].iEntry != 0)
+            iSlot = (iSlot + 1) & m_iSlotMask;
+
+        m_Slots[iSlot] = OldSlots[i];
+    }
+}
+
+UINT NvVertexWelder::Weld(const void *pKey, UINT iNewIndex, bool *pbAdded)
+{
+    const UINT *pKeyWords = static_cast<const UINT*>(pKey);
+    const UINT hash = HashKey(pKeyWords);
+
+    if((m_Values.size() + 1) * 2 > m_Slots.size())
+        Rehash(m_Slots.empty() ? 16 : m_Slots.size() * 2);
+
+    // Linear probing; the table is never more than half full, so an empty slot is always reached.
+    // The hash is kept in the slot so most mismatches are rejected without touching the keys
+    UINT iSlot = hash & m_iSlotMask;
+    for(;;)
+    {
+        const Slot& slot = m_Slots[iSlot];
+        if(slot.iEntry == 0)
+            break;
+
+        if(slot.hash == hash &&
+           0 == memcmp(&m_Keys[size_t(slot.iEntry - 1) * m_iKeyWords], pKeyWords, m_iKeyWords * sizeof(UINT)))
+        {
+            if(pbAdded)
+                *pbAdded = false;
+            return m_Values[slot.iEntry - 1];
+        }
+
+        iSlot = (iSlot + 1) & m_iSlotMask;
+    }
+
+    m_Slots[iSlot].iEntry = UINT(m_Values.size()) + 1;
+    m_Slots[iSlot].hash = hash;
+    m_Keys.insert(m_Keys.end(), pKeyWords, pKeyWords + m_iKeyWords);
+    m_Values.push_back(iNewIndex);
+
+    if(pbAdded)
+        *pbAdded = true;
+    return iNewIndex;
+}
+
+UINT NvVertexWelder::WeldVertices(const void *pVertices, UINT iStride, UINT iNumVertices, UINT *pRemap)
+{
+    NvVertexWelder welder(iStride);
+    welder.Reserve(iNumVertices);
+
+    const BYTE *pVertex = static_cast<const BYTE*>(pVertices);
+    for(UINT i = 0; i < iNumVertices; i++, pVertex += iStride)
+        pRemap[i] = welder.Weld(pVertex, welder.GetNumVertices());
+
+    return welder.GetNumVertices();
+}
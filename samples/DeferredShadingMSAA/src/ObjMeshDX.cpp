@@ -34,6 +34,7 @@
 #pragma warning(disable: 4995)
 #include "ObjMeshDX.h"
 #include <fstream>
+#include <process.h>
 using namespace std;
 #pragma warning(default: 4995)
 
@@ -48,9 +49,13 @@ const D3D11_INPUT_ELEMENT_DESC ObjMeshDX::layout_Position_Normal_Texture[] =
 
 //--------------------------------------------------------------------------------------
 ObjMeshDX::ObjMeshDX()
-	: m_pCBMesh(nullptr)
+	: m_VertexWelder(3 * sizeof(UINT))
+	, m_NormalWelder(sizeof(UINT) + sizeof(D3DXVECTOR3))
+	, m_pCBMesh(nullptr)
 	, m_pCBSubMesh(nullptr)
 {
+	ZeroMemory(&m_CacheStatsBefore, sizeof(NvVertexCacheStatistics));
+	ZeroMemory(&m_CacheStatsAfter, sizeof(NvVertexCacheStatistics));
 }
 
 
@@ -219,17 +224,364 @@ void ObjMeshDX::Draw(ID3D11DeviceContext* pDeviceContext, const D3DXMATRIX& worl
 	}
 }
 
+//--------------------------------------------------------------------------------------
+// Multithreaded .obj parsing
+//
+// The file is memory mapped and split into line-aligned chunks that are scanned in
+// parallel. A chunk only records what it finds: face indices in an .obj file are
+// absolute, so the chunks can be merged in file order afterwards and the vertices
+// built exactly as a single front-to-back pass would build them.
+//--------------------------------------------------------------------------------------
+struct ObjFaceRecord
+{
+	UINT aiPosition[4];
+	UINT aiTexCoord[4];	// 0 if the vertex has no texture coordinate
+	UINT aiNormal[4];	// 0 if the vertex has no normal
+	UINT nVertices;		// 3, or 4 for a quad
+};
+
+enum ObjEventType
+{
+	OBJ_EVENT_SMOOTHING,
+	OBJ_EVENT_USEMTL,
+	OBJ_EVENT_MTLLIB,
+};
+
+// State changes are kept in order with the faces so they can be replayed at the right point
+struct ObjChunkEvent
+{
+	size_t iFace;		// Applies before this face of the chunk
+	ObjEventType type;
+	int iSmoothingGroup;
+	const char* pName;	// Points into the mapped file
+	size_t nNameLength;
+};
+
+struct ObjChunk
+{
+	const char* pBegin;
+	const char* pEnd;
+
+	std::vector<D3DXVECTOR3> Positions;
+	std::vector<D3DXVECTOR2> TexCoords;
+	std::vector<D3DXVECTOR3> Normals;
+	std::vector<ObjFaceRecord> Faces;
+	std::vector<ObjChunkEvent> Events;
+
+	D3DXVECTOR3 vMin;
+	D3DXVECTOR3 vMax;
+
+	// Set if a line could not be parsed; nothing after it in the file is used
+	bool bStopped;
+};
+
+static inline bool IsObjSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool IsObjDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static const char* SkipObjSpaces(const char* p, const char* pEnd)
+{
+	while(p < pEnd && IsObjSpace(*p))
+		++p;
+	return p;
+}
+
+static const char* SkipObjLine(const char* p, const char* pEnd)
+{
+	while(p < pEnd && *p != '\n')
+		++p;
+	return (p < pEnd) ? p + 1 : p;
+}
+
+//--------------------------------------------------------------------------------------
+static bool ParseObjUInt(const char*& p, const char* pEnd, UINT& value)
+{
+	p = SkipObjSpaces(p, pEnd);
+	if(p < pEnd && *p == '+')
+		++p;
+
+	if(p >= pEnd || !IsObjDigit(*p))
+		return false;
+
+	UINT v = 0;
+	while(p < pEnd && IsObjDigit(*p))
+	{
+		v = v * 10 + UINT(*p - '0');
+		++p;
+	}
+
+	value = v;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+static bool ParseObjFloat(const char*& p, const char* pEnd, float& value)
+{
+	// Powers of ten that are exact in a double
+	static const double s_Pow10[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	p = SkipObjSpaces(p, pEnd);
+	const char* pStart = p;
+
+	bool bNegative = false;
+	if(p < pEnd && (*p == '-' || *p == '+'))
+	{
+		bNegative = (*p == '-');
+		++p;
+	}
+
+	UINT64 mantissa = 0;
+	int nSignificant = 0;
+	int nDigits = 0;
+	int exponent = 0;
+
+	for(; p < pEnd && IsObjDigit(*p); ++p, ++nDigits)
+	{
+		if(mantissa || *p != '0')
+			++nSignificant;
+		mantissa = mantissa * 10 + UINT64(*p - '0');
+	}
+
+	if(p < pEnd && *p == '.')
+	{
+		for(++p; p < pEnd && IsObjDigit(*p); ++p, ++nDigits)
+		{
+			if(mantissa || *p != '0')
+				++nSignificant;
+			mantissa = mantissa * 10 + UINT64(*p - '0');
+			--exponent;
+		}
+	}
+
+	if(nDigits == 0)
+		return false;
+
+	if(p < pEnd && (*p == 'e' || *p == 'E'))
+	{
+		const char* pExp = p + 1;
+		bool bNegativeExp = false;
+		if(pExp < pEnd && (*pExp == '-' || *pExp == '+'))
+		{
+			bNegativeExp = (*pExp == '-');
+			++pExp;
+		}
+
+		if(pExp < pEnd && IsObjDigit(*pExp))
+		{
+			int e = 0;
+			for(; pExp < pEnd && IsObjDigit(*pExp); ++pExp)
+			{
+				if(e < 10000)
+					e = e * 10 + (*pExp - '0');
+			}
+			exponent += bNegativeExp ? -e : e;
+			p = pExp;
+		}
+	}
+
+	// With at most 15 significant digits and a power of ten that is exact, one multiply or
+	// divide gives the correctly rounded double. Anything else goes through the C runtime
+	double d;
+	if(nSignificant <= 15 && exponent >= -22 && exponent <= 22)
+	{
+		d = double(mantissa);
+		d = (exponent < 0) ? d / s_Pow10[-exponent] : d * s_Pow10[exponent];
+		if(bNegative)
+			d = -d;
+	}
+	else
+	{
+		char strNumber[128];
+		size_t nLength = min(size_t(p - pStart), sizeof(strNumber) - 1);
+		memcpy(strNumber, pStart, nLength);
+		strNumber[nLength] = 0;
+		d = strtod(strNumber, NULL);
+	}
+
+	value = float(d);
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+static bool ParseObjFaceVertex(const char*& p, const char* pEnd, ObjFaceRecord& face, UINT iVertex)
+{
+	face.aiTexCoord[iVertex] = 0;
+	face.aiNormal[iVertex] = 0;
+
+	if(!ParseObjUInt(p, pEnd, face.aiPosition[iVertex]))
+		return false;
+
+	if(p < pEnd && *p == '/')
+	{
+		++p;
+
+		// Optional texture coordinate
+		if(p < pEnd && *p != '/')
+		{
+			if(!ParseObjUInt(p, pEnd, face.aiTexCoord[iVertex]))
+				return false;
+		}
+
+		// Optional vertex normal
+		if(p < pEnd && *p == '/')
+		{
+			++p;
+			if(!ParseObjUInt(p, pEnd, face.aiNormal[iVertex]))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+static void ParseObjChunk(ObjChunk& chunk)
+{
+	const char* p = chunk.pBegin;
+	const char* pEnd = chunk.pEnd;
+
+	while(p < pEnd)
+	{
+		// Command
+		while(p < pEnd && (IsObjSpace(*p) || *p == '\n'))
+			++p;
+
+		const char* pCommand = p;
+		while(p < pEnd && !IsObjSpace(*p) && *p != '\n')
+			++p;
+
+		const size_t nCommand = size_t(p - pCommand);
+		if(nCommand == 0)
+			break;
+
+		bool bParsed = true;
+		if(nCommand == 1 && pCommand[0] == 'v')
+		{
+			// Vertex Position
+			D3DXVECTOR3 v;
+			bParsed = ParseObjFloat(p, pEnd, v.x) && ParseObjFloat(p, pEnd, v.y) && ParseObjFloat(p, pEnd, v.z);
+			if(bParsed)
+			{
+				chunk.Positions.push_back(v);
+
+				chunk.vMin.x = min(chunk.vMin.x, v.x);
+				chunk.vMin.y = min(chunk.vMin.y, v.y);
+				chunk.vMin.z = min(chunk.vMin.z, v.z);
+				chunk.vMax.x = max(chunk.vMax.x, v.x);
+				chunk.vMax.y = max(chunk.vMax.y, v.y);
+				chunk.vMax.z = max(chunk.vMax.z, v.z);
+			}
+		}
+		else if(nCommand == 2 && pCommand[0] == 'v' && pCommand[1] == 't')
+		{
+			// Vertex TexCoord
+			D3DXVECTOR2 vt;
+			bParsed = ParseObjFloat(p, pEnd, vt.x) && ParseObjFloat(p, pEnd, vt.y);
+			if(bParsed)
+				chunk.TexCoords.push_back(vt);
+		}
+		else if(nCommand == 2 && pCommand[0] == 'v' && pCommand[1] == 'n')
+		{
+			// Vertex Normal
+			D3DXVECTOR3 vn;
+			bParsed = ParseObjFloat(p, pEnd, vn.x) && ParseObjFloat(p, pEnd, vn.y) && ParseObjFloat(p, pEnd, vn.z);
+			if(bParsed)
+				chunk.Normals.push_back(vn);
+		}
+		else if(nCommand == 1 && pCommand[0] == 'f')
+		{
+			// Face, with a fourth vertex making a quad; any further vertices are ignored
+			ObjFaceRecord face;
+			face.nVertices = 3;
+			bParsed = ParseObjFaceVertex(p, pEnd, face, 0) &&
+					  ParseObjFaceVertex(p, pEnd, face, 1) &&
+					  ParseObjFaceVertex(p, pEnd, face, 2);
+
+			if(bParsed)
+			{
+				while(p < pEnd && !IsObjDigit(*p) && *p != '\n')
+					++p;
+
+				if(p < pEnd && IsObjDigit(*p))
+				{
+					bParsed = ParseObjFaceVertex(p, pEnd, face, 3);
+					face.nVertices = 4;
+				}
+			}
+
+			if(bParsed)
+				chunk.Faces.push_back(face);
+		}
+		else if(nCommand == 1 && pCommand[0] == 's')
+		{
+			// Smoothing group; "s off" and other non-numeric values turn smoothing off
+			ObjChunkEvent event = { chunk.Faces.size(), OBJ_EVENT_SMOOTHING, 0, NULL, 0 };
+
+			if(p < pEnd)
+				++p;
+
+			if(p < pEnd && IsObjDigit(*p))
+			{
+				UINT iSmoothingGroup;
+				ParseObjUInt(p, pEnd, iSmoothingGroup);
+				event.iSmoothingGroup = int(iSmoothingGroup);
+			}
+
+			chunk.Events.push_back(event);
+		}
+		else if((nCommand == 6 && 0 == memcmp(pCommand, "mtllib", 6)) ||
+				(nCommand == 6 && 0 == memcmp(pCommand, "usemtl", 6)))
+		{
+			// Material library or material
+			ObjChunkEvent event = { chunk.Faces.size(), (pCommand[0] == 'm') ? OBJ_EVENT_MTLLIB : OBJ_EVENT_USEMTL, 0, NULL, 0 };
+
+			p = SkipObjSpaces(p, pEnd);
+			event.pName = p;
+			while(p < pEnd && !IsObjSpace(*p) && *p != '\n')
+				++p;
+			event.nNameLength = size_t(p - event.pName);
+
+			bParsed = (event.nNameLength > 0 && event.nNameLength < MAX_PATH);
+			if(bParsed)
+				chunk.Events.push_back(event);
+		}
+		else
+		{
+			// Comment, unimplemented or unrecognized command
+		}
+
+		if(!bParsed)
+		{
+			chunk.bStopped = true;
+			return;
+		}
+
+		p = SkipObjLine(p, pEnd);
+	}
+}
+
+static unsigned __stdcall ParseObjChunkThread(void* pParam)
+{
+	ParseObjChunk(*reinterpret_cast<ObjChunk*>(pParam));
+	return 0;
+}
+
 //--------------------------------------------------------------------------------------
 HRESULT ObjMeshDX::LoadGeometryFromOBJ(const WCHAR* strFileName)
 {
     WCHAR strMaterialFilename[MAX_PATH] = {0};
     HRESULT hr;
 
-    // Create temporary storage for the input data. Once the data has been loaded into
-    // a reasonable format we can create a D3DXMesh object and load it with the mesh data.
-    std::vector<D3DXVECTOR3> Positions;
-    std::vector<D3DXVECTOR2> TexCoords;
-    std::vector<D3DXVECTOR3> Normals;
 	int iSmoothingGroup = 0;
 
     // The first subset uses the default material
@@ -244,195 +596,276 @@ HRESULT ObjMeshDX::LoadGeometryFromOBJ(const WCHAR* strFileName)
 	m_iNumSubsets = 0;
     auto dwCurSubset = 0;
 
-    // File input
-    WCHAR strCommand[256] = {0};
-    wifstream InFile(strFileName);
-    if(!InFile)
+    // Map the file
+    HANDLE hFile = CreateFileW(strFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(hFile == INVALID_HANDLE_VALUE)
 		return E_FAIL;
-	
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(hFile, &fileSize) || fileSize.HighPart != 0)
+	{
+		CloseHandle(hFile);
+		return E_FAIL;
+	}
+
+	HANDLE hMapping = NULL;
+	const char* pFile = NULL;
+	if(fileSize.LowPart > 0)
+	{
+		hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(hMapping)
+			pFile = static_cast<const char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+
+		if(pFile == NULL)
+		{
+			if(hMapping)
+				CloseHandle(hMapping);
+			CloseHandle(hFile);
+			return E_FAIL;
+		}
+	}
+
+	// Split into roughly equal chunks, each ending at a line break, and scan them in parallel
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+
+	const size_t nFileSize = fileSize.LowPart;
+	const size_t nMinChunkSize = 1024 * 1024;
+	size_t nChunks = max<size_t>(1, min<size_t>(sysInfo.dwNumberOfProcessors, nFileSize / nMinChunkSize));
+
+	std::vector<ObjChunk> Chunks(nChunks);
+	const char* pChunkBegin = pFile;
+	for(size_t iChunk = 0; iChunk < nChunks; ++iChunk)
+	{
+		const char* pChunkEnd = pFile + nFileSize;
+		if(iChunk + 1 < nChunks)
+		{
+			pChunkEnd = max(pChunkBegin, pFile + nFileSize * (iChunk + 1) / nChunks);
+			pChunkEnd = SkipObjLine(pChunkEnd, pFile + nFileSize);
+		}
+
+		ObjChunk& chunk = Chunks[iChunk];
+		chunk.pBegin = pChunkBegin;
+		chunk.pEnd = pChunkEnd;
+		chunk.vMin = D3DXVECTOR3(FLT_MAX, FLT_MAX, FLT_MAX);
+		chunk.vMax = D3DXVECTOR3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		chunk.bStopped = false;
+
+		pChunkBegin = pChunkEnd;
+	}
+
+	std::vector<HANDLE> Threads;
+	for(size_t iChunk = 1; iChunk < nChunks; ++iChunk)
+	{
+		HANDLE hThread = (HANDLE)_beginthreadex(NULL, 0, ParseObjChunkThread, &Chunks[iChunk], 0, NULL);
+		if(hThread)
+			Threads.push_back(hThread);
+		else
+			ParseObjChunk(Chunks[iChunk]);
+	}
+
+	ParseObjChunk(Chunks[0]);
+
+	if(!Threads.empty())
+	{
+		WaitForMultipleObjects(DWORD(Threads.size()), Threads.data(), TRUE, INFINITE);
+		for(size_t iThread = 0; iThread < Threads.size(); ++iThread)
+			CloseHandle(Threads[iThread]);
+	}
+
+	// A line that could not be parsed ends the file, as it would for a serial parse
+	size_t nUsedChunks = nChunks;
+	for(size_t iChunk = 0; iChunk < nChunks; ++iChunk)
+	{
+		if(Chunks[iChunk].bStopped)
+		{
+			nUsedChunks = iChunk + 1;
+			break;
+		}
+	}
+
+	// Merge the vertex attributes
+    std::vector<D3DXVECTOR3> Positions;
+    std::vector<D3DXVECTOR2> TexCoords;
+    std::vector<D3DXVECTOR3> Normals;
+	size_t nPositions = 0, nTexCoords = 0, nNormals = 0, nFaces = 0;
+	for(size_t iChunk = 0; iChunk < nUsedChunks; ++iChunk)
+	{
+		nPositions += Chunks[iChunk].Positions.size();
+		nTexCoords += Chunks[iChunk].TexCoords.size();
+		nNormals += Chunks[iChunk].Normals.size();
+		nFaces += Chunks[iChunk].Faces.size();
+	}
+
+	Positions.reserve(nPositions);
+	TexCoords.reserve(nTexCoords);
+	Normals.reserve(nNormals);
+	m_Faces.reserve(2 * nFaces);
+	m_Indices.reserve(6 * nFaces);
+	m_VertexWelder.Reserve(UINT(nPositions));
+
 	D3DXVECTOR3 vMin = D3DXVECTOR3(FLT_MAX, FLT_MAX, FLT_MAX);
 	D3DXVECTOR3 vMax = D3DXVECTOR3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-	for(; ;)
-    {
-        InFile >> strCommand;
-        if(!InFile)
-            break;
+	for(size_t iChunk = 0; iChunk < nUsedChunks; ++iChunk)
+	{
+		ObjChunk& chunk = Chunks[iChunk];
+		Positions.insert(Positions.end(), chunk.Positions.begin(), chunk.Positions.end());
+		TexCoords.insert(TexCoords.end(), chunk.TexCoords.begin(), chunk.TexCoords.end());
+		Normals.insert(Normals.end(), chunk.Normals.begin(), chunk.Normals.end());
+
+		vMin.x = min(vMin.x, chunk.vMin.x);
+		vMin.y = min(vMin.y, chunk.vMin.y);
+		vMin.z = min(vMin.z, chunk.vMin.z);
+		vMax.x = max(vMax.x, chunk.vMax.x);
+		vMax.y = max(vMax.y, chunk.vMax.y);
+		vMax.z = max(vMax.z, chunk.vMax.z);
+
+		std::vector<D3DXVECTOR3>().swap(chunk.Positions);
+		std::vector<D3DXVECTOR2>().swap(chunk.TexCoords);
+		std::vector<D3DXVECTOR3>().swap(chunk.Normals);
+	}
 
-        if(0 == wcscmp(strCommand, L"#"))
-        {
-            // Comment
-        }
-        else if(0 == wcscmp(strCommand, L"v"))
-        {
-            // Vertex Position
-            float x, y, z;
-            InFile >> x >> y >> z;
-            Positions.push_back(D3DXVECTOR3(x, y, z));
-			
-			if(x > vMax.x)
-				vMax.x = x;
-			if(y > vMax.y)
-				vMax.y = y;
-			if(z > vMax.z)
-				vMax.z = z;
-			if(x < vMin.x)
-				vMin.x = x;
-			if(y < vMin.y)
-				vMin.y = y;
-			if(z < vMin.z)
-				vMin.z = z;
-        }
-        else if(0 == wcscmp(strCommand, L"vt"))
-        {
-            // Vertex TexCoord
-            float u, v;
-            InFile >> u >> v;
-            TexCoords.push_back(D3DXVECTOR2(u, v));
-        }
-        else if(0 == wcscmp(strCommand, L"vn"))
-        {
-            // Vertex Normal
-            float x, y, z;
-            InFile >> x >> y >> z;
-            Normals.push_back(D3DXVECTOR3(x, y, z));
-        }
-        else if(0 == wcscmp(strCommand, L"f"))
-        {
-            // Face
-            UINT iPosition = 0, iTexCoord, iNormal;
-            MeshVertex vertex;
-			MeshFace Face, quadFace;
+	// Replay the faces and state changes in file order
+	hr = S_OK;
+	for(size_t iChunk = 0; iChunk < nUsedChunks && SUCCEEDED(hr); ++iChunk)
+	{
+		const ObjChunk& chunk = Chunks[iChunk];
+		size_t iEvent = 0;
 
-			auto ReadNextVertex = [&]() -> DWORD
+		for(size_t iFace = 0; iFace <= chunk.Faces.size() && SUCCEEDED(hr); ++iFace)
+		{
+			for(; iEvent < chunk.Events.size() && chunk.Events[iEvent].iFace == iFace; ++iEvent)
 			{
-				ZeroMemory(&vertex, sizeof(MeshVertex));
+				const ObjChunkEvent& event = chunk.Events[iEvent];
+				if(event.type == OBJ_EVENT_SMOOTHING)
+				{
+					iSmoothingGroup = event.iSmoothingGroup;
+					continue;
+				}
 
-                // OBJ format uses 1-based arrays
-                InFile >> iPosition;
-                vertex.position = Positions[iPosition - 1];
+				WCHAR strName[MAX_PATH] = {0};
+				MultiByteToWideChar(CP_ACP, 0, event.pName, int(event.nNameLength), strName, MAX_PATH - 1);
 
-                if('/' == InFile.peek())
-                {
-                    InFile.ignore();
-
-                    if('/' != InFile.peek())
-                    {
-                        // Optional texture coordinate
-                        InFile >> iTexCoord;
-                        vertex.texcoord = TexCoords[iTexCoord - 1];
-                    }
-
-                    if('/' == InFile.peek())
-                    {
-                        InFile.ignore();
-
-                        // Optional vertex normal
-                        InFile >> iNormal;
-                        vertex.normal = Normals[iNormal - 1];
-                    }
-                }
+				if(event.type == OBJ_EVENT_MTLLIB)
+				{
+					wcscpy_s(strMaterialFilename, MAX_PATH, strName);
+					continue;
+				}
 
-				DWORD index = AddVertex(iPosition, &vertex);
-				return index;
-			};
+				bool bFound = false;
+				for(UINT32 iMaterial = 0; iMaterial < m_Materials.size(); iMaterial++)
+				{
+					Material* pCurMaterial = m_Materials[iMaterial];
+					if(0 == wcscmp(pCurMaterial->strName, strName))
+					{
+						bFound = true;
+						dwCurSubset = iMaterial;
+						break;
+					}
+				}
 
-			UINT iFace;
-            for(iFace = 0; iFace < 3; iFace++)
-            {
-				auto index = ReadNextVertex();
-				m_Indices.push_back(index);
-				Face.aiIndices[iFace] = index;
-            }
+				if(!bFound)
+				{
+					pMaterial = new Material();
+					if(pMaterial == NULL)
+					{
+						hr = E_OUTOFMEMORY;
+						break;
+					}
 
-			Face.iSmoothingGroup = iSmoothingGroup;
-			m_Faces.push_back(Face);
-			
-			bool bQuad = false;
-			while((InFile.peek() < '0' || InFile.peek() > '9') && InFile.peek() != '\n')
-			{
-				InFile.ignore();
+					dwCurSubset = static_cast<int>(m_Materials.size());
+
+					InitMaterial(pMaterial);
+					wcscpy_s(pMaterial->strName, MAX_PATH - 1, strName);
+
+					m_Materials.push_back(pMaterial);
+				}
+
+				m_SubsetStartIdx.push_back(DWORD(m_Indices.size()));
+				m_SubsetMtlIdx.push_back(dwCurSubset);
+				m_iNumSubsets++;
 			}
-			if(InFile.peek() >= '0' && InFile.peek() <= '9')
-				bQuad = true;
-			else
-				bQuad = false;
 
-			if(bQuad)
-			{
-				auto index = ReadNextVertex();
+			if(iFace == chunk.Faces.size() || FAILED(hr))
+				break;
 
-				// Triangularize quad
-				{
-					quadFace.aiIndices[0] = index;
-					quadFace.aiIndices[1] = Face.aiIndices[0];
-					quadFace.aiIndices[2] = Face.aiIndices[2];
+			const ObjFaceRecord& record = chunk.Faces[iFace];
+			MeshFace Face, quadFace;
 
-					m_Indices.push_back(quadFace.aiIndices[0]);
-					m_Indices.push_back(quadFace.aiIndices[1]);
-					m_Indices.push_back(quadFace.aiIndices[2]);
+			DWORD aIndex[4];
+			for(UINT iVertex = 0; iVertex < record.nVertices; iVertex++)
+			{
+				// OBJ format uses 1-based arrays
+				const UINT iPosition = record.aiPosition[iVertex];
+				const UINT iTexCoord = record.aiTexCoord[iVertex];
+				const UINT iNormal = record.aiNormal[iVertex];
+				if(iPosition == 0 || iPosition > Positions.size() ||
+				   iTexCoord > TexCoords.size() || iNormal > Normals.size())
+				{
+					hr = E_FAIL;
+					break;
 				}
 
-				quadFace.iSmoothingGroup = iSmoothingGroup;
-				m_Faces.push_back(quadFace);
+				// Vertices are welded on their index triple, so each one is only built the first time it is used
+				// Repeated vt/vn entries with equal values are different keys, so their vertices are not merged
+				const UINT aiKey[3] = { iPosition, iTexCoord, iNormal };
+				bool bAdded;
+				aIndex[iVertex] = m_VertexWelder.Weld(aiKey, UINT(m_Vertices.size()), &bAdded);
+				if(bAdded)
+				{
+					MeshVertex vertex;
+					ZeroMemory(&vertex, sizeof(MeshVertex));
+					vertex.position = Positions[iPosition - 1];
+					if(iTexCoord)
+						vertex.texcoord = TexCoords[iTexCoord - 1];
+					if(iNormal)
+						vertex.normal = Normals[iNormal - 1];
+
+					m_Vertices.push_back(vertex);
+				}
 			}
-        }
-		else if(0 == wcscmp(strCommand, L"s")) // Handle smoothing group for normal computation
-		{
-			InFile.ignore();
 
-			if(InFile.peek() >= '0' && InFile.peek() <= '9')
-				InFile >> iSmoothingGroup;
-			else
-				iSmoothingGroup = 0;
-		}
-        else if(0 == wcscmp(strCommand, L"mtllib"))
-        {
-            // Material library
-            InFile >> strMaterialFilename;
-        }
-        else if(0 == wcscmp(strCommand, L"usemtl"))
-        {
-            // Material
-            WCHAR strName[MAX_PATH] = {0};
-            InFile >> strName;
+			if(FAILED(hr))
+				break;
 
-			bool bFound = false;
-			for(UINT32 iMaterial = 0; iMaterial < m_Materials.size(); iMaterial++)
+			for(UINT iVertex = 0; iVertex < 3; iVertex++)
 			{
-				Material* pCurMaterial = m_Materials[iMaterial];
-				if(0 == wcscmp(pCurMaterial->strName, strName))
-				{
-					bFound = true;
-                    dwCurSubset = iMaterial;
-                    break;
-                }
-            }
+				m_Indices.push_back(aIndex[iVertex]);
+				Face.aiIndices[iVertex] = aIndex[iVertex];
+			}
 
-            if(!bFound)
-            {
-                pMaterial = new Material();
-                if(pMaterial == NULL)
-                    return E_OUTOFMEMORY;
+			Face.iSmoothingGroup = iSmoothingGroup;
+			m_Faces.push_back(Face);
 
-                dwCurSubset = static_cast<int>(m_Materials.size());
+			if(record.nVertices == 4)
+			{
+				// Triangularize quad
+				quadFace.aiIndices[0] = aIndex[3];
+				quadFace.aiIndices[1] = Face.aiIndices[0];
+				quadFace.aiIndices[2] = Face.aiIndices[2];
 
-                InitMaterial(pMaterial);
-                wcscpy_s(pMaterial->strName, MAX_PATH - 1, strName);
+				m_Indices.push_back(quadFace.aiIndices[0]);
+				m_Indices.push_back(quadFace.aiIndices[1]);
+				m_Indices.push_back(quadFace.aiIndices[2]);
 
-                m_Materials.push_back(pMaterial);
-            }
+				quadFace.iSmoothingGroup = iSmoothingGroup;
+				m_Faces.push_back(quadFace);
+			}
+		}
+	}
 
-			m_SubsetStartIdx.push_back(DWORD(m_Indices.size()));
-			m_SubsetMtlIdx.push_back(dwCurSubset);
-			m_iNumSubsets++;
-        }
-        else
-        {
-            // Unimplemented or unrecognized command
-        }
+	// Material names point into the mapped file, so it is only released once everything is merged
+	if(pFile)
+		UnmapViewOfFile(pFile);
+	if(hMapping)
+		CloseHandle(hMapping);
+	CloseHandle(hFile);
 
-        InFile.ignore(1000, '\n');
-    }
+	if(FAILED(hr))
+	{
+		DeleteCache();
+		return hr;
+	}
 
 	// Correct subsets index
 	if(m_iNumSubsets == 0)
@@ -445,9 +878,9 @@ HRESULT ObjMeshDX::LoadGeometryFromOBJ(const WCHAR* strFileName)
 	m_SubsetStartIdx.push_back(DWORD(m_Indices.size()));
 	
 	ComputeVertexNormals();
+	OptimizeIndices();
 
     // Cleanup
-    InFile.close();
     DeleteCache();
 
 	D3DXVECTOR3 vMid = 0.5f * (vMax + vMin);
@@ -468,6 +901,7 @@ HRESULT ObjMeshDX::LoadGeometryFromOBJ(const WCHAR* strFileName)
     return S_OK;
 }
 
+
 //--------------------------------------------------------------------------------------
 void ObjMeshDX::ComputeVertexNormals()
 {
@@ -540,7 +974,15 @@ void ObjMeshDX::ComputeVertexNormals()
 				MeshVertex newVertex = vert;
 				newVertex.normal = vNormal;
 
-				auto idx = AddVertex(m_Faces[i].aiIndices[j], &newVertex);
+				// Copies are welded on the vertex they came from and their new normal
+				UINT aiKey[4];
+				aiKey[0] = face.aiIndices[j];
+				memcpy(&aiKey[1], &vNormal, sizeof(D3DXVECTOR3));
+
+				bool bAdded;
+				auto idx = m_NormalWelder.Weld(aiKey, UINT(m_Vertices.size()), &bAdded);
+				if(bAdded)
+					m_Vertices.push_back(newVertex);
 				//m_Faces[i].aiIndices[j] = idx;
 				m_Indices[3 * i + j] = idx;
 			}
@@ -549,96 +991,27 @@ void ObjMeshDX::ComputeVertexNormals()
 }
 
 //--------------------------------------------------------------------------------------
-DWORD ObjMeshDX::AddVertex(UINT hash, MeshVertex* pVertex)
+// Reorders each subset for the post-transform vertex cache and overdraw, then the vertex
+// buffer for fetch locality. m_Faces is only used to build the normals and is not remapped.
+void ObjMeshDX::OptimizeIndices()
 {
-    // If this vertex doesn't already exist in the Vertices list, create a new entry.
-    // Add the index of the vertex to the Indices list.
-    bool bFoundInList = false;
-    auto index = 0;
-
-    // Since it's very slow to check every element in the vertex list, a hashtable stores
-    // vertex indices according to the vertex position's index as reported by the OBJ file
-    if((UINT)m_VertexCache.size() > hash)
-    {
-        CacheEntry* pEntry = m_VertexCache[hash];
-        while(pEntry != NULL)
-        {
-            MeshVertex* pCacheVertex = m_Vertices.data() + pEntry->index;
-
-            // If this vertex is identical to the vertex already in the list, simply
-            // point the index buffer to the existing vertex
-            if(0 == memcmp(pVertex, pCacheVertex, sizeof(MeshVertex)))
-            {
-                bFoundInList = true;
-                index = pEntry->index;
-                break;
-            }
-
-            pEntry = pEntry->pNext;
-        }
-    }
-
-    // Vertex was not found in the list. Create a new entry, both within the Vertices list
-    // and also within the hashtable cache
-    if(!bFoundInList)
-    {
-        // Add to the Vertices list
-        index = static_cast<int>(m_Vertices.size());
-        m_Vertices.push_back(*pVertex);
-
-        // Add this to the hashtable
-        CacheEntry* pNewEntry = new CacheEntry;
-        if(pNewEntry == NULL)
-            return(DWORD)-1;
+	if(m_Indices.empty())
+		return;
 
-        pNewEntry->index = index;
-        pNewEntry->pNext = NULL;
+	vector<UINT> indices(m_Indices.begin(), m_Indices.end());
+	vector<UINT> subsetStarts(m_SubsetStartIdx.begin(), m_SubsetStartIdx.end());
 
-        // Grow the cache if needed
-        while((UINT)m_VertexCache.size() <= hash)
-        {
-            m_VertexCache.push_back(NULL);
-        }
-
-        // Add to the end of the linked list
-        CacheEntry* pCurEntry = m_VertexCache[hash];
-        if(pCurEntry == NULL)
-        {
-            // This is the head element
-            m_VertexCache[hash] = pNewEntry;
-        }
-        else
-        {
-            // Find the tail
-            while(pCurEntry->pNext != NULL)
-            {
-                pCurEntry = pCurEntry->pNext;
-            }
+	NvMeshOptimizer::OptimizeMesh(m_Vertices.data(), sizeof(MeshVertex), UINT(m_Vertices.size()), indices.data(), UINT(indices.size()),
+		subsetStarts.data(), UINT(m_iNumSubsets), &m_CacheStatsBefore, &m_CacheStatsAfter);
 
-            pCurEntry->pNext = pNewEntry;
-        }
-    }
-
-    return index;
+	m_Indices.assign(indices.begin(), indices.end());
 }
 
-
 //--------------------------------------------------------------------------------------
 void ObjMeshDX::DeleteCache()
 {
-    // Iterate through all the elements in the cache and subsequent linked lists
-    for(UINT32 i = 0; i < m_VertexCache.size(); i++)
-    {
-        CacheEntry* pEntry = m_VertexCache[i];
-        while(pEntry != NULL)
-        {
-            CacheEntry* pNext = pEntry->pNext;
-            SAFE_DELETE(pEntry);
-            pEntry = pNext;
-        }
-    }
-
-    m_VertexCache.clear();
+    m_VertexWelder.Clear();
+    m_NormalWelder.Clear();
 }
 
 
@@ -36,6 +36,8 @@
 #pragma once
 
 #include "DirectXUtil.h"
+#include "NvVertexWelder.h"
+#include "NvMeshOptimizer.h"
 #include <vector>
 
 // Vertex format
@@ -52,14 +54,6 @@ struct MeshFace
 	int iSmoothingGroup;
 };
 
-// Used for a hashtable vertex cache when creating the mesh from a .obj file
-struct CacheEntry
-{
-    UINT index;
-    CacheEntry* pNext;
-};
-
-
 // Material properties per mesh subset
 struct Material
 {
@@ -102,6 +96,15 @@ public:
     {
 		return m_Materials[iMaterial];
     }
+	// Post-transform vertex cache behaviour of the index buffer before and after OptimizeIndices reordered it
+	const NvVertexCacheStatistics& GetCacheStatsBefore() const
+	{
+		return m_CacheStatsBefore;
+	}
+	const NvVertexCacheStatistics& GetCacheStatsAfter() const
+	{
+		return m_CacheStatsAfter;
+	}
 	size_t GetNumSubsets() const
 	{
 		return m_SubsetStartIdx.size();
@@ -127,16 +130,17 @@ private:
     HRESULT LoadGeometryFromOBJ(const WCHAR* strFilename);
     HRESULT LoadMaterialsFromMTL(const WCHAR* strFileName);
 	void	ComputeVertexNormals();
+	void	OptimizeIndices();
     void    InitMaterial(Material* pMaterial);
 
-    DWORD   AddVertex(UINT hash, MeshVertex* pVertex);
     void    DeleteCache();
 
 	
 	inline const DWORD* GetIndexAt(int iNum) const { return m_Indices.data() + 3 * iNum; }
 	inline const MeshVertex& GetVertexAt(int iIndex) const { return m_Vertices[iIndex]; }
 
-    std::vector<CacheEntry*> m_VertexCache;   // Hashtable cache for locating duplicate vertices
+    NvVertexWelder m_VertexWelder;      // Welds face vertices with the same position, texcoord and normal indices
+    NvVertexWelder m_NormalWelder;      // Welds the copies of a vertex made for differing smoothing group normals
     std::vector<MeshVertex> m_Vertices;      // Filled and copied to the vertex buffer
     std::vector<DWORD> m_Indices;       // Filled and copied to the index buffer
 	std::vector<MeshFace> m_Faces;
@@ -144,6 +148,8 @@ private:
 	std::vector<DWORD> m_SubsetMtlIdx;  // Holds the material index of each subset
     std::vector<Material*> m_Materials;     // Holds material properties per subset
 	int m_iNumSubsets;
+	NvVertexCacheStatistics m_CacheStatsBefore;
+	NvVertexCacheStatistics m_CacheStatsAfter;
 
 	// D3D Buffers
 	ID3D11Buffer* m_pVertexBuffer;